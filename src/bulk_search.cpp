@@ -0,0 +1,365 @@
+#include "stdafx.h"
+
+#include "bulk_search.h"
+#include "logging.h"
+#include "preferences.h"
+
+static const uint32_t JOURNAL_FORMAT_VERSION = 1;
+static const size_t JOURNAL_RECORD_SIZE = 5; // uint32 track index, followed by a uint8 state
+
+BulkSearchJournal::BulkSearchJournal(std::vector<metadb_handle_ptr> tracks) :
+    m_tracks(std::move(tracks)),
+    m_states(m_tracks.size(), BulkSearchTrackState::Pending),
+    m_file()
+{
+}
+
+std::string BulkSearchJournal::persistent_path()
+{
+    std::string path = core_api::get_profile_path();
+    path += "\\openlyrics_bulk_search.journal";
+    return path;
+}
+
+bool BulkSearchJournal::persistent_exists()
+{
+    try
+    {
+        abort_callback_dummy noAbort;
+        return filesystem::g_exists(persistent_path().c_str(), noAbort);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to check for an existing bulk search journal: %s", e.what());
+        return false;
+    }
+}
+
+std::unique_ptr<BulkSearchJournal> BulkSearchJournal::create_persistent(std::vector<metadb_handle_ptr> tracks)
+{
+    auto journal = std::make_unique<BulkSearchJournal>(std::move(tracks));
+    const std::string path = persistent_path();
+    try
+    {
+        abort_callback_dummy noAbort;
+        file_ptr file;
+        filesystem::g_open_write_new(file, path.c_str(), noAbort);
+        file->write_lendian_t(JOURNAL_FORMAT_VERSION, noAbort);
+        file->write_lendian_t(uint32_t(journal->m_tracks.size()), noAbort);
+        for(const metadb_handle_ptr& track : journal->m_tracks)
+        {
+            const playable_location& location = track->get_location();
+            file->write_string(location.get_path(), noAbort);
+            file->write_lendian_t(uint32_t(location.get_subsong()), noAbort);
+        }
+        journal->m_file = file;
+        LOG_INFO("Created bulk search journal for %u tracks at %s", uint32_t(journal->m_tracks.size()), path.c_str());
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to create bulk search journal at %s, the search will not be resumable: %s", path.c_str(), e.what());
+    }
+    return journal;
+}
+
+std::unique_ptr<BulkSearchJournal> BulkSearchJournal::load_persistent()
+{
+    const std::string path = persistent_path();
+    try
+    {
+        abort_callback_dummy noAbort;
+        if(!filesystem::g_exists(path.c_str(), noAbort))
+        {
+            return nullptr;
+        }
+
+        file_ptr file;
+        filesystem::g_open(file, path.c_str(), filesystem::open_mode_write_existing, noAbort);
+
+        uint32_t version = 0;
+        uint32_t track_count = 0;
+        file->read_lendian_t(version, noAbort);
+        if(version != JOURNAL_FORMAT_VERSION)
+        {
+            LOG_WARN("Ignoring bulk search journal at %s with unsupported version %u", path.c_str(), version);
+            return nullptr;
+        }
+        file->read_lendian_t(track_count, noAbort);
+
+        std::vector<metadb_handle_ptr> tracks;
+        tracks.reserve(track_count);
+        auto db = metadb::get();
+        for(uint32_t i=0; i<track_count; i++)
+        {
+            pfc::string8 track_path;
+            uint32_t subsong = 0;
+            file->read_string(track_path, noAbort);
+            file->read_lendian_t(subsong, noAbort);
+            tracks.push_back(db->handle_create(track_path.c_str(), subsong));
+        }
+        auto journal = std::make_unique<BulkSearchJournal>(std::move(tracks));
+
+        // NOTE: We read all the records in one go rather than one at a time because there could be a lot of them.
+        //       If the last record was only partially written (e.g because foobar2000 closed while it was being
+        //       written) then we ignore it and truncate the file so that new records start at the right place.
+        const t_filesize records_start = file->get_position(noAbort);
+        const t_filesize records_size = file->get_size(noAbort) - records_start;
+        const size_t record_count = size_t(records_size / JOURNAL_RECORD_SIZE);
+        std::vector<uint8_t> records(record_count * JOURNAL_RECORD_SIZE);
+        file->read_object(records.data(), records.size(), noAbort);
+        for(size_t i=0; i<record_count; i++)
+        {
+            const uint8_t* record = records.data() + i*JOURNAL_RECORD_SIZE;
+            const uint32_t track_index = uint32_t(record[0]) |
+                                         (uint32_t(record[1]) << 8) |
+                                         (uint32_t(record[2]) << 16) |
+                                         (uint32_t(record[3]) << 24);
+            const uint8_t state = record[4];
+            if((track_index >= track_count) || (state > uint8_t(BulkSearchTrackState::Error)))
+            {
+                LOG_WARN("Ignoring invalid record in bulk search journal at %s", path.c_str());
+                continue;
+            }
+            journal->m_states[track_index] = BulkSearchTrackState(state);
+        }
+        file->seek(records_start + records.size(), noAbort);
+        file->set_eof(noAbort);
+
+        journal->m_file = file;
+        LOG_INFO("Loaded bulk search journal for %u tracks with %u records from %s", track_count, uint32_t(record_count), path.c_str());
+        return journal;
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to load bulk search journal from %s: %s", path.c_str(), e.what());
+        return nullptr;
+    }
+}
+
+const std::vector<metadb_handle_ptr>& BulkSearchJournal::tracks() const
+{
+    return m_tracks;
+}
+
+BulkSearchTrackState BulkSearchJournal::state(size_t track_index) const
+{
+    assert(track_index < m_states.size());
+    return m_states[track_index];
+}
+
+void BulkSearchJournal::record(size_t track_index, BulkSearchTrackState state)
+{
+    assert(track_index < m_states.size());
+    m_states[track_index] = state;
+    if(m_file == nullptr)
+    {
+        return;
+    }
+
+    const uint32_t index = uint32_t(track_index);
+    const uint8_t record[JOURNAL_RECORD_SIZE] = {
+        uint8_t(index & 0xFF),
+        uint8_t((index >> 8) & 0xFF),
+        uint8_t((index >> 16) & 0xFF),
+        uint8_t((index >> 24) & 0xFF),
+        uint8_t(state)
+    };
+    try
+    {
+        abort_callback_dummy noAbort;
+        m_file->write_object(record, sizeof(record), noAbort);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to write to the bulk search journal, the search will no longer be resumable: %s", e.what());
+        m_file.release();
+    }
+}
+
+void BulkSearchJournal::discard()
+{
+    if(m_file == nullptr)
+    {
+        return;
+    }
+
+    m_file.release();
+    const std::string path = persistent_path();
+    try
+    {
+        abort_callback_dummy noAbort;
+        filesystem::g_remove(path.c_str(), noAbort);
+        LOG_INFO("Removed completed bulk search journal at %s", path.c_str());
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to remove completed bulk search journal at %s: %s", path.c_str(), e.what());
+    }
+}
+
+BulkSearchEngine::InProgressSearch::InProgressSearch(size_t index, metadb_handle_ptr track, abort_callback& abort) :
+    track_index(index),
+    update(LyricUpdateHandle::Type::AutoSearch, track, abort)
+{
+}
+
+static std::vector<BulkSearchTrackState> journal_states(const BulkSearchJournal& journal)
+{
+    std::vector<BulkSearchTrackState> states;
+    states.reserve(journal.tracks().size());
+    for(size_t i=0; i<journal.tracks().size(); i++)
+    {
+        states.push_back(journal.state(i));
+    }
+    return states;
+}
+
+BulkSearchEngine::BulkSearchEngine(std::unique_ptr<BulkSearchJournal> journal, size_t max_concurrent_searches, abort_callback& abort) :
+    m_journal(std::move(journal)),
+    m_schedule(journal_states(*m_journal), max_concurrent_searches),
+    m_abort(abort),
+    m_in_progress(),
+    m_timer()
+{
+    m_timer.start();
+}
+
+BulkSearchUpdate BulkSearchEngine::poll()
+{
+    BulkSearchUpdate result = collect();
+    const std::vector<metadb_handle_ptr>& tracks = m_journal->tracks();
+
+    std::vector<size_t> start_indices;
+    std::vector<metadb_handle_ptr> start_tracks;
+    while(!m_abort.is_aborting())
+    {
+        const std::optional<size_t> maybe_index = m_schedule.start_next(m_timer.query());
+        if(!maybe_index.has_value())
+        {
+            break;
+        }
+        start_indices.push_back(maybe_index.value());
+        start_tracks.push_back(tracks[maybe_index.value()]);
+    }
+
+    // NOTE: The save filenames and search-avoidance records for every search that we start are loaded in
+    //       one pass each, so that the save settings and metadb index are only looked up once per poll
+    //       rather than once per track.
+    std::vector<std::string> save_filenames = preferences::saving::filename(start_tracks);
+    std::vector<lyric_search_avoidance> avoidances = load_search_avoidance(start_tracks);
+    for(size_t i=0; i<start_indices.size(); i++)
+    {
+        // NOTE: A bulk search is explicitly requested for these tracks so (as with the panel's manual search)
+        //       every source is searched, even those that recently failed to find lyrics for the track.
+        InProgressSearch& search = m_in_progress.emplace_back(start_indices[i], start_tracks[i], m_abort);
+        search.update.set_search_context(std::make_shared<const SearchContext>(start_tracks[i], std::move(save_filenames[i])));
+        search.update.set_search_avoidance(std::move(avoidances[i]));
+        io::search_for_lyrics(search.update, false, true);
+        result.started.push_back(start_indices[i]);
+    }
+
+    discard_journal_if_complete(result);
+    return result;
+}
+
+BulkSearchUpdate BulkSearchEngine::collect()
+{
+    BulkSearchUpdate result = {};
+
+    for(auto iter=m_in_progress.begin(); iter!=m_in_progress.end(); /*omitted*/)
+    {
+        if(!iter->update.is_complete())
+        {
+            iter++;
+            continue;
+        }
+
+        BulkSearchResult track_result = {};
+        track_result.track_index = iter->track_index;
+        bool save_failed = false;
+        track_result.lyrics = io::process_available_lyric_update(iter->update, &save_failed);
+
+        BulkSearchOutcome outcome = {};
+        outcome.found_lyrics = track_result.lyrics.has_value();
+        outcome.save_failed = save_failed;
+        outcome.aborted = m_abort.is_aborting();
+        outcome.had_errors = iter->update.had_errors();
+        track_result.state = bulk_search_outcome_state(outcome);
+
+        m_schedule.finish(track_result.state);
+        if(track_result.state != BulkSearchTrackState::Pending)
+        {
+            m_journal->record(track_result.track_index, track_result.state);
+        }
+        result.completed.push_back(std::move(track_result));
+        iter = m_in_progress.erase(iter);
+    }
+
+    discard_journal_if_complete(result);
+    return result;
+}
+
+void BulkSearchEngine::discard_journal_if_complete(const BulkSearchUpdate& update)
+{
+    if(!update.completed.empty() && is_complete())
+    {
+        // NOTE: We keep the journal if any of the searches failed or were interrupted,
+        //       so that they can be retried by resuming the job.
+        bool any_unfinished = false;
+        for(size_t i=0; i<m_journal->tracks().size(); i++)
+        {
+            const BulkSearchTrackState state = m_journal->state(i);
+            any_unfinished |= (state == BulkSearchTrackState::Error) || (state == BulkSearchTrackState::Pending);
+        }
+        if(!any_unfinished)
+        {
+            m_journal->discard();
+        }
+    }
+}
+
+bool BulkSearchEngine::wait_for_in_progress(uint32_t timeout_ms)
+{
+    pfc::hires_timer timer;
+    timer.start();
+    for(InProgressSearch& search : m_in_progress)
+    {
+        const double elapsed_ms = timer.query() * 1000.0;
+        const uint32_t remaining_ms = (elapsed_ms < timeout_ms) ? (timeout_ms - uint32_t(elapsed_ms)) : 0;
+        if(!search.update.wait_for_complete(remaining_ms))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BulkSearchEngine::is_complete() const
+{
+    return m_schedule.is_complete();
+}
+
+const std::vector<metadb_handle_ptr>& BulkSearchEngine::tracks() const
+{
+    return m_journal->tracks();
+}
+
+BulkSearchTrackState BulkSearchEngine::track_state(size_t track_index) const
+{
+    return m_journal->state(track_index);
+}
+
+size_t BulkSearchEngine::completed_count() const
+{
+    return m_schedule.completed_count();
+}
+
+double BulkSearchEngine::tracks_per_minute() const
+{
+    return m_schedule.tracks_per_minute(m_timer.query());
+}
+
+std::optional<double> BulkSearchEngine::estimated_seconds_remaining() const
+{
+    return m_schedule.estimated_seconds_remaining(m_timer.query());
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <list>
+
+#include "bulk_search_schedule.h"
+#include "lyric_data.h"
+#include "lyric_io.h"
+
+// The list of tracks in a bulk search, along with the state of each one.
+// A persistent journal is stored in the foobar2000 profile directory so that an interrupted bulk search can be
+// resumed later. The file contains the identity (path & subsong) of every track, followed by a fixed-size record
+// that is appended each time a track's state changes. Appending a record is O(1) regardless of the size of the job
+// and when the journal is loaded, the last record for each track wins.
+// Only one bulk search is journalled at a time. Starting a new one replaces the journal of the previous one.
+class BulkSearchJournal
+{
+public:
+    // Creates a journal that is only held in memory, with every track pending
+    explicit BulkSearchJournal(std::vector<metadb_handle_ptr> tracks);
+    BulkSearchJournal(const BulkSearchJournal& other) = delete;
+
+    // Creates a new persistent journal for the given tracks, replacing any existing one.
+    // If the journal cannot be written to disk then the returned journal is only held in memory.
+    static std::unique_ptr<BulkSearchJournal> create_persistent(std::vector<metadb_handle_ptr> tracks);
+    // Loads the existing persistent journal, or returns null if there is no (valid) journal
+    static std::unique_ptr<BulkSearchJournal> load_persistent();
+    static bool persistent_exists();
+
+    const std::vector<metadb_handle_ptr>& tracks() const;
+    BulkSearchTrackState state(size_t track_index) const;
+    void record(size_t track_index, BulkSearchTrackState state);
+
+    // Removes the journal from disk (if it was persistent), for once the job is finished
+    void discard();
+
+private:
+    static std::string persistent_path();
+
+    std::vector<metadb_handle_ptr> m_tracks;
+    std::vector<BulkSearchTrackState> m_states;
+    file_ptr m_file; // Null if the journal is only held in memory
+};
+
+struct BulkSearchResult
+{
+    size_t track_index;
+    BulkSearchTrackState state;
+    std::optional<LyricData> lyrics; // Empty if no lyrics were found
+};
+
+struct BulkSearchUpdate
+{
+    std::vector<size_t> started; // The indices of the tracks for which a search was started
+    std::vector<BulkSearchResult> completed;
+};
+
+// Searches for lyrics for each pending track in a journal, with up to a fixed number of searches in progress at once.
+// This has no UI of its own: the owner calls `poll` regularly (e.g from a timer) to start new searches as earlier
+// ones complete and to collect the results. Results have already been saved (as per the user's auto-save setting)
+// by the time they are returned. Requests to remote sources are rate-limited by the HTTP transport so the number
+// of searches in progress does not change the rate at which any single lyric provider receives requests.
+// Tracks that previously failed with an error are searched again. Searches that are interrupted by the abort
+// callback leave their track pending, so that it is searched again when the job is resumed.
+class BulkSearchEngine
+{
+public:
+    BulkSearchEngine(std::unique_ptr<BulkSearchJournal> journal, size_t max_concurrent_searches, abort_callback& abort);
+    BulkSearchEngine(const BulkSearchEngine& other) = delete;
+
+    // Collects the results of every search that completed since the last call and then starts new searches until
+    // the maximum number are in progress. No new searches are started once the abort callback has been triggered.
+    BulkSearchUpdate poll();
+    // Collects the results of every search that completed since the last call, without starting any new searches
+    BulkSearchUpdate collect();
+
+    // Blocks until every search that is in progress has completed, or the timeout expires.
+    // Returns true if there are no searches in progress.
+    bool wait_for_in_progress(uint32_t timeout_ms);
+
+    bool is_complete() const;
+    const std::vector<metadb_handle_ptr>& tracks() const;
+    BulkSearchTrackState track_state(size_t track_index) const;
+    size_t completed_count() const; // Including tracks that were completed before the job was resumed
+
+    // The number of tracks completed per minute since the first search (in this session) started
+    double tracks_per_minute() const;
+    // The estimated time until all tracks have been searched, or nothing if we don't have enough data yet
+    std::optional<double> estimated_seconds_remaining() const;
+
+private:
+    struct InProgressSearch
+    {
+        InProgressSearch(size_t index, metadb_handle_ptr track, abort_callback& abort);
+
+        size_t track_index;
+        LyricUpdateHandle update;
+    };
+
+    void discard_journal_if_complete(const BulkSearchUpdate& update);
+
+    std::unique_ptr<BulkSearchJournal> m_journal;
+    BulkSearchSchedule m_schedule;
+    abort_callback& m_abort;
+
+    // NOTE: This must be a std::list because the search tasks hold references to the update handles
+    std::list<InProgressSearch> m_in_progress;
+
+    pfc::hires_timer m_timer;
+};
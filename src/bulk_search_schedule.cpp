@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cassert>
+
+#include "bulk_search_schedule.h"
+
+BulkSearchTrackState bulk_search_outcome_state(const BulkSearchOutcome& outcome)
+{
+    if(outcome.found_lyrics && !outcome.save_failed)
+    {
+        return BulkSearchTrackState::Found;
+    }
+    else if(outcome.aborted)
+    {
+        // NOTE: The search (or the save of its result) was interrupted, so we don't actually know
+        //       whether there are lyrics for this track.
+        return BulkSearchTrackState::Pending;
+    }
+    else if(outcome.save_failed || outcome.had_errors)
+    {
+        return BulkSearchTrackState::Error;
+    }
+    else
+    {
+        return BulkSearchTrackState::NotFound;
+    }
+}
+
+BulkSearchSchedule::BulkSearchSchedule(const std::vector<BulkSearchTrackState>& track_states, size_t max_concurrent_searches) :
+    m_tracks_to_search(),
+    m_track_count(track_states.size()),
+    m_max_concurrent_searches((std::max)(max_concurrent_searches, size_t(1))),
+    m_next_search(0),
+    m_in_progress_count(0),
+    m_completed_count(0),
+    m_session_completed_count(0),
+    m_first_start_seconds()
+{
+    // NOTE: Tracks that previously failed with an error are searched again
+    for(size_t i=0; i<track_states.size(); i++)
+    {
+        const BulkSearchTrackState state = track_states[i];
+        if((state == BulkSearchTrackState::Found) || (state == BulkSearchTrackState::NotFound))
+        {
+            m_completed_count++;
+        }
+        else
+        {
+            m_tracks_to_search.push_back(i);
+        }
+    }
+}
+
+std::optional<size_t> BulkSearchSchedule::start_next(double now_seconds)
+{
+    if((m_in_progress_count >= m_max_concurrent_searches) || (m_next_search >= m_tracks_to_search.size()))
+    {
+        return {};
+    }
+
+    if(!m_first_start_seconds.has_value())
+    {
+        m_first_start_seconds = now_seconds;
+    }
+    m_in_progress_count++;
+    return m_tracks_to_search[m_next_search++];
+}
+
+void BulkSearchSchedule::finish(BulkSearchTrackState state)
+{
+    assert(m_in_progress_count > 0);
+    m_in_progress_count--;
+    if(state != BulkSearchTrackState::Pending)
+    {
+        m_completed_count++;
+        m_session_completed_count++;
+    }
+}
+
+bool BulkSearchSchedule::is_complete() const
+{
+    return (m_in_progress_count == 0) && (m_next_search >= m_tracks_to_search.size());
+}
+
+size_t BulkSearchSchedule::in_progress_count() const
+{
+    return m_in_progress_count;
+}
+
+size_t BulkSearchSchedule::completed_count() const
+{
+    return m_completed_count;
+}
+
+double BulkSearchSchedule::tracks_per_minute(double now_seconds) const
+{
+    if(!m_first_start_seconds.has_value())
+    {
+        return 0.0;
+    }
+
+    const double elapsed_minutes = (now_seconds - m_first_start_seconds.value()) / 60.0;
+    if(elapsed_minutes <= 0.0)
+    {
+        return 0.0;
+    }
+    return double(m_session_completed_count) / elapsed_minutes;
+}
+
+std::optional<double> BulkSearchSchedule::estimated_seconds_remaining(double now_seconds) const
+{
+    const double rate = tracks_per_minute(now_seconds);
+    if((m_session_completed_count == 0) || (rate <= 0.0))
+    {
+        return {};
+    }
+
+    const size_t remaining = m_track_count - m_completed_count;
+    return 60.0 * double(remaining) / rate;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+enum class BulkSearchTrackState : uint8_t
+{
+    Pending = 0,
+    Found = 1,
+    NotFound = 2,
+    Error = 3, // One or more sources could not be searched, so it is worth searching for this track again later
+};
+
+// What happened when a bulk search searched for a single track (and saved the result, if there was one)
+struct BulkSearchOutcome
+{
+    bool found_lyrics;
+    bool save_failed;
+    bool aborted;    // The abort callback was triggered during the search or save
+    bool had_errors; // One or more sources could not be searched
+};
+
+BulkSearchTrackState bulk_search_outcome_state(const BulkSearchOutcome& outcome);
+
+// Decides which track a bulk search should search for next and measures the progress of the job, independently of
+// how the searches are run and where the track states are stored. Times are in seconds since any fixed point.
+class BulkSearchSchedule
+{
+public:
+    // `track_states` are the states of the tracks when the job is started (or resumed)
+    BulkSearchSchedule(const std::vector<BulkSearchTrackState>& track_states, size_t max_concurrent_searches);
+
+    // Returns the index of the next track to search, or nothing if the maximum number of searches are already in
+    // progress or a search has been started for every track. Tracks that were already found or not found are skipped.
+    std::optional<size_t> start_next(double now_seconds);
+    // Records that one of the searches in progress has finished. A Pending state means that the search was
+    // interrupted, in which case the track does not count as completed.
+    void finish(BulkSearchTrackState state);
+
+    bool is_complete() const;
+    size_t in_progress_count() const;
+    size_t completed_count() const; // Including tracks that were completed before the job was resumed
+
+    // The number of tracks completed per minute since the first search (in this session) started
+    double tracks_per_minute(double now_seconds) const;
+    // The estimated time until all tracks have been searched, or nothing if we don't have enough data yet
+    std::optional<double> estimated_seconds_remaining(double now_seconds) const;
+
+private:
+    std::vector<size_t> m_tracks_to_search;
+    size_t m_track_count;
+    size_t m_max_concurrent_searches;
+
+    size_t m_next_search;
+    size_t m_in_progress_count;
+    size_t m_completed_count;
+    size_t m_session_completed_count;
+    std::optional<double> m_first_start_seconds;
+};
@@ -0,0 +1,98 @@
+#include "stdafx.h"
+
+#include "preferences.h"
+
+// NOTE: These settings are not intended for general use, so rather than being part of our own preferences
+//       pages they're listed in foobar2000's "Advanced" preferences page (under "Tools").
+static const GUID GUID_ADVCONFIG_BRANCH = { 0x360c504f, 0x30ae, 0x47e0, { 0xab, 0x45, 0x24, 0x70, 0x8, 0xcb, 0x4b, 0x3e } };
+static const GUID GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES = { 0xdd2a7ddb, 0x7a1e, 0x49ce, { 0x83, 0xa8, 0xf7, 0x50, 0xfe, 0x40, 0xbf, 0xdf } };
+static const GUID GUID_ADVCONFIG_HTTP_FIXTURES_DISABLED = { 0x6b43c833, 0xa828, 0x4442, { 0xbe, 0x1b, 0x91, 0xfb, 0xdf, 0x68, 0x61, 0xe7 } };
+static const GUID GUID_ADVCONFIG_HTTP_FIXTURES_RECORD = { 0x63948cb, 0x206f, 0x41a4, { 0x89, 0xe8, 0x34, 0x66, 0x71, 0x24, 0xbe, 0x46 } };
+static const GUID GUID_ADVCONFIG_HTTP_FIXTURES_REPLAY = { 0xc48b060e, 0x4eec, 0x4699, { 0xa5, 0x71, 0x51, 0xc2, 0x80, 0xf4, 0xaa, 0x40 } };
+static const GUID GUID_ADVCONFIG_HTTP_FIXTURES_DIRECTORY = { 0xf4d728d8, 0x485f, 0x40b3, { 0x82, 0xee, 0x3d, 0xd6, 0x6c, 0xbe, 0xdb, 0x2b } };
+static const GUID GUID_ADVCONFIG_HTTP_STANDIN_SERVER = { 0x65039273, 0xfbb3, 0x49b3, { 0x92, 0xff, 0x98, 0x20, 0x92, 0xf0, 0xeb, 0x51 } };
+static const GUID GUID_ADVCONFIG_SCRAPER_PAGE_DISK_CACHE = { 0x5a497e1, 0x7506, 0x4b31, { 0x80, 0x1b, 0x7c, 0xaa, 0xab, 0x7f, 0x6a, 0xf0 } };
+static const GUID GUID_ADVCONFIG_MUSIXMATCH_MACRO_SEARCH = { 0xc8712af0, 0xcf0b, 0x443b, { 0xaf, 0xf7, 0xf1, 0xc6, 0x59, 0xae, 0x54, 0xc5 } };
+static const GUID GUID_ADVCONFIG_BULK_SEARCH_CONCURRENCY = { 0x296dca97, 0x3de1, 0x4b09, { 0x87, 0x33, 0xea, 0x8d, 0x89, 0xcd, 0x13, 0x7b } };
+static const GUID GUID_ADVCONFIG_BRANCH_CONCURRENT_LOOKUPS = { 0x447bac26, 0xeb79, 0x4c79, { 0x82, 0x28, 0x4b, 0x9a, 0x89, 0xdd, 0x87, 0xf2 } };
+static const GUID GUID_ADVCONFIG_MUSIXMATCH_CONCURRENT_LOOKUPS = { 0x88381f0d, 0xdcf6, 0x49af, { 0x94, 0xbb, 0xcd, 0x81, 0xec, 0x8e, 0x9d, 0x98 } };
+static const GUID GUID_ADVCONFIG_NETEASE_CONCURRENT_LOOKUPS = { 0x1a239630, 0xeb13, 0x4703, { 0xa8, 0x9f, 0x67, 0xe6, 0xa7, 0x32, 0xf, 0xb9 } };
+static const GUID GUID_ADVCONFIG_QQMUSIC_CONCURRENT_LOOKUPS = { 0x623a9f6c, 0xb3f8, 0x45ab, { 0xb4, 0x32, 0x0, 0xbe, 0x45, 0xb4, 0x6d, 0x68 } };
+
+static advconfig_branch_factory g_advconfig_branch("OpenLyrics", GUID_ADVCONFIG_BRANCH, advconfig_branch::guid_branch_tools, 0.0);
+static advconfig_branch_factory g_advconfig_branch_http_fixtures("HTTP response fixtures (for debugging lyric sources)", GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES, GUID_ADVCONFIG_BRANCH, 0.0);
+static advconfig_branch_factory g_advconfig_branch_concurrent_lookups("Number of search results to look up at once from each source", GUID_ADVCONFIG_BRANCH_CONCURRENT_LOOKUPS, GUID_ADVCONFIG_BRANCH, 4.0);
+
+static advconfig_radio_factory cfg_http_fixtures_disabled("Disabled", GUID_ADVCONFIG_HTTP_FIXTURES_DISABLED, GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES, 0.0, true);
+static advconfig_radio_factory cfg_http_fixtures_record("Record all responses into the fixture directory", GUID_ADVCONFIG_HTTP_FIXTURES_RECORD, GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES, 1.0, false);
+static advconfig_radio_factory cfg_http_fixtures_replay("Replay responses from the fixture directory instead of sending requests", GUID_ADVCONFIG_HTTP_FIXTURES_REPLAY, GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES, 2.0, false);
+static advconfig_string_factory_MT cfg_http_fixtures_directory("Fixture directory", GUID_ADVCONFIG_HTTP_FIXTURES_DIRECTORY, GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES, 3.0, "");
+static advconfig_string_factory_MT cfg_http_standin_server("Send all requests to this local stand-in server instead (host:port)", GUID_ADVCONFIG_HTTP_STANDIN_SERVER, GUID_ADVCONFIG_BRANCH_HTTP_FIXTURES, 4.0, "");
+
+static advconfig_checkbox_factory cfg_scraper_page_disk_cache("Keep scraped album pages in the profile directory between sessions", GUID_ADVCONFIG_SCRAPER_PAGE_DISK_CACHE, GUID_ADVCONFIG_BRANCH, 1.0, false);
+static advconfig_checkbox_factory cfg_musixmatch_macro_search("Search Musixmatch with a single request that also returns the lyrics", GUID_ADVCONFIG_MUSIXMATCH_MACRO_SEARCH, GUID_ADVCONFIG_BRANCH, 2.0, false);
+static advconfig_integer_factory cfg_bulk_search_concurrency("Number of tracks to search for at once during a bulk search", GUID_ADVCONFIG_BULK_SEARCH_CONCURRENCY, GUID_ADVCONFIG_BRANCH, 3.0, 4, 1, 16);
+
+static advconfig_integer_factory cfg_musixmatch_concurrent_lookups("Musixmatch", GUID_ADVCONFIG_MUSIXMATCH_CONCURRENT_LOOKUPS, GUID_ADVCONFIG_BRANCH_CONCURRENT_LOOKUPS, 0.0, 2, 1, 8);
+static advconfig_integer_factory cfg_netease_concurrent_lookups("NetEase Online Music", GUID_ADVCONFIG_NETEASE_CONCURRENT_LOOKUPS, GUID_ADVCONFIG_BRANCH_CONCURRENT_LOOKUPS, 1.0, 4, 1, 8);
+static advconfig_integer_factory cfg_qqmusic_concurrent_lookups("QQ Music", GUID_ADVCONFIG_QQMUSIC_CONCURRENT_LOOKUPS, GUID_ADVCONFIG_BRANCH_CONCURRENT_LOOKUPS, 2.0, 4, 1, 8);
+
+HttpFixtureMode preferences::advanced::http_fixture_mode()
+{
+    if(cfg_http_fixtures_record.get())
+    {
+        return HttpFixtureMode::Record;
+    }
+    else if(cfg_http_fixtures_replay.get())
+    {
+        return HttpFixtureMode::Replay;
+    }
+    else
+    {
+        return HttpFixtureMode::Disabled;
+    }
+}
+
+std::string preferences::advanced::http_fixture_directory()
+{
+    pfc::string8 result;
+    cfg_http_fixtures_directory.get(result);
+    return std::string(result.c_str(), result.length());
+}
+
+std::string preferences::advanced::http_standin_server()
+{
+    pfc::string8 result;
+    cfg_http_standin_server.get(result);
+    return std::string(result.c_str(), result.length());
+}
+
+bool preferences::advanced::scraper_page_disk_cache()
+{
+    return cfg_scraper_page_disk_cache.get();
+}
+
+bool preferences::advanced::musixmatch_macro_search()
+{
+    return cfg_musixmatch_macro_search.get();
+}
+
+size_t preferences::advanced::bulk_search_concurrency()
+{
+    return size_t(cfg_bulk_search_concurrency.get());
+}
+
+size_t preferences::advanced::musixmatch_concurrent_lookups()
+{
+    return size_t(cfg_musixmatch_concurrent_lookups.get());
+}
+
+size_t preferences::advanced::netease_concurrent_lookups()
+{
+    return size_t(cfg_netease_concurrent_lookups.get());
+}
+
+size_t preferences::advanced::qqmusic_concurrent_lookups()
+{
+    return size_t(cfg_qqmusic_concurrent_lookups.get());
+}
@@ -1,543 +1,989 @@
-#include "stdafx.h"
-
-#include "logging.h"
-#include "lyric_auto_edit.h"
-#include "lyric_data.h"
-#include "lyric_io.h"
-#include "metadb_index_search_avoidance.h"
-#include "parsers.h"
-#include "sources/lyric_source.h"
-#include "ui_hooks.h"
-#include "win32_util.h"
-
-std::string io::save_lyrics(metadb_handle_ptr track, const LyricData& lyrics, bool allow_overwrite, abort_callback& abort)
-{
-    // NOTE: We require that saving happens on the main thread because the ID3 tag updates can
-    //       only happen on the main thread.
-    core_api::ensure_main_thread();
-
-    std::string output_path;
-
-    LyricSourceBase* source = LyricSourceBase::get(preferences::saving::save_source());
-    if(source != nullptr)
-    {
-        std::string text;
-        if(lyrics.IsTimestamped())
-        {
-            text = parsers::lrc::shrink_text(lyrics);
-        }
-        else
-        {
-            text = lyrics.text;
-        }
-
-        try
-        {
-            output_path = source->save(track, lyrics.IsTimestamped(), text, allow_overwrite, abort);
-        }
-        catch(const std::exception& e)
-        {
-            std::string source_name = from_tstring(source->friendly_name());
-            LOG_ERROR("Failed to save lyrics to %s: %s", source_name.c_str(), e.what());
-        }
-    }
-
-    return output_path;
-}
-
-static void ensure_windows_newlines(std::string& str)
-{
-    int replace_count = 0;
-    size_t prev_index = 0;
-    while(true)
-    {
-        size_t next_index = str.find('\n', prev_index);
-        if(next_index == pfc::infinite_size)
-        {
-            break;
-        }
-
-        if((next_index == 0) || (str[next_index-1] != '\r'))
-        {
-            char cr = '\r';
-            str.insert(next_index, 1, cr);
-            replace_count++;
-        }
-
-        prev_index = next_index+1;
-    }
-}
-
-static void internal_search_for_lyrics(LyricUpdateHandle& handle, bool local_only)
-{
-    LOG_INFO("Searching for lyrics...");
-    handle.set_started();
-
-    LyricDataRaw lyric_data_raw = {};
-    for(GUID source_id : preferences::searching::active_sources())
-    {
-        LyricSourceBase* source = LyricSourceBase::get(source_id);
-        assert(source != nullptr);
-
-        std::string friendly_name = from_tstring(source->friendly_name());
-        if(local_only && !source->is_local())
-        {
-            LOG_INFO("Current search is only considering local sources and %s is not marked as local, skipping...", friendly_name.c_str());
-            continue;
-        }
-        handle.set_progress("Searching " + friendly_name + "...");
-
-        try
-        {
-            std::vector<LyricDataRaw> search_results = source->search(handle.get_track(), handle.get_checked_abort());
-
-            std::string tag_artist = track_metadata(handle.get_track(), "artist");
-            std::string tag_album = track_metadata(handle.get_track(), "album");
-            std::string tag_title = track_metadata(handle.get_track(), "title");
-            for(LyricDataRaw& result : search_results)
-            {
-                // NOTE: Some sources don't return an album so we ignore album data if the source didn't give us any
-                bool tag_match = (result.album.empty() || tag_values_match(tag_album, result.album)) &&
-                                 tag_values_match(tag_artist, result.artist) &&
-                                 tag_values_match(tag_title, result.title);
-                if(!tag_match)
-                {
-                    LOG_INFO("Rejected %s search result %s/%s/%s due to tag mismatch: %s/%s/%s",
-                            friendly_name.c_str(),
-                            tag_artist.c_str(),
-                            tag_album.c_str(),
-                            tag_title.c_str(),
-                            result.artist.c_str(),
-                            result.album.c_str(),
-                            result.title.c_str());
-                    continue;
-                }
-
-                assert(result.source_id == source_id);
-                if(result.lookup_id.empty())
-                {
-                    assert(!result.text.empty());
-                    lyric_data_raw = std::move(result);
-                    LOG_INFO("Successfully retrieved lyrics from source: %s", friendly_name.c_str());
-                    break;
-                }
-                else
-                {
-                    bool lyrics_found = source->lookup(result, handle.get_checked_abort());
-                    if(lyrics_found)
-                    {
-                        if(result.text.empty())
-                        {
-                            LOG_WARN("Received illegal empty success result from source: %s", friendly_name.c_str());
-                            assert(!result.text.empty());
-                            continue;
-                        }
-
-                        lyric_data_raw = std::move(result);
-                        LOG_INFO("Successfully looked-up lyrics from source: %s", friendly_name.c_str());
-                        break;
-                    }
-                    else
-                    {
-                        LOG_INFO("Look up for lyrics from source %s returned an empty result, ignoring...", friendly_name.c_str());
-                    }
-                }
-            }
-        }
-        catch(const std::exception& e)
-        {
-            LOG_ERROR("Error while searching %s: %s", friendly_name.c_str(), e.what());
-        }
-        catch(...)
-        {
-            LOG_ERROR("Error of unrecognised type while searching %s", friendly_name.c_str());
-        }
-
-        if(!lyric_data_raw.text.empty())
-        {
-            break;
-        }
-        LOG_INFO("Failed to retrieve lyrics from source: %s", friendly_name.c_str());
-    }
-    ensure_windows_newlines(lyric_data_raw.text);
-
-    LOG_INFO("Parsing lyrics text...");
-    handle.set_progress("Parsing...");
-    LyricData lyric_data = parsers::lrc::parse(lyric_data_raw);
-
-    if(lyric_data.IsEmpty())
-    {
-        lyric_search_avoidance avoidance = load_search_avoidance(handle.get_track());
-        avoidance.search_config_generation = preferences::searching::source_config_generation();
-        if(avoidance.first_fail_time == 0)
-        {
-            avoidance.first_fail_time = filetimestamp_from_system_timer();
-        }
-        if(avoidance.failed_searches < INT_MAX)
-        {
-            avoidance.failed_searches++;
-        }
-        save_search_avoidance(handle.get_track(), avoidance);
-    }
-
-    handle.set_result(std::move(lyric_data), true);
-    LOG_INFO("Lyric loading complete");
-}
-
-void io::search_for_lyrics(LyricUpdateHandle& handle, bool local_only)
-{
-    fb2k::splitTask([&handle, local_only](){
-        internal_search_for_lyrics(handle, local_only);
-    });
-}
-
-static void internal_search_for_all_lyrics_from_source(LyricUpdateHandle& handle, LyricSourceBase* source, std::string artist, std::string album, std::string title)
-{
-    std::string friendly_name = from_tstring(source->friendly_name());
-    handle.set_started();
-
-    try
-    {
-        std::vector<LyricDataRaw> search_results;
-        if(source->is_local())
-        {
-            search_results = source->search(handle.get_track(), handle.get_checked_abort());
-        }
-        else
-        {
-            LyricSourceRemote* remote_source = dynamic_cast<LyricSourceRemote*>(source);
-            assert(remote_source != nullptr);
-            if(remote_source == nullptr)
-            {
-                LOG_ERROR("Bad LyricSourceRemote cast for: %s", friendly_name.c_str());
-                handle.set_complete();
-                return;
-            }
-
-            search_results = remote_source->search(artist, album, title, handle.get_checked_abort());
-        }
-
-        for(LyricDataRaw& result : search_results)
-        {
-            assert(result.source_id == source->id());
-
-            std::optional<LyricDataRaw> lyric;
-            if(result.lookup_id.empty())
-            {
-                assert(!result.text.empty());
-                lyric = std::move(result);
-            }
-            else
-            {
-                bool lyrics_found = source->lookup(result, handle.get_checked_abort());
-                if(lyrics_found)
-                {
-                    assert(!result.text.empty());
-                    lyric = std::move(result);
-                }
-            }
-
-            if(lyric.has_value())
-            {
-                ensure_windows_newlines(lyric.value().text);
-
-                LyricData parsed_lyrics = parsers::lrc::parse(lyric.value());
-                handle.set_result(std::move(parsed_lyrics), false);
-            }
-        }
-    }
-    catch(const std::exception& e)
-    {
-        LOG_ERROR("Error while searching %s: %s", friendly_name.c_str(), e.what());
-    }
-    catch(...)
-    {
-        LOG_ERROR("Error of unrecognised type while searching %s", friendly_name.c_str());
-    }
-
-    handle.set_complete();
-}
-
-static void internal_search_for_all_lyrics(LyricUpdateHandle& handle, std::string artist, std::string album, std::string title)
-{
-    LOG_INFO("Searching for lyrics using custom parameters...");
-    handle.set_started();
-
-    // NOTE: It is crucial that this is a std::list so that inserting new items or removing old ones
-    //       does not re-allocate the entire list and invalidate earlier pointers. We pass references
-    //       to these handles into the search task and so they need to remain valid for the task's
-    //       entire lifetime or we'll get weird random-memory bugs.
-    std::list<LyricUpdateHandle> source_handles;
-
-    std::vector<GUID> all_source_ids = LyricSourceBase::get_all_ids();
-    for(GUID source_id : all_source_ids)
-    {
-        LyricSourceBase* source = LyricSourceBase::get(source_id);
-        assert(source != nullptr);
-
-        source_handles.emplace_back(handle.get_type(), handle.get_track(), handle.get_checked_abort());
-        LyricUpdateHandle& src_handle = source_handles.back();
-
-        fb2k::splitTask([&src_handle, source, artist, album, title](){
-            internal_search_for_all_lyrics_from_source(src_handle, source, artist, album, title);
-        });
-    }
-
-    while(!source_handles.empty())
-    {
-        for(auto iter=source_handles.begin(); iter!=source_handles.end(); /*omitted*/)
-        {
-            LyricUpdateHandle& src_handle = *iter;
-            while(src_handle.has_result())
-            {
-                handle.set_result(src_handle.get_result(), false);
-            }
-
-            bool is_complete = src_handle.wait_for_complete(100);
-            if(is_complete)
-            {
-                iter = source_handles.erase(iter);
-            }
-            else
-            {
-                iter++;
-            }
-        }
-    }
-
-    handle.set_complete();
-    LOG_INFO("Finished loading lyrics from a custom search");
-}
-
-void io::search_for_all_lyrics(LyricUpdateHandle& handle, std::string artist, std::string album, std::string title)
-{
-    fb2k::splitTask([&handle, artist, album, title](){
-        internal_search_for_all_lyrics(handle, artist, album, title);
-    });
-}
-
-std::optional<LyricData> io::process_available_lyric_update(LyricUpdateHandle& update)
-{
-    if(!update.has_result())
-    {
-        LOG_INFO("Received lyric update with no results, ignoring...");
-        return {};
-    }
-
-    assert(update.has_result());
-    LyricData lyrics = update.get_result();
-
-    if(lyrics.IsEmpty())
-    {
-        LOG_INFO("Received empty lyric update, ignoring...");
-        return {};
-    }
-
-    AutoSaveStrategy autosave = preferences::saving::autosave_strategy();
-    bool should_autosave = (autosave == AutoSaveStrategy::Always) ||
-                           ((autosave == AutoSaveStrategy::OnlySynced) && lyrics.IsTimestamped()) ||
-                           ((autosave == AutoSaveStrategy::OnlyUnsynced) && !lyrics.IsTimestamped());
-
-    bool user_requested = (update.get_type() == LyricUpdateHandle::Type::Edit) || (update.get_type() == LyricUpdateHandle::Type::ManualSearch);
-
-    LyricSourceBase* source = LyricSourceBase::get(lyrics.source_id);
-    bool loaded_from_local_src = ((source != nullptr) && source->is_local());
-
-    // NOTE: We previously changed this to:
-    //       `should_autosave && (is_edit || !loaded_from_local_src)`
-    //       This makes all the behaviour consistent in the sense that the *only* time it will
-    //       save if you set auto-save to "never" is when you explicitly click the "Save" button
-    //       in the context menu. However as a user pointed out (here: https://github.com/jacquesh/foo_openlyrics/issues/18)
-    //       this doesn't really make sense. If you make an edit then you almost certainly want
-    //       to save your edits (and if you just made them then you can always undo them).
-    const bool should_save = user_requested || (should_autosave && !loaded_from_local_src); // Don't save to the source we just loaded from
-    if(should_save)
-    {
-        try
-        {
-            bool was_search = (update.get_type() == LyricUpdateHandle::Type::AutoSearch) || (update.get_type() == LyricUpdateHandle::Type::ManualSearch);
-            if(was_search && (source != nullptr) && !source->is_local())
-            {
-                for(AutoEditType type : preferences::editing::automated_auto_edits())
-                {
-                    std::optional<LyricData> maybe_lyrics = auto_edit::RunAutoEdit(type, lyrics);
-                    if(maybe_lyrics.has_value())
-                    {
-                        lyrics = std::move(maybe_lyrics.value());
-                    }
-                }
-            }
-
-            const bool allow_overwrite = user_requested;
-            lyrics.persistent_storage_path = io::save_lyrics(update.get_track(), lyrics, allow_overwrite, update.get_checked_abort());
-        }
-        catch(const std::exception& e)
-        {
-            LOG_ERROR("Failed to save downloaded lyrics: %s", e.what());
-        }
-    }
-
-    return {std::move(lyrics)};
-}
-
-LyricUpdateHandle::LyricUpdateHandle(Type type, metadb_handle_ptr track, abort_callback& abort) :
-    m_track(track),
-    m_type(type),
-    m_mutex({}),
-    m_lyrics(),
-    m_abort(abort),
-    m_complete(nullptr),
-    m_status(Status::Created),
-    m_progress()
-{
-    InitializeCriticalSection(&m_mutex);
-    m_complete = CreateEvent(nullptr, TRUE, FALSE, nullptr);
-    assert(m_complete != nullptr);
-}
-
-LyricUpdateHandle::LyricUpdateHandle(LyricUpdateHandle&& other) :
-    m_track(other.m_track),
-    m_type(other.m_type),
-    m_mutex(),
-    m_lyrics(std::move(other.m_lyrics)),
-    m_abort(other.m_abort),
-    m_complete(nullptr),
-    m_status(other.m_status),
-    m_progress(std::move(other.m_progress))
-{
-    other.m_status = Status::Closed;
-    InitializeCriticalSection(&m_mutex);
-
-    BOOL event_set = other.is_complete();
-    m_complete = CreateEvent(nullptr, TRUE, event_set, nullptr);
-    assert(m_complete != nullptr);
-}
-
-LyricUpdateHandle::~LyricUpdateHandle()
-{
-    DWORD wait_result = WaitForSingleObject(m_complete, 30'000);
-    while(wait_result != WAIT_OBJECT_0)
-    {
-        LOG_ERROR("Lyric search did not complete successfully during cleanup: %d", wait_result);
-        assert(wait_result == WAIT_OBJECT_0);
-
-        wait_result = WaitForSingleObject(m_complete, 30'000);
-    }
-    CloseHandle(m_complete);
-    DeleteCriticalSection(&m_mutex);
-}
-
-LyricUpdateHandle::Type LyricUpdateHandle::get_type()
-{
-    return m_type;
-}
-
-std::string LyricUpdateHandle::get_progress()
-{
-    EnterCriticalSection(&m_mutex);
-    std::string result = m_progress;
-    LeaveCriticalSection(&m_mutex);
-    return result;
-}
-
-bool LyricUpdateHandle::is_complete()
-{
-    EnterCriticalSection(&m_mutex);
-    bool complete = ((m_status == Status::Complete) || (m_status == Status::Closed));
-    LeaveCriticalSection(&m_mutex);
-    return complete;
-}
-
-bool LyricUpdateHandle::wait_for_complete(uint32_t timeout_ms)
-{
-    DWORD wait_result = WaitForSingleObject(m_complete, timeout_ms);
-    return (wait_result == WAIT_OBJECT_0);
-}
-
-bool LyricUpdateHandle::has_result()
-{
-    EnterCriticalSection(&m_mutex);
-    bool output = !m_lyrics.empty();
-    LeaveCriticalSection(&m_mutex);
-    return output;
-}
-
-LyricData LyricUpdateHandle::get_result()
-{
-    EnterCriticalSection(&m_mutex);
-    assert(!m_lyrics.empty());
-    LyricData result = std::move(m_lyrics.front());
-    m_lyrics.erase(m_lyrics.begin());
-    if(m_lyrics.empty() && (m_status == Status::Complete))
-    {
-        m_status = Status::Closed;
-    }
-    LeaveCriticalSection(&m_mutex);
-    return result;
-}
-
-abort_callback& LyricUpdateHandle::get_checked_abort()
-{
-    m_abort.check();
-    return m_abort;
-}
-
-metadb_handle_ptr LyricUpdateHandle::get_track()
-{
-    return m_track;
-}
-
-void LyricUpdateHandle::set_started()
-{
-    EnterCriticalSection(&m_mutex);
-    assert(m_status == Status::Created);
-    m_status = Status::Running;
-    LeaveCriticalSection(&m_mutex);
-}
-
-void LyricUpdateHandle::set_progress(std::string_view value)
-{
-    EnterCriticalSection(&m_mutex);
-    assert(m_status == Status::Running);
-    m_progress = value;
-    LeaveCriticalSection(&m_mutex);
-
-    repaint_all_lyric_panels();
-}
-
-void LyricUpdateHandle::set_result(LyricData&& data, bool final_result)
-{
-    EnterCriticalSection(&m_mutex);
-    assert(m_status == Status::Running);
-    m_lyrics.push_back(std::move(data));
-
-    if(final_result)
-    {
-        m_status = Status::Complete;
-        BOOL complete_success = SetEvent(m_complete);
-        assert(complete_success);
-    }
-    LeaveCriticalSection(&m_mutex);
-
-    repaint_all_lyric_panels();
-}
-
-void LyricUpdateHandle::set_complete()
-{
-    EnterCriticalSection(&m_mutex);
-    assert(m_status == Status::Running);
-
-    if(m_lyrics.empty())
-    {
-        m_status = Status::Closed;
-    }
-    else
-    {
-        m_status = Status::Complete;
-    }
-    BOOL complete_success = SetEvent(m_complete);
-    assert(complete_success);
-
-    LeaveCriticalSection(&m_mutex);
-}
-
+#include "stdafx.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "logging.h"
+#include "lyric_auto_edit.h"
+#include "lyric_data.h"
+#include "lyric_io.h"
+#include "metadb_index_lyric_status.h"
+#include "metadb_index_search_avoidance.h"
+#include "parsers.h"
+#include "sources/lyric_source.h"
+#include "ui_hooks.h"
+#include "win32_util.h"
+
+std::string io::save_lyrics(metadb_handle_ptr track, const LyricData& lyrics, bool allow_overwrite, abort_callback& abort)
+{
+    std::string output_path;
+
+    LyricSourceBase* source = LyricSourceBase::get(preferences::saving::save_source());
+    if(source != nullptr)
+    {
+        // NOTE: Some sources (e.g ID3 tags) can only save on the main thread because the metadata
+        //       updates that they make can only happen on the main thread.
+        if(source->save_requires_main_thread())
+        {
+            core_api::ensure_main_thread();
+        }
+
+        std::string text;
+        if(lyrics.IsTimestamped())
+        {
+            text = parsers::lrc::shrink_text(lyrics);
+        }
+        else
+        {
+            text = lyrics.text;
+        }
+
+        try
+        {
+            output_path = source->save(track, lyrics.IsTimestamped(), text, allow_overwrite, abort);
+            if(!output_path.empty())
+            {
+                save_lyric_status(track, lyrics, source->id(), output_path);
+            }
+        }
+        catch(const std::exception& e)
+        {
+            std::string source_name = from_tstring(source->friendly_name());
+            LOG_ERROR("Failed to save lyrics to %s: %s", source_name.c_str(), e.what());
+        }
+    }
+
+    return output_path;
+}
+
+static void ensure_windows_newlines(std::string& str)
+{
+    int replace_count = 0;
+    size_t prev_index = 0;
+    while(true)
+    {
+        size_t next_index = str.find('\n', prev_index);
+        if(next_index == pfc::infinite_size)
+        {
+            break;
+        }
+
+        if((next_index == 0) || (str[next_index-1] != '\r'))
+        {
+            char cr = '\r';
+            str.insert(next_index, 1, cr);
+            replace_count++;
+        }
+
+        prev_index = next_index+1;
+    }
+}
+
+enum class LookupStatus
+{
+    Pending,
+    Running,
+    Found,
+    NotFound,
+    Failed,
+};
+
+// Looks up the given search results (which must all come from the given source), with up to the source's
+// maximum number of lookups in flight at once. Lookups are started in the order that the source returned them.
+// If `first_only` is set then `on_found` is called at most once, for the earliest result (in the source's order)
+// that had lyrics, and every other lookup is cancelled as soon as that result is known. As with a serial lookup,
+// an error from an earlier result is rethrown instead of returning a later result.
+// Otherwise `on_found` is called for every result that had lyrics, in whatever order the lookups complete.
+// `on_found` is always called on the calling thread.
+static void lookup_search_results(LyricSourceBase* source,
+                                  const SearchContext& context,
+                                  std::vector<LyricDataRaw>& results,
+                                  bool first_only,
+                                  abort_callback& abort,
+                                  std::function<void(LyricDataRaw&)> on_found)
+{
+    const std::string friendly_name = from_tstring(source->friendly_name());
+
+    std::mutex lock;
+    std::condition_variable status_changed;
+    std::vector<LookupStatus> status(results.size(), LookupStatus::Pending);
+    std::vector<std::exception_ptr> errors(results.size());
+    size_t next_index = 0;
+    size_t lookup_limit = results.size(); // No lookups will be started for results at or after this index
+    size_t lookups_needed = 0;
+    for(size_t i=0; i<results.size(); i++)
+    {
+        if(results[i].lookup_id.empty())
+        {
+            assert(!results[i].text.empty());
+            status[i] = LookupStatus::Found;
+        }
+        else
+        {
+            lookups_needed++;
+        }
+    }
+
+    // NOTE: The lookups are given their own abort callback so that we can cancel the ones that are still in flight
+    //       once we know that we won't need their results, without aborting the rest of the search.
+    abort_callback_impl lookup_abort;
+    auto lookup_worker = [&]()
+    {
+        while(true)
+        {
+            size_t index = 0;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                while((next_index < lookup_limit) && (status[next_index] != LookupStatus::Pending))
+                {
+                    next_index++;
+                }
+                if(next_index >= lookup_limit)
+                {
+                    return;
+                }
+                index = next_index++;
+                status[index] = LookupStatus::Running;
+            }
+
+            LookupStatus result_status = LookupStatus::NotFound;
+            std::exception_ptr error;
+            try
+            {
+                bool lyrics_found = source->lookup(context, results[index], lookup_abort);
+                if(!lyrics_found)
+                {
+                    LOG_INFO("Look up for lyrics from source %s returned an empty result, ignoring...", friendly_name.c_str());
+                }
+                else if(results[index].text.empty())
+                {
+                    LOG_WARN("Received illegal empty success result from source: %s", friendly_name.c_str());
+                    assert(!results[index].text.empty());
+                }
+                else
+                {
+                    result_status = LookupStatus::Found;
+                }
+            }
+            catch(...)
+            {
+                result_status = LookupStatus::Failed;
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                status[index] = result_status;
+                errors[index] = error;
+                if(first_only && (result_status == LookupStatus::Found))
+                {
+                    // NOTE: Results after this one can never be chosen, so there's no point looking them up
+                    lookup_limit = min(lookup_limit, index);
+                }
+            }
+            status_changed.notify_all();
+        }
+    };
+
+    const size_t worker_count = min(max(source->max_concurrent_lookups(), size_t(1)), lookups_needed);
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for(size_t i=0; i<worker_count; i++)
+    {
+        workers.emplace_back(lookup_worker);
+    }
+
+    std::optional<size_t> first_found;
+    std::exception_ptr first_error;
+    std::vector<bool> delivered(results.size(), false);
+    std::unique_lock<std::mutex> guard(lock);
+    while(!abort.is_aborting())
+    {
+        bool all_complete = true;
+        if(first_only)
+        {
+            for(size_t i=0; i<results.size(); i++)
+            {
+                if(status[i] == LookupStatus::NotFound)
+                {
+                    continue;
+                }
+
+                if(status[i] == LookupStatus::Found)
+                {
+                    first_found = i;
+                }
+                else if(status[i] == LookupStatus::Failed)
+                {
+                    first_error = errors[i];
+                }
+                else
+                {
+                    all_complete = false;
+                }
+                break;
+            }
+        }
+        else
+        {
+            for(size_t i=0; i<results.size(); i++)
+            {
+                if((status[i] == LookupStatus::Pending) || (status[i] == LookupStatus::Running))
+                {
+                    all_complete = false;
+                }
+                else if(!delivered[i])
+                {
+                    delivered[i] = true;
+                    if(status[i] == LookupStatus::Found)
+                    {
+                        guard.unlock();
+                        on_found(results[i]);
+                        guard.lock();
+                    }
+                    else if(status[i] == LookupStatus::Failed)
+                    {
+                        try
+                        {
+                            std::rethrow_exception(errors[i]);
+                        }
+                        catch(const std::exception& e)
+                        {
+                            LOG_ERROR("Error while looking up lyrics from %s: %s", friendly_name.c_str(), e.what());
+                        }
+                        catch(...)
+                        {
+                            LOG_ERROR("Error of unrecognised type while looking up lyrics from %s", friendly_name.c_str());
+                        }
+                    }
+                }
+            }
+        }
+
+        if(all_complete)
+        {
+            break;
+        }
+        status_changed.wait_for(guard, std::chrono::milliseconds(100));
+    }
+    lookup_limit = 0;
+    guard.unlock();
+
+    lookup_abort.abort();
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+
+    abort.check();
+    if(first_error)
+    {
+        std::rethrow_exception(first_error);
+    }
+    if(first_found.has_value())
+    {
+        on_found(results[first_found.value()]);
+    }
+}
+
+static void internal_search_for_lyrics(LyricUpdateHandle& handle, bool local_only, bool ignore_search_avoidance)
+{
+    LOG_INFO("Searching for lyrics...");
+    handle.set_started();
+
+    const SearchContext& context = handle.get_search_context();
+    const t_filetimestamp search_start_time = filetimestamp_from_system_timer();
+    lyric_search_avoidance avoidance = handle.get_search_avoidance();
+    bool avoidance_changed = false;
+    bool all_sources_searched = true; // Whether every active source was asked, and answered, without the search being aborted
+
+    LyricDataRaw lyric_data_raw = {};
+    for(GUID source_id : preferences::searching::active_sources())
+    {
+        LyricSourceBase* source = LyricSourceBase::get(source_id);
+        assert(source != nullptr);
+
+        std::string friendly_name = from_tstring(source->friendly_name());
+        if(local_only && !source->is_local())
+        {
+            LOG_INFO("Current search is only considering local sources and %s is not marked as local, skipping...", friendly_name.c_str());
+            all_sources_searched = false;
+            handle.set_had_errors();
+            continue;
+        }
+        if(!ignore_search_avoidance && !source->is_local() && !search_avoidance_allows_search(avoidance, source_id, search_start_time))
+        {
+            LOG_INFO("Skipping search of %s because it recently failed to find lyrics for this track and was not specifically requested", friendly_name.c_str());
+            all_sources_searched = false;
+            handle.set_had_errors();
+            continue;
+        }
+        handle.set_progress("Searching " + friendly_name + "...");
+
+        pfc::hires_timer source_timer;
+        source_timer.start();
+        bool search_completed = false;
+        try
+        {
+            std::vector<LyricDataRaw> search_results = source->search(context, handle.get_checked_abort());
+
+            std::vector<LyricDataRaw> candidates;
+            candidates.reserve(search_results.size());
+            for(LyricDataRaw& result : search_results)
+            {
+                // NOTE: Some sources don't return an album so we ignore album data if the source didn't give us any
+                bool tag_match = (result.album.empty() || tag_values_match(context.tag_album, result.album)) &&
+                                 tag_values_match(context.tag_artist, result.artist) &&
+                                 tag_values_match(context.tag_title, result.title);
+                if(!tag_match)
+                {
+                    LOG_INFO("Rejected %s search result %s/%s/%s due to tag mismatch: %s/%s/%s",
+                            friendly_name.c_str(),
+                            context.tag_artist.c_str(),
+                            context.tag_album.c_str(),
+                            context.tag_title.c_str(),
+                            result.artist.c_str(),
+                            result.album.c_str(),
+                            result.title.c_str());
+                    continue;
+                }
+
+                assert(result.source_id == source_id);
+                candidates.push_back(std::move(result));
+            }
+
+            lookup_search_results(source, context, candidates, true, handle.get_checked_abort(),
+                [&lyric_data_raw, &friendly_name](LyricDataRaw& result)
+                {
+                    lyric_data_raw = std::move(result);
+                    LOG_INFO("Successfully retrieved lyrics from source: %s", friendly_name.c_str());
+                });
+            search_completed = true;
+        }
+        catch(const std::exception& e)
+        {
+            LOG_ERROR("Error while searching %s: %s", friendly_name.c_str(), e.what());
+            handle.set_had_errors();
+        }
+        catch(...)
+        {
+            LOG_ERROR("Error of unrecognised type while searching %s", friendly_name.c_str());
+            handle.set_had_errors();
+        }
+        LOG_INFO("Search of %s took %.1fms", friendly_name.c_str(), source_timer.query()*1000.0);
+        all_sources_searched &= search_completed;
+
+        // NOTE: Sources throw if the search was aborted (e.g because the track changed), in which case
+        //       we stop without remembering anything about this search.
+        if(handle.is_aborting())
+        {
+            LOG_INFO("Search was aborted while searching %s", friendly_name.c_str());
+            all_sources_searched = false;
+            break;
+        }
+
+        // NOTE: We only back off from sources that told us they don't have lyrics for this track.
+        //       A source that threw (e.g because of a network error) might well succeed next time.
+        if(!source->is_local())
+        {
+            if(!lyric_data_raw.text.empty())
+            {
+                avoidance_changed |= search_avoidance_record_success(avoidance, source_id);
+            }
+            else if(search_completed)
+            {
+                search_avoidance_record_failure(avoidance, source_id, search_start_time);
+                avoidance_changed = true;
+            }
+        }
+
+        if(!lyric_data_raw.text.empty())
+        {
+            break;
+        }
+        LOG_INFO("Failed to retrieve lyrics from source: %s", friendly_name.c_str());
+    }
+
+    if(avoidance_changed)
+    {
+        save_search_avoidance(handle.get_track(), avoidance);
+    }
+    ensure_windows_newlines(lyric_data_raw.text);
+
+    LOG_INFO("Parsing lyrics text...");
+    handle.set_progress("Parsing...");
+    LyricData lyric_data = parsers::lrc::parse(lyric_data_raw);
+
+    // NOTE: Lyrics that we find from a remote source are only recorded in the lyric status once they are saved
+    //       (see io::save_lyrics) or once we know that they won't be (see take_available_lyric_update), since until
+    //       then we don't know whether or where they'll be stored. Lyrics from a local source are already stored,
+    //       and are never saved again, so we record them straight away. We only record that a track has no lyrics
+    //       if every source was asked and told us so, so that a search that was aborted, or that skipped
+    //       or failed to reach some sources, isn't mistaken for a confirmed miss.
+    LyricSourceBase* found_source = LyricSourceBase::get(lyric_data.source_id);
+    const bool found_locally = !lyric_data.IsEmpty() && (found_source != nullptr) && found_source->is_local();
+    if(found_locally || (lyric_data.IsEmpty() && all_sources_searched))
+    {
+        save_lyric_status(handle.get_track(), lyric_data, lyric_data.source_id, lyric_data.persistent_storage_path);
+    }
+
+    handle.set_result(std::move(lyric_data), true);
+    LOG_INFO("Lyric loading complete");
+}
+
+void io::search_for_lyrics(LyricUpdateHandle& handle, bool local_only, bool ignore_search_avoidance)
+{
+    fb2k::splitTask([&handle, local_only, ignore_search_avoidance](){
+        internal_search_for_lyrics(handle, local_only, ignore_search_avoidance);
+    });
+}
+
+static void internal_search_for_all_lyrics_from_source(LyricUpdateHandle& handle, LyricSourceBase* source)
+{
+    std::string friendly_name = from_tstring(source->friendly_name());
+    handle.set_started();
+
+    try
+    {
+        const SearchContext& context = handle.get_search_context();
+        std::vector<LyricDataRaw> search_results = source->search(context, handle.get_checked_abort());
+
+        for(const LyricDataRaw& result : search_results)
+        {
+            assert(result.source_id == source->id());
+        }
+
+        // NOTE: Results are passed on as soon as each lookup completes, so they appear in the dialog
+        //       in the order that the lookups complete rather than the order that the source gave them.
+        lookup_search_results(source, context, search_results, false, handle.get_checked_abort(),
+            [&handle](LyricDataRaw& lyric)
+            {
+                ensure_windows_newlines(lyric.text);
+
+                LyricData parsed_lyrics = parsers::lrc::parse(lyric);
+                handle.set_result(std::move(parsed_lyrics), false);
+            });
+    }
+    catch(const std::exception& e)
+    {
+        LOG_ERROR("Error while searching %s: %s", friendly_name.c_str(), e.what());
+    }
+    catch(...)
+    {
+        LOG_ERROR("Error of unrecognised type while searching %s", friendly_name.c_str());
+    }
+
+    handle.set_complete();
+}
+
+static void internal_search_for_all_lyrics(LyricUpdateHandle& handle, std::string artist, std::string album, std::string title)
+{
+    LOG_INFO("Searching for lyrics using custom parameters...");
+    handle.set_started();
+
+    // NOTE: It is crucial that this is a std::list so that inserting new items or removing old ones
+    //       does not re-allocate the entire list and invalidate earlier pointers. We pass references
+    //       to these handles into the search task and so they need to remain valid for the task's
+    //       entire lifetime or we'll get weird random-memory bugs.
+    std::list<LyricUpdateHandle> source_handles;
+
+    // NOTE: The custom search parameters apply to every source, so we only need one context for all of them
+    auto context = std::make_shared<const SearchContext>(handle.get_track(), artist, album, title);
+
+    std::vector<GUID> all_source_ids = LyricSourceBase::get_all_ids();
+    for(GUID source_id : all_source_ids)
+    {
+        LyricSourceBase* source = LyricSourceBase::get(source_id);
+        assert(source != nullptr);
+
+        source_handles.emplace_back(handle.get_type(), handle.get_track(), handle.get_checked_abort());
+        LyricUpdateHandle& src_handle = source_handles.back();
+        src_handle.set_search_context(context);
+
+        fb2k::splitTask([&src_handle, source](){
+            internal_search_for_all_lyrics_from_source(src_handle, source);
+        });
+    }
+
+    while(!source_handles.empty())
+    {
+        for(auto iter=source_handles.begin(); iter!=source_handles.end(); /*omitted*/)
+        {
+            LyricUpdateHandle& src_handle = *iter;
+            while(src_handle.has_result())
+            {
+                handle.set_result(src_handle.get_result(), false);
+            }
+
+            bool is_complete = src_handle.wait_for_complete(100);
+            if(is_complete)
+            {
+                iter = source_handles.erase(iter);
+            }
+            else
+            {
+                iter++;
+            }
+        }
+    }
+
+    handle.set_complete();
+    LOG_INFO("Finished loading lyrics from a custom search");
+}
+
+void io::search_for_all_lyrics(LyricUpdateHandle& handle, std::string artist, std::string album, std::string title)
+{
+    fb2k::splitTask([&handle, artist, album, title](){
+        internal_search_for_all_lyrics(handle, artist, album, title);
+    });
+}
+
+// The result of a lyric update, along with everything needed to process it without access to the update itself
+struct AvailableLyricUpdate
+{
+    LyricData lyrics;
+    metadb_handle_ptr track;
+    bool should_save;
+    bool run_auto_edits;
+    bool allow_overwrite;
+};
+
+static std::optional<AvailableLyricUpdate> take_available_lyric_update(LyricUpdateHandle& update)
+{
+    if(!update.has_result())
+    {
+        LOG_INFO("Received lyric update with no results, ignoring...");
+        return {};
+    }
+
+    assert(update.has_result());
+    LyricData lyrics = update.get_result();
+
+    if(lyrics.IsEmpty())
+    {
+        LOG_INFO("Received empty lyric update, ignoring...");
+        return {};
+    }
+
+    AutoSaveStrategy autosave = preferences::saving::autosave_strategy();
+    bool should_autosave = (autosave == AutoSaveStrategy::Always) ||
+                           ((autosave == AutoSaveStrategy::OnlySynced) && lyrics.IsTimestamped()) ||
+                           ((autosave == AutoSaveStrategy::OnlyUnsynced) && !lyrics.IsTimestamped());
+
+    bool user_requested = (update.get_type() == LyricUpdateHandle::Type::Edit) || (update.get_type() == LyricUpdateHandle::Type::ManualSearch);
+
+    LyricSourceBase* source = LyricSourceBase::get(lyrics.source_id);
+    bool loaded_from_local_src = ((source != nullptr) && source->is_local());
+
+    // NOTE: We previously changed this to:
+    //       `should_autosave && (is_edit || !loaded_from_local_src)`
+    //       This makes all the behaviour consistent in the sense that the *only* time it will
+    //       save if you set auto-save to "never" is when you explicitly click the "Save" button
+    //       in the context menu. However as a user pointed out (here: https://github.com/jacquesh/foo_openlyrics/issues/18)
+    //       this doesn't really make sense. If you make an edit then you almost certainly want
+    //       to save your edits (and if you just made them then you can always undo them).
+    const bool should_save = user_requested || (should_autosave && !loaded_from_local_src); // Don't save to the source we just loaded from
+    const bool was_search = (update.get_type() == LyricUpdateHandle::Type::AutoSearch) || (update.get_type() == LyricUpdateHandle::Type::ManualSearch);
+    const bool run_auto_edits = should_save && was_search && (source != nullptr) && !source->is_local();
+
+    // NOTE: Lyrics from a remote source that the auto-save strategy doesn't save would otherwise never be recorded
+    //       in the lyric status, so we record where they came from instead. Lyrics from local sources were
+    //       already recorded when they were found.
+    if(!should_save && !loaded_from_local_src)
+    {
+        save_lyric_status(update.get_track(), lyrics, lyrics.source_id, lyrics.persistent_storage_path);
+    }
+
+    return AvailableLyricUpdate{std::move(lyrics), update.get_track(), should_save, run_auto_edits, user_requested};
+}
+
+static void run_automated_auto_edits(LyricData& lyrics)
+{
+    for(AutoEditType type : preferences::editing::automated_auto_edits())
+    {
+        std::optional<LyricData> maybe_lyrics = auto_edit::RunAutoEdit(type, lyrics);
+        if(maybe_lyrics.has_value())
+        {
+            lyrics = std::move(maybe_lyrics.value());
+        }
+    }
+}
+
+// Returns true if the lyrics were saved successfully
+static bool save_available_lyric_update(AvailableLyricUpdate& update, abort_callback& abort)
+{
+    try
+    {
+        update.lyrics.persistent_storage_path = io::save_lyrics(update.track, update.lyrics, update.allow_overwrite, abort);
+        return !update.lyrics.persistent_storage_path.empty();
+    }
+    catch(const std::exception& e)
+    {
+        LOG_ERROR("Failed to save downloaded lyrics: %s", e.what());
+        return false;
+    }
+}
+
+std::optional<LyricData> io::process_available_lyric_update(LyricUpdateHandle& update, bool* save_failed)
+{
+    std::optional<AvailableLyricUpdate> maybe_update = take_available_lyric_update(update);
+    if(!maybe_update.has_value())
+    {
+        return {};
+    }
+
+    AvailableLyricUpdate& available = maybe_update.value();
+    if(available.should_save)
+    {
+        if(available.run_auto_edits)
+        {
+            run_automated_auto_edits(available.lyrics);
+        }
+        bool saved = false;
+        try
+        {
+            saved = save_available_lyric_update(available, update.get_checked_abort());
+        }
+        catch(const std::exception& e)
+        {
+            // NOTE: The update was aborted before we could start saving it
+            LOG_INFO("Skipped saving downloaded lyrics: %s", e.what());
+        }
+
+        if(save_failed != nullptr)
+        {
+            *save_failed = !saved;
+        }
+    }
+
+    return {std::move(available.lyrics)};
+}
+
+// NOTE: Lyric updates are processed (and saved) by a single worker, one at a time and in the order that they
+//       became available. Saving lyrics for the same track on several threads at once could leave either version
+//       on disk (or interleave their tag updates), whereas processing them in order means that the most recent
+//       update for a track is always the one that is kept. The worker only runs while there are updates queued.
+struct LyricProcessingQueue
+{
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+    bool worker_running = false;
+};
+static LyricProcessingQueue g_processing_queue;
+
+static void enqueue_lyric_processing(std::function<void()> task)
+{
+    std::lock_guard<std::mutex> guard(g_processing_queue.lock);
+    g_processing_queue.tasks.push_back(std::move(task));
+    if(g_processing_queue.worker_running)
+    {
+        return;
+    }
+
+    g_processing_queue.worker_running = true;
+    fb2k::splitTask([]()
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> task_guard(g_processing_queue.lock);
+                if(g_processing_queue.tasks.empty())
+                {
+                    g_processing_queue.worker_running = false;
+                    return;
+                }
+                task = std::move(g_processing_queue.tasks.front());
+                g_processing_queue.tasks.pop_front();
+            }
+
+            try
+            {
+                task();
+            }
+            catch(const std::exception& e)
+            {
+                LOG_ERROR("Failed to process lyric update: %s", e.what());
+            }
+        }
+    });
+}
+
+bool io::process_available_lyric_update_async(LyricUpdateHandle& update, std::function<void(LyricData&&)> on_processed)
+{
+    core_api::ensure_main_thread();
+
+    std::optional<AvailableLyricUpdate> maybe_update = take_available_lyric_update(update);
+    if(!maybe_update.has_value())
+    {
+        return false;
+    }
+
+    // NOTE: The update handle may be destroyed as soon as we return, so everything we need from it was taken above.
+    //       For the same reason we can't use its abort callback and we don't abort saves once they've started.
+    enqueue_lyric_processing([available = std::move(maybe_update.value()), on_processed = std::move(on_processed)]() mutable
+    {
+        pfc::hires_timer background_timer;
+        background_timer.start();
+        if(available.should_save && available.run_auto_edits)
+        {
+            run_automated_auto_edits(available.lyrics);
+        }
+
+        LyricSourceBase* save_source = LyricSourceBase::get(preferences::saving::save_source());
+        const bool save_on_main_thread = (save_source != nullptr) && save_source->save_requires_main_thread();
+        if(available.should_save && !save_on_main_thread)
+        {
+            save_available_lyric_update(available, fb2k::noAbort);
+        }
+        const double background_ms = background_timer.query()*1000.0;
+
+        fb2k::inMainThread2([available = std::move(available), on_processed = std::move(on_processed), save_on_main_thread, background_ms]() mutable
+        {
+            pfc::hires_timer main_thread_timer;
+            main_thread_timer.start();
+            if(available.should_save && save_on_main_thread)
+            {
+                save_available_lyric_update(available, fb2k::noAbort);
+            }
+            on_processed(std::move(available.lyrics));
+
+            // NOTE: Only the main thread time blocks drawing. Comparing these times with the maximum paint
+            //       time in the panel's frame stats shows whether any part of processing still stalls it.
+            LOG_INFO("Processing a lyric update took %.1fms in the background and %.1fms on the main thread",
+                     background_ms,
+                     main_thread_timer.query()*1000.0);
+        });
+    });
+    return true;
+}
+
+LyricUpdateHandle::LyricUpdateHandle(Type type, metadb_handle_ptr track, abort_callback& abort) :
+    m_track(track),
+    m_type(type),
+    m_search_context(),
+    m_search_avoidance(),
+    m_mutex({}),
+    m_lyrics(),
+    m_abort(abort),
+    m_complete(nullptr),
+    m_status(Status::Created),
+    m_progress(),
+    m_had_errors(false)
+{
+    InitializeCriticalSection(&m_mutex);
+    m_complete = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    assert(m_complete != nullptr);
+}
+
+LyricUpdateHandle::LyricUpdateHandle(LyricUpdateHandle&& other) :
+    m_track(other.m_track),
+    m_type(other.m_type),
+    m_search_context(std::move(other.m_search_context)),
+    m_search_avoidance(std::move(other.m_search_avoidance)),
+    m_mutex(),
+    m_lyrics(std::move(other.m_lyrics)),
+    m_abort(other.m_abort),
+    m_complete(nullptr),
+    m_status(other.m_status),
+    m_progress(std::move(other.m_progress)),
+    m_had_errors(other.m_had_errors)
+{
+    other.m_status = Status::Closed;
+    InitializeCriticalSection(&m_mutex);
+
+    BOOL event_set = other.is_complete();
+    m_complete = CreateEvent(nullptr, TRUE, event_set, nullptr);
+    assert(m_complete != nullptr);
+}
+
+LyricUpdateHandle::~LyricUpdateHandle()
+{
+    DWORD wait_result = WaitForSingleObject(m_complete, 30'000);
+    while(wait_result != WAIT_OBJECT_0)
+    {
+        LOG_ERROR("Lyric search did not complete successfully during cleanup: %d", wait_result);
+        assert(wait_result == WAIT_OBJECT_0);
+
+        wait_result = WaitForSingleObject(m_complete, 30'000);
+    }
+    CloseHandle(m_complete);
+    DeleteCriticalSection(&m_mutex);
+}
+
+LyricUpdateHandle::Type LyricUpdateHandle::get_type()
+{
+    return m_type;
+}
+
+std::string LyricUpdateHandle::get_progress()
+{
+    EnterCriticalSection(&m_mutex);
+    std::string result = m_progress;
+    LeaveCriticalSection(&m_mutex);
+    return result;
+}
+
+bool LyricUpdateHandle::is_complete()
+{
+    EnterCriticalSection(&m_mutex);
+    bool complete = ((m_status == Status::Complete) || (m_status == Status::Closed));
+    LeaveCriticalSection(&m_mutex);
+    return complete;
+}
+
+bool LyricUpdateHandle::wait_for_complete(uint32_t timeout_ms)
+{
+    DWORD wait_result = WaitForSingleObject(m_complete, timeout_ms);
+    return (wait_result == WAIT_OBJECT_0);
+}
+
+bool LyricUpdateHandle::has_result()
+{
+    EnterCriticalSection(&m_mutex);
+    bool output = !m_lyrics.empty();
+    LeaveCriticalSection(&m_mutex);
+    return output;
+}
+
+LyricData LyricUpdateHandle::get_result()
+{
+    EnterCriticalSection(&m_mutex);
+    assert(!m_lyrics.empty());
+    LyricData result = std::move(m_lyrics.front());
+    m_lyrics.erase(m_lyrics.begin());
+    if(m_lyrics.empty() && (m_status == Status::Complete))
+    {
+        m_status = Status::Closed;
+    }
+    LeaveCriticalSection(&m_mutex);
+    return result;
+}
+
+bool LyricUpdateHandle::had_errors()
+{
+    EnterCriticalSection(&m_mutex);
+    bool result = m_had_errors;
+    LeaveCriticalSection(&m_mutex);
+    return result;
+}
+
+bool LyricUpdateHandle::is_aborting()
+{
+    return m_abort.is_aborting();
+}
+
+abort_callback& LyricUpdateHandle::get_checked_abort()
+{
+    m_abort.check();
+    return m_abort;
+}
+
+metadb_handle_ptr LyricUpdateHandle::get_track()
+{
+    return m_track;
+}
+
+const SearchContext& LyricUpdateHandle::get_search_context()
+{
+    EnterCriticalSection(&m_mutex);
+    if(m_search_context == nullptr)
+    {
+        m_search_context = std::make_shared<const SearchContext>(m_track);
+    }
+    const SearchContext& result = *m_search_context;
+    LeaveCriticalSection(&m_mutex);
+    return result;
+}
+
+void LyricUpdateHandle::set_search_context(std::shared_ptr<const SearchContext> context)
+{
+    EnterCriticalSection(&m_mutex);
+    assert(m_search_context == nullptr);
+    m_search_context = std::move(context);
+    LeaveCriticalSection(&m_mutex);
+}
+
+lyric_search_avoidance LyricUpdateHandle::get_search_avoidance()
+{
+    EnterCriticalSection(&m_mutex);
+    std::optional<lyric_search_avoidance> result = m_search_avoidance;
+    LeaveCriticalSection(&m_mutex);
+
+    // NOTE: We don't hold the lock while loading, because it reads from the metadb index
+    if(!result.has_value())
+    {
+        result = load_search_avoidance(m_track);
+    }
+    return std::move(result.value());
+}
+
+void LyricUpdateHandle::set_search_avoidance(lyric_search_avoidance avoidance)
+{
+    EnterCriticalSection(&m_mutex);
+    m_search_avoidance = std::move(avoidance);
+    LeaveCriticalSection(&m_mutex);
+}
+
+void LyricUpdateHandle::set_started()
+{
+    EnterCriticalSection(&m_mutex);
+    assert(m_status == Status::Created);
+    m_status = Status::Running;
+    LeaveCriticalSection(&m_mutex);
+}
+
+void LyricUpdateHandle::set_progress(std::string_view value)
+{
+    EnterCriticalSection(&m_mutex);
+    assert(m_status == Status::Running);
+    m_progress = value;
+    LeaveCriticalSection(&m_mutex);
+
+    repaint_all_lyric_panels();
+}
+
+void LyricUpdateHandle::set_result(LyricData&& data, bool final_result)
+{
+    EnterCriticalSection(&m_mutex);
+    assert(m_status == Status::Running);
+    m_lyrics.push_back(std::move(data));
+
+    if(final_result)
+    {
+        m_status = Status::Complete;
+        BOOL complete_success = SetEvent(m_complete);
+        assert(complete_success);
+    }
+    LeaveCriticalSection(&m_mutex);
+
+    repaint_all_lyric_panels();
+}
+
+void LyricUpdateHandle::set_had_errors()
+{
+    EnterCriticalSection(&m_mutex);
+    m_had_errors = true;
+    LeaveCriticalSection(&m_mutex);
+}
+
+void LyricUpdateHandle::set_complete()
+{
+    EnterCriticalSection(&m_mutex);
+    assert(m_status == Status::Running);
+
+    if(m_lyrics.empty())
+    {
+        m_status = Status::Closed;
+    }
+    else
+    {
+        m_status = Status::Complete;
+    }
+    BOOL complete_success = SetEvent(m_complete);
+    assert(complete_success);
+
+    LeaveCriticalSection(&m_mutex);
+}
+
@@ -1,73 +1,93 @@
-#pragma once
-
-#include "stdafx.h"
-
-#include "lyric_data.h"
-#include "tag_util.h"
-
-class LyricUpdateHandle;
-
-namespace io
-{
-    void search_for_lyrics(LyricUpdateHandle& handle, bool local_only);
-    void search_for_all_lyrics(LyricUpdateHandle& handle, std::string artist, std::string album, std::string title);
-
-    std::optional<LyricData> process_available_lyric_update(LyricUpdateHandle& update);
-
-    // Returns the path of the file on disk to which the lyrics were saved
-    std::string save_lyrics(metadb_handle_ptr track, const LyricData& lyrics, bool allow_overwrite, abort_callback& abort);
-}
-
-
-class LyricUpdateHandle
-{
-public:
-    enum class Type
-    {
-        Unknown,
-        AutoSearch,
-        ManualSearch,
-        Edit,
-    };
-
-    LyricUpdateHandle(Type type, metadb_handle_ptr track, abort_callback& abort);
-    LyricUpdateHandle(const LyricUpdateHandle& other) = delete;
-    LyricUpdateHandle(LyricUpdateHandle&& other);
-    ~LyricUpdateHandle();
-
-    Type get_type();
-    std::string get_progress();
-    bool wait_for_complete(uint32_t timeout_ms);
-    bool is_complete();
-    bool has_result();
-    LyricData get_result();
-
-    abort_callback& get_checked_abort(); // Checks the abort flag (so it might throw) and returns it
-    metadb_handle_ptr get_track();
-
-    void set_started();
-    void set_progress(std::string_view value);
-    void set_result(LyricData&& data, bool final_result);
-    void set_complete();
-
-private:
-    enum class Status
-    {
-        Unknown,
-        Created,
-        Running,
-        Complete,
-        Closed
-    };
-
-    const metadb_handle_ptr m_track;
-    const Type m_type;
-
-    CRITICAL_SECTION m_mutex;
-    std::vector<LyricData> m_lyrics;
-    abort_callback& m_abort;
-    HANDLE m_complete;
-    Status m_status;
-    std::string m_progress;
-};
-
+#pragma once
+
+#include "stdafx.h"
+
+#include "lyric_data.h"
+#include "metadb_index_search_avoidance.h"
+#include "search_context.h"
+#include "tag_util.h"
+
+class LyricUpdateHandle;
+
+namespace io
+{
+    void search_for_lyrics(LyricUpdateHandle& handle, bool local_only, bool ignore_search_avoidance);
+    void search_for_all_lyrics(LyricUpdateHandle& handle, std::string artist, std::string album, std::string title);
+
+    // If given, `save_failed` is set to whether the lyrics needed saving (as per the user's auto-save setting) but could not be saved
+    std::optional<LyricData> process_available_lyric_update(LyricUpdateHandle& update, bool* save_failed = nullptr);
+
+    // Takes the available result from the given update and processes it (running auto-edits and saving it if required)
+    // on a background thread, so that slow disk or tag writes don't block the caller. Updates are processed one at a time,
+    // in the order that they were passed to this function. Parts of the save that can only happen on the main thread
+    // are run there. `on_processed` is then called on the main thread with the processed lyrics.
+    // Returns false (and never calls `on_processed`) if the update has no (non-empty) result.
+    bool process_available_lyric_update_async(LyricUpdateHandle& update, std::function<void(LyricData&&)> on_processed);
+
+    // Returns the path of the file on disk to which the lyrics were saved
+    std::string save_lyrics(metadb_handle_ptr track, const LyricData& lyrics, bool allow_overwrite, abort_callback& abort);
+}
+
+
+class LyricUpdateHandle
+{
+public:
+    enum class Type
+    {
+        Unknown,
+        AutoSearch,
+        ManualSearch,
+        Edit,
+    };
+
+    LyricUpdateHandle(Type type, metadb_handle_ptr track, abort_callback& abort);
+    LyricUpdateHandle(const LyricUpdateHandle& other) = delete;
+    LyricUpdateHandle(LyricUpdateHandle&& other);
+    ~LyricUpdateHandle();
+
+    Type get_type();
+    std::string get_progress();
+    bool wait_for_complete(uint32_t timeout_ms);
+    bool is_complete();
+    bool has_result();
+    LyricData get_result();
+    bool had_errors(); // True if one or more active sources were not searched (e.g because of a network error or because they were skipped)
+
+    bool is_aborting();
+    abort_callback& get_checked_abort(); // Checks the abort flag (so it might throw) and returns it
+    metadb_handle_ptr get_track();
+    const SearchContext& get_search_context(); // Built from the track on first request, unless one was set explicitly
+    void set_search_context(std::shared_ptr<const SearchContext> context);
+    lyric_search_avoidance get_search_avoidance(); // Loaded from the metadb index, unless it was set explicitly
+    void set_search_avoidance(lyric_search_avoidance avoidance);
+
+    void set_started();
+    void set_progress(std::string_view value);
+    void set_result(LyricData&& data, bool final_result);
+    void set_had_errors();
+    void set_complete();
+
+private:
+    enum class Status
+    {
+        Unknown,
+        Created,
+        Running,
+        Complete,
+        Closed
+    };
+
+    const metadb_handle_ptr m_track;
+    const Type m_type;
+    std::shared_ptr<const SearchContext> m_search_context;
+    std::optional<lyric_search_avoidance> m_search_avoidance;
+
+    CRITICAL_SECTION m_mutex;
+    std::vector<LyricData> m_lyrics;
+    abort_callback& m_abort;
+    HANDLE m_complete;
+    Status m_status;
+    std::string m_progress;
+    bool m_had_errors;
+};
+
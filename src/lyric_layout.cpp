@@ -0,0 +1,368 @@
+#include <cassert>
+#include <cfloat>
+
+#include "lyric_layout.h"
+
+FixedAdvanceTextMetrics::FixedAdvanceTextMetrics(int char_advance, int ascent, int descent) :
+    m_char_advance(char_advance),
+    m_ascent(ascent),
+    m_descent(descent)
+{
+}
+
+int FixedAdvanceTextMetrics::ascent() const
+{
+    return m_ascent;
+}
+
+int FixedAdvanceTextMetrics::descent() const
+{
+    return m_descent;
+}
+
+int FixedAdvanceTextMetrics::height() const
+{
+    return m_ascent + m_descent;
+}
+
+int FixedAdvanceTextMetrics::average_char_width() const
+{
+    return m_char_advance;
+}
+
+std::optional<int> FixedAdvanceTextMetrics::measure(std::wstring_view text)
+{
+    return int(text.length()) * m_char_advance;
+}
+
+LayoutLine layout_line(TextMetricsProvider& metrics, int width, int linegap, std::wstring_view text)
+{
+    LayoutLine result = {};
+    const int line_height = metrics.height() + linegap;
+    if(text.length() == 0)
+    {
+        result.height = line_height;
+        return result;
+    }
+
+    // This serves as an upper bound on the number of chars we draw on a single line.
+    // Used to prevent the metrics provider from having to compute the size of very long strings.
+    size_t generous_max_chars = 256;
+    const int average_char_width = metrics.average_char_width();
+    if(average_char_width > 0)
+    {
+        assert(width >= 0);
+        size_t avg_chars_that_fit = ((size_t)width/(size_t)average_char_width) + 1;
+        generous_max_chars = 3*avg_chars_that_fit;
+    }
+
+    std::wstring_view text_outstanding = text;
+    while(text_outstanding.length() > 0)
+    {
+        size_t leading_spaces = text_outstanding.find_first_not_of(L' ');
+        text_outstanding.remove_prefix((std::min)(leading_spaces, text_outstanding.size()));
+
+        size_t last_not_space = text_outstanding.find_last_not_of(L' ');
+        if(last_not_space != std::wstring_view::npos)
+        {
+            size_t trailing_spaces = text_outstanding.length() - 1 - last_not_space;
+            text_outstanding.remove_suffix(trailing_spaces);
+        }
+
+        size_t next_line_start_index = text_outstanding.length();
+        size_t chars_to_draw = (std::min)(text_outstanding.length(), generous_max_chars);
+        int segment_width = 0;
+        while(true)
+        {
+            std::optional<int> measured_width = metrics.measure(text_outstanding.substr(0, chars_to_draw));
+            if(!measured_width.has_value())
+            {
+                return {};
+            }
+            segment_width = measured_width.value();
+
+            if((chars_to_draw == 0) || (segment_width <= width))
+            {
+                break;
+            }
+            else
+            {
+                assert(chars_to_draw > 0);
+                size_t previous_space_index = text_outstanding.rfind(' ', chars_to_draw-1);
+                if(previous_space_index == std::wstring::npos)
+                {
+                    // There is a single word that doesn't fit on the line
+                    // This should be rare so just draw it rather than trying to split words.
+                    break;
+                }
+                else
+                {
+                    next_line_start_index = previous_space_index;
+                    chars_to_draw = previous_space_index;
+                }
+            }
+        }
+
+        const size_t segment_start = size_t(text_outstanding.data() - text.data());
+        result.segments.push_back({segment_start, chars_to_draw, segment_width});
+        result.height += line_height;
+        result.text_width += segment_width;
+        text_outstanding = text_outstanding.substr(next_line_start_index);
+    }
+
+    return result;
+}
+
+// Measures the position of each word along a line that has already been wrapped
+static std::vector<int> layout_word_positions(TextMetricsProvider& metrics, const LyricDataLine& line, const LayoutLine& layout)
+{
+    std::vector<int> result;
+    result.reserve(line.words.size());
+    for(const LyricDataWord& word : line.words)
+    {
+        // NOTE: Words that start in whitespace that was removed by wrapping are placed at the start of the next segment,
+        //       and words that start after the last segment are placed at the end of the line.
+        int position = layout.text_width;
+        int segment_offset = 0;
+        for(const LayoutLine::Segment& segment : layout.segments)
+        {
+            if(word.start < segment.start)
+            {
+                position = segment_offset;
+                break;
+            }
+            if(word.start < segment.start + segment.length)
+            {
+                std::wstring_view prefix = std::wstring_view(line.text).substr(segment.start, word.start - segment.start);
+                position = segment_offset + metrics.measure(prefix).value_or(0);
+                break;
+            }
+            segment_offset += segment.width;
+        }
+        result.push_back(position);
+    }
+    return result;
+}
+
+LyricLayout layout_lyrics(TextMetricsProvider& metrics, int width, int linegap, const std::vector<LyricDataLine>& lines)
+{
+    LyricLayout result = {};
+    result.width = width;
+    result.linegap = linegap;
+    result.font_ascent = metrics.ascent();
+    result.font_descent = metrics.descent();
+    result.line_height = metrics.height() + linegap;
+
+    result.lines.reserve(lines.size());
+    result.line_tops.reserve(lines.size() + 1);
+    result.line_tops.push_back(0);
+    for(const LyricDataLine& line : lines)
+    {
+        result.lines.push_back(layout_line(metrics, width, linegap, line.text));
+        if(!line.words.empty())
+        {
+            result.lines.back().word_positions = layout_word_positions(metrics, line, result.lines.back());
+        }
+        result.total_height += result.lines.back().height;
+        result.line_tops.push_back(result.total_height);
+        result.measure_failed |= (result.lines.back().height == 0);
+    }
+    return result;
+}
+
+HorizontalLyricLayout layout_lyrics_horizontal(TextMetricsProvider& metrics, int glue_chars, const std::vector<LyricDataLine>& lines)
+{
+    HorizontalLyricLayout result = {};
+    result.font_ascent = metrics.ascent();
+    result.font_descent = metrics.descent();
+
+    const std::wstring glue(size_t((std::max)(0, glue_chars)), L' ');
+    std::optional<int> glue_width = metrics.measure(glue);
+    result.glue_width = glue_width.value_or(0);
+    result.measure_failed = !glue_width.has_value();
+
+    result.line_widths.reserve(lines.size());
+    result.line_lefts.reserve(lines.size() + 1);
+    result.line_lefts.push_back(0);
+    result.word_positions.reserve(lines.size());
+    for(const LyricDataLine& line : lines)
+    {
+        std::optional<int> line_width = metrics.measure(line.text);
+        result.measure_failed |= !line_width.has_value();
+        result.line_widths.push_back(line_width.value_or(0));
+
+        std::vector<int> word_positions;
+        word_positions.reserve(line.words.size());
+        for(const LyricDataWord& word : line.words)
+        {
+            std::wstring_view prefix = std::wstring_view(line.text).substr(0, (std::min)(word.start, line.text.length()));
+            std::optional<int> prefix_width = metrics.measure(prefix);
+            result.measure_failed |= !prefix_width.has_value();
+            word_positions.push_back(prefix_width.value_or(0));
+        }
+        result.word_positions.push_back(std::move(word_positions));
+
+        // NOTE: The glue is only between lines, so the end of the last line is the total width
+        result.total_width = result.line_lefts.back() + result.line_widths.back();
+        result.line_lefts.push_back(result.total_width + result.glue_width);
+    }
+    return result;
+}
+
+std::pair<size_t, size_t> visible_lines_horizontal(const HorizontalLyricLayout& layout, int first_left_x, int clip_left, int clip_right)
+{
+    assert(layout.line_lefts.size() == layout.line_widths.size() + 1);
+
+    // NOTE: Searching on the line starts (rather than ends) for the first visible line may include
+    //       one line to the left of the clip rect (if the clip edge falls in the glue after it).
+    //       That is fine because the text would be clipped anyway.
+    const auto lefts_begin = layout.line_lefts.begin();
+    const auto lefts_end = lefts_begin + layout.line_widths.size();
+    const auto first_iter = std::upper_bound(lefts_begin + 1, layout.line_lefts.end(), clip_left - first_left_x);
+    const auto end_iter = std::upper_bound(lefts_begin, lefts_end, clip_right - first_left_x);
+
+    const size_t first = size_t(first_iter - (lefts_begin + 1));
+    const size_t end = size_t(end_iter - lefts_begin);
+    return {(std::min)(first, end), end};
+}
+
+std::pair<size_t, size_t> visible_lines(const LyricLayout& layout, int first_baseline_y, int clip_top, int clip_bottom)
+{
+    assert(layout.line_tops.size() == layout.lines.size() + 1);
+
+    // NOTE: A line is visible if the bottom of its last segment is below the top of the clip rect and
+    //       the top of its first segment is above the bottom of the clip rect. We search on the line tops
+    //       (i.e the baseline of the first segment) for both, which may include one extra line above the
+    //       clip rect, but that is fine because the drawing code clips each segment anyway.
+    const int first_offset = clip_top - first_baseline_y - layout.font_descent;
+    const int end_offset = clip_bottom - first_baseline_y + layout.font_ascent;
+
+    const auto tops_begin = layout.line_tops.begin();
+    const auto tops_end = tops_begin + layout.lines.size();
+    const auto first_iter = std::upper_bound(tops_begin + 1, layout.line_tops.end(), first_offset);
+    const auto end_iter = std::upper_bound(tops_begin, tops_end, end_offset);
+
+    const size_t first = size_t(first_iter - (tops_begin + 1));
+    const size_t end = size_t(end_iter - tops_begin);
+    return {(std::min)(first, end), end};
+}
+
+void position_runs(const LyricLayout& layout, size_t first_line, size_t end_line, int centre_x, int first_baseline_y, std::vector<PositionedRun>& runs)
+{
+    assert(first_line <= end_line);
+    assert(end_line <= layout.lines.size());
+
+    int y = first_baseline_y;
+    for(size_t line_index=first_line; line_index<end_line; line_index++)
+    {
+        const LayoutLine& line = layout.lines[line_index];
+        for(const LayoutLine::Segment& segment : line.segments)
+        {
+            runs.push_back({line_index, segment.start, segment.length, centre_x, y, segment.width});
+            y += layout.line_height;
+        }
+
+        // NOTE: Empty lines have no segments but still take up (at least) one line of height
+        if(line.segments.empty())
+        {
+            y += line.height;
+        }
+    }
+}
+
+int karaoke_position(const LyricDataLine& line, const std::vector<int>& word_positions, int line_width, double time, double line_end_time)
+{
+    assert(word_positions.size() == line.words.size());
+    if(line.words.empty())
+    {
+        return line_width;
+    }
+
+    const auto first_future_word = std::partition_point(line.words.begin(), line.words.end(),
+                                                        [time](const LyricDataWord& word) { return time >= word.timestamp; });
+    if(first_future_word == line.words.begin())
+    {
+        return 0;
+    }
+
+    const size_t word_index = size_t(first_future_word - line.words.begin()) - 1;
+    const double start_time = line.words[word_index].timestamp;
+    const int start_x = word_positions[word_index];
+    double end_time = karaoke_end_time(line, line_end_time);
+    int end_x = line_width;
+    if(word_index + 1 < line.words.size())
+    {
+        end_time = line.words[word_index + 1].timestamp;
+        end_x = word_positions[word_index + 1];
+    }
+
+    if(end_time <= start_time)
+    {
+        return end_x;
+    }
+    const double word_fraction = (std::min)(1.0, (time - start_time) / (end_time - start_time));
+    return start_x + int(double(end_x - start_x) * word_fraction);
+}
+
+double karaoke_end_time(const LyricDataLine& line, double line_end_time)
+{
+    if(line.words.empty())
+    {
+        return line.timestamp;
+    }
+
+    // NOTE: If the line has no explicit end for its last word (or there is no next line) then the
+    //       last word ends when the next line starts (or immediately, respectively).
+    const LyricDataWord& last_word = line.words.back();
+    const bool has_end_marker = (last_word.start >= line.text.length());
+    if(has_end_marker || (line_end_time == DBL_MAX))
+    {
+        return last_word.timestamp;
+    }
+    return line_end_time;
+}
+
+uint64_t hash_lyric_lines(const std::vector<LyricDataLine>& lines)
+{
+    // NOTE: This is a 64-bit FNV-1a hash over the characters of each line, with a separator between lines
+    //       (which is not a valid character in a line) so that differently-split lines hash differently.
+    const uint64_t fnv_offset_basis = 0xcbf29ce484222325ull;
+    const uint64_t fnv_prime = 0x100000001b3ull;
+    uint64_t result = fnv_offset_basis;
+    for(const LyricDataLine& line : lines)
+    {
+        for(wchar_t c : line.text)
+        {
+            result ^= uint64_t(c);
+            result *= fnv_prime;
+        }
+        for(const LyricDataWord& word : line.words)
+        {
+            result ^= uint64_t(word.start);
+            result *= fnv_prime;
+        }
+        result ^= uint64_t(L'\n');
+        result *= fnv_prime;
+    }
+    return result;
+}
+
+bool lyric_lines_match(const std::vector<LyricDataLine>& lhs, const std::vector<LyricDataLine>& rhs)
+{
+    if(lhs.size() != rhs.size())
+    {
+        return false;
+    }
+
+    // NOTE: Word timestamps do not affect the layout, only where each word starts
+    auto word_starts_match = [](const LyricDataWord& lhs_word, const LyricDataWord& rhs_word) { return lhs_word.start == rhs_word.start; };
+    for(size_t i=0; i<lhs.size(); i++)
+    {
+        if((lhs[i].text != rhs[i].text) ||
+           !std::equal(lhs[i].words.begin(), lhs[i].words.end(), rhs[i].words.begin(), rhs[i].words.end(), word_starts_match))
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+// NOTE: The layout engine deliberately does not depend on the foobar2000 SDK (or windows.h),
+//       so that it can be built and tested on its own.
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lyric_line.h"
+
+// Provides measurements of text in a particular font.
+// The layout engine only measures text through this interface, so that it does not depend on
+// any particular platform's text rendering (and can be tested or profiled without one).
+class TextMetricsProvider
+{
+public:
+    virtual ~TextMetricsProvider() = default;
+
+    virtual int ascent() const = 0;  // The distance from the top of a line of text to the baseline
+    virtual int descent() const = 0; // The distance from the baseline to the bottom of a line of text
+    virtual int height() const = 0;  // The height of a single line of text, not including the line gap
+    virtual int average_char_width() const = 0;
+
+    // Returns the width of the given text, or nothing if it could not be measured
+    virtual std::optional<int> measure(std::wstring_view text) = 0;
+};
+
+// Measures text as if every character has the same advance, so that layouts are deterministic and
+// do not depend on the fonts that are installed. Intended for testing and benchmarking layouts.
+class FixedAdvanceTextMetrics : public TextMetricsProvider
+{
+public:
+    FixedAdvanceTextMetrics(int char_advance, int ascent, int descent);
+
+    int ascent() const override;
+    int descent() const override;
+    int height() const override;
+    int average_char_width() const override;
+    std::optional<int> measure(std::wstring_view text) override;
+
+private:
+    int m_char_advance;
+    int m_ascent;
+    int m_descent;
+};
+
+// A single lyric line, split into segments that each fit within the layout width (where possible)
+struct LayoutLine
+{
+    struct Segment
+    {
+        size_t start; // The index of the first character of this segment in the line text
+        size_t length;
+        int width;
+    };
+
+    std::vector<Segment> segments;
+    int height;
+    int text_width; // The sum of the widths of every segment
+
+    // The distance along the line (with every segment placed end-to-end) to the start of each word.
+    // Only present for lines with per-word timestamps.
+    std::vector<int> word_positions;
+};
+
+struct LyricLayout
+{
+    int width;
+    int linegap;
+    int font_ascent;
+    int font_descent;
+    int line_height; // The height of a single (unwrapped) line of text, including the line gap
+
+    std::vector<LayoutLine> lines;
+    std::vector<int> line_tops; // The sum of the heights of all lines before each line. Contains one more entry than `lines`.
+    int total_height;
+    bool measure_failed; // Set if the text of any line could not be measured (in which case that line is empty)
+};
+
+// The lines of the lyrics laid out end-to-end on a single row, separated by "glue" whitespace
+struct HorizontalLyricLayout
+{
+    int font_ascent;
+    int font_descent;
+    int glue_width;
+
+    std::vector<int> line_widths;
+    std::vector<int> line_lefts; // The x-offset of the start of each line, from the start of the first line. Contains one more entry than `line_widths`.
+    std::vector<std::vector<int>> word_positions; // The x-offset of the start of each word in each line, from the start of that line
+    int total_width;
+    bool measure_failed;
+};
+
+// A segment of a lyric line, with the position of its baseline centre
+struct PositionedRun
+{
+    size_t line_index;
+    size_t start;
+    size_t length;
+    int x;
+    int y;
+    int width;
+};
+
+// Wraps the given line to the given width. Returns a line with zero height if the text could not be measured.
+LayoutLine layout_line(TextMetricsProvider& metrics, int width, int linegap, std::wstring_view text);
+
+// Wraps every line of the given lyrics to the given width
+LyricLayout layout_lyrics(TextMetricsProvider& metrics, int width, int linegap, const std::vector<LyricDataLine>& lines);
+
+// Measures every line of the given lyrics for display on a single row, with `glue_chars` spaces between each line
+HorizontalLyricLayout layout_lyrics_horizontal(TextMetricsProvider& metrics, int glue_chars, const std::vector<LyricDataLine>& lines);
+
+// Returns the range [first, end) of lines that are (at least partially) visible between `clip_left` and `clip_right`
+// when the start of the first line of the layout is at `first_left_x`.
+std::pair<size_t, size_t> visible_lines_horizontal(const HorizontalLyricLayout& layout, int first_left_x, int clip_left, int clip_right);
+
+// Returns the range [first, end) of lines that are (at least partially) visible between `clip_top` and `clip_bottom`
+// when the baseline of the first line of the layout is at `first_baseline_y`.
+std::pair<size_t, size_t> visible_lines(const LyricLayout& layout, int first_baseline_y, int clip_top, int clip_bottom);
+
+// Positions every segment of the lines in [first_line, end_line) with the baseline of the first segment at
+// `first_baseline_y` and every segment centred horizontally on `centre_x`. Runs are appended to `runs`.
+void position_runs(const LyricLayout& layout, size_t first_line, size_t end_line, int centre_x, int first_baseline_y, std::vector<PositionedRun>& runs);
+
+// Returns the distance along the given line (as in the word positions of a layout) up to which it should be
+// highlighted at the given time, moving steadily across each word between its timestamp and that of the next word.
+// The last word ends at `line_end_time` unless the line text ends with its own word-end timestamp.
+// Times are as in the lyric data (i.e without the timestamp offset applied).
+int karaoke_position(const LyricDataLine& line, const std::vector<int>& word_positions, int line_width, double time, double line_end_time);
+
+// Returns the time after which the highlight for the given line (as returned by `karaoke_position`) stops moving
+double karaoke_end_time(const LyricDataLine& line, double line_end_time);
+
+// Returns a hash of the text (and word boundaries) of the given lines, for identifying lyrics that will have the same layout
+uint64_t hash_lyric_lines(const std::vector<LyricDataLine>& lines);
+
+// Returns true if the given lines have exactly the same text and word boundaries
+bool lyric_lines_match(const std::vector<LyricDataLine>& lhs, const std::vector<LyricDataLine>& rhs);
+
+// Shares layouts between everything that displays the same lyrics with the same font, width and line gap
+// (e.g multiple panels), so that the text only needs to be measured once.
+// Fonts are identified by both their ID and a generation that the caller changes whenever fonts may have been
+// re-created, since a new font can be given the ID (e.g the handle) of one that was deleted.
+// Layouts are reference-counted and only kept for as long as something still holds on to them.
+// This is not thread-safe.
+template<typename TLayout>
+class SharedLayoutCache
+{
+public:
+    // Returns the layout for the given lines with the given parameters if there is one in use,
+    // otherwise returns (and shares) the result of calling `compute`.
+    template<typename TComputeFunc>
+    std::shared_ptr<const TLayout> get(uintptr_t font_id, uint64_t font_generation, int width, int linegap, const std::vector<LyricDataLine>& lines, uint64_t lyrics_hash, TComputeFunc compute)
+    {
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return entry.layout.expired(); }),
+                        m_entries.end());
+
+        for(const Entry& entry : m_entries)
+        {
+            // NOTE: We compare the actual text as well as the hash so that a hash collision can't give us the
+            //       layout for different text. This is cheap relative to measuring the text again.
+            const bool matches = (entry.lyrics_hash == lyrics_hash) &&
+                                 (entry.font_id == font_id) &&
+                                 (entry.font_generation == font_generation) &&
+                                 (entry.width == width) &&
+                                 (entry.linegap == linegap) &&
+                                 lyric_lines_match(entry.lines, lines);
+            if(matches)
+            {
+                std::shared_ptr<const TLayout> layout = entry.layout.lock();
+                if(layout != nullptr)
+                {
+                    return layout;
+                }
+            }
+        }
+
+        std::shared_ptr<const TLayout> layout = std::make_shared<const TLayout>(compute());
+        m_entries.push_back({lyrics_hash, font_id, font_generation, width, linegap, lines, layout});
+        return layout;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t lyrics_hash;
+        uintptr_t font_id;
+        uint64_t font_generation;
+        int width;
+        int linegap;
+        std::vector<LyricDataLine> lines;
+        std::weak_ptr<const TLayout> layout;
+    };
+
+    std::vector<Entry> m_entries;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// NOTE: This deliberately does not depend on the foobar2000 SDK (or windows.h) so that code that only deals with
+//       parsed lyric lines (e.g the layout engine) can be built and tested on its own.
+//       Lyric text is stored as wide characters (i.e std::tstring in our Unicode build) for drawing with the Windows text APIs.
+#include <string>
+#include <vector>
+
+// Parsed lyric lines, as stored in LyricData
+struct LyricDataWord
+{
+    size_t start; // The index of the first character of this word in the line text (which may be the length of the text, to mark the end of the last word)
+    double timestamp;
+};
+
+struct LyricDataLine
+{
+    std::wstring text;
+    double timestamp;
+    std::vector<LyricDataWord> words; // Only present for lines with per-word timestamps (e.g "enhanced" LRC), in order of time
+};
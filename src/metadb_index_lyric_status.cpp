@@ -0,0 +1,236 @@
+#include "stdafx.h"
+
+#pragma warning(push, 0)
+#include "foobar2000/helpers/filetimetools.h"
+#pragma warning(pop)
+
+#include "metadb_index_lyric_status.h"
+
+#include "logging.h"
+#include "metadb_index_search_avoidance.h"
+#include "sources/lyric_source.h"
+#include "win32_util.h"
+
+// NOTE: This index records whether (and how) we have lyrics for each track, so that the information
+//       can be shown in playlist columns (or used to filter tracks) without needing to touch the
+//       files on disk or run a search. It is keyed on the same hash as the search-avoidance index.
+static const GUID GUID_METADBINDEX_LYRIC_STATUS = { 0x8f3b5d21, 0x6a4e, 0x4c97, { 0xb1, 0x2d, 0x57, 0xe0, 0x9c, 0x3a, 0x64, 0xf8 } };
+
+static const uint8_t LYRIC_STATUS_RECORD_VERSION = 1;
+
+class lyric_status_metadb_index_init : public init_stage_callback
+{
+    void on_init_stage(t_uint32 stage) override
+    {
+        if(stage != init_stages::before_config_read)
+        {
+            return;
+        }
+
+        auto mim = metadb_index_manager::get();
+        try
+        {
+            mim->add(lyric_metadb_index_client_instance(), GUID_METADBINDEX_LYRIC_STATUS, system_time_periods::week);
+            mim->dispatch_global_refresh();
+            LOG_INFO("Successfully initialised the lyric status metadb index");
+        }
+        catch(const std::exception& ex)
+        {
+            mim->remove(GUID_METADBINDEX_LYRIC_STATUS);
+            LOG_INFO("Failed to initialise the lyric status metadb index: %s", ex.what());
+        }
+    }
+};
+static service_factory_single_t<lyric_status_metadb_index_init> g_lyric_status_metadb_index_init;
+
+static LyricStatus compute_lyric_status(const LyricData& lyrics)
+{
+    if(lyrics.IsEmpty())
+    {
+        return LyricStatus::None;
+    }
+
+    // NOTE: This matches the lyrics created by the "Mark as instrumental" auto-edit
+    if((lyrics.lines.size() == 1) && (lyrics.lines[0].text == _T("[Instrumental]")))
+    {
+        return LyricStatus::Instrumental;
+    }
+
+    if(lyrics.IsTimestamped())
+    {
+        return LyricStatus::Synced;
+    }
+    return LyricStatus::Unsynced;
+}
+
+static lyric_status_record load_lyric_status(metadb_index_manager::ptr& meta_index, metadb_index_hash index_hash)
+{
+    pfc::array_t<uint8_t> data;
+    meta_index->get_user_data_t(GUID_METADBINDEX_LYRIC_STATUS, index_hash, data);
+    if(data.get_size() == 0)
+    {
+        return {};
+    }
+
+    try
+    {
+        stream_reader_formatter_simple<false> reader(data.get_ptr(), data.get_size());
+        uint8_t version = 0;
+        reader >> version;
+        if(version != LYRIC_STATUS_RECORD_VERSION)
+        {
+            LOG_INFO("Unrecognised lyric status record version: %u", version);
+            return {};
+        }
+
+        lyric_status_record result = {};
+        uint8_t status = 0;
+        pfc::string8 storage_path;
+        reader >> status;
+        reader >> result.source_id;
+        reader >> storage_path;
+        reader >> result.verified_time;
+        result.status = static_cast<LyricStatus>(status);
+        result.storage_path = std::string(storage_path.c_str(), storage_path.length());
+        return result;
+    }
+    catch(const std::exception& ex)
+    {
+        LOG_INFO("Failed to read lyric status info: %s", ex.what());
+        return {};
+    }
+}
+
+lyric_status_record load_lyric_status(metadb_handle_ptr track)
+{
+    auto meta_index = metadb_index_manager::get();
+    return load_lyric_status(meta_index, lyric_metadb_index_hash(track));
+}
+
+void save_lyric_status(metadb_handle_ptr track, const LyricData& lyrics, const GUID& source_id, std::string_view storage_path)
+{
+    const LyricStatus status = compute_lyric_status(lyrics);
+    const metadb_index_hash index_hash = lyric_metadb_index_hash(track);
+
+    stream_writer_formatter_simple<false> writer;
+    writer << LYRIC_STATUS_RECORD_VERSION;
+    writer << static_cast<uint8_t>(status);
+    writer << source_id;
+    writer << pfc::string8(storage_path.data(), storage_path.length());
+    writer << filetimestamp_from_system_timer();
+
+    auto meta_index = metadb_index_manager::get();
+    meta_index->set_user_data(GUID_METADBINDEX_LYRIC_STATUS,
+                              index_hash,
+                              writer.m_buffer.get_ptr(),
+                              writer.m_buffer.get_size());
+
+    // NOTE: Refreshing causes playlists (and anything else showing our fields) to redraw the affected tracks.
+    //       We may be called from a search thread, so hop over to the main thread to dispatch it.
+    fb2k::inMainThread2([index_hash]()
+    {
+        metadb_index_manager::get()->dispatch_refresh(GUID_METADBINDEX_LYRIC_STATUS, index_hash);
+    });
+}
+
+class lyric_status_field_provider : public metadb_display_field_provider
+{
+public:
+    enum class Field : t_uint32
+    {
+        Status,
+        Source,
+        Path,
+        Verified,
+
+        Count
+    };
+
+    t_uint32 get_field_count() override
+    {
+        return static_cast<t_uint32>(Field::Count);
+    }
+
+    void get_field_name(t_uint32 index, pfc::string_base& out) override
+    {
+        switch(static_cast<Field>(index))
+        {
+            case Field::Status: out = "lyrics_status"; break;
+            case Field::Source: out = "lyrics_source"; break;
+            case Field::Path: out = "lyrics_path"; break;
+            case Field::Verified: out = "lyrics_verified"; break;
+
+            case Field::Count:
+            default:
+                LOG_WARN("Unrecognised lyric status field index: %u", index);
+                assert(false);
+                break;
+        }
+    }
+
+    bool process_field(t_uint32 index, metadb_handle* handle, titleformat_text_out* out) override
+    {
+        auto meta_index = metadb_index_manager::get();
+        const lyric_status_record record = load_lyric_status(meta_index, lyric_metadb_index_hash(metadb_handle_ptr(handle)));
+        if(record.status == LyricStatus::Unknown)
+        {
+            return false;
+        }
+
+        switch(static_cast<Field>(index))
+        {
+            case Field::Status:
+            {
+                const char* status_str = nullptr;
+                switch(record.status)
+                {
+                    case LyricStatus::None: status_str = "none"; break;
+                    case LyricStatus::Unsynced: status_str = "unsynced"; break;
+                    case LyricStatus::Synced: status_str = "synced"; break;
+                    case LyricStatus::Instrumental: status_str = "instrumental"; break;
+
+                    case LyricStatus::Unknown:
+                    default:
+                        return false;
+                }
+                out->write(titleformat_inputtypes::meta, status_str);
+                return true;
+            }
+
+            case Field::Source:
+            {
+                LyricSourceBase* source = LyricSourceBase::get(record.source_id);
+                if((record.status == LyricStatus::None) || (source == nullptr))
+                {
+                    return false;
+                }
+                std::string source_name = from_tstring(source->friendly_name());
+                out->write(titleformat_inputtypes::meta, source_name.c_str(), source_name.length());
+                return true;
+            }
+
+            case Field::Path:
+            {
+                if(record.storage_path.empty())
+                {
+                    return false;
+                }
+                out->write(titleformat_inputtypes::meta, record.storage_path.c_str(), record.storage_path.length());
+                return true;
+            }
+
+            case Field::Verified:
+            {
+                out->write(titleformat_inputtypes::meta, foobar2000_io::format_filetimestamp(record.verified_time));
+                return true;
+            }
+
+            case Field::Count:
+            default:
+                LOG_WARN("Unrecognised lyric status field index: %u", index);
+                assert(false);
+                return false;
+        }
+    }
+};
+static service_factory_single_t<lyric_status_field_provider> g_lyric_status_field_provider;
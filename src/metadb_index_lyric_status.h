@@ -0,0 +1,25 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "lyric_data.h"
+
+enum class LyricStatus : uint8_t
+{
+    Unknown = 0, // We have never searched for, or saved lyrics for this track
+    None = 1, // The most recent search found nothing
+    Unsynced = 2,
+    Synced = 3,
+    Instrumental = 4,
+};
+
+struct lyric_status_record
+{
+    LyricStatus status;
+    GUID source_id;
+    std::string storage_path;
+    t_filetimestamp verified_time;
+};
+
+lyric_status_record load_lyric_status(metadb_handle_ptr track);
+void save_lyric_status(metadb_handle_ptr track, const LyricData& lyrics, const GUID& source_id, std::string_view storage_path);
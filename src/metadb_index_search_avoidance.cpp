@@ -1,106 +1,482 @@
-#include "stdafx.h"
-
-#include "metadb_index_search_avoidance.h"
-
-#include "logging.h"
-#include "tag_util.h"
-
-static const GUID GUID_METADBINDEX_LYRIC_HISTORY = { 0x915bee72, 0xfd1d, 0x4cf8, { 0x90, 0xd4, 0x8e, 0x2c, 0x18, 0xfd, 0x5, 0xbf } };
-
-struct lyric_metadb_index_client : metadb_index_client
-{
-    static lyric_metadb_index_client::ptr instance()
-    {
-        static lyric_metadb_index_client::ptr singleton = new service_impl_single_t<lyric_metadb_index_client>();
-        return singleton;
-    }
-
-    static metadb_index_hash hash(const file_info& info)
-    {
-        std::string artist = track_metadata(info, "artist");
-        std::string album = track_metadata(info, "album");
-        std::string title = track_metadata(info, "title");
-        std::string key = artist + album + title;
-        return static_api_ptr_t<hasher_md5>()->process_single_string(key.c_str()).xorHalve();
-    }
-
-    static metadb_index_hash hash_handle(const metadb_handle_ptr& info)
-    {
-        metadb_info_container::ptr container = info->get_info_ref();
-        return hash(container->info());
-    }
-
-    metadb_index_hash transform(const file_info& info, const playable_location& /*location*/) override
-    {
-        return hash(info);
-    }
-};
-
-class lyric_metadb_index_init : public init_stage_callback
-{
-    void on_init_stage(t_uint32 stage) override
-    {
-        if(stage != init_stages::before_config_read)
-        {
-            return;
-        }
-
-        auto mim = metadb_index_manager::get();
-        try
-        {
-            mim->add(lyric_metadb_index_client::instance(), GUID_METADBINDEX_LYRIC_HISTORY, system_time_periods::week);
-            mim->dispatch_global_refresh();
-            LOG_INFO("Successfully initialised the lyric metadb index");
-        }
-        catch(const std::exception& ex)
-        {
-            mim->remove(GUID_METADBINDEX_LYRIC_HISTORY);
-            LOG_INFO("Failed to initialise the lyric metadb index: %s", ex.what());
-        }
-    }
-};
-static service_factory_single_t<lyric_metadb_index_init> g_lyric_metadb_index_init;
-
-lyric_search_avoidance load_search_avoidance(metadb_handle_ptr track)
-{
-    char data_buffer[512] = {};
-
-    auto meta_index = metadb_index_manager::get();
-    metadb_index_hash our_index_hash = lyric_metadb_index_client::hash_handle(track);
-    size_t data_bytes = meta_index->get_user_data_here(GUID_METADBINDEX_LYRIC_HISTORY,
-                                                       our_index_hash,
-                                                       data_buffer,
-                                                       sizeof(data_buffer));
-
-    try
-    {
-        lyric_search_avoidance result = {};
-        stream_reader_formatter_simple<false> reader(data_buffer, data_bytes);
-        reader >> result.failed_searches;
-        reader >> result.first_fail_time;
-        reader >> result.search_config_generation;
-        return result;
-    }
-    catch(const std::exception& ex)
-    {
-        LOG_INFO("Failed to read search-avoidance info: %s", ex.what());
-        return {};
-    }
-}
-
-void save_search_avoidance(metadb_handle_ptr track, lyric_search_avoidance avoidance)
-{
-    auto meta_index = metadb_index_manager::get();
-    metadb_index_hash our_index_hash = lyric_metadb_index_client::hash_handle(track);
-
-    stream_writer_formatter_simple<false> writer;
-    writer << avoidance.failed_searches;
-    writer << avoidance.first_fail_time;
-    writer << avoidance.search_config_generation;
-
-    meta_index->set_user_data(GUID_METADBINDEX_LYRIC_HISTORY,
-                              our_index_hash,
-                              writer.m_buffer.get_ptr(),
-                              writer.m_buffer.get_size());
-}
-
+#include "stdafx.h"
+
+#include <list>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#include "metadb_index_search_avoidance.h"
+
+#include "logging.h"
+#include "sources/lyric_source.h"
+#include "tag_util.h"
+
+// NOTE: The original index hashed the plain concatenation of artist, album & title, which meant that
+//       (for example) artist "ab" with title "c" collided with artist "a" with title "bc".
+//       The current index length-prefixes each field before hashing. We keep the legacy index
+//       registered so that records stored before the switch can be migrated when next loaded.
+static const GUID GUID_METADBINDEX_LYRIC_HISTORY_LEGACY = { 0x915bee72, 0xfd1d, 0x4cf8, { 0x90, 0xd4, 0x8e, 0x2c, 0x18, 0xfd, 0x5, 0xbf } };
+static const GUID GUID_METADBINDEX_LYRIC_HISTORY = { 0x4c6e2a7d, 0x1b9f, 0x4e38, { 0xa5, 0x62, 0x3d, 0x8e, 0x71, 0xc4, 0x0f, 0x95 } };
+
+// NOTE: Version 1 records held a single failure counter for the track as a whole.
+//       Version 2 records hold one fixed-size entry for each source that has failed to find lyrics
+//       for the track, so that a source which never has lyrics for a track stops getting asked while
+//       other sources (including newly-enabled ones, which have no entry at all) are still searched.
+static const uint8_t SEARCH_AVOIDANCE_RECORD_VERSION_SINGLE_COUNTER = 1;
+static const uint8_t SEARCH_AVOIDANCE_RECORD_VERSION = 2;
+
+// NOTE: The delay before we'll search a source again doubles with every consecutive failure,
+//       up to a maximum. A random jitter is applied so that the retries for all the tracks that
+//       failed together in (for example) a bulk search don't all come due at the same time.
+static const t_filetimestamp SEARCH_AVOIDANCE_BASE_DELAY = system_time_periods::hour * 6;
+static const t_filetimestamp SEARCH_AVOIDANCE_MAX_DELAY = system_time_periods::week * 12;
+static const double SEARCH_AVOIDANCE_JITTER_FRACTION = 0.25;
+
+// NOTE: Legacy records are only migrated for a limited time after the current index is first used.
+//       Every legacy record was written before then and its migrated backoff is at most the maximum delay
+//       (plus jitter) after the failure, so once that time has passed the migrated records would no longer
+//       skip any source anyway. At that point we remove the legacy index (and all of its data) for good.
+//       The time at which the migration started is stored in a file in the profile directory, because
+//       config variables have not yet been read when the indices are registered.
+static const t_filetimestamp LEGACY_MIGRATION_PERIOD = static_cast<t_filetimestamp>(static_cast<double>(SEARCH_AVOIDANCE_MAX_DELAY) * (1.0 + SEARCH_AVOIDANCE_JITTER_FRACTION));
+static bool g_legacy_index_registered = false;
+
+struct lyric_metadb_index_client : metadb_index_client
+{
+    static lyric_metadb_index_client::ptr instance()
+    {
+        static lyric_metadb_index_client::ptr singleton = new service_impl_single_t<lyric_metadb_index_client>();
+        return singleton;
+    }
+
+    static metadb_index_hash hash(const file_info& info)
+    {
+        stream_writer_formatter_simple<false> key;
+        for(const char* tag : {"artist", "album", "title"})
+        {
+            std::string value = track_metadata(info, tag);
+            key << static_cast<uint32_t>(value.length());
+            key.write_raw(value.data(), value.length());
+        }
+        return static_api_ptr_t<hasher_md5>()->process_single(key.m_buffer.get_ptr(), key.m_buffer.get_size()).xorHalve();
+    }
+
+    metadb_index_hash transform(const file_info& info, const playable_location& /*location*/) override
+    {
+        return hash(info);
+    }
+};
+
+struct lyric_legacy_metadb_index_client : metadb_index_client
+{
+    static lyric_legacy_metadb_index_client::ptr instance()
+    {
+        static lyric_legacy_metadb_index_client::ptr singleton = new service_impl_single_t<lyric_legacy_metadb_index_client>();
+        return singleton;
+    }
+
+    static metadb_index_hash hash(const file_info& info)
+    {
+        std::string artist = track_metadata(info, "artist");
+        std::string album = track_metadata(info, "album");
+        std::string title = track_metadata(info, "title");
+        std::string key = artist + album + title;
+        return static_api_ptr_t<hasher_md5>()->process_single_string(key.c_str()).xorHalve();
+    }
+
+    metadb_index_hash transform(const file_info& info, const playable_location& /*location*/) override
+    {
+        return hash(info);
+    }
+};
+
+// NOTE: We load (and often save) the avoidance info every time a track changes or a search fails.
+//       Computing the hash requires reading 3 tags and running MD5 over them, so we remember the hash
+//       for recently-used handles. The memo holds a reference to the info container that the hash was
+//       computed from, and if the handle's info has since changed (e.g because the tags were edited)
+//       then the container will be different and the hash is recomputed.
+//       Once the memo is full we forget the least-recently-used handle, so that hashing a long run of
+//       other tracks (e.g the lyric status of every row in a large playlist) doesn't throw away the
+//       hashes of the tracks that we keep coming back to.
+//       The memo also remembers whether we have already looked for a legacy record for the track, because
+//       most tracks have never failed a search and so have no record in either index. Without this we would
+//       read the tags and hash them again (with the legacy hash) on every load for those tracks.
+struct index_hash_memo_entry
+{
+    metadb_handle_ptr track;
+    metadb_info_container::ptr info;
+    metadb_index_hash hash;
+    std::list<const metadb_handle*>::iterator recency;
+    bool legacy_record_checked;
+};
+static std::mutex g_index_hash_memo_lock;
+static std::unordered_map<const metadb_handle*, index_hash_memo_entry> g_index_hash_memo;
+static std::list<const metadb_handle*> g_index_hash_memo_recency; // The handles in the memo, most-recently-used first
+static const size_t INDEX_HASH_MEMO_MAX_SIZE = 1024;
+
+metadb_index_hash lyric_metadb_index_hash(const metadb_handle_ptr& track)
+{
+    metadb_info_container::ptr info = track->get_info_ref();
+
+    std::lock_guard<std::mutex> lock(g_index_hash_memo_lock);
+    auto iter = g_index_hash_memo.find(track.get_ptr());
+    if(iter != g_index_hash_memo.end())
+    {
+        index_hash_memo_entry& entry = iter->second;
+        g_index_hash_memo_recency.splice(g_index_hash_memo_recency.begin(), g_index_hash_memo_recency, entry.recency);
+        if(entry.info != info)
+        {
+            entry.info = info;
+            entry.hash = lyric_metadb_index_client::hash(info->info());
+            entry.legacy_record_checked = false;
+        }
+        return entry.hash;
+    }
+
+    if(g_index_hash_memo.size() >= INDEX_HASH_MEMO_MAX_SIZE)
+    {
+        g_index_hash_memo.erase(g_index_hash_memo_recency.back());
+        g_index_hash_memo_recency.pop_back();
+    }
+
+    metadb_index_hash result = lyric_metadb_index_client::hash(info->info());
+    g_index_hash_memo_recency.push_front(track.get_ptr());
+    g_index_hash_memo[track.get_ptr()] = {track, info, result, g_index_hash_memo_recency.begin(), false};
+    return result;
+}
+
+// NOTE: These must only be called after lyric_metadb_index_hash for the same track, so that the memo entry
+//       (if there is one) is for the track's current info.
+static bool legacy_record_checked(const metadb_handle_ptr& track)
+{
+    std::lock_guard<std::mutex> lock(g_index_hash_memo_lock);
+    auto iter = g_index_hash_memo.find(track.get_ptr());
+    return (iter != g_index_hash_memo.end()) && iter->second.legacy_record_checked;
+}
+
+static void set_legacy_record_checked(const metadb_handle_ptr& track)
+{
+    std::lock_guard<std::mutex> lock(g_index_hash_memo_lock);
+    auto iter = g_index_hash_memo.find(track.get_ptr());
+    if(iter != g_index_hash_memo.end())
+    {
+        iter->second.legacy_record_checked = true;
+    }
+}
+
+metadb_index_client::ptr lyric_metadb_index_client_instance()
+{
+    return lyric_metadb_index_client::instance();
+}
+
+// Returns the time at which we started migrating legacy records, recording the current time if we haven't started yet
+static t_filetimestamp legacy_migration_start_time()
+{
+    std::string path = core_api::get_profile_path();
+    path += "\\openlyrics_search_avoidance_migration.bin";
+
+    const t_filetimestamp now = filetimestamp_from_system_timer();
+    try
+    {
+        abort_callback_dummy noAbort;
+        file_ptr file;
+        if(filesystem::g_exists(path.c_str(), noAbort))
+        {
+            filesystem::g_open_read(file, path.c_str(), noAbort);
+            t_filetimestamp start_time = 0;
+            file->read_lendian_t(start_time, noAbort);
+            return start_time;
+        }
+
+        filesystem::g_open_write_new(file, path.c_str(), noAbort);
+        file->write_lendian_t(now, noAbort);
+        LOG_INFO("Started migrating legacy search-avoidance records");
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to access the search-avoidance migration time at %s: %s", path.c_str(), e.what());
+    }
+    return now;
+}
+
+class lyric_metadb_index_init : public init_stage_callback
+{
+    void on_init_stage(t_uint32 stage) override
+    {
+        if(stage != init_stages::before_config_read)
+        {
+            return;
+        }
+
+        auto mim = metadb_index_manager::get();
+        try
+        {
+            mim->add(lyric_metadb_index_client::instance(), GUID_METADBINDEX_LYRIC_HISTORY, system_time_periods::week);
+
+            const t_filetimestamp now = filetimestamp_from_system_timer();
+            if(now < legacy_migration_start_time() + LEGACY_MIGRATION_PERIOD)
+            {
+                mim->add(lyric_legacy_metadb_index_client::instance(), GUID_METADBINDEX_LYRIC_HISTORY_LEGACY, system_time_periods::week);
+                g_legacy_index_registered = true;
+            }
+            else
+            {
+                mim->remove(GUID_METADBINDEX_LYRIC_HISTORY_LEGACY);
+            }
+
+            mim->dispatch_global_refresh();
+            LOG_INFO("Successfully initialised the lyric metadb index");
+        }
+        catch(const std::exception& ex)
+        {
+            mim->remove(GUID_METADBINDEX_LYRIC_HISTORY);
+            mim->remove(GUID_METADBINDEX_LYRIC_HISTORY_LEGACY);
+            g_legacy_index_registered = false;
+            LOG_INFO("Failed to initialise the lyric metadb index: %s", ex.what());
+        }
+    }
+};
+static service_factory_single_t<lyric_metadb_index_init> g_lyric_metadb_index_init;
+
+static uint32_t get_source_key(const GUID& source_id)
+{
+    // NOTE: Our source GUIDs are all randomly generated, so the first 32 bits are plenty to distinguish
+    //       between the handful of sources that exist and this keeps each stored entry small.
+    return static_cast<uint32_t>(source_id.Data1);
+}
+
+static t_filetimestamp compute_backoff_delay(uint16_t failed_searches)
+{
+    t_filetimestamp delay = SEARCH_AVOIDANCE_BASE_DELAY;
+    for(uint16_t i=1; (i<failed_searches) && (delay < SEARCH_AVOIDANCE_MAX_DELAY); i++)
+    {
+        delay *= 2;
+    }
+    delay = min(delay, SEARCH_AVOIDANCE_MAX_DELAY);
+
+    thread_local std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<double> jitter_dist(1.0 - SEARCH_AVOIDANCE_JITTER_FRACTION, 1.0 + SEARCH_AVOIDANCE_JITTER_FRACTION);
+    return static_cast<t_filetimestamp>(static_cast<double>(delay) * jitter_dist(rng));
+}
+
+static lyric_search_avoidance from_single_counter(int failed_searches, t_filetimestamp first_fail_time)
+{
+    // NOTE: Records from older versions only know that the search as a whole failed, so we assume
+    //       that every remote source failed and back all of them off from the time of the first failure.
+    //       Under the old scheme a track wasn't skipped until it had failed more than 3 times, so we don't
+    //       back anything off for fewer failures than that.
+    lyric_search_avoidance result = {};
+    if(failed_searches <= 3)
+    {
+        return result;
+    }
+
+    const uint16_t failures = static_cast<uint16_t>(min(failed_searches, int(UINT16_MAX)));
+    for(GUID source_id : LyricSourceBase::get_all_ids())
+    {
+        LyricSourceBase* source = LyricSourceBase::get(source_id);
+        if((source == nullptr) || source->is_local())
+        {
+            continue;
+        }
+        result.sources.push_back({get_source_key(source_id), failures, first_fail_time + compute_backoff_delay(failures)});
+    }
+    return result;
+}
+
+static bool read_search_avoidance(const void* data, size_t data_bytes, bool has_version, lyric_search_avoidance& out_avoidance)
+{
+    try
+    {
+        stream_reader_formatter_simple<false> reader(data, data_bytes);
+        uint8_t version = SEARCH_AVOIDANCE_RECORD_VERSION_SINGLE_COUNTER;
+        if(has_version)
+        {
+            reader >> version;
+        }
+
+        if(version == SEARCH_AVOIDANCE_RECORD_VERSION_SINGLE_COUNTER)
+        {
+            int failed_searches = 0;
+            t_filetimestamp first_fail_time = 0;
+            uint64_t search_config_generation = 0;
+            reader >> failed_searches;
+            reader >> first_fail_time;
+            reader >> search_config_generation;
+            out_avoidance = from_single_counter(failed_searches, first_fail_time);
+            return true;
+        }
+        else if(version == SEARCH_AVOIDANCE_RECORD_VERSION)
+        {
+            lyric_search_avoidance result = {};
+            uint8_t source_count = 0;
+            reader >> source_count;
+            result.sources.resize(source_count);
+            for(lyric_search_avoidance_source& source : result.sources)
+            {
+                reader >> source.source_key;
+                reader >> source.failed_searches;
+                reader >> source.next_search_time;
+            }
+            out_avoidance = std::move(result);
+            return true;
+        }
+        else
+        {
+            LOG_INFO("Unrecognised search-avoidance record version: %u", version);
+            return false;
+        }
+    }
+    catch(const std::exception& ex)
+    {
+        LOG_INFO("Failed to read search-avoidance info: %s", ex.what());
+        return false;
+    }
+}
+
+static void write_search_avoidance(metadb_index_manager::ptr& meta_index, metadb_index_hash index_hash, const lyric_search_avoidance& avoidance)
+{
+    if(avoidance.sources.empty())
+    {
+        meta_index->set_user_data(GUID_METADBINDEX_LYRIC_HISTORY, index_hash, nullptr, 0);
+        return;
+    }
+
+    const size_t source_count = min(avoidance.sources.size(), size_t(UINT8_MAX));
+    stream_writer_formatter_simple<false> writer;
+    writer << SEARCH_AVOIDANCE_RECORD_VERSION;
+    writer << static_cast<uint8_t>(source_count);
+    for(size_t i=0; i<source_count; i++)
+    {
+        const lyric_search_avoidance_source& source = avoidance.sources[i];
+        writer << source.source_key;
+        writer << source.failed_searches;
+        writer << source.next_search_time;
+    }
+
+    meta_index->set_user_data(GUID_METADBINDEX_LYRIC_HISTORY,
+                              index_hash,
+                              writer.m_buffer.get_ptr(),
+                              writer.m_buffer.get_size());
+}
+
+static lyric_search_avoidance load_search_avoidance(metadb_index_manager::ptr& meta_index, const metadb_handle_ptr& track, metadb_index_hash index_hash)
+{
+    char data_buffer[512] = {};
+    lyric_search_avoidance result = {};
+
+    size_t data_bytes = meta_index->get_user_data_here(GUID_METADBINDEX_LYRIC_HISTORY,
+                                                       index_hash,
+                                                       data_buffer,
+                                                       sizeof(data_buffer));
+    if(data_bytes > 0)
+    {
+        read_search_avoidance(data_buffer, data_bytes, true, result);
+        return result;
+    }
+
+    // NOTE: There is no current record, so check for one under the legacy hash. If we find one
+    //       then copy it across so that subsequent loads find it in the current index.
+    //       The legacy record is cleared so that it does not get migrated a second time.
+    if(!g_legacy_index_registered || legacy_record_checked(track))
+    {
+        return result;
+    }
+    set_legacy_record_checked(track);
+
+    metadb_info_container::ptr info = track->get_info_ref();
+    metadb_index_hash legacy_hash = lyric_legacy_metadb_index_client::hash(info->info());
+    size_t legacy_bytes = meta_index->get_user_data_here(GUID_METADBINDEX_LYRIC_HISTORY_LEGACY,
+                                                         legacy_hash,
+                                                         data_buffer,
+                                                         sizeof(data_buffer));
+    if((legacy_bytes > 0) && read_search_avoidance(data_buffer, legacy_bytes, false, result))
+    {
+        write_search_avoidance(meta_index, index_hash, result);
+        meta_index->set_user_data(GUID_METADBINDEX_LYRIC_HISTORY_LEGACY, legacy_hash, nullptr, 0);
+    }
+    return result;
+}
+
+lyric_search_avoidance load_search_avoidance(metadb_handle_ptr track)
+{
+    auto meta_index = metadb_index_manager::get();
+    metadb_index_hash our_index_hash = lyric_metadb_index_hash(track);
+    return load_search_avoidance(meta_index, track, our_index_hash);
+}
+
+std::vector<lyric_search_avoidance> load_search_avoidance(const std::vector<metadb_handle_ptr>& tracks)
+{
+    std::vector<lyric_search_avoidance> result;
+    result.reserve(tracks.size());
+
+    // NOTE: Many tracks in a bulk search are likely to share a hash (e.g different releases of the same song)
+    //       so we only look up each distinct hash once.
+    auto meta_index = metadb_index_manager::get();
+    std::unordered_map<metadb_index_hash, lyric_search_avoidance> loaded;
+    for(const metadb_handle_ptr& track : tracks)
+    {
+        metadb_index_hash index_hash = lyric_metadb_index_hash(track);
+        auto iter = loaded.find(index_hash);
+        if(iter == loaded.end())
+        {
+            iter = loaded.emplace(index_hash, load_search_avoidance(meta_index, track, index_hash)).first;
+        }
+        result.push_back(iter->second);
+    }
+    return result;
+}
+
+void save_search_avoidance(metadb_handle_ptr track, const lyric_search_avoidance& avoidance)
+{
+    auto meta_index = metadb_index_manager::get();
+    metadb_index_hash our_index_hash = lyric_metadb_index_hash(track);
+    write_search_avoidance(meta_index, our_index_hash, avoidance);
+}
+
+bool search_avoidance_allows_search(const lyric_search_avoidance& avoidance, const GUID& source_id, t_filetimestamp now)
+{
+    const uint32_t source_key = get_source_key(source_id);
+    for(const lyric_search_avoidance_source& source : avoidance.sources)
+    {
+        if(source.source_key == source_key)
+        {
+            return (now >= source.next_search_time);
+        }
+    }
+    return true;
+}
+
+void search_avoidance_record_failure(lyric_search_avoidance& avoidance, const GUID& source_id, t_filetimestamp now)
+{
+    const uint32_t source_key = get_source_key(source_id);
+    auto iter = std::find_if(avoidance.sources.begin(),
+                             avoidance.sources.end(),
+                             [source_key](const lyric_search_avoidance_source& source){ return source.source_key == source_key; });
+    if(iter == avoidance.sources.end())
+    {
+        avoidance.sources.push_back({source_key, 0, 0});
+        iter = avoidance.sources.end() - 1;
+    }
+
+    if(iter->failed_searches < UINT16_MAX)
+    {
+        iter->failed_searches++;
+    }
+    iter->next_search_time = now + compute_backoff_delay(iter->failed_searches);
+}
+
+bool search_avoidance_record_success(lyric_search_avoidance& avoidance, const GUID& source_id)
+{
+    const uint32_t source_key = get_source_key(source_id);
+    auto iter = std::find_if(avoidance.sources.begin(),
+                             avoidance.sources.end(),
+                             [source_key](const lyric_search_avoidance_source& source){ return source.source_key == source_key; });
+    if(iter == avoidance.sources.end())
+    {
+        return false;
+    }
+
+    avoidance.sources.erase(iter);
+    return true;
+}
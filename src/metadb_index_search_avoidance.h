@@ -1,14 +1,27 @@
-#pragma once
-
-#include "stdafx.h"
-
-struct lyric_search_avoidance
-{
-    int failed_searches;
-    t_filetimestamp first_fail_time;
-    uint64_t search_config_generation;
-};
-
-lyric_search_avoidance load_search_avoidance(metadb_handle_ptr track);
-void save_search_avoidance(metadb_handle_ptr track, lyric_search_avoidance avoidance);
-
+#pragma once
+
+#include "stdafx.h"
+
+// NOTE: All of our metadb indices identify tracks by the same hash of the artist, album & title
+metadb_index_client::ptr lyric_metadb_index_client_instance();
+metadb_index_hash lyric_metadb_index_hash(const metadb_handle_ptr& track);
+
+struct lyric_search_avoidance_source
+{
+    uint32_t source_key;
+    uint16_t failed_searches;
+    t_filetimestamp next_search_time;
+};
+
+struct lyric_search_avoidance
+{
+    std::vector<lyric_search_avoidance_source> sources;
+};
+
+lyric_search_avoidance load_search_avoidance(metadb_handle_ptr track);
+std::vector<lyric_search_avoidance> load_search_avoidance(const std::vector<metadb_handle_ptr>& tracks);
+void save_search_avoidance(metadb_handle_ptr track, const lyric_search_avoidance& avoidance);
+
+bool search_avoidance_allows_search(const lyric_search_avoidance& avoidance, const GUID& source_id, t_filetimestamp now);
+void search_avoidance_record_failure(lyric_search_avoidance& avoidance, const GUID& source_id, t_filetimestamp now);
+bool search_avoidance_record_success(lyric_search_avoidance& avoidance, const GUID& source_id);
@@ -0,0 +1,614 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#include "json.h"
+
+namespace parsers::json
+{
+
+static constexpr int INDEX_NONE = -2;
+static constexpr int INDEX_ANY = -1;
+
+// NOTE: A path segment is either an object key (in which case index is INDEX_NONE) or an array index.
+//       Keys are compared in their raw (still-escaped) form, which is fine for the plain ASCII keys we look for.
+struct PathSegment
+{
+    std::string_view key;
+    int index;
+};
+using Path = std::vector<PathSegment>;
+
+static Path parse_path(std::string_view path)
+{
+    Path result;
+    size_t pos = 0;
+    while(pos < path.length())
+    {
+        if(path[pos] == '.')
+        {
+            pos++;
+        }
+        else if(path[pos] == '[')
+        {
+            size_t close_index = path.find(']', pos);
+            if(close_index == std::string_view::npos)
+            {
+                close_index = path.length();
+            }
+
+            std::string_view index_str = path.substr(pos + 1, close_index - pos - 1);
+            int index = INDEX_ANY;
+            if(!index_str.empty())
+            {
+                index = 0;
+                for(char c : index_str)
+                {
+                    index = (index*10) + (c - '0');
+                }
+            }
+            result.push_back({{}, index});
+            pos = close_index + 1;
+        }
+        else
+        {
+            size_t end_index = path.find_first_of(".[", pos);
+            if(end_index == std::string_view::npos)
+            {
+                end_index = path.length();
+            }
+            result.push_back({path.substr(pos, end_index - pos), INDEX_NONE});
+            pos = end_index;
+        }
+    }
+    return result;
+}
+
+static bool segment_matches(const PathSegment& pattern, const PathSegment& actual)
+{
+    if(pattern.index == INDEX_NONE)
+    {
+        return (actual.index == INDEX_NONE) && (pattern.key == actual.key);
+    }
+    else
+    {
+        return (actual.index != INDEX_NONE) && ((pattern.index == INDEX_ANY) || (pattern.index == actual.index));
+    }
+}
+
+// Returns true if the first `length` segments of `actual` (starting from `offset`) match the start of `pattern`
+static bool path_prefix_matches(const Path& pattern, const Path& actual, size_t offset, size_t length)
+{
+    if(length > pattern.size())
+    {
+        return false;
+    }
+    for(size_t i=0; i<length; i++)
+    {
+        if(!segment_matches(pattern[i], actual[offset + i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void append_utf8(std::string& output, uint32_t codepoint)
+{
+    if(codepoint < 0x80)
+    {
+        output += char(codepoint);
+    }
+    else if(codepoint < 0x800)
+    {
+        output += char(0xC0 | (codepoint >> 6));
+        output += char(0x80 | (codepoint & 0x3F));
+    }
+    else if(codepoint < 0x10000)
+    {
+        output += char(0xE0 | (codepoint >> 12));
+        output += char(0x80 | ((codepoint >> 6) & 0x3F));
+        output += char(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+        output += char(0xF0 | (codepoint >> 18));
+        output += char(0x80 | ((codepoint >> 12) & 0x3F));
+        output += char(0x80 | ((codepoint >> 6) & 0x3F));
+        output += char(0x80 | (codepoint & 0x3F));
+    }
+}
+
+class RecordExtractor
+{
+public:
+    RecordExtractor(std::string_view input,
+                    std::string_view record_path,
+                    const std::vector<std::string_view>& field_paths,
+                    const std::function<bool(const RecordFields&)>& on_record)
+        : m_input(input)
+        , m_record_path(parse_path(record_path))
+        , m_on_record(on_record)
+    {
+        for(std::string_view field_path : field_paths)
+        {
+            m_field_paths.push_back(parse_path(field_path));
+        }
+    }
+
+    bool run(std::string* out_error)
+    {
+        parse_value();
+        if(m_error && (out_error != nullptr))
+        {
+            *out_error = m_error_message;
+        }
+        return !m_error;
+    }
+
+private:
+    bool fail(const char* reason)
+    {
+        if(!m_error)
+        {
+            char message[128];
+            snprintf(message, sizeof(message), "%s at offset %u", reason, (unsigned int)m_pos);
+            m_error_message = message;
+        }
+        m_error = true;
+        return false;
+    }
+
+    void skip_whitespace()
+    {
+        while((m_pos < m_input.length()) &&
+              ((m_input[m_pos] == ' ') || (m_input[m_pos] == '\t') || (m_input[m_pos] == '\r') || (m_input[m_pos] == '\n')))
+        {
+            m_pos++;
+        }
+    }
+
+    bool in_record() const
+    {
+        return m_record_fields.has_value();
+    }
+
+    // Returns true if the value at the current path could contain something we're looking for
+    bool current_path_is_relevant() const
+    {
+        if(in_record())
+        {
+            const size_t record_depth = m_record_path.size();
+            const size_t relative_depth = m_path.size() - record_depth;
+            for(const Path& field_path : m_field_paths)
+            {
+                if((relative_depth < field_path.size()) && path_prefix_matches(field_path, m_path, record_depth, relative_depth))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        else
+        {
+            return path_prefix_matches(m_record_path, m_path, 0, m_path.size());
+        }
+    }
+
+    // Returns the index of the field at the current path, or nothing if we're not in a record or the current
+    // path is not one of the fields that we're looking for
+    std::optional<size_t> current_field_index() const
+    {
+        if(!in_record())
+        {
+            return {};
+        }
+
+        const size_t record_depth = m_record_path.size();
+        const size_t relative_depth = m_path.size() - record_depth;
+        for(size_t i=0; i<m_field_paths.size(); i++)
+        {
+            const Path& field_path = m_field_paths[i];
+            if((relative_depth == field_path.size()) && path_prefix_matches(field_path, m_path, record_depth, relative_depth))
+            {
+                return i;
+            }
+        }
+        return {};
+    }
+
+    // Returns false if parsing should stop, either because of an error or because the caller asked to stop
+    bool parse_value()
+    {
+        const bool starts_record = !in_record() && (m_path.size() == m_record_path.size()) && path_prefix_matches(m_record_path, m_path, 0, m_path.size());
+        if(starts_record)
+        {
+            m_record_fields = RecordFields(m_field_paths.size());
+        }
+
+        bool keep_going = parse_value_contents();
+        if(starts_record)
+        {
+            if(keep_going)
+            {
+                keep_going = m_on_record(m_record_fields.value());
+            }
+            m_record_fields.reset();
+        }
+        return keep_going;
+    }
+
+    bool parse_value_contents()
+    {
+        skip_whitespace();
+        if(m_pos >= m_input.length())
+        {
+            return fail("Unexpected end of input");
+        }
+
+        const char c = m_input[m_pos];
+        if((c == '{') || (c == '['))
+        {
+            if(!current_path_is_relevant())
+            {
+                return skip_container();
+            }
+            return (c == '{') ? parse_object() : parse_array();
+        }
+        else if(c == '"')
+        {
+            // NOTE: Most of the strings in a record are not fields that we're looking for, so we only
+            //       pay for unescaping (and copying) the ones that are.
+            const std::optional<size_t> field_index = current_field_index();
+            if(!field_index.has_value())
+            {
+                return skip_string();
+            }
+
+            Scalar value = {ScalarType::String, {}};
+            if(!parse_string(value.text))
+            {
+                return false;
+            }
+            (*m_record_fields)[field_index.value()] = std::move(value);
+            return true;
+        }
+        else
+        {
+            return parse_literal();
+        }
+    }
+
+    bool parse_object()
+    {
+        assert(m_input[m_pos] == '{');
+        m_pos++;
+
+        skip_whitespace();
+        if((m_pos < m_input.length()) && (m_input[m_pos] == '}'))
+        {
+            m_pos++;
+            return true;
+        }
+
+        while(true)
+        {
+            skip_whitespace();
+            if((m_pos >= m_input.length()) || (m_input[m_pos] != '"'))
+            {
+                return fail("Expected an object key");
+            }
+            const size_t key_start = m_pos + 1;
+            if(!skip_string())
+            {
+                return false;
+            }
+            const std::string_view key = m_input.substr(key_start, m_pos - key_start - 1);
+
+            skip_whitespace();
+            if((m_pos >= m_input.length()) || (m_input[m_pos] != ':'))
+            {
+                return fail("Expected ':' after object key");
+            }
+            m_pos++;
+
+            m_path.push_back({key, INDEX_NONE});
+            const bool keep_going = parse_value();
+            m_path.pop_back();
+            if(!keep_going)
+            {
+                return false;
+            }
+
+            skip_whitespace();
+            if(m_pos >= m_input.length())
+            {
+                return fail("Unterminated object");
+            }
+            const char c = m_input[m_pos++];
+            if(c == '}')
+            {
+                return true;
+            }
+            else if(c != ',')
+            {
+                return fail("Expected ',' or '}' in object");
+            }
+        }
+    }
+
+    bool parse_array()
+    {
+        assert(m_input[m_pos] == '[');
+        m_pos++;
+
+        skip_whitespace();
+        if((m_pos < m_input.length()) && (m_input[m_pos] == ']'))
+        {
+            m_pos++;
+            return true;
+        }
+
+        for(int index=0; ; index++)
+        {
+            m_path.push_back({{}, index});
+            const bool keep_going = parse_value();
+            m_path.pop_back();
+            if(!keep_going)
+            {
+                return false;
+            }
+
+            skip_whitespace();
+            if(m_pos >= m_input.length())
+            {
+                return fail("Unterminated array");
+            }
+            const char c = m_input[m_pos++];
+            if(c == ']')
+            {
+                return true;
+            }
+            else if(c != ',')
+            {
+                return fail("Expected ',' or ']' in array");
+            }
+        }
+    }
+
+    bool parse_literal()
+    {
+        const size_t start = m_pos;
+        while((m_pos < m_input.length()) &&
+              (m_input[m_pos] != ',') && (m_input[m_pos] != '}') && (m_input[m_pos] != ']') &&
+              (m_input[m_pos] != ' ') && (m_input[m_pos] != '\t') && (m_input[m_pos] != '\r') && (m_input[m_pos] != '\n'))
+        {
+            m_pos++;
+        }
+
+        const std::string_view literal = m_input.substr(start, m_pos - start);
+        ScalarType type;
+        if((literal == "true") || (literal == "false"))
+        {
+            type = ScalarType::Bool;
+        }
+        else if(literal == "null")
+        {
+            type = ScalarType::Null;
+        }
+        else if(!literal.empty() && ((literal[0] == '-') || ((literal[0] >= '0') && (literal[0] <= '9'))))
+        {
+            type = ScalarType::Number;
+        }
+        else
+        {
+            return fail("Unrecognised literal value");
+        }
+
+        const std::optional<size_t> field_index = current_field_index();
+        if(field_index.has_value())
+        {
+            (*m_record_fields)[field_index.value()] = {type, std::string(literal)};
+        }
+        return true;
+    }
+
+    bool skip_string()
+    {
+        assert(m_input[m_pos] == '"');
+        for(m_pos++; m_pos < m_input.length(); m_pos++)
+        {
+            if(m_input[m_pos] == '\\')
+            {
+                m_pos++;
+            }
+            else if(m_input[m_pos] == '"')
+            {
+                m_pos++;
+                return true;
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    bool skip_container()
+    {
+        int depth = 0;
+        while(m_pos < m_input.length())
+        {
+            const char c = m_input[m_pos];
+            if(c == '"')
+            {
+                if(!skip_string())
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            m_pos++;
+            if((c == '{') || (c == '['))
+            {
+                depth++;
+            }
+            else if((c == '}') || (c == ']'))
+            {
+                depth--;
+                if(depth == 0)
+                {
+                    return true;
+                }
+            }
+        }
+        return fail("Unterminated object or array");
+    }
+
+    bool parse_hex4(uint32_t& out_value)
+    {
+        if(m_pos + 4 > m_input.length())
+        {
+            return fail("Truncated unicode escape");
+        }
+
+        out_value = 0;
+        for(int i=0; i<4; i++)
+        {
+            const char c = m_input[m_pos++];
+            uint32_t digit;
+            if((c >= '0') && (c <= '9')) digit = c - '0';
+            else if((c >= 'a') && (c <= 'f')) digit = 10 + (c - 'a');
+            else if((c >= 'A') && (c <= 'F')) digit = 10 + (c - 'A');
+            else return fail("Invalid unicode escape");
+            out_value = (out_value << 4) | digit;
+        }
+        return true;
+    }
+
+    bool parse_string(std::string& output)
+    {
+        assert(m_input[m_pos] == '"');
+        m_pos++;
+
+        while(m_pos < m_input.length())
+        {
+            // NOTE: Copy unescaped runs in one go, most strings contain no escapes at all
+            const size_t run_end = m_input.find_first_of("\"\\", m_pos);
+            if(run_end == std::string_view::npos)
+            {
+                break;
+            }
+            output.append(m_input.data() + m_pos, run_end - m_pos);
+            m_pos = run_end;
+
+            if(m_input[m_pos] == '"')
+            {
+                m_pos++;
+                return true;
+            }
+
+            m_pos++; // Skip the backslash
+            if(m_pos >= m_input.length())
+            {
+                break;
+            }
+            const char escaped = m_input[m_pos++];
+            switch(escaped)
+            {
+                case '"': output += '"'; break;
+                case '\\': output += '\\'; break;
+                case '/': output += '/'; break;
+                case 'b': output += '\b'; break;
+                case 'f': output += '\f'; break;
+                case 'n': output += '\n'; break;
+                case 'r': output += '\r'; break;
+                case 't': output += '\t'; break;
+                case 'u':
+                {
+                    uint32_t codepoint = 0;
+                    if(!parse_hex4(codepoint))
+                    {
+                        return false;
+                    }
+
+                    // NOTE: Characters outside the BMP are encoded as a UTF-16 surrogate pair of escapes.
+                    //       A surrogate that is not part of a valid pair has no UTF-8 encoding, so it is
+                    //       replaced with U+FFFD (the replacement character) rather than output as invalid UTF-8.
+                    if((codepoint >= 0xD800) && (codepoint <= 0xDBFF))
+                    {
+                        const size_t next_escape = m_pos;
+                        uint32_t low_surrogate = 0;
+                        if((m_pos + 1 < m_input.length()) && (m_input[m_pos] == '\\') && (m_input[m_pos+1] == 'u'))
+                        {
+                            m_pos += 2;
+                            if(!parse_hex4(low_surrogate))
+                            {
+                                return false;
+                            }
+                        }
+
+                        if((low_surrogate >= 0xDC00) && (low_surrogate <= 0xDFFF))
+                        {
+                            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low_surrogate - 0xDC00);
+                        }
+                        else
+                        {
+                            codepoint = 0xFFFD;
+                            m_pos = next_escape; // Whatever followed the high surrogate is decoded on its own
+                        }
+                    }
+                    else if((codepoint >= 0xDC00) && (codepoint <= 0xDFFF))
+                    {
+                        codepoint = 0xFFFD;
+                    }
+                    append_utf8(output, codepoint);
+                } break;
+
+                default:
+                    return fail("Invalid escape sequence");
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+
+    std::string_view m_input;
+    size_t m_pos = 0;
+    bool m_error = false;
+    std::string m_error_message;
+
+    Path m_path;
+    const Path m_record_path;
+    std::vector<Path> m_field_paths;
+    const std::function<bool(const RecordFields&)>& m_on_record;
+    std::optional<RecordFields> m_record_fields;
+};
+
+std::optional<int64_t> Scalar::as_int64() const
+{
+    if((type != ScalarType::Number) || text.empty())
+    {
+        return {};
+    }
+
+    // NOTE: Some APIs send IDs with a fractional part or an exponent (e.g 1.2345e5), so fall back to
+    //       parsing as a double if we don't consume the whole string as an integer.
+    char* end = nullptr;
+    const int64_t value = strtoll(text.c_str(), &end, 10);
+    if(end == text.c_str() + text.length())
+    {
+        return value;
+    }
+    return static_cast<int64_t>(strtod(text.c_str(), nullptr));
+}
+
+bool extract_records(std::string_view input,
+                     std::string_view record_path,
+                     const std::vector<std::string_view>& field_paths,
+                     const std::function<bool(const RecordFields&)>& on_record,
+                     std::string* out_error)
+{
+    RecordExtractor extractor(input, record_path, field_paths, on_record);
+    return extractor.run(out_error);
+}
+
+} // namespace parsers::json
@@ -0,0 +1,48 @@
+#pragma once
+
+// NOTE: This deliberately does not depend on the foobar2000 SDK so that it can be built and tested on its own.
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace parsers
+{
+
+namespace json
+{
+    enum class ScalarType
+    {
+        String,
+        Number,
+        Bool,
+        Null
+    };
+
+    struct Scalar
+    {
+        ScalarType type;
+        std::string text; // The unescaped contents for strings, the literal source text for everything else
+
+        std::optional<int64_t> as_int64() const;
+    };
+    using RecordFields = std::vector<std::optional<Scalar>>;
+
+    // Streams through a JSON document without building a DOM, calling `on_record` once for each
+    // element of the array at `record_path` with the values found at each of `field_paths` within that element.
+    // Paths are dot-separated object keys, with "[]" to match any array element or "[n]" to match only the
+    // element at index n. For example: record_path="message.body.track_list[]" and field_path="track.track_name",
+    // or record_path="result.songs[]" and field_path="artists[0].name".
+    // Subtrees that cannot contain any of the requested paths are skipped without being parsed.
+    // Parsing stops early if `on_record` returns false. Returns false if the document is malformed, in which case
+    // `out_error` (if given) is set to a description of the problem and where it was found.
+    bool extract_records(std::string_view input,
+                         std::string_view record_path,
+                         const std::vector<std::string_view>& field_paths,
+                         const std::function<bool(const RecordFields&)>& on_record,
+                         std::string* out_error = nullptr);
+} // namespace json
+
+} // namespace parsers
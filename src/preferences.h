@@ -1,100 +1,121 @@
-#pragma once
-
-#include "stdafx.h"
-
-extern const GUID GUID_PREFERENCES_PAGE_ROOT;
-
-// NOTE: These enums must change in a backward-compatible manner.
-//       This means that values can never be removed or re-used.
-//       If we don't do this then updates will cause weird behaviour on users that have
-//       saved settings on previous versions.
-enum class SaveMethod : int
-{
-    DEPRECATED_None = 0,
-    LocalFile       = 1,
-    Id3Tag          = 2
-};
-
-enum class SaveDirectoryClass : int
-{
-    DEPRECATED_None    = 0,
-    ConfigDirectory    = 1,
-    TrackFileDirectory = 2,
-    Custom             = 3
-};
-
-enum class AutoSaveStrategy : int
-{
-    Never        = 0,
-    Always       = 1,
-    OnlySynced   = 2,
-    OnlyUnsynced = 3,
-};
-
-enum class LineScrollDirection : int
-{
-    Vertical   = 0,
-    Horizontal = 1
-};
-
-enum class LineScrollType : int
-{
-    Automatic = 0,
-    Manual    = 1,
-};
-
-enum class AutoEditType : int
-{
-    Unknown                  = 0,
-    CreateInstrumental       = 1,
-    ReplaceHtmlEscapedChars  = 2,
-    RemoveRepeatedSpaces     = 3,
-    RemoveRepeatedBlankLines = 4,
-    RemoveAllBlankLines      = 5,
-    ResetCapitalisation      = 6,
-    FixMalformedTimestamps   = 7,
-};
-
-namespace preferences
-{
-    namespace searching
-    {
-        uint64_t source_config_generation();
-        std::vector<GUID> active_sources();
-        std::vector<std::string> tags();
-        bool exclude_trailing_brackets();
-
-        std::string musixmatch_api_key();
-    }
-
-    namespace editing
-    {
-        std::vector<AutoEditType> automated_auto_edits();
-    }
-
-    namespace saving
-    {
-        AutoSaveStrategy autosave_strategy();
-        GUID save_source();
-
-        std::string filename(metadb_handle_ptr track);
-
-        std::string_view untimed_tag();
-        std::string_view timestamped_tag();
-
-        bool merge_equivalent_lrc_lines();
-    }
-
-    namespace display
-    {
-        t_ui_font font();
-        std::optional<t_ui_color> foreground_colour();
-        std::optional<t_ui_color> background_colour();
-        std::optional<t_ui_color> highlight_colour();
-
-        LineScrollDirection scroll_direction();
-        LineScrollType scroll_type();
-        double scroll_time_seconds();
-        int linegap();
-    }
-}
+#pragma once
+
+#include "stdafx.h"
+
+extern const GUID GUID_PREFERENCES_PAGE_ROOT;
+
+// NOTE: These enums must change in a backward-compatible manner.
+//       This means that values can never be removed or re-used.
+//       If we don't do this then updates will cause weird behaviour on users that have
+//       saved settings on previous versions.
+enum class SaveMethod : int
+{
+    DEPRECATED_None = 0,
+    LocalFile       = 1,
+    Id3Tag          = 2
+};
+
+enum class SaveDirectoryClass : int
+{
+    DEPRECATED_None    = 0,
+    ConfigDirectory    = 1,
+    TrackFileDirectory = 2,
+    Custom             = 3
+};
+
+enum class AutoSaveStrategy : int
+{
+    Never        = 0,
+    Always       = 1,
+    OnlySynced   = 2,
+    OnlyUnsynced = 3,
+};
+
+enum class LineScrollDirection : int
+{
+    Vertical   = 0,
+    Horizontal = 1
+};
+
+enum class LineScrollType : int
+{
+    Automatic = 0,
+    Manual    = 1,
+};
+
+enum class AutoEditType : int
+{
+    Unknown                  = 0,
+    CreateInstrumental       = 1,
+    ReplaceHtmlEscapedChars  = 2,
+    RemoveRepeatedSpaces     = 3,
+    RemoveRepeatedBlankLines = 4,
+    RemoveAllBlankLines      = 5,
+    ResetCapitalisation      = 6,
+    FixMalformedTimestamps   = 7,
+};
+
+enum class HttpFixtureMode : int
+{
+    Disabled = 0,
+    Record   = 1,
+    Replay   = 2,
+};
+
+namespace preferences
+{
+    namespace searching
+    {
+        std::vector<GUID> active_sources();
+        std::vector<std::string> tags();
+        bool exclude_trailing_brackets();
+
+        std::string musixmatch_api_key();
+    }
+
+    namespace editing
+    {
+        std::vector<AutoEditType> automated_auto_edits();
+    }
+
+    namespace saving
+    {
+        AutoSaveStrategy autosave_strategy();
+        GUID save_source();
+
+        std::string filename(metadb_handle_ptr track);
+        // Computes the filenames for many tracks at once, looking up the save settings only once
+        std::vector<std::string> filename(const std::vector<metadb_handle_ptr>& tracks);
+
+        std::string_view untimed_tag();
+        std::string_view timestamped_tag();
+
+        bool merge_equivalent_lrc_lines();
+    }
+
+    namespace display
+    {
+        t_ui_font font();
+        std::optional<t_ui_color> foreground_colour();
+        std::optional<t_ui_color> background_colour();
+        std::optional<t_ui_color> highlight_colour();
+
+        LineScrollDirection scroll_direction();
+        LineScrollType scroll_type();
+        double scroll_time_seconds();
+        int linegap();
+    }
+
+    namespace advanced
+    {
+        HttpFixtureMode http_fixture_mode();
+        std::string http_fixture_directory();
+        std::string http_standin_server();
+        bool scraper_page_disk_cache();
+        bool musixmatch_macro_search();
+        size_t bulk_search_concurrency();
+        size_t musixmatch_concurrent_lookups();
+        size_t netease_concurrent_lookups();
+        size_t qqmusic_concurrent_lookups();
+    }
+}
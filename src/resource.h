@@ -1,86 +1,86 @@
-//{{NO_DEPENDENCIES}}
-// Microsoft Visual C++ generated include file.
-// Used by foo_openlyrics.rc
-//
-#define IDI_SCROLL                      109
-#define IDD_LYRIC_EDIT                  113
-#define IDD_MANUAL_SEARCH               121
-#define IDD_BULK_SEARCH                 125
-#define IDD_PREFERENCES_ROOT            148
-#define IDD_PREFERENCES_SAVING          149
-#define IDD_PREFERENCES_DISPLAY         150
-#define IDD_PREFERENCES_EDIT            151
-#define IDC_ACTIVE_SOURCE_LIST          1021
-#define IDC_INACTIVE_SOURCE_LIST        1025
-#define IDC_SOURCE_ACTIVATE_BTN         1026
-#define IDC_SOURCE_DEACTIVATE_BTN       1027
-#define IDC_SOURCE_MOVE_UP_BTN          1028
-#define IDC_SOURCE_MOVE_DOWN_BTN        1029
-#define IDC_SAVE_METHOD_COMBO           1032
-#define IDC_SAVE_FILENAME_FORMAT        1034
-#define IDC_FILE_NAME_PREVIEW           1035
-#define IDC_SAVE_FILE_NAME_PREVIEW      1035
-#define IDC_MANUALSEARCH_PREVIEW        1035
-#define ID_LYRIC_EDIT_APPLY             1037
-#define ID_LYRIC_EDIT_OK                1038
-#define ID_LYRIC_EDIT_CANCEL            1039
-#define IDC_LYRIC_TEXT                  1040
-#define IDC_RENDER_LINEGAP_EDIT         1041
-#define IDC_LYRIC_EDIT_SYNC             1042
-#define IDC_LYRIC_EDIT_BACK5            1043
-#define IDC_LYRIC_EDIT_PLAY             1044
-#define IDC_LYRIC_EDIT_FWD5             1045
-#define IDC_LYRIC_EDIT_RESET            1046
-#define IDC_LYRIC_EDIT_TIME             1047
-#define IDC_SAVE_TAG_UNSYNCED           1048
-#define IDC_SAVE_TAG_SYNCED             1049
-#define IDC_SEARCH_TAGS                 1050
-#define IDC_FONT                        1051
-#define IDC_FOREGROUND_COLOUR           1054
-#define IDC_HIGHLIGHT_COLOUR            1055
-#define IDC_BACKGROUND_COLOUR           1056
-#define IDC_FOREGROUND_COLOUR_CUSTOM    1059
-#define IDC_BACKGROUND_COLOUR_CUSTOM    1060
-#define IDC_HIGHLIGHT_COLOUR_CUSTOM     1061
-#define IDC_FONT_CUSTOM                 1062
-#define IDC_SAVE_DIRECTORY_CLASS        1063
-#define IDC_SAVE_CUSTOM_PATH            1064
-#define IDC_SAVE_CUSTOM_PATH_PREVIEW    1065
-#define IDC_SAVE_CUSTOM_PATH_BROWSE     1066
-#define IDC_SAVE_AUTOSAVE_TYPE          1067
-#define IDC_DISPLAY_SCROLL_TIME         1068
-#define IDC_DISPLAY_SCROLL_TIME_PREVIEW 1071
-#define IDC_DISPLAY_SCROLL_DIRECTION    1072
-#define IDC_SEARCH_EXCLUDE_BRACKETS     1073
-#define IDC_LYRIC_EDIT_SYNC_OFFSET      1074
-#define IDC_LYRIC_EDIT_APPLY_OFFSET     1075
-#define IDC_SEARCH_MUSIXMATCH_TOKEN     1077
-#define IDC_MANUALSEARCH_ARTIST         1078
-#define IDC_MANUALSEARCH_ALBUM          1079
-#define IDC_MANUALSEARCH_TITLE          1080
-#define IDC_MANUALSEARCH_PROGRESS       1081
-#define IDC_MANUALSEARCH_RESULTLIST     1082
-#define IDC_MANUALSEARCH_OK             1084
-#define IDC_MANUALSEARCH_CANCEL         1085
-#define IDC_MANUALSEARCH_SEARCH         1086
-#define IDC_SEARCH_MUSIXMATCH_HELP      1087
-#define IDC_DISPLAY_SCROLL_TYPE         1088
-#define IDC_EDIT_AUTOEDITS_AUTOMATED    1089
-#define IDC_SAVE_MERGE_EQUIVALENT_LRC_LINES 1091
-#define IDC_MANUALSEARCH_APPLY          1092
-#define IDC_BULKSEARCH_CLOSE            1093
-#define IDC_BULKSEARCH_PROGRESS         1094
-#define IDC_BULKSEARCH_LIST             1095
-#define IDC_BULKSEARCH_STATUS           1096
-#define IDC_SAVE_SYNTAX_HELP            1097
-
-// Next default values for new objects
-// 
-#ifdef APSTUDIO_INVOKED
-#ifndef APSTUDIO_READONLY_SYMBOLS
-#define _APS_NEXT_RESOURCE_VALUE        127
-#define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1098
-#define _APS_NEXT_SYMED_VALUE           101
-#endif
-#endif
+//{{NO_DEPENDENCIES}}
+// Microsoft Visual C++ generated include file.
+// Used by foo_openlyrics.rc
+//
+#define IDI_SCROLL                      109
+#define IDD_LYRIC_EDIT                  113
+#define IDD_MANUAL_SEARCH               121
+#define IDD_BULK_SEARCH                 125
+#define IDD_PREFERENCES_ROOT            148
+#define IDD_PREFERENCES_SAVING          149
+#define IDD_PREFERENCES_DISPLAY         150
+#define IDD_PREFERENCES_EDIT            151
+#define IDC_ACTIVE_SOURCE_LIST          1021
+#define IDC_INACTIVE_SOURCE_LIST        1025
+#define IDC_SOURCE_ACTIVATE_BTN         1026
+#define IDC_SOURCE_DEACTIVATE_BTN       1027
+#define IDC_SOURCE_MOVE_UP_BTN          1028
+#define IDC_SOURCE_MOVE_DOWN_BTN        1029
+#define IDC_SAVE_METHOD_COMBO           1032
+#define IDC_SAVE_FILENAME_FORMAT        1034
+#define IDC_FILE_NAME_PREVIEW           1035
+#define IDC_SAVE_FILE_NAME_PREVIEW      1035
+#define IDC_MANUALSEARCH_PREVIEW        1035
+#define ID_LYRIC_EDIT_APPLY             1037
+#define ID_LYRIC_EDIT_OK                1038
+#define ID_LYRIC_EDIT_CANCEL            1039
+#define IDC_LYRIC_TEXT                  1040
+#define IDC_RENDER_LINEGAP_EDIT         1041
+#define IDC_LYRIC_EDIT_SYNC             1042
+#define IDC_LYRIC_EDIT_BACK5            1043
+#define IDC_LYRIC_EDIT_PLAY             1044
+#define IDC_LYRIC_EDIT_FWD5             1045
+#define IDC_LYRIC_EDIT_RESET            1046
+#define IDC_LYRIC_EDIT_TIME             1047
+#define IDC_SAVE_TAG_UNSYNCED           1048
+#define IDC_SAVE_TAG_SYNCED             1049
+#define IDC_SEARCH_TAGS                 1050
+#define IDC_FONT                        1051
+#define IDC_FOREGROUND_COLOUR           1054
+#define IDC_HIGHLIGHT_COLOUR            1055
+#define IDC_BACKGROUND_COLOUR           1056
+#define IDC_FOREGROUND_COLOUR_CUSTOM    1059
+#define IDC_BACKGROUND_COLOUR_CUSTOM    1060
+#define IDC_HIGHLIGHT_COLOUR_CUSTOM     1061
+#define IDC_FONT_CUSTOM                 1062
+#define IDC_SAVE_DIRECTORY_CLASS        1063
+#define IDC_SAVE_CUSTOM_PATH            1064
+#define IDC_SAVE_CUSTOM_PATH_PREVIEW    1065
+#define IDC_SAVE_CUSTOM_PATH_BROWSE     1066
+#define IDC_SAVE_AUTOSAVE_TYPE          1067
+#define IDC_DISPLAY_SCROLL_TIME         1068
+#define IDC_DISPLAY_SCROLL_TIME_PREVIEW 1071
+#define IDC_DISPLAY_SCROLL_DIRECTION    1072
+#define IDC_SEARCH_EXCLUDE_BRACKETS     1073
+#define IDC_LYRIC_EDIT_SYNC_OFFSET      1074
+#define IDC_LYRIC_EDIT_APPLY_OFFSET     1075
+#define IDC_SEARCH_MUSIXMATCH_TOKEN     1077
+#define IDC_MANUALSEARCH_ARTIST         1078
+#define IDC_MANUALSEARCH_ALBUM          1079
+#define IDC_MANUALSEARCH_TITLE          1080
+#define IDC_MANUALSEARCH_PROGRESS       1081
+#define IDC_MANUALSEARCH_RESULTLIST     1082
+#define IDC_MANUALSEARCH_OK             1084
+#define IDC_MANUALSEARCH_CANCEL         1085
+#define IDC_MANUALSEARCH_SEARCH         1086
+#define IDC_SEARCH_MUSIXMATCH_HELP      1087
+#define IDC_DISPLAY_SCROLL_TYPE         1088
+#define IDC_EDIT_AUTOEDITS_AUTOMATED    1089
+#define IDC_SAVE_MERGE_EQUIVALENT_LRC_LINES 1091
+#define IDC_MANUALSEARCH_APPLY          1092
+#define IDC_BULKSEARCH_CLOSE            1093
+#define IDC_BULKSEARCH_PROGRESS         1094
+#define IDC_BULKSEARCH_LIST             1095
+#define IDC_BULKSEARCH_STATUS           1096
+#define IDC_SAVE_SYNTAX_HELP            1097
+
+// Next default values for new objects
+// 
+#ifdef APSTUDIO_INVOKED
+#ifndef APSTUDIO_READONLY_SYMBOLS
+#define _APS_NEXT_RESOURCE_VALUE        127
+#define _APS_NEXT_COMMAND_VALUE         40001
+#define _APS_NEXT_CONTROL_VALUE         1098
+#define _APS_NEXT_SYMED_VALUE           101
+#endif
+#endif
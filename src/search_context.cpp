@@ -0,0 +1,61 @@
+#include "stdafx.h"
+
+#include "preferences.h"
+#include "search_context.h"
+#include "tag_util.h"
+
+static std::string normalise_for_search(const std::string& tag_value)
+{
+    if(preferences::searching::exclude_trailing_brackets())
+    {
+        return std::string(trim_surrounding_whitespace(trim_trailing_text_in_brackets(tag_value)));
+    }
+    return tag_value;
+}
+
+SearchContext::SearchContext(metadb_handle_ptr track_handle) :
+    SearchContext(track_handle, preferences::saving::filename(track_handle))
+{
+}
+
+SearchContext::SearchContext(metadb_handle_ptr track_handle, std::string track_save_filename) :
+    track(track_handle),
+    info(track_handle->get_info_ref()),
+    tag_artist(track_metadata(info->info(), "artist")),
+    tag_album(track_metadata(info->info(), "album")),
+    tag_title(track_metadata(info->info(), "title")),
+    artist(normalise_for_search(tag_artist)),
+    album(normalise_for_search(tag_album)),
+    title(normalise_for_search(tag_title)),
+    duration_sec(info->info().get_length()),
+    save_filename(std::move(track_save_filename)),
+    m_full_info_lock(),
+    m_full_info()
+{
+}
+
+SearchContext::SearchContext(metadb_handle_ptr track_handle, std::string_view custom_artist, std::string_view custom_album, std::string_view custom_title) :
+    track(track_handle),
+    info(track_handle->get_info_ref()),
+    tag_artist(track_metadata(info->info(), "artist")),
+    tag_album(track_metadata(info->info(), "album")),
+    tag_title(track_metadata(info->info(), "title")),
+    artist(custom_artist),
+    album(custom_album),
+    title(custom_title),
+    duration_sec(info->info().get_length()),
+    save_filename(preferences::saving::filename(track_handle)),
+    m_full_info_lock(),
+    m_full_info()
+{
+}
+
+const file_info& SearchContext::get_full_info(abort_callback& abort) const
+{
+    std::lock_guard<std::mutex> lock(m_full_info_lock);
+    if(m_full_info == nullptr)
+    {
+        m_full_info = track->get_full_info_ref(abort);
+    }
+    return m_full_info->info();
+}
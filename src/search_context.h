@@ -0,0 +1,49 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include <mutex>
+
+// Everything that the lyric sources need to know about the track that is being searched for.
+// This is built once per search so that each source does not need to separately extract
+// (and re-normalise) the same metadata from the metadb.
+class SearchContext
+{
+public:
+    // Build a context for searching with the track's own metadata
+    SearchContext(metadb_handle_ptr track);
+
+    // Build a context for searching with the track's own metadata and a save filename that was already computed
+    // (e.g by preferences::saving::filename for a whole batch of tracks)
+    SearchContext(metadb_handle_ptr track, std::string save_filename);
+
+    // Build a context for searching with custom metadata for the given track (e.g from the manual search dialog)
+    SearchContext(metadb_handle_ptr track, std::string_view artist, std::string_view album, std::string_view title);
+
+    SearchContext(const SearchContext& other) = delete;
+    void operator =(const SearchContext& other) = delete;
+
+    // Loaded on first request (which can be slow) because most sources do not need the full info
+    const file_info& get_full_info(abort_callback& abort) const;
+
+    const metadb_handle_ptr track;
+    const metadb_info_container::ptr info;
+
+    // The values of the track's metadata tags, as stored on the track
+    const std::string tag_artist;
+    const std::string tag_album;
+    const std::string tag_title;
+
+    // The values that should actually be sent to remote sources, which may have been normalised
+    // (e.g to remove trailing text in brackets) or supplied by the user instead of the tags
+    const std::string artist;
+    const std::string album;
+    const std::string title;
+
+    const double duration_sec;
+    const std::string save_filename; // The path at which lyrics for this track are saved (without extension)
+
+private:
+    mutable std::mutex m_full_info_lock;
+    mutable metadb_info_container::ptr m_full_info;
+};
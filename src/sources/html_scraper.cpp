@@ -0,0 +1,146 @@
+#include <algorithm>
+
+#include "html_scraper.h"
+
+HtmlElement::HtmlElement(std::string_view name, const xmlChar** attributes)
+    : m_name(name)
+    , m_attributes(attributes)
+{
+}
+
+std::string_view HtmlElement::name() const
+{
+    return m_name;
+}
+
+std::optional<std::string_view> HtmlElement::attribute(std::string_view attr_name) const
+{
+    if(m_attributes == nullptr)
+    {
+        return {};
+    }
+
+    // NOTE: libxml2 passes attributes as a null-terminated array of alternating names and values.
+    //       Values are null for attributes given without one (e.g <input disabled>).
+    for(const xmlChar** attr = m_attributes; attr[0] != nullptr; attr += 2)
+    {
+        if(attr_name == (const char*)attr[0])
+        {
+            return (attr[1] == nullptr) ? std::string_view() : std::string_view((const char*)attr[1]);
+        }
+    }
+    return {};
+}
+
+bool HtmlElement::has_attribute(std::string_view attr_name) const
+{
+    return attribute(attr_name).has_value();
+}
+
+bool HtmlScraper::parse(std::string_view html, std::string_view url)
+{
+    htmlSAXHandler handler = {};
+    handler.startElement = sax_start_element;
+    handler.endElement = sax_end_element;
+    handler.characters = sax_characters;
+    handler.comment = sax_comment;
+    handler.cdataBlock = sax_cdata_block;
+
+    const std::string url_str(url);
+    m_parser = htmlCreatePushParserCtxt(&handler, this, nullptr, 0, url_str.c_str(), XML_CHAR_ENCODING_NONE);
+    if(m_parser == nullptr)
+    {
+        return false;
+    }
+    htmlCtxtUseOptions(m_parser, HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+
+    // NOTE: We feed the page to the parser in chunks so that if the scraper stops early
+    //       we don't spend any time tokenising the rest of the page.
+    constexpr size_t chunk_size = 16*1024;
+    m_pending_text.clear();
+    m_depth = 0;
+    m_stopped = false;
+    size_t offset = 0;
+    while(!m_stopped && (offset < html.length()))
+    {
+        const size_t length = (std::min)(chunk_size, html.length() - offset);
+        htmlParseChunk(m_parser, html.data() + offset, int(length), 0);
+        offset += length;
+    }
+    if(!m_stopped)
+    {
+        htmlParseChunk(m_parser, nullptr, 0, 1);
+        flush_text();
+    }
+
+    htmlFreeParserCtxt(m_parser);
+    m_parser = nullptr;
+    return true;
+}
+
+void HtmlScraper::stop_parsing()
+{
+    if(!m_stopped && (m_parser != nullptr))
+    {
+        m_stopped = true;
+        xmlStopParser(m_parser);
+    }
+}
+
+int HtmlScraper::depth() const
+{
+    return m_depth;
+}
+
+void HtmlScraper::flush_text()
+{
+    // NOTE: libxml2 can split a single text node across multiple character callbacks,
+    //       so we only pass text on once we reach the next markup boundary.
+    if(!m_pending_text.empty() && !m_stopped)
+    {
+        on_text(m_pending_text);
+    }
+    m_pending_text.clear();
+}
+
+void HtmlScraper::sax_start_element(void* ctx, const xmlChar* name, const xmlChar** attributes)
+{
+    HtmlScraper* scraper = static_cast<HtmlScraper*>(ctx);
+    scraper->flush_text();
+    scraper->m_depth++;
+    if(!scraper->m_stopped)
+    {
+        scraper->on_element_start(HtmlElement((const char*)name, attributes));
+    }
+}
+
+void HtmlScraper::sax_end_element(void* ctx, const xmlChar* name)
+{
+    HtmlScraper* scraper = static_cast<HtmlScraper*>(ctx);
+    scraper->flush_text();
+    if(!scraper->m_stopped)
+    {
+        scraper->on_element_end((const char*)name);
+    }
+    scraper->m_depth--;
+}
+
+void HtmlScraper::sax_characters(void* ctx, const xmlChar* text, int length)
+{
+    HtmlScraper* scraper = static_cast<HtmlScraper*>(ctx);
+    scraper->m_pending_text.append((const char*)text, size_t(length));
+}
+
+void HtmlScraper::sax_comment(void* ctx, const xmlChar* /*text*/)
+{
+    // NOTE: Comments split text nodes in the same way that elements do
+    HtmlScraper* scraper = static_cast<HtmlScraper*>(ctx);
+    scraper->flush_text();
+}
+
+void HtmlScraper::sax_cdata_block(void* /*ctx*/, const xmlChar* /*text*/, int /*length*/)
+{
+    // NOTE: libxml2's HTML parser passes the contents of <script> and <style> elements to this callback,
+    //       or to the characters callback if this one is not set. We never want to scrape those contents
+    //       (they would otherwise end up in any text that a scraper collects), so they are ignored.
+}
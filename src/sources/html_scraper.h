@@ -0,0 +1,59 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "libxml/HTMLparser.h"
+
+class HtmlElement
+{
+public:
+    HtmlElement(std::string_view name, const xmlChar** attributes);
+
+    std::string_view name() const;
+    std::optional<std::string_view> attribute(std::string_view attr_name) const;
+    bool has_attribute(std::string_view attr_name) const;
+
+private:
+    std::string_view m_name;
+    const xmlChar** m_attributes;
+};
+
+// A streaming HTML scraper built on libxml2's SAX push parser.
+// Rather than building a DOM of the whole page and querying it, subclasses receive each element
+// and text node as it is parsed and can call stop_parsing() as soon as they have what they need,
+// in which case the rest of the page is never parsed at all.
+class HtmlScraper
+{
+public:
+    virtual ~HtmlScraper() = default;
+
+    // Returns false if the page could not be parsed at all
+    bool parse(std::string_view html, std::string_view url);
+
+protected:
+    virtual void on_element_start(const HtmlElement& element) = 0;
+    virtual void on_element_end(std::string_view name) = 0;
+    virtual void on_text(std::string_view text) = 0; // Called once for each complete text node, in UTF-8
+
+    void stop_parsing();
+
+    // The number of elements that are currently open. During on_element_start and on_element_end this
+    // includes the element being opened/closed, so an element and its direct text children have the same depth.
+    int depth() const;
+
+private:
+    static void sax_start_element(void* ctx, const xmlChar* name, const xmlChar** attributes);
+    static void sax_end_element(void* ctx, const xmlChar* name);
+    static void sax_characters(void* ctx, const xmlChar* text, int length);
+    static void sax_comment(void* ctx, const xmlChar* text);
+    static void sax_cdata_block(void* ctx, const xmlChar* text, int length);
+
+    void flush_text();
+
+    htmlParserCtxtPtr m_parser = nullptr;
+    std::string m_pending_text;
+    int m_depth = 0;
+    bool m_stopped = false;
+};
@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "http_fixture.h"
+
+// NOTE: Each fixture file contains the request key on the first line (so that the files can be identified by a
+//       human, and so that we can detect a file being used for the wrong request) followed by the response body.
+static const std::string_view FIXTURE_KEY_TERMINATOR = "\r\n";
+
+std::string http_fixture_key(std::string_view method, std::string_view url, std::string_view body)
+{
+    std::string result;
+    result.reserve(method.length() + url.length() + 32);
+    result += method;
+    result += ' ';
+    result += url;
+
+    if(!body.empty())
+    {
+        // NOTE: The body is hashed (using 64-bit FNV-1a) rather than included directly so that the key
+        //       stays on a single line no matter what the body contains.
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for(char c : body)
+        {
+            hash ^= uint64_t(static_cast<unsigned char>(c));
+            hash *= 0x100000001b3ull;
+        }
+
+        char hash_str[17];
+        snprintf(hash_str, sizeof(hash_str), "%016llx", static_cast<unsigned long long>(hash));
+        result += " body=";
+        result += hash_str;
+    }
+    return result;
+}
+
+std::string format_http_fixture(std::string_view key, std::string_view response)
+{
+    std::string result;
+    result.reserve(key.length() + FIXTURE_KEY_TERMINATOR.length() + response.length());
+    result += key;
+    result += FIXTURE_KEY_TERMINATOR;
+    result += response;
+    return result;
+}
+
+std::optional<std::string> parse_http_fixture(std::string_view contents, std::string_view key)
+{
+    const size_t key_end = contents.find(FIXTURE_KEY_TERMINATOR);
+    if((key_end == std::string_view::npos) || (contents.substr(0, key_end) != key))
+    {
+        return {};
+    }
+    return std::string(contents.substr(key_end + FIXTURE_KEY_TERMINATOR.length()));
+}
+
+std::optional<std::string> parse_http_fixture_key(std::string_view contents)
+{
+    const size_t key_end = contents.find(FIXTURE_KEY_TERMINATOR);
+    if(key_end == std::string_view::npos)
+    {
+        return {};
+    }
+    return std::string(contents.substr(0, key_end));
+}
+
+std::string http_standin_url(std::string_view server, std::string_view url)
+{
+    const size_t scheme_end = url.find("://");
+    if(scheme_end != std::string_view::npos)
+    {
+        url.remove_prefix(scheme_end + 3);
+    }
+    const size_t path_start = url.find_first_of("/?#");
+    url = (path_start == std::string_view::npos) ? std::string_view() : url.substr(path_start);
+
+    std::string result = "http://";
+    result += server;
+    if(url.empty() || (url[0] != '/'))
+    {
+        result += '/';
+    }
+    result += url.substr(0, url.find('#'));
+    return result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// NOTE: This only deals with the contents of fixture files (not with reading or writing them) and deliberately
+//       does not depend on the foobar2000 SDK, so that it can be built and tested on its own.
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Returns the text that identifies a request in its fixture file. This is the method and URL, followed by a hash of
+// the request body if there is one, so that (for example) POST requests to the same URL with different bodies
+// are recorded separately. Requests without a body have the same key as they did before bodies were supported.
+std::string http_fixture_key(std::string_view method, std::string_view url, std::string_view body);
+
+// Returns the contents of a fixture file that records `response` as the response to the request with the given key
+std::string format_http_fixture(std::string_view key, std::string_view response);
+
+// Returns the response recorded in the given fixture file contents, or nothing if the contents are malformed
+// or record the response to a request with a different key.
+std::optional<std::string> parse_http_fixture(std::string_view contents, std::string_view key);
+
+// Returns the key of the request whose response is recorded in the given fixture file contents,
+// or nothing if the contents are malformed.
+std::optional<std::string> parse_http_fixture_key(std::string_view contents);
+
+// Requests sent to a local stand-in server (which replays fixtures over HTTP, for end-to-end testing) carry their
+// original URL in this header, so that the server can find the fixture recorded for them.
+inline constexpr std::string_view HTTP_STANDIN_ORIGINAL_URL_HEADER = "X-OpenLyrics-Original-Url";
+
+// Returns the URL to which a request for `url` should be sent when it is redirected to the stand-in server at
+// `server` (given as "host:port"). This keeps the path and query of the original URL, but not its scheme or host.
+std::string http_standin_url(std::string_view server, std::string_view url);
@@ -0,0 +1,271 @@
+#include "stdafx.h"
+#include <mutex>
+
+#include "http_transport.h"
+
+#include "http_fixture.h"
+#include "logging.h"
+#include "preferences.h"
+
+struct HostRateLimit
+{
+    const char* host;
+    double requests_per_second;
+    double burst; // The number of requests that can be sent immediately after a period of inactivity
+};
+
+// NOTE: These are deliberately conservative. Some of these sites will block clients (sometimes for days)
+//       that send them more than a handful of requests in a short period of time.
+static const HostRateLimit g_host_rate_limits[] =
+{
+    {"www.azlyrics.com", 0.1, 2.0},
+    {"darklyrics.com", 0.2, 2.0},
+    {"genius.com", 0.5, 4.0},
+    {"apic-desktop.musixmatch.com", 0.5, 4.0},
+    {"music.163.com", 1.0, 6.0},
+    {"c.y.qq.com", 1.0, 10.0},
+};
+static const HostRateLimit g_default_rate_limit = {"", 0.5, 4.0};
+
+// Returns the (lower-case) host name from the given URL, without the scheme, port or path
+static std::string url_host(std::string_view url)
+{
+    const size_t scheme_end = url.find("://");
+    if(scheme_end != std::string_view::npos)
+    {
+        url.remove_prefix(scheme_end + 3);
+    }
+    url = url.substr(0, url.find_first_of(":/?#"));
+
+    std::string host(url);
+    std::transform(host.begin(), host.end(), host.begin(), [](char c) { return pfc::ascii_tolower(c); });
+    return host;
+}
+
+// A token bucket for each remote host, so that every request to a host (from any source or search)
+// draws from the same budget. Callers that are over budget reserve their token in advance and then
+// wait for it to become available, so concurrent callers are served in the order that they arrived.
+class HostRateLimiter
+{
+public:
+    HostRateLimiter()
+    {
+        m_clock.start();
+    }
+
+    void acquire(const std::string& host, abort_callback& abort)
+    {
+        double wait_seconds = 0.0;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            Bucket& bucket = get_bucket(host);
+
+            const double now = m_clock.query();
+            bucket.tokens = min(bucket.limit.burst, bucket.tokens + (now - bucket.last_refill)*bucket.limit.requests_per_second);
+            bucket.last_refill = now;
+
+            bucket.tokens -= 1.0;
+            if(bucket.tokens < 0.0)
+            {
+                wait_seconds = -bucket.tokens / bucket.limit.requests_per_second;
+            }
+        }
+
+        if(wait_seconds > 0.0)
+        {
+            LOG_INFO("Waiting %.1fs before sending a request to %s", wait_seconds, host.c_str());
+            try
+            {
+                abort.sleep(wait_seconds);
+            }
+            catch(...)
+            {
+                // NOTE: We won't be sending the request that we reserved this token for, so give it back.
+                //       Callers that reserved after us will still wait for their original time, but any
+                //       request made after that can use it.
+                std::lock_guard<std::mutex> guard(m_lock);
+                Bucket& bucket = get_bucket(host);
+                bucket.tokens = min(bucket.limit.burst, bucket.tokens + 1.0);
+                throw;
+            }
+        }
+    }
+
+private:
+    struct Bucket
+    {
+        std::string host;
+        HostRateLimit limit;
+        double tokens;
+        double last_refill;
+    };
+
+    Bucket& get_bucket(const std::string& host)
+    {
+        for(Bucket& bucket : m_buckets)
+        {
+            if(bucket.host == host)
+            {
+                return bucket;
+            }
+        }
+
+        HostRateLimit limit = g_default_rate_limit;
+        for(const HostRateLimit& known_limit : g_host_rate_limits)
+        {
+            if(host == known_limit.host)
+            {
+                limit = known_limit;
+                break;
+            }
+        }
+        m_buckets.push_back({host, limit, limit.burst, m_clock.query()});
+        return m_buckets.back();
+    }
+
+    std::mutex m_lock;
+    std::vector<Bucket> m_buckets;
+    pfc::hires_timer m_clock;
+};
+
+class Fb2kHttpTransport : public HttpTransport
+{
+public:
+    std::string run(const HttpRequest& request, abort_callback& abort) override
+    {
+        // NOTE: Requests that are redirected to a local stand-in server are not rate-limited, since they
+        //       never reach the remote host. The server uses the original URL to find the response to send.
+        const std::string standin_server = preferences::advanced::http_standin_server();
+        std::string url = request.url;
+        if(standin_server.empty())
+        {
+            m_rate_limiter.acquire(url_host(request.url), abort);
+        }
+        else
+        {
+            url = http_standin_url(standin_server, request.url);
+        }
+
+        pfc::hires_timer timer;
+        timer.start();
+
+        http_request::ptr fb2k_request = http_client::get()->create_request(request.method.c_str());
+        if(!standin_server.empty())
+        {
+            fb2k_request->add_header(std::string(HTTP_STANDIN_ORIGINAL_URL_HEADER).c_str(), request.url.c_str());
+        }
+        std::string content_type;
+        for(const auto& header : request.headers)
+        {
+            fb2k_request->add_header(header.first.c_str(), header.second.c_str());
+            if(pfc::stringEqualsI_ascii(header.first.c_str(), "Content-Type"))
+            {
+                content_type = header.second;
+            }
+        }
+
+        if(!request.body.empty())
+        {
+            http_request_post_v2::ptr post_request;
+            if(!fb2k_request->service_query_t(post_request))
+            {
+                throw std::runtime_error("Unable to send a " + request.method + " request body with this version of foobar2000");
+            }
+            post_request->set_post_data(request.body.data(), request.body.length(), content_type.c_str());
+        }
+
+        pfc::string8 content;
+        file_ptr response_file = fb2k_request->run(url.c_str(), abort);
+        response_file->read_string_raw(content, abort);
+        // NOTE: We're assuming here that the response is encoded in UTF-8
+
+        LOG_INFO("%s %s returned %u bytes in %.1fms", request.method.c_str(), url.c_str(), (unsigned int)content.length(), timer.query()*1000.0);
+        return std::string(content.c_str(), content.length());
+    }
+
+private:
+    HostRateLimiter m_rate_limiter;
+};
+
+// NOTE: Fixture files are named after the hash of the request's fixture key (see http_fixture.h)
+class FixtureHttpTransport : public HttpTransport
+{
+public:
+    FixtureHttpTransport(HttpTransport& upstream) : m_upstream(upstream) {}
+
+    std::string run(const HttpRequest& request, abort_callback& abort) override
+    {
+        const std::string fixture_dir = preferences::advanced::http_fixture_directory();
+        if(fixture_dir.empty())
+        {
+            LOG_WARN("HTTP fixtures are enabled but no fixture directory has been set. Sending the request as normal...");
+            return m_upstream.run(request, abort);
+        }
+
+        const std::string request_line = http_fixture_key(request.method, request.url, request.body);
+        const pfc::string8 request_hash = static_api_ptr_t<hasher_md5>()->process_single_string(request_line.c_str()).asString();
+        const std::string fixture_path = fixture_dir + "\\" + request_hash.c_str() + ".txt";
+
+        const HttpFixtureMode mode = preferences::advanced::http_fixture_mode();
+        if(mode == HttpFixtureMode::Replay)
+        {
+            pfc::string8 fixture_contents;
+            try
+            {
+                file_ptr fixture_file;
+                filesystem::g_open_read(fixture_file, fixture_path.c_str(), abort);
+                fixture_file->read_string_raw(fixture_contents, abort);
+            }
+            catch(const std::exception& e)
+            {
+                throw std::runtime_error(std::string("No HTTP fixture available for ") + request_line + ": " + e.what());
+            }
+
+            std::optional<std::string> response = parse_http_fixture(std::string_view(fixture_contents.c_str(), fixture_contents.length()), request_line);
+            if(!response.has_value())
+            {
+                throw std::runtime_error("HTTP fixture " + fixture_path + " does not match request " + request_line);
+            }
+
+            LOG_INFO("Replayed %s from fixture %s", request_line.c_str(), fixture_path.c_str());
+            return std::move(response.value());
+        }
+        else
+        {
+            std::string response = m_upstream.run(request, abort);
+            try
+            {
+                if(!filesystem::g_exists(fixture_dir.c_str(), abort))
+                {
+                    filesystem::g_create_directory(fixture_dir.c_str(), abort);
+                }
+
+                const std::string fixture_contents = format_http_fixture(request_line, response);
+                file_ptr fixture_file;
+                filesystem::g_open_write_new(fixture_file, fixture_path.c_str(), abort);
+                fixture_file->write_object(fixture_contents.c_str(), fixture_contents.length(), abort);
+                LOG_INFO("Recorded %s to fixture %s", request_line.c_str(), fixture_path.c_str());
+            }
+            catch(const std::exception& e)
+            {
+                LOG_WARN("Failed to record HTTP fixture for %s: %s", request_line.c_str(), e.what());
+            }
+            return response;
+        }
+    }
+
+private:
+    HttpTransport& m_upstream;
+};
+
+HttpTransport& get_http_transport()
+{
+    static Fb2kHttpTransport fb2k_transport;
+    static FixtureHttpTransport fixture_transport(fb2k_transport);
+
+    if(preferences::advanced::http_fixture_mode() == HttpFixtureMode::Disabled)
+    {
+        return fb2k_transport;
+    }
+    return fixture_transport;
+}
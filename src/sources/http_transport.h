@@ -0,0 +1,28 @@
+#pragma once
+
+#include "stdafx.h"
+
+struct HttpRequest
+{
+    std::string method;
+    std::string url;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body; // Only sent if non-empty, with the content type given in the "Content-Type" header (if any)
+};
+
+class HttpTransport
+{
+public:
+    virtual ~HttpTransport() = default;
+
+    // Sends the given request and returns the body of the response. Throws if the request fails.
+    virtual std::string run(const HttpRequest& request, abort_callback& abort) = 0;
+};
+
+// Returns the transport through which lyric sources should send all of their requests.
+// This is foobar2000's HTTP client unless the advanced preferences have been configured to
+// record responses to (or replay responses from) a directory of fixture files, or to send every request to
+// a local stand-in server (see tests/http_standin_server.h) instead of the remote host.
+// Requests that go out to remote hosts are rate-limited per host, so callers may block
+// (until the request is allowed or the abort callback fires) before the request is sent.
+HttpTransport& get_http_transport();
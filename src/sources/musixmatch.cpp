@@ -1,395 +1,583 @@
-#include "stdafx.h"
-
-#include "cJSON.h"
-
-#include "logging.h"
-#include "lyric_data.h"
-#include "lyric_source.h"
-
-static const GUID src_guid = { 0xf94ba31a, 0x7b33, 0x49e4, { 0x81, 0x9b, 0x0, 0xc, 0x36, 0x44, 0x29, 0xcd } };
-
-struct SongSearchResult
-{
-    int64_t track_id;
-    bool has_synced_lyrics;
-    bool has_unsynced_lyrics;
-};
-
-class MusixmatchLyricsSource : public LyricSourceRemote
-{
-    const GUID& id() const final { return src_guid; }
-    std::tstring_view friendly_name() const final { return _T("Musixmatch"); }
-
-    std::vector<LyricDataRaw> search(std::string_view artist, std::string_view album, std::string_view title, abort_callback& abort) final;
-    bool lookup(LyricDataRaw& data, abort_callback& abort) final;
-
-private:
-    std::vector<LyricDataRaw> get_song_ids(std::string_view artist, std::string_view album, std::string_view title, abort_callback& abort) const;
-    bool get_lyrics(LyricDataRaw& data, int64_t track_id, abort_callback& abort, const char* method, const char* body_entry_name, const char* text_entry_name) const;
-    bool get_unsynced_lyrics(LyricDataRaw& data, int64_t track_id, abort_callback& abort) const;
-    bool get_synced_lyrics(LyricDataRaw& data, int64_t track_id, abort_callback& abort) const;
-};
-static const LyricSourceFactory<MusixmatchLyricsSource> src_factory;
-
-static const char* g_api_url = "https://apic-desktop.musixmatch.com/ws/1.1/";
-static const char* g_common_params = "user_language=en&app_id=web-desktop-app-v1.0";
-
-static std::string EncodeSearchResult(SongSearchResult search_result)
-{
-    std::string output;
-    output += (search_result.has_unsynced_lyrics ? '1' : '0');
-    output += (search_result.has_synced_lyrics ? '1' : '0');
-    output += std::to_string(search_result.track_id);
-    return output;
-}
-
-static std::optional<SongSearchResult> DecodeSearchResult(std::string_view str)
-{
-    if(str.length() < 3)
-    {
-        return {};
-    }
-    if((str[0] != '0') && (str[0] != '1'))
-    {
-        return {};
-    }
-    if((str[1] != '0') && (str[1] != '1'))
-    {
-        return {};
-    }
-
-    SongSearchResult result = {};
-    result.has_unsynced_lyrics = (str[0] == '1');
-    result.has_synced_lyrics = (str[1] == '1');
-    result.track_id = strtoll(&str[2], nullptr, 10);
-    return result;
-}
-
-std::vector<LyricDataRaw> MusixmatchLyricsSource::get_song_ids(std::string_view artist, std::string_view album, std::string_view title, abort_callback& abort) const
-{
-    std::string apikey = preferences::searching::musixmatch_api_key();
-    std::string url = std::string(g_api_url) + "track.search?" + g_common_params + "&subtitle_format=lrc&usertoken=" + apikey;
-    url += "&q_artist=" + urlencode(artist);
-    url += "&q_album=" + urlencode(album);
-    url += "&q_track=" + urlencode(title);
-    LOG_INFO("Querying for track ID from %s...", url.c_str());
-
-    pfc::string8 content;
-    try
-    {
-        http_request::ptr request = http_client::get()->create_request("GET");
-
-        // NOTE: Without adding the AWSELB and AWSELBCORS headers, we get a 301 (permanent redirect back)
-        //       with a header instructing us to set those cookies to the given hash.
-        //       The fb2k http API automatically follows the redirect but does not honour the Set-Cookie headers.
-        //       The redirect goes to the same URL and the request then fails after a while (presumably because
-        //       ELB thinks we're DoS'ing them and kills the connection).
-        //       Setting the headers here to just *some* value (even if its not a useful one) seems to make it work.
-        //       We may need to upgrade this in future to actually set the cookies that we're asked to set.
-        request->add_header("cookie", "AWSELBCORS=0; AWSELB=0");
-
-        file_ptr response_file = request->run(url.c_str(), abort);
-
-        response_file->read_string_raw(content, abort);
-    }
-    catch(const std::exception& e)
-    {
-        LOG_WARN("Failed to make Musixmatch search request to %s: %s", url.c_str(), e.what());
-        return {};
-    }
-
-    cJSON* json = cJSON_ParseWithLength(content.c_str(), content.get_length());
-    if((json == nullptr) || (json->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch search result but root was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return {};
-    }
-
-    cJSON* json_message = cJSON_GetObjectItem(json, "message");
-    if((json_message == nullptr) || (json_message->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch search result but message was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return {};
-    }
-
-    cJSON* json_body = cJSON_GetObjectItem(json_message, "body");
-    if((json_body == nullptr) || (json_body->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch search result but body was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return {};
-    }
-
-    cJSON* json_tracklist = cJSON_GetObjectItem(json_body, "track_list");
-    if((json_tracklist == nullptr) || (json_tracklist->type != cJSON_Array))
-    {
-        LOG_INFO("Received musixmatch search result but track_list was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return {};
-    }
-
-    std::vector<LyricDataRaw> results;
-    cJSON* json_track = nullptr;
-    cJSON_ArrayForEach(json_track, json_tracklist)
-    {
-        if((json_track == nullptr) || (json_track->type != cJSON_Object))
-        {
-            LOG_INFO("Received musixmatch search result but track was malformed: %s", content.c_str());
-            break;
-        }
-
-        cJSON* json_tracktrack = cJSON_GetObjectItem(json_track, "track");
-        if((json_tracktrack == nullptr) || (json_tracktrack->type != cJSON_Object))
-        {
-            LOG_INFO("Received musixmatch search result but tracktrack was malformed: %s", content.c_str());
-            break;
-        }
-
-        cJSON* json_artist = cJSON_GetObjectItem(json_tracktrack, "artist_name");
-        if((json_artist == nullptr) || (json_artist->type != cJSON_String))
-        {
-            LOG_INFO("Received musixmatch search result but artist_name was malformed");
-            break;
-        }
-
-        cJSON* json_album = cJSON_GetObjectItem(json_tracktrack, "album_name");
-        if((json_album == nullptr) || (json_album->type != cJSON_String))
-        {
-            LOG_INFO("Received musixmatch search result but album_name was malformed");
-            break;
-        }
-
-        cJSON* json_title = cJSON_GetObjectItem(json_tracktrack, "track_name");
-        if((json_title == nullptr) || (json_title->type != cJSON_String))
-        {
-            LOG_INFO("Received musixmatch search result but track_name was malformed");
-            break;
-        }
-
-        cJSON* json_haslyrics = cJSON_GetObjectItem(json_tracktrack, "has_lyrics");
-        if((json_haslyrics == nullptr) || (json_haslyrics->type != cJSON_Number))
-        {
-            LOG_INFO("Received musixmatch search result but has-lyrics was malformed: %s", content.c_str());
-            break;
-        }
-
-        cJSON* json_hassubtitles = cJSON_GetObjectItem(json_tracktrack, "has_subtitles");
-        if((json_hassubtitles == nullptr) || (json_hassubtitles->type != cJSON_Number))
-        {
-            LOG_INFO("Received musixmatch search result but has-subtitles was malformed: %s", content.c_str());
-            break;
-        }
-
-        cJSON* json_trackid = cJSON_GetObjectItem(json_tracktrack, "commontrack_id");
-        if((json_tracktrack == nullptr) || (json_trackid->type != cJSON_Number))
-        {
-            LOG_INFO("Received musixmatch search result but track ID was malformed: %s", content.c_str());
-            break;
-        }
-
-        SongSearchResult search_result = {};
-        search_result.track_id = json_trackid->valueint;
-        search_result.has_unsynced_lyrics = (json_haslyrics->valueint != 0);
-        search_result.has_synced_lyrics = (json_hassubtitles->valueint != 0);
-
-        LyricDataRaw data = {};
-        data.source_id = id();
-        data.artist = json_artist->valuestring;
-        data.album = json_album->valuestring;
-        data.title = json_title->valuestring;
-        data.lookup_id = EncodeSearchResult(search_result);
-        results.push_back(std::move(data));
-    }
-
-    cJSON_Delete(json);
-    return results;
-}
-
-bool MusixmatchLyricsSource::get_lyrics(LyricDataRaw& data, int64_t track_id, abort_callback& abort, const char* method, const char* body_entry_name, const char* text_entry_name) const
-{
-    assert(data.source_id == id());
-
-    std::string apikey = preferences::searching::musixmatch_api_key();
-    std::string url = std::string(g_api_url) + method + "?" + g_common_params + "&usertoken=" + apikey + "&commontrack_id=" + std::to_string(track_id);
-    data.persistent_storage_path = url;
-    LOG_INFO("Get Musixmatch lyrics lyrics from %s...", url.c_str());
-
-    pfc::string8 content;
-    try
-    {
-        http_request::ptr request = http_client::get()->create_request("GET");
-        request->add_header("cookie", "AWSELBCORS=0; AWSELB=0"); // NOTE: See the comment on the cookie in the track ID query
-
-        file_ptr response_file = request->run(url.c_str(), abort);
-
-        response_file->read_string_raw(content, abort);
-    }
-    catch(const std::exception& e)
-    {
-        LOG_WARN("Failed to make Musixmatch %s request to %s: %s", method, url.c_str(), e.what());
-        return false;
-    }
-
-    cJSON* json = cJSON_ParseWithLength(content.c_str(), content.get_length());
-    if((json == nullptr) || (json->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch %s response but root was malformed: %s", method, content.c_str());
-        cJSON_Delete(json);
-        return false;
-    }
-
-    cJSON* json_message = cJSON_GetObjectItem(json, "message");
-    if((json_message == nullptr) || (json_message->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch %s response but message was malformed: %s", method, content.c_str());
-        cJSON_Delete(json);
-        return false;
-    }
-
-    cJSON* json_body = cJSON_GetObjectItem(json_message, "body");
-    if((json_body == nullptr) || (json_body->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch %s response but body was malformed: %s", method, content.c_str());
-        cJSON_Delete(json);
-        return false;
-    }
-
-    cJSON* json_lyrics = cJSON_GetObjectItem(json_body, body_entry_name);
-    if((json_lyrics == nullptr) || (json_lyrics->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch %s response but %s was malformed: %s", method, body_entry_name, content.c_str());
-        cJSON_Delete(json);
-        return false;
-    }
-
-    cJSON* json_lyricstext = cJSON_GetObjectItem(json_lyrics, text_entry_name);
-    if((json_lyricstext == nullptr) || (json_lyricstext->type != cJSON_String))
-    {
-        LOG_INFO("Received musixmatch %s response but %s was malformed: %s", method, text_entry_name, content.c_str());
-        cJSON_Delete(json);
-        return false;
-    }
-
-    if(strlen(json_lyricstext->valuestring) == 0)
-    {
-        cJSON_Delete(json);
-        return false;
-    }
-
-    data.text = json_lyricstext->valuestring;
-    cJSON_Delete(json);
-    return !data.text.empty();
-}
-
-bool MusixmatchLyricsSource::get_unsynced_lyrics(LyricDataRaw& data, int64_t track_id, abort_callback& abort) const
-{
-    return get_lyrics(data, track_id, abort, "track.lyrics.get", "lyrics", "lyrics_body");
-}
-
-bool MusixmatchLyricsSource::get_synced_lyrics(LyricDataRaw& data, int64_t track_id, abort_callback& abort) const
-{
-    return get_lyrics(data, track_id, abort, "track.subtitle.get", "subtitle", "subtitle_body");
-}
-
-std::vector<LyricDataRaw> MusixmatchLyricsSource::search(std::string_view artist, std::string_view album, std::string_view title, abort_callback& abort)
-{
-    if(preferences::searching::musixmatch_api_key().empty())
-    {
-        // An API key is required.
-        // Skip the search if we don't have one so we don't accidentally spam their servers with obviously-bad requests.
-        LOG_INFO("Skipping request to the Musixmatch source because no API key is available");
-        return {};
-    }
-
-    return get_song_ids(artist, album, title, abort);
-}
-
-bool MusixmatchLyricsSource::lookup(LyricDataRaw& data, abort_callback& abort)
-{
-    std::optional<SongSearchResult> maybe_search_result = DecodeSearchResult(data.lookup_id);
-    if(!maybe_search_result.has_value())
-    {
-        LOG_WARN("Attempt to lookup musixmatch lyrics with invalid lookup ID: %s", data.lookup_id.c_str());
-        return false;
-    }
-
-    const SongSearchResult& search_result = maybe_search_result.value();
-    if(search_result.track_id == 0)
-    {
-        LOG_WARN("Attempt to lookup musixmatch lyrics with null lookup track ID: %s", data.lookup_id.c_str());
-        return false;
-    }
-
-    if(search_result.has_synced_lyrics)
-    {
-        return get_synced_lyrics(data, search_result.track_id, abort);
-    }
-    else if(search_result.has_unsynced_lyrics)
-    {
-        return get_unsynced_lyrics(data, search_result.track_id, abort);
-    }
-    else
-    {
-        return false;
-    }
-}
-
-std::string musixmatch_get_token(abort_callback& abort)
-{
-    std::string url = std::string(g_api_url) + "token.get?" + g_common_params;
-    LOG_INFO("Attempting to get Musixmatch token from %s...", url.c_str());
-
-    pfc::string8 content;
-    try
-    {
-        http_request::ptr request = http_client::get()->create_request("GET");
-        request->add_header("cookie", "AWSELBCORS=0; AWSELB=0"); // NOTE: See the comment on the cookie in the track ID query
-
-        file_ptr response_file = request->run(url.c_str(), abort);
-
-        response_file->read_string_raw(content, abort);
-    }
-    catch(const std::exception& e)
-    {
-        LOG_WARN("Failed to get Musixmatch token from %s: %s", url.c_str(), e.what());
-        return "";
-    }
-
-    cJSON* json = cJSON_ParseWithLength(content.c_str(), content.get_length());
-    if((json == nullptr) || (json->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch token response but root was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return "";
-    }
-
-    cJSON* json_message = cJSON_GetObjectItem(json, "message");
-    if((json_message == nullptr) || (json_message->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch token response but message was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return "";
-    }
-
-    cJSON* json_body = cJSON_GetObjectItem(json_message, "body");
-    if((json_body == nullptr) || (json_body->type != cJSON_Object))
-    {
-        LOG_INFO("Received musixmatch token response but body was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return "";
-    }
-
-    cJSON* json_token = cJSON_GetObjectItem(json_body, "user_token");
-    if((json_token == nullptr) || (json_token->type != cJSON_String))
-    {
-        LOG_INFO("Received musixmatch token response but user_token was malformed: %s", content.c_str());
-        cJSON_Delete(json);
-        return "";
-    }
-
-    std::string result = json_token->valuestring;
-    cJSON_Delete(json);
-    return result;
-}
+#include "stdafx.h"
+#include <mutex>
+
+#include "cJSON.h"
+
+#include "http_transport.h"
+#include "logging.h"
+#include "lyric_data.h"
+#include "lyric_source.h"
+#include "parsers.h"
+
+static const GUID src_guid = { 0xf94ba31a, 0x7b33, 0x49e4, { 0x81, 0x9b, 0x0, 0xc, 0x36, 0x44, 0x29, 0xcd } };
+
+struct SongSearchResult
+{
+    int64_t track_id;
+    bool has_synced_lyrics;
+    bool has_unsynced_lyrics;
+};
+
+class MusixmatchLyricsSource : public LyricSourceRemote
+{
+    const GUID& id() const final { return src_guid; }
+    std::tstring_view friendly_name() const final { return _T("Musixmatch"); }
+    size_t max_concurrent_lookups() const final { return preferences::advanced::musixmatch_concurrent_lookups(); }
+
+    std::vector<LyricDataRaw> search(const SearchContext& context, abort_callback& abort) final;
+    bool lookup(const SearchContext& context, LyricDataRaw& data, abort_callback& abort) final;
+
+private:
+    std::vector<LyricDataRaw> get_song_ids(const std::string& token, std::string_view artist, std::string_view album, std::string_view title, abort_callback& abort) const;
+    std::vector<LyricDataRaw> get_macro_lyrics(const std::string& token, const SearchContext& context, abort_callback& abort) const;
+    bool get_lyrics(const std::string& token, LyricDataRaw& data, int64_t track_id, abort_callback& abort, const char* method, const char* body_entry_name, const char* text_entry_name) const;
+    bool get_unsynced_lyrics(const std::string& token, LyricDataRaw& data, int64_t track_id, abort_callback& abort) const;
+    bool get_synced_lyrics(const std::string& token, LyricDataRaw& data, int64_t track_id, abort_callback& abort) const;
+};
+static const LyricSourceFactory<MusixmatchLyricsSource> src_factory;
+
+static const char* g_api_url = "https://apic-desktop.musixmatch.com/ws/1.1/";
+static const char* g_common_params = "user_language=en&app_id=web-desktop-app-v1.0";
+
+// Returns the item at the given path of object keys, or null if any of the items along the path are missing or not objects
+static cJSON* get_object_path(cJSON* root, std::initializer_list<const char*> path)
+{
+    cJSON* current = root;
+    for(const char* key : path)
+    {
+        if((current == nullptr) || (current->type != cJSON_Object))
+        {
+            return nullptr;
+        }
+        current = cJSON_GetObjectItem(current, key);
+    }
+    return current;
+}
+
+static const char* get_string_path(cJSON* root, std::initializer_list<const char*> path)
+{
+    cJSON* item = get_object_path(root, path);
+    if((item == nullptr) || (item->type != cJSON_String))
+    {
+        return nullptr;
+    }
+    return item->valuestring;
+}
+
+static bool token_rejected(cJSON* response_message)
+{
+    cJSON* status_code = get_object_path(response_message, {"header", "status_code"});
+    return (status_code != nullptr) && (status_code->type == cJSON_Number) && (status_code->valueint == 401);
+}
+
+static std::string request_token(abort_callback& abort);
+
+// NOTE: If no token has been configured then we request one ourselves. Tokens remain valid for a long time, so we
+//       keep the last one we received rather than requesting a new one for every search. Once it's old enough that
+//       it might be about to expire we still use it but request a replacement in the background, so that searches
+//       never have to wait for a refresh. A configured token is always used instead, if there is one.
+static constexpr t_filetimestamp TOKEN_REFRESH_AGE = system_time_periods::day;
+
+struct TokenCache
+{
+    std::mutex lock;
+    std::string token;
+    t_filetimestamp fetch_time = 0;
+    bool refresh_in_progress = false;
+};
+static TokenCache g_token_cache;
+
+static void cache_token(const std::string& token)
+{
+    if(!token.empty())
+    {
+        std::lock_guard<std::mutex> lock(g_token_cache.lock);
+        g_token_cache.token = token;
+        g_token_cache.fetch_time = filetimestamp_from_system_timer();
+    }
+}
+
+// Returns the token to use for requests, requesting one first if necessary
+static std::string get_request_token(abort_callback& abort)
+{
+    std::string configured_token = preferences::searching::musixmatch_api_key();
+    if(!configured_token.empty())
+    {
+        return configured_token;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_token_cache.lock);
+        if(!g_token_cache.token.empty())
+        {
+            const t_filetimestamp now = filetimestamp_from_system_timer();
+            if((now - g_token_cache.fetch_time > TOKEN_REFRESH_AGE) && !g_token_cache.refresh_in_progress)
+            {
+                LOG_INFO("Cached Musixmatch token is old, requesting a new one in the background...");
+                g_token_cache.refresh_in_progress = true;
+                fb2k::splitTask([](){
+                    abort_callback_dummy noAbort;
+                    std::string new_token = request_token(noAbort);
+                    cache_token(new_token);
+
+                    std::lock_guard<std::mutex> refresh_lock(g_token_cache.lock);
+                    g_token_cache.refresh_in_progress = false;
+                });
+            }
+            return g_token_cache.token;
+        }
+    }
+
+    std::string token = request_token(abort);
+    if(token.empty())
+    {
+        // A token is required.
+        // Skip the search if we don't have one so we don't accidentally spam their servers with obviously-bad requests.
+        // NOTE: We throw rather than returning no results because we haven't actually asked Musixmatch,
+        //       so this must not count as Musixmatch not having lyrics for the track.
+        throw std::runtime_error("No API key is configured and one could not be requested, so the request was skipped");
+    }
+    cache_token(token);
+    return token;
+}
+
+// NOTE: Musixmatch reports a rejected token in the response body (and sometimes as an HTTP 401).
+//       We throw in that case because it means that we could not search, not that there are no lyrics.
+//       A rejected token that we requested ourselves is dropped, so that the next search requests a new one.
+[[noreturn]] static void throw_token_rejected(const std::string& token)
+{
+    bool was_cached = false;
+    {
+        std::lock_guard<std::mutex> lock(g_token_cache.lock);
+        if(!token.empty() && (token == g_token_cache.token))
+        {
+            g_token_cache.token.clear();
+            was_cached = true;
+        }
+    }
+
+    if(was_cached)
+    {
+        throw std::runtime_error("Musixmatch rejected the token that we requested for it. A new one will be requested for the next search");
+    }
+    throw std::runtime_error("Musixmatch rejected the configured token. It may have expired, in which case a new one can be requested from the preferences page");
+}
+
+static std::string EncodeSearchResult(SongSearchResult search_result)
+{
+    std::string output;
+    output += (search_result.has_unsynced_lyrics ? '1' : '0');
+    output += (search_result.has_synced_lyrics ? '1' : '0');
+    output += std::to_string(search_result.track_id);
+    return output;
+}
+
+static std::optional<SongSearchResult> DecodeSearchResult(std::string_view str)
+{
+    if(str.length() < 3)
+    {
+        return {};
+    }
+    if((str[0] != '0') && (str[0] != '1'))
+    {
+        return {};
+    }
+    if((str[1] != '0') && (str[1] != '1'))
+    {
+        return {};
+    }
+
+    SongSearchResult result = {};
+    result.has_unsynced_lyrics = (str[0] == '1');
+    result.has_synced_lyrics = (str[1] == '1');
+    result.track_id = strtoll(&str[2], nullptr, 10);
+    return result;
+}
+
+std::vector<LyricDataRaw> MusixmatchLyricsSource::get_song_ids(const std::string& token, std::string_view artist, std::string_view album, std::string_view title, abort_callback& abort) const
+{
+    std::string url = std::string(g_api_url) + "track.search?" + g_common_params + "&subtitle_format=lrc&usertoken=" + token;
+    url += "&q_artist=" + urlencode(artist);
+    url += "&q_album=" + urlencode(album);
+    url += "&q_track=" + urlencode(title);
+    LOG_INFO("Querying for track ID from %s...", url.c_str());
+
+    std::string content;
+    try
+    {
+        // NOTE: Without adding the AWSELB and AWSELBCORS headers, we get a 301 (permanent redirect back)
+        //       with a header instructing us to set those cookies to the given hash.
+        //       The fb2k http API automatically follows the redirect but does not honour the Set-Cookie headers.
+        //       The redirect goes to the same URL and the request then fails after a while (presumably because
+        //       ELB thinks we're DoS'ing them and kills the connection).
+        //       Setting the headers here to just *some* value (even if its not a useful one) seems to make it work.
+        //       We may need to upgrade this in future to actually set the cookies that we're asked to set.
+        HttpRequest request = {"GET", url, {{"cookie", "AWSELBCORS=0; AWSELB=0"}}};
+        content = get_http_transport().run(request, abort);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to make Musixmatch search request to %s: %s", url.c_str(), e.what());
+        throw;
+    }
+
+    // NOTE: The header comes before the body, so this stops parsing as soon as it has the status code
+    std::optional<int64_t> status_code;
+    parsers::json::extract_records(content, "message.header", {"status_code"},
+        [&status_code](const parsers::json::RecordFields& header)
+        {
+            status_code = header[0].has_value() ? header[0]->as_int64() : std::nullopt;
+            return false;
+        });
+    if(status_code == std::optional<int64_t>(401))
+    {
+        throw_token_rejected(token);
+    }
+
+    // NOTE: Search responses can be hundreds of KB (mostly fields we don't care about), so rather
+    //       than building a full DOM we just pull out the handful of fields we need as we go.
+    const std::vector<std::string_view> fields = {
+        "track.artist_name",
+        "track.album_name",
+        "track.track_name",
+        "track.has_lyrics",
+        "track.has_subtitles",
+        "track.commontrack_id"
+    };
+    std::vector<LyricDataRaw> results;
+    std::string parse_error;
+    bool parse_success = parsers::json::extract_records(content, "message.body.track_list[]", fields,
+        [this, &results](const parsers::json::RecordFields& track)
+        {
+            const std::optional<parsers::json::Scalar>& artist = track[0];
+            const std::optional<parsers::json::Scalar>& album = track[1];
+            const std::optional<parsers::json::Scalar>& title = track[2];
+            if(!artist.has_value() || (artist->type != parsers::json::ScalarType::String) ||
+               !album.has_value() || (album->type != parsers::json::ScalarType::String) ||
+               !title.has_value() || (title->type != parsers::json::ScalarType::String))
+            {
+                LOG_INFO("Received musixmatch search result but track tags were malformed");
+                return false;
+            }
+
+            const std::optional<int64_t> has_lyrics = track[3].has_value() ? track[3]->as_int64() : std::nullopt;
+            const std::optional<int64_t> has_subtitles = track[4].has_value() ? track[4]->as_int64() : std::nullopt;
+            const std::optional<int64_t> track_id = track[5].has_value() ? track[5]->as_int64() : std::nullopt;
+            if(!has_lyrics.has_value() || !has_subtitles.has_value() || !track_id.has_value())
+            {
+                LOG_INFO("Received musixmatch search result but track lyric availability or ID was malformed");
+                return false;
+            }
+
+            SongSearchResult search_result = {};
+            search_result.track_id = track_id.value();
+            search_result.has_unsynced_lyrics = (has_lyrics.value() != 0);
+            search_result.has_synced_lyrics = (has_subtitles.value() != 0);
+
+            LyricDataRaw data = {};
+            data.source_id = id();
+            data.artist = artist->text;
+            data.album = album->text;
+            data.title = title->text;
+            data.lookup_id = EncodeSearchResult(search_result);
+            results.push_back(std::move(data));
+            return true;
+        },
+        &parse_error);
+
+    if(!parse_success)
+    {
+        LOG_INFO("Received musixmatch search result but it was malformed (%s): %s", parse_error.c_str(), content.c_str());
+    }
+    return results;
+}
+
+bool MusixmatchLyricsSource::get_lyrics(const std::string& token, LyricDataRaw& data, int64_t track_id, abort_callback& abort, const char* method, const char* body_entry_name, const char* text_entry_name) const
+{
+    assert(data.source_id == id());
+
+    std::string url = std::string(g_api_url) + method + "?" + g_common_params + "&usertoken=" + token + "&commontrack_id=" + std::to_string(track_id);
+    data.persistent_storage_path = url;
+    LOG_INFO("Get Musixmatch lyrics lyrics from %s...", url.c_str());
+
+    std::string content;
+    try
+    {
+        HttpRequest request = {"GET", url, {{"cookie", "AWSELBCORS=0; AWSELB=0"}}}; // NOTE: See the comment on the cookie in the track ID query
+        content = get_http_transport().run(request, abort);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to make Musixmatch %s request to %s: %s", method, url.c_str(), e.what());
+        throw;
+    }
+
+    cJSON* json = cJSON_ParseWithLength(content.c_str(), content.length());
+    if((json == nullptr) || (json->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch %s response but root was malformed: %s", method, content.c_str());
+        cJSON_Delete(json);
+        return false;
+    }
+
+    cJSON* json_message = cJSON_GetObjectItem(json, "message");
+    if((json_message == nullptr) || (json_message->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch %s response but message was malformed: %s", method, content.c_str());
+        cJSON_Delete(json);
+        return false;
+    }
+    if(token_rejected(json_message))
+    {
+        cJSON_Delete(json);
+        throw_token_rejected(token);
+    }
+
+    cJSON* json_body = cJSON_GetObjectItem(json_message, "body");
+    if((json_body == nullptr) || (json_body->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch %s response but body was malformed: %s", method, content.c_str());
+        cJSON_Delete(json);
+        return false;
+    }
+
+    cJSON* json_lyrics = cJSON_GetObjectItem(json_body, body_entry_name);
+    if((json_lyrics == nullptr) || (json_lyrics->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch %s response but %s was malformed: %s", method, body_entry_name, content.c_str());
+        cJSON_Delete(json);
+        return false;
+    }
+
+    cJSON* json_lyricstext = cJSON_GetObjectItem(json_lyrics, text_entry_name);
+    if((json_lyricstext == nullptr) || (json_lyricstext->type != cJSON_String))
+    {
+        LOG_INFO("Received musixmatch %s response but %s was malformed: %s", method, text_entry_name, content.c_str());
+        cJSON_Delete(json);
+        return false;
+    }
+
+    if(strlen(json_lyricstext->valuestring) == 0)
+    {
+        cJSON_Delete(json);
+        return false;
+    }
+
+    data.text = json_lyricstext->valuestring;
+    cJSON_Delete(json);
+    return !data.text.empty();
+}
+
+bool MusixmatchLyricsSource::get_unsynced_lyrics(const std::string& token, LyricDataRaw& data, int64_t track_id, abort_callback& abort) const
+{
+    return get_lyrics(token, data, track_id, abort, "track.lyrics.get", "lyrics", "lyrics_body");
+}
+
+bool MusixmatchLyricsSource::get_synced_lyrics(const std::string& token, LyricDataRaw& data, int64_t track_id, abort_callback& abort) const
+{
+    return get_lyrics(token, data, track_id, abort, "track.subtitle.get", "subtitle", "subtitle_body");
+}
+
+// NOTE: The macro call runs the track match, lyrics and subtitle requests on Musixmatch's side and returns
+//       all three results in one response. That saves us a full round-trip per track compared to searching
+//       and then looking up the lyrics for the result, at the cost of also downloading the unsynced lyrics
+//       for tracks that have synced lyrics available.
+std::vector<LyricDataRaw> MusixmatchLyricsSource::get_macro_lyrics(const std::string& token, const SearchContext& context, abort_callback& abort) const
+{
+    std::string url = std::string(g_api_url) + "macro.subtitles.get?" + g_common_params + "&format=json&namespace=lyrics_richsynched&subtitle_format=lrc&usertoken=" + token;
+    url += "&q_artist=" + urlencode(context.artist);
+    url += "&q_album=" + urlencode(context.album);
+    url += "&q_track=" + urlencode(context.title);
+    if(context.duration_sec > 0.0)
+    {
+        url += "&q_duration=" + std::to_string(int(context.duration_sec));
+    }
+    LOG_INFO("Querying for lyrics with macro request to %s...", url.c_str());
+
+    std::string content;
+    try
+    {
+        HttpRequest request = {"GET", url, {{"cookie", "AWSELBCORS=0; AWSELB=0"}}}; // NOTE: See the comment on the cookie in the track ID query
+        content = get_http_transport().run(request, abort);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to make Musixmatch macro request to %s: %s", url.c_str(), e.what());
+        throw;
+    }
+
+    cJSON* json = cJSON_ParseWithLength(content.c_str(), content.length());
+    cJSON* json_message = get_object_path(json, {"message"});
+    cJSON* json_calls = get_object_path(json_message, {"body", "macro_calls"});
+    if((json_calls == nullptr) || (json_calls->type != cJSON_Object))
+    {
+        const bool rejected = token_rejected(json_message);
+        cJSON_Delete(json);
+        if(rejected)
+        {
+            throw_token_rejected(token);
+        }
+        LOG_INFO("Received musixmatch macro response but it was malformed: %s", content.c_str());
+        return {};
+    }
+
+    cJSON* json_track = get_object_path(json_calls, {"matcher.track.get", "message", "body", "track"});
+    const char* artist = get_string_path(json_track, {"artist_name"});
+    const char* album = get_string_path(json_track, {"album_name"});
+    const char* title = get_string_path(json_track, {"track_name"});
+    if((artist == nullptr) || (title == nullptr))
+    {
+        const bool rejected = token_rejected(get_object_path(json_calls, {"matcher.track.get", "message"}));
+        cJSON_Delete(json);
+        if(rejected)
+        {
+            throw_token_rejected(token);
+        }
+        LOG_INFO("Musixmatch macro response did not contain a matching track");
+        return {};
+    }
+
+    LyricDataRaw data = {};
+    data.source_id = id();
+    data.persistent_storage_path = url;
+    data.artist = artist;
+    data.album = (album != nullptr) ? album : "";
+    data.title = title;
+
+    // NOTE: An empty result body is returned as an empty array rather than an object, which get_object_path handles for us
+    cJSON* json_subtitle_list = get_object_path(json_calls, {"track.subtitles.get", "message", "body", "subtitle_list"});
+    if((json_subtitle_list != nullptr) && (json_subtitle_list->type == cJSON_Array))
+    {
+        cJSON* json_first_subtitle = cJSON_GetArrayItem(json_subtitle_list, 0);
+        const char* subtitle_body = get_string_path(json_first_subtitle, {"subtitle", "subtitle_body"});
+        if(subtitle_body != nullptr)
+        {
+            data.text = subtitle_body;
+        }
+    }
+
+    if(data.text.empty())
+    {
+        const char* lyrics_body = get_string_path(json_calls, {"track.lyrics.get", "message", "body", "lyrics", "lyrics_body"});
+        if(lyrics_body != nullptr)
+        {
+            data.text = lyrics_body;
+        }
+    }
+    cJSON_Delete(json);
+
+    if(data.text.empty())
+    {
+        LOG_INFO("Musixmatch macro response matched a track but did not contain any lyrics");
+        return {};
+    }
+
+    // NOTE: The lyrics are already in the result, so there will be no lookup for it
+    return {std::move(data)};
+}
+
+std::vector<LyricDataRaw> MusixmatchLyricsSource::search(const SearchContext& context, abort_callback& abort)
+{
+    const std::string token = get_request_token(abort);
+
+    if(preferences::advanced::musixmatch_macro_search())
+    {
+        return get_macro_lyrics(token, context, abort);
+    }
+    return get_song_ids(token, context.artist, context.album, context.title, abort);
+}
+
+bool MusixmatchLyricsSource::lookup(const SearchContext& /*context*/, LyricDataRaw& data, abort_callback& abort)
+{
+    std::optional<SongSearchResult> maybe_search_result = DecodeSearchResult(data.lookup_id);
+    if(!maybe_search_result.has_value())
+    {
+        LOG_WARN("Attempt to lookup musixmatch lyrics with invalid lookup ID: %s", data.lookup_id.c_str());
+        return false;
+    }
+
+    const SongSearchResult& search_result = maybe_search_result.value();
+    if(search_result.track_id == 0)
+    {
+        LOG_WARN("Attempt to lookup musixmatch lyrics with null lookup track ID: %s", data.lookup_id.c_str());
+        return false;
+    }
+
+    const std::string token = get_request_token(abort);
+
+    if(search_result.has_synced_lyrics)
+    {
+        return get_synced_lyrics(token, data, search_result.track_id, abort);
+    }
+    else if(search_result.has_unsynced_lyrics)
+    {
+        return get_unsynced_lyrics(token, data, search_result.track_id, abort);
+    }
+    else
+    {
+        return false;
+    }
+}
+
+static std::string request_token(abort_callback& abort)
+{
+    std::string url = std::string(g_api_url) + "token.get?" + g_common_params;
+    LOG_INFO("Attempting to get Musixmatch token from %s...", url.c_str());
+
+    std::string content;
+    try
+    {
+        HttpRequest request = {"GET", url, {{"cookie", "AWSELBCORS=0; AWSELB=0"}}}; // NOTE: See the comment on the cookie in the track ID query
+        content = get_http_transport().run(request, abort);
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to get Musixmatch token from %s: %s", url.c_str(), e.what());
+        return "";
+    }
+
+    cJSON* json = cJSON_ParseWithLength(content.c_str(), content.length());
+    if((json == nullptr) || (json->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch token response but root was malformed: %s", content.c_str());
+        cJSON_Delete(json);
+        return "";
+    }
+
+    cJSON* json_message = cJSON_GetObjectItem(json, "message");
+    if((json_message == nullptr) || (json_message->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch token response but message was malformed: %s", content.c_str());
+        cJSON_Delete(json);
+        return "";
+    }
+
+    cJSON* json_body = cJSON_GetObjectItem(json_message, "body");
+    if((json_body == nullptr) || (json_body->type != cJSON_Object))
+    {
+        LOG_INFO("Received musixmatch token response but body was malformed: %s", content.c_str());
+        cJSON_Delete(json);
+        return "";
+    }
+
+    cJSON* json_token = cJSON_GetObjectItem(json_body, "user_token");
+    if((json_token == nullptr) || (json_token->type != cJSON_String))
+    {
+        LOG_INFO("Received musixmatch token response but user_token was malformed: %s", content.c_str());
+        cJSON_Delete(json);
+        return "";
+    }
+
+    std::string result = json_token->valuestring;
+    cJSON_Delete(json);
+    return result;
+}
+
+std::string musixmatch_get_token(abort_callback& abort)
+{
+    // NOTE: This is used when the user explicitly asks for a token (which is usually because the one they have has
+    //       stopped working), so we always request a new one rather than returning the cached one.
+    std::string token = request_token(abort);
+    cache_token(token);
+    return token;
+}
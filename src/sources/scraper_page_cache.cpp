@@ -0,0 +1,146 @@
+#include "stdafx.h"
+
+#include "logging.h"
+#include "preferences.h"
+#include "scraper_page_cache.h"
+
+static constexpr size_t MAX_PAGES_IN_MEMORY = 64;
+static constexpr uint32_t DISK_FORMAT_VERSION = 1;
+static constexpr t_filetimestamp DISK_ENTRY_LIFETIME = 4 * system_time_periods::week;
+
+std::shared_ptr<const ScrapedPageCache::Sections> ScrapedPageCache::get(const std::string& url)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto iter = m_pages.find(url);
+        if(iter != m_pages.end())
+        {
+            return iter->second;
+        }
+    }
+
+    if(!preferences::advanced::scraper_page_disk_cache())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<const Sections> sections = read_from_disk(url);
+    if(sections != nullptr)
+    {
+        add_to_memory(url, sections);
+    }
+    return sections;
+}
+
+void ScrapedPageCache::put(const std::string& url, std::shared_ptr<const Sections> sections)
+{
+    add_to_memory(url, sections);
+    if(preferences::advanced::scraper_page_disk_cache())
+    {
+        write_to_disk(url, *sections);
+    }
+}
+
+void ScrapedPageCache::add_to_memory(const std::string& url, std::shared_ptr<const Sections> sections)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    if(m_pages.count(url) == 0)
+    {
+        m_insertion_order.push_back(url);
+        if(m_insertion_order.size() > MAX_PAGES_IN_MEMORY)
+        {
+            m_pages.erase(m_insertion_order.front());
+            m_insertion_order.pop_front();
+        }
+    }
+    m_pages[url] = std::move(sections);
+}
+
+std::string ScrapedPageCache::disk_path(const std::string& url)
+{
+    const pfc::string8 url_hash = static_api_ptr_t<hasher_md5>()->process_single_string(url.c_str()).asString();
+    std::string path = core_api::get_profile_path();
+    path += "\\openlyrics_page_cache\\";
+    path += url_hash.c_str();
+    path += ".bin";
+    return path;
+}
+
+std::shared_ptr<const ScrapedPageCache::Sections> ScrapedPageCache::read_from_disk(const std::string& url)
+{
+    const std::string path = disk_path(url);
+    try
+    {
+        abort_callback_dummy noAbort;
+        if(!filesystem::g_exists(path.c_str(), noAbort))
+        {
+            return nullptr;
+        }
+
+        file_ptr file;
+        filesystem::g_open_read(file, path.c_str(), noAbort);
+
+        uint32_t version = 0;
+        t_filetimestamp write_time = 0;
+        pfc::string8 stored_url;
+        file->read_lendian_t(version, noAbort);
+        file->read_lendian_t(write_time, noAbort);
+        file->read_string(stored_url, noAbort);
+        if((version != DISK_FORMAT_VERSION) ||
+           (url != stored_url.c_str()) ||
+           (write_time + DISK_ENTRY_LIFETIME < filetimestamp_from_system_timer()))
+        {
+            return nullptr;
+        }
+
+        uint32_t section_count = 0;
+        file->read_lendian_t(section_count, noAbort);
+        auto sections = std::make_shared<Sections>();
+        for(uint32_t i=0; i<section_count; i++)
+        {
+            pfc::string8 title;
+            pfc::string8 text;
+            file->read_string(title, noAbort);
+            file->read_string(text, noAbort);
+            sections->push_back({title.c_str(), text.c_str()});
+        }
+
+        LOG_INFO("Loaded %u cached sections for %s from %s", section_count, url.c_str(), path.c_str());
+        return sections;
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to read cached page for %s from %s: %s", url.c_str(), path.c_str(), e.what());
+        return nullptr;
+    }
+}
+
+void ScrapedPageCache::write_to_disk(const std::string& url, const Sections& sections)
+{
+    const std::string path = disk_path(url);
+    try
+    {
+        abort_callback_dummy noAbort;
+        pfc::string8 directory = pfc::string_directory(path.c_str());
+        if(!filesystem::g_exists(directory.c_str(), noAbort))
+        {
+            filesystem::g_create_directory(directory.c_str(), noAbort);
+        }
+
+        file_ptr file;
+        filesystem::g_open_write_new(file, path.c_str(), noAbort);
+        file->write_lendian_t(DISK_FORMAT_VERSION, noAbort);
+        file->write_lendian_t(filetimestamp_from_system_timer(), noAbort);
+        file->write_string(url.c_str(), noAbort);
+        file->write_lendian_t(uint32_t(sections.size()), noAbort);
+        for(const ScrapedSection& section : sections)
+        {
+            file->write_string(section.title.c_str(), noAbort);
+            file->write_string(section.text.c_str(), noAbort);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to write cached page for %s to %s: %s", url.c_str(), path.c_str(), e.what());
+    }
+}
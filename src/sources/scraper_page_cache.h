@@ -0,0 +1,33 @@
+#pragma once
+
+#include "stdafx.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "scraper_program.h"
+
+// A cache of the sections scraped from each page, so that searches for other tracks whose lyrics are on the same
+// page (e.g the rest of an album) do not need to download or parse it again.
+// NOTE: Cached pages are keyed by URL, which identifies both the rule and the page (e.g the artist & album).
+//       Pages are kept in memory for the session and (if enabled) in the profile directory between sessions.
+class ScrapedPageCache
+{
+public:
+    using Sections = std::vector<ScrapedSection>;
+
+    // Returns the cached sections for the given page, or null if it is not in the cache
+    std::shared_ptr<const Sections> get(const std::string& url);
+    void put(const std::string& url, std::shared_ptr<const Sections> sections);
+
+private:
+    void add_to_memory(const std::string& url, std::shared_ptr<const Sections> sections);
+
+    static std::string disk_path(const std::string& url);
+    static std::shared_ptr<const Sections> read_from_disk(const std::string& url);
+    static void write_to_disk(const std::string& url, const Sections& sections);
+
+    std::mutex m_lock;
+    std::unordered_map<std::string, std::shared_ptr<const Sections>> m_pages;
+    std::deque<std::string> m_insertion_order;
+};
@@ -0,0 +1,545 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "html_scraper.h"
+#include "scraper_program.h"
+
+static constexpr size_t MAX_SELECTOR_STEPS = 64;
+
+// NOTE: This matches trim_surrounding_whitespace() in tag_util.h, which we can't use without the foobar2000 SDK
+static std::string_view trim_whitespace(std::string_view str)
+{
+    const size_t first_non_whitespace = str.find_first_not_of("\r\n ");
+    if(first_non_whitespace == std::string_view::npos)
+    {
+        return {};
+    }
+    const size_t last_non_whitespace = str.find_last_not_of("\r\n ");
+    return str.substr(first_non_whitespace, last_non_whitespace + 1 - first_non_whitespace);
+}
+
+class SelectorCompiler
+{
+public:
+    SelectorCompiler(std::string_view selector, std::vector<SelectorStep>& out_steps)
+        : m_input(selector)
+        , m_steps(out_steps)
+    {
+    }
+
+    // Returns the index of the final step of the compiled selector
+    int compile()
+    {
+        Combinator combinator = Combinator::None;
+        while(true)
+        {
+            skip_whitespace();
+            SelectorStep step = {};
+            step.combinator = combinator;
+            parse_compound(step);
+            if(m_steps.size() >= MAX_SELECTOR_STEPS)
+            {
+                throw std::runtime_error("Too many selector steps in scraper rule");
+            }
+            m_steps.push_back(std::move(step));
+
+            const size_t whitespace_start = m_pos;
+            skip_whitespace();
+            if(m_pos >= m_input.length())
+            {
+                break;
+            }
+
+            const char c = m_input[m_pos];
+            if(c == '>') combinator = Combinator::Child;
+            else if(c == '~') combinator = Combinator::Sibling;
+            else if(c == '+') combinator = Combinator::AdjacentSibling;
+            else if(m_pos > whitespace_start) combinator = Combinator::Descendant;
+            else fail("Unexpected character");
+
+            if(combinator != Combinator::Descendant)
+            {
+                m_pos++;
+            }
+        }
+        return int(m_steps.size()) - 1;
+    }
+
+private:
+    [[noreturn]] void fail(const char* reason) const
+    {
+        throw std::runtime_error(std::string(reason) + " at offset " + std::to_string(m_pos) + " of selector '" + std::string(m_input) + "'");
+    }
+
+    void skip_whitespace()
+    {
+        while((m_pos < m_input.length()) && (m_input[m_pos] == ' '))
+        {
+            m_pos++;
+        }
+    }
+
+    static bool is_ident_char(char c)
+    {
+        return (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))) || (c == '-') || (c == '_');
+    }
+
+    std::string parse_ident()
+    {
+        const size_t start = m_pos;
+        while((m_pos < m_input.length()) && is_ident_char(m_input[m_pos]))
+        {
+            m_pos++;
+        }
+        if(m_pos == start)
+        {
+            fail("Expected an identifier");
+        }
+        return std::string(m_input.substr(start, m_pos - start));
+    }
+
+    std::string parse_value()
+    {
+        if((m_pos < m_input.length()) && ((m_input[m_pos] == '\'') || (m_input[m_pos] == '"')))
+        {
+            const char quote = m_input[m_pos];
+            const size_t end = m_input.find(quote, m_pos + 1);
+            if(end == std::string_view::npos)
+            {
+                fail("Unterminated attribute value");
+            }
+            std::string value(m_input.substr(m_pos + 1, end - m_pos - 1));
+            m_pos = end + 1;
+            return value;
+        }
+        return parse_ident();
+    }
+
+    void expect(char c)
+    {
+        if((m_pos >= m_input.length()) || (m_input[m_pos] != c))
+        {
+            fail("Unexpected character");
+        }
+        m_pos++;
+    }
+
+    AttributeTest parse_attribute()
+    {
+        expect('[');
+        AttributeTest test = {};
+        test.name = parse_ident();
+        test.op = AttributeOp::Exists;
+        if(m_input.substr(m_pos, 2) == "*=")
+        {
+            m_pos += 2;
+            test.op = AttributeOp::Contains;
+            test.value = parse_value();
+        }
+        else if(m_input.substr(m_pos, 1) == "=")
+        {
+            m_pos += 1;
+            test.op = AttributeOp::Equals;
+            test.value = parse_value();
+        }
+        expect(']');
+        return test;
+    }
+
+    void parse_compound(SelectorStep& step)
+    {
+        const size_t start = m_pos;
+        if((m_pos < m_input.length()) && is_ident_char(m_input[m_pos]))
+        {
+            step.tag = parse_ident();
+        }
+
+        while(m_pos < m_input.length())
+        {
+            const char c = m_input[m_pos];
+            if(c == '.')
+            {
+                m_pos++;
+                step.classes.push_back(parse_ident());
+            }
+            else if(c == '[')
+            {
+                step.attributes.push_back(parse_attribute());
+            }
+            else if(m_input.substr(m_pos, 5) == ":not(")
+            {
+                m_pos += 5;
+                AttributeTest test = parse_attribute();
+                if(test.op != AttributeOp::Exists)
+                {
+                    fail(":not() only supports attribute existence tests");
+                }
+                test.op = AttributeOp::NotExists;
+                step.attributes.push_back(std::move(test));
+                expect(')');
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if(m_pos == start)
+        {
+            fail("Expected a selector");
+        }
+    }
+
+    std::string_view m_input;
+    size_t m_pos = 0;
+    std::vector<SelectorStep>& m_steps;
+};
+
+static bool step_matches_element(const SelectorStep& step, const HtmlElement& element)
+{
+    if(!step.tag.empty() && (step.tag != element.name()))
+    {
+        return false;
+    }
+
+    for(const AttributeTest& test : step.attributes)
+    {
+        const std::optional<std::string_view> value = element.attribute(test.name);
+        switch(test.op)
+        {
+            case AttributeOp::Exists: if(!value.has_value()) return false; break;
+            case AttributeOp::NotExists: if(value.has_value()) return false; break;
+            case AttributeOp::Equals: if(value != test.value) return false; break;
+            case AttributeOp::Contains: if(!value.has_value() || (value->find(test.value) == std::string_view::npos)) return false; break;
+        }
+    }
+
+    if(!step.classes.empty())
+    {
+        const std::string_view class_list = element.attribute("class").value_or(std::string_view());
+        for(const std::string& required_class : step.classes)
+        {
+            bool found = false;
+            size_t pos = 0;
+            while(!found && (pos < class_list.length()))
+            {
+                size_t end = class_list.find(' ', pos);
+                if(end == std::string_view::npos)
+                {
+                    end = class_list.length();
+                }
+                found = (class_list.substr(pos, end - pos) == required_class);
+                pos = end + 1;
+            }
+
+            if(!found)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+struct ScrapedContent
+{
+    std::string text;
+    bool complete = false;
+    std::vector<std::pair<std::string, std::string>> sections; // Title & text for each section
+};
+
+class RuleScraper : public HtmlScraper
+{
+public:
+    // If no section matcher is given then every section is collected (rather than stopping after the one for the track)
+    RuleScraper(const ScraperProgram& program, SectionTitleMatcher section_matches)
+        : m_program(program)
+        , m_section_matches(std::move(section_matches))
+        , m_results(program.content.size())
+    {
+        m_stack.push_back({}); // The document root
+    }
+
+    std::vector<ScrapedSection> take_sections()
+    {
+        std::vector<ScrapedSection> output;
+        for(size_t i=0; i<m_results.size(); i++)
+        {
+            if(m_program.content[i].text_policy != TextPolicy::Sections)
+            {
+                continue;
+            }
+
+            for(auto& section : m_results[i].sections)
+            {
+                std::optional<std::string_view> title = normalise_section_title(m_program.content[i], section.first);
+                std::string_view text = trim_whitespace(section.second);
+                if(title.has_value() && !title->empty() && !text.empty())
+                {
+                    output.push_back({std::string(title.value()), std::string(text)});
+                }
+            }
+        }
+        return output;
+    }
+
+    std::string take_lyrics()
+    {
+        for(size_t i=0; i<m_results.size(); i++)
+        {
+            ScrapedContent& result = m_results[i];
+            if(m_program.content[i].text_policy == TextPolicy::Sections)
+            {
+                for(auto& section : result.sections)
+                {
+                    if(section_title_matches(m_program.content[i], section.first))
+                    {
+                        return std::move(section.second);
+                    }
+                }
+            }
+            else if(!result.text.empty())
+            {
+                return std::move(result.text);
+            }
+        }
+        return {};
+    }
+
+protected:
+    void on_element_start(const HtmlElement& element) override
+    {
+        ElementState& parent = m_stack.back();
+        uint64_t matched = 0;
+        for(size_t i=0; i<m_program.steps.size(); i++)
+        {
+            const SelectorStep& step = m_program.steps[i];
+            const uint64_t previous_step = (i > 0) ? (uint64_t(1) << (i-1)) : 0;
+            bool relation_satisfied = false;
+            switch(step.combinator)
+            {
+                case Combinator::None: relation_satisfied = true; break;
+                case Combinator::Descendant: relation_satisfied = ((parent.matched_by_self_or_ancestor & previous_step) != 0); break;
+                case Combinator::Child: relation_satisfied = ((parent.matched & previous_step) != 0); break;
+                case Combinator::Sibling: relation_satisfied = ((parent.matched_by_any_child & previous_step) != 0); break;
+                case Combinator::AdjacentSibling: relation_satisfied = ((parent.matched_by_last_child & previous_step) != 0); break;
+            }
+
+            if(relation_satisfied && step_matches_element(step, element))
+            {
+                matched |= (uint64_t(1) << i);
+            }
+        }
+
+        parent.matched_by_any_child |= matched;
+        parent.matched_by_last_child = matched;
+        ElementState state = {};
+        state.matched = matched;
+        state.matched_by_self_or_ancestor = parent.matched_by_self_or_ancestor | matched;
+        m_stack.push_back(state);
+
+        if(m_capture_index < 0)
+        {
+            for(size_t i=0; i<m_program.content.size(); i++)
+            {
+                const ContentRule& rule = m_program.content[i];
+                if(!m_results[i].complete && ((matched & (uint64_t(1) << rule.selector)) != 0))
+                {
+                    m_capture_index = int(i);
+                    m_capture_depth = depth();
+                    m_section_header_depth = 0;
+                    m_in_section = false;
+                    break;
+                }
+            }
+        }
+        else if(m_program.content[m_capture_index].text_policy == TextPolicy::Sections)
+        {
+            const ContentRule& rule = m_program.content[m_capture_index];
+            ScrapedContent& result = m_results[m_capture_index];
+            const bool is_header = (rule.section_header >= 0) && ((matched & (uint64_t(1) << rule.section_header)) != 0);
+            const bool is_end = (rule.section_end >= 0) && ((matched & (uint64_t(1) << rule.section_end)) != 0);
+            if(is_header || is_end)
+            {
+                end_section();
+            }
+
+            if(is_header && (m_section_header_depth == 0))
+            {
+                m_section_header_depth = depth();
+                result.sections.push_back({});
+            }
+        }
+    }
+
+    void on_element_end(std::string_view /*name*/) override
+    {
+        if(m_capture_index >= 0)
+        {
+            if(depth() == m_capture_depth)
+            {
+                end_section();
+                finish_capture();
+            }
+            else if(depth() == m_section_header_depth)
+            {
+                m_section_header_depth = 0;
+                m_in_section = true;
+            }
+        }
+
+        m_stack.pop_back();
+    }
+
+    void on_text(std::string_view text) override
+    {
+        if(m_capture_index < 0)
+        {
+            return;
+        }
+
+        const ContentRule& rule = m_program.content[m_capture_index];
+        ScrapedContent& result = m_results[m_capture_index];
+        switch(rule.text_policy)
+        {
+            case TextPolicy::DirectText:
+                if(depth() == m_capture_depth)
+                {
+                    append_line(result.text, text);
+                }
+                break;
+
+            case TextPolicy::AllText:
+                append_line(result.text, text);
+                break;
+
+            case TextPolicy::Sections:
+                if(result.sections.empty())
+                {
+                    break;
+                }
+                if(m_section_header_depth > 0)
+                {
+                    result.sections.back().first += text;
+                }
+                else if(m_in_section)
+                {
+                    append_line(result.sections.back().second, text);
+                }
+                break;
+        }
+    }
+
+private:
+    struct ElementState
+    {
+        uint64_t matched;
+        uint64_t matched_by_self_or_ancestor;
+        uint64_t matched_by_any_child;
+        uint64_t matched_by_last_child;
+    };
+
+    static void append_line(std::string& output, std::string_view text)
+    {
+        output += trim_whitespace(text);
+        output += "\r\n";
+    }
+
+    static std::optional<std::string_view> normalise_section_title(const ContentRule& rule, std::string_view title)
+    {
+        const std::string& title_after = rule.section_title_after;
+        if(!title_after.empty())
+        {
+            size_t prefix_index = title.find(title_after);
+            if(prefix_index == std::string_view::npos)
+            {
+                return {};
+            }
+            title.remove_prefix(prefix_index + title_after.length());
+        }
+        return trim_whitespace(title);
+    }
+
+    bool section_title_matches(const ContentRule& rule, std::string_view title) const
+    {
+        if(!m_section_matches)
+        {
+            return false;
+        }
+
+        std::optional<std::string_view> section_title = normalise_section_title(rule, title);
+        return section_title.has_value() && m_section_matches(section_title.value());
+    }
+
+    void end_section()
+    {
+        if(!m_in_section)
+        {
+            return;
+        }
+        m_in_section = false;
+
+        // NOTE: If we've just finished the section for our track then there is nothing more to look for
+        const ScrapedContent& result = m_results[m_capture_index];
+        if(!result.sections.empty() && section_title_matches(m_program.content[m_capture_index], result.sections.back().first))
+        {
+            stop_parsing();
+        }
+    }
+
+    void finish_capture()
+    {
+        const ContentRule& rule = m_program.content[m_capture_index];
+        if(!rule.match_all)
+        {
+            m_results[m_capture_index].complete = true;
+        }
+        m_capture_index = -1;
+        m_capture_depth = 0;
+
+        // NOTE: We can stop as soon as the most-preferred content has been found
+        //       (or all the content that we could ever find has been found).
+        const bool all_complete = std::all_of(m_results.begin(), m_results.end(), [](const ScrapedContent& r) { return r.complete; });
+        if(m_results.front().complete || all_complete)
+        {
+            stop_parsing();
+        }
+    }
+
+    const ScraperProgram& m_program;
+    SectionTitleMatcher m_section_matches;
+    std::vector<ScrapedContent> m_results;
+    std::vector<ElementState> m_stack;
+
+    int m_capture_index = -1;
+    int m_capture_depth = 0;
+    int m_section_header_depth = 0;
+    bool m_in_section = false;
+};
+
+int compile_selector(std::string_view selector, std::vector<SelectorStep>& steps)
+{
+    return SelectorCompiler(selector, steps).compile();
+}
+
+std::optional<std::string> scrape_lyrics(const ScraperProgram& program, std::string_view html, std::string_view url, const SectionTitleMatcher& section_matches)
+{
+    RuleScraper scraper(program, section_matches);
+    if(!scraper.parse(html, url))
+    {
+        return {};
+    }
+    return scraper.take_lyrics();
+}
+
+std::optional<std::vector<ScrapedSection>> scrape_sections(const ScraperProgram& program, std::string_view html, std::string_view url)
+{
+    RuleScraper scraper(program, nullptr);
+    if(!scraper.parse(html, url))
+    {
+        return {};
+    }
+    return scraper.take_sections();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// NOTE: This deliberately does not depend on the foobar2000 SDK, so that it can be built and tested on its own.
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class AttributeOp
+{
+    Exists,
+    NotExists,
+    Equals,
+    Contains,
+};
+
+struct AttributeTest
+{
+    std::string name;
+    AttributeOp op;
+    std::string value;
+};
+
+enum class Combinator
+{
+    None, // The first step of a selector
+    Descendant,
+    Child,
+    Sibling,
+    AdjacentSibling,
+};
+
+struct SelectorStep
+{
+    Combinator combinator;
+    std::string tag; // Empty to match any tag
+    std::vector<std::string> classes;
+    std::vector<AttributeTest> attributes;
+};
+
+enum class TextPolicy
+{
+    DirectText,
+    AllText,
+    Sections,
+};
+
+struct ContentRule
+{
+    int selector; // The index of the final step of the content selector
+    TextPolicy text_policy;
+    bool match_all;
+
+    int section_header; // The index of the final step of the section header selector, or -1 if there is none
+    int section_end; // The index of the final step of the section end selector, or -1 if there is none
+    std::string section_title_after;
+};
+
+struct ScraperProgram
+{
+    // NOTE: The steps of every selector used by the rule are stored in one list so that the state of all of them
+    //       can be tracked using a single bitmask per element while scraping. A step whose combinator is not None
+    //       is relative to the step immediately before it.
+    std::vector<SelectorStep> steps;
+    std::vector<ContentRule> content;
+};
+
+struct ScrapedSection
+{
+    std::string title;
+    std::string text;
+};
+
+// Compiles the given selector (see the rules in scraper_rules.cpp for the subset of CSS that is supported) and
+// appends its steps to `steps`. Returns the index of the final step. Throws if the selector is invalid.
+int compile_selector(std::string_view selector, std::vector<SelectorStep>& steps);
+
+// Returns true if the given (normalised) section title is the title of the track that we're looking for
+using SectionTitleMatcher = std::function<bool(std::string_view section_title)>;
+
+// Returns the lyrics that the program finds on the given page (which are empty if there are none),
+// or nothing if the page could not be parsed at all
+std::optional<std::string> scrape_lyrics(const ScraperProgram& program, std::string_view html, std::string_view url, const SectionTitleMatcher& section_matches);
+
+// Returns every section on the page (for programs with "sections" content), with titles and text trimmed,
+// or nothing if the page could not be parsed at all
+std::optional<std::vector<ScrapedSection>> scrape_sections(const ScraperProgram& program, std::string_view html, std::string_view url);
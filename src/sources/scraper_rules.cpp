@@ -0,0 +1,417 @@
+#include "stdafx.h"
+#include <cctype>
+#include <mutex>
+#include <unordered_map>
+
+#include "cJSON.h"
+
+#include "http_transport.h"
+#include "logging.h"
+#include "scraper_page_cache.h"
+#include "scraper_rules.h"
+#include "tag_util.h"
+
+// NOTE: These are the rules that we ship with. Any rule with the same name in the rules file
+//       in the profile directory replaces the corresponding rule here, so that a user can fix a source
+//       after a site changes its layout without waiting for a new release.
+//
+//       Selectors support a subset of CSS: tag names, .class, [attr], [attr=value], [attr*=value] and
+//       :not([attr]), combined with descendant (" "), child (">"), sibling ("~") and adjacent-sibling ("+")
+//       combinators. Each "content" entry is tried in order and the first one to produce text is used.
+//       Text is assembled one line per text node, from either the matched element's "direct" text children,
+//       "all" the text inside it, or (for "sections") the text following the section header whose title
+//       matches the track title.
+static const char* g_default_rules = R"json({
+    "azlyrics": {
+        "url": "https://www.azlyrics.com/lyrics/{artist}/{title}.html",
+        "url_encoding": "alphanumeric",
+        "headers": { "User-Agent": "Mozilla/5.0 (Windows NT 10.0; Win64; x64; rv:84.0) Gecko/20100101 Firefox/84.0" },
+        "content": [
+            { "selector": "div.lyricsh ~ div:not([class])", "text": "direct" }
+        ]
+    },
+    "darklyrics": {
+        "url": "http://darklyrics.com/lyrics/{artist}/{album}.html",
+        "url_encoding": "alphanumeric",
+        "cache_sections": true,
+        "content": [
+            {
+                "selector": "div.lyrics",
+                "text": "sections",
+                "section_header": "div.lyrics > h3",
+                "section_end": "div.lyrics div",
+                "section_title_after": "."
+            }
+        ]
+    },
+    "genius": {
+        "url": "https://genius.com/{artist}-{title}-lyrics",
+        "url_encoding": "hyphenated",
+        "content": [
+            { "selector": "div.lyrics", "text": "all" },
+            { "selector": "div[class*=Lyrics__Container]", "text": "all", "match": "all" }
+        ]
+    }
+})json";
+
+static const char* g_rules_override_filename = "openlyrics_scraper_rules.json";
+
+static std::string json_string(cJSON* obj, const char* key, std::string_view default_value = {})
+{
+    cJSON* item = cJSON_GetObjectItem(obj, key);
+    if((item == nullptr) || (item->type != cJSON_String))
+    {
+        return std::string(default_value);
+    }
+    return item->valuestring;
+}
+
+static std::shared_ptr<const ScraperRule> compile_rule(const char* name, cJSON* json)
+{
+    if((json == nullptr) || (json->type != cJSON_Object))
+    {
+        throw std::runtime_error("Rule is not an object");
+    }
+
+    auto rule = std::make_shared<ScraperRule>();
+    auto program = std::make_shared<ScraperProgram>();
+    rule->name = name;
+    rule->url_template = json_string(json, "url");
+    if(rule->url_template.empty())
+    {
+        throw std::runtime_error("Rule has no URL");
+    }
+
+    const std::string url_encoding = json_string(json, "url_encoding", "alphanumeric");
+    if(url_encoding == "alphanumeric") rule->url_encoding = ScraperUrlEncoding::Alphanumeric;
+    else if(url_encoding == "hyphenated") rule->url_encoding = ScraperUrlEncoding::Hyphenated;
+    else throw std::runtime_error("Unrecognised URL encoding: " + url_encoding);
+
+    cJSON* headers = cJSON_GetObjectItem(json, "headers");
+    if((headers != nullptr) && (headers->type == cJSON_Object))
+    {
+        cJSON* header = nullptr;
+        cJSON_ArrayForEach(header, headers)
+        {
+            if(header->type == cJSON_String)
+            {
+                rule->headers.emplace_back(header->string, header->valuestring);
+            }
+        }
+    }
+
+    cJSON* content_list = cJSON_GetObjectItem(json, "content");
+    if((content_list == nullptr) || (content_list->type != cJSON_Array) || (cJSON_GetArraySize(content_list) == 0))
+    {
+        throw std::runtime_error("Rule has no content selectors");
+    }
+
+    cJSON* content = nullptr;
+    cJSON_ArrayForEach(content, content_list)
+    {
+        if(content->type != cJSON_Object)
+        {
+            throw std::runtime_error("Content entry is not an object");
+        }
+
+        ContentRule content_rule = {};
+        content_rule.selector = compile_selector(json_string(content, "selector"), program->steps);
+        content_rule.match_all = (json_string(content, "match", "first") == "all");
+        content_rule.section_header = -1;
+        content_rule.section_end = -1;
+
+        const std::string text_policy = json_string(content, "text", "all");
+        if(text_policy == "direct") content_rule.text_policy = TextPolicy::DirectText;
+        else if(text_policy == "all") content_rule.text_policy = TextPolicy::AllText;
+        else if(text_policy == "sections") content_rule.text_policy = TextPolicy::Sections;
+        else throw std::runtime_error("Unrecognised text policy: " + text_policy);
+
+        if(content_rule.text_policy == TextPolicy::Sections)
+        {
+            content_rule.section_header = compile_selector(json_string(content, "section_header"), program->steps);
+            const std::string section_end = json_string(content, "section_end");
+            if(!section_end.empty())
+            {
+                content_rule.section_end = compile_selector(section_end, program->steps);
+            }
+            content_rule.section_title_after = json_string(content, "section_title_after");
+        }
+
+        program->content.push_back(std::move(content_rule));
+    }
+
+    rule->cache_sections = cJSON_IsTrue(cJSON_GetObjectItem(json, "cache_sections"));
+    rule->program = std::move(program);
+    return rule;
+}
+
+static void load_rules_from_json(std::string_view json_text, std::string_view origin, std::unordered_map<std::string, std::shared_ptr<const ScraperRule>>& rules)
+{
+    cJSON* json = cJSON_ParseWithLength(json_text.data(), json_text.length());
+    if((json == nullptr) || (json->type != cJSON_Object))
+    {
+        LOG_WARN("Failed to parse scraper rules from %s", std::string(origin).c_str());
+        cJSON_Delete(json);
+        return;
+    }
+
+    cJSON* rule_json = nullptr;
+    cJSON_ArrayForEach(rule_json, json)
+    {
+        try
+        {
+            rules[rule_json->string] = compile_rule(rule_json->string, rule_json);
+            LOG_INFO("Loaded scraper rule '%s' from %s", rule_json->string, std::string(origin).c_str());
+        }
+        catch(const std::exception& e)
+        {
+            LOG_WARN("Failed to load scraper rule '%s' from %s: %s", rule_json->string, std::string(origin).c_str(), e.what());
+        }
+    }
+    cJSON_Delete(json);
+}
+
+static std::unordered_map<std::string, std::shared_ptr<const ScraperRule>> load_all_rules()
+{
+    std::unordered_map<std::string, std::shared_ptr<const ScraperRule>> rules;
+    load_rules_from_json(g_default_rules, "built-in defaults", rules);
+
+    pfc::string8 override_path = core_api::get_profile_path();
+    override_path += "\\";
+    override_path += g_rules_override_filename;
+    try
+    {
+        abort_callback_dummy noAbort;
+        if(filesystem::g_exists(override_path.c_str(), noAbort))
+        {
+            pfc::string8 override_contents;
+            file_ptr override_file;
+            filesystem::g_open_read(override_file, override_path.c_str(), noAbort);
+            override_file->read_string_raw(override_contents, noAbort);
+            load_rules_from_json(std::string_view(override_contents.c_str(), override_contents.length()), override_path.c_str(), rules);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to read scraper rules from %s: %s", override_path.c_str(), e.what());
+    }
+
+    return rules;
+}
+
+std::shared_ptr<const ScraperRule> get_scraper_rule(std::string_view name)
+{
+    static std::mutex rules_lock;
+    static std::optional<std::unordered_map<std::string, std::shared_ptr<const ScraperRule>>> rules;
+
+    std::lock_guard<std::mutex> lock(rules_lock);
+    if(!rules.has_value())
+    {
+        rules = load_all_rules();
+    }
+
+    auto iter = rules->find(std::string(name));
+    if(iter == rules->end())
+    {
+        return nullptr;
+    }
+    return iter->second;
+}
+
+static std::string encode_for_url(std::string_view input, ScraperUrlEncoding encoding)
+{
+    std::string output;
+    output.reserve(input.length() + 3); // We add a bit to allow for one or two & or @ replacements without re-allocation
+    for(size_t i=0; i<input.length(); i++)
+    {
+        if(pfc::char_is_ascii_alphanumeric(input[i]))
+        {
+            output += static_cast<char>(std::tolower(static_cast<unsigned char>(input[i])));
+        }
+        else if(encoding == ScraperUrlEncoding::Hyphenated)
+        {
+            if((input[i] == ' ') || (input[i] == '-'))
+            {
+                output += '-';
+            }
+            else if(input[i] == '&')
+            {
+                output += "and";
+            }
+            else if(input[i] == '@')
+            {
+                output += "at";
+            }
+        }
+    }
+
+    return output;
+}
+
+std::string ScraperRule::format_url(const SearchContext& context) const
+{
+    std::string url;
+    url.reserve(url_template.length() + context.artist.length() + context.album.length() + context.title.length());
+
+    size_t pos = 0;
+    while(pos < url_template.length())
+    {
+        const size_t open_index = url_template.find('{', pos);
+        const size_t close_index = (open_index == std::string::npos) ? std::string::npos : url_template.find('}', open_index);
+        if(close_index == std::string::npos)
+        {
+            url.append(url_template, pos, std::string::npos);
+            break;
+        }
+
+        url.append(url_template, pos, open_index - pos);
+        const std::string_view placeholder = std::string_view(url_template).substr(open_index + 1, close_index - open_index - 1);
+        if(placeholder == "artist") url += encode_for_url(context.artist, url_encoding);
+        else if(placeholder == "album") url += encode_for_url(context.album, url_encoding);
+        else if(placeholder == "title") url += encode_for_url(context.title, url_encoding);
+        else url.append(url_template, open_index, close_index - open_index + 1);
+        pos = close_index + 1;
+    }
+    return url;
+}
+
+bool ScraperRule::url_uses_album() const
+{
+    return url_template.find("{album}") != std::string::npos;
+}
+
+std::string ScraperRule::scrape(std::string_view html, std::string_view url, std::string_view track_title) const
+{
+    const auto section_matches = [track_title](std::string_view section_title)
+    {
+        return tag_values_match(section_title, track_title);
+    };
+    std::optional<std::string> lyrics = scrape_lyrics(*program, html, url, section_matches);
+    if(!lyrics.has_value())
+    {
+        LOG_WARN("Failed to create HTML parser for %s", std::string(url).c_str());
+        return {};
+    }
+    return std::move(lyrics.value());
+}
+
+std::vector<ScrapedSection> ScraperRule::scrape_sections(std::string_view html, std::string_view url) const
+{
+    std::optional<std::vector<ScrapedSection>> sections = ::scrape_sections(*program, html, url);
+    if(!sections.has_value())
+    {
+        LOG_WARN("Failed to create HTML parser for %s", std::string(url).c_str());
+        return {};
+    }
+    return std::move(sections.value());
+}
+
+static ScrapedPageCache g_page_cache;
+
+static std::optional<std::string> download_page(std::string_view rule_name, const ScraperRule& rule, const std::string& url, abort_callback& abort)
+{
+    LOG_INFO("Querying for lyrics from %s...", url.c_str());
+    HttpRequest request = {"GET", url, rule.headers};
+    try
+    {
+        return get_http_transport().run(request, abort);
+    }
+    catch(const exception_io_not_found&)
+    {
+        // NOTE: Scraper rules guess the page URL from the track metadata, so a page that doesn't exist
+        //       just means that the site has no lyrics for this track.
+        LOG_INFO("No %s page exists at %s", std::string(rule_name).c_str(), url.c_str());
+        return {};
+    }
+    catch(const std::exception& e)
+    {
+        LOG_WARN("Failed to download %s page %s: %s", std::string(rule_name).c_str(), url.c_str(), e.what());
+        throw;
+    }
+}
+
+std::vector<LyricDataRaw> ScraperRuleSource::search(const SearchContext& context, abort_callback& abort)
+{
+    std::shared_ptr<const ScraperRule> rule = get_scraper_rule(rule_name());
+    if(rule == nullptr)
+    {
+        LOG_WARN("No valid scraper rule '%s' is available, skipping search", std::string(rule_name()).c_str());
+        return {};
+    }
+
+    const std::string url = rule->format_url(context);
+    std::string lyric_text;
+    if(rule->cache_sections)
+    {
+        std::shared_ptr<const ScrapedPageCache::Sections> sections = g_page_cache.get(url);
+        if(sections != nullptr)
+        {
+            LOG_INFO("Using cached copy of %s", url.c_str());
+        }
+        else
+        {
+            std::optional<std::string> content = download_page(rule_name(), *rule, url, abort);
+            if(!content.has_value())
+            {
+                return {};
+            }
+
+            sections = std::make_shared<const ScrapedPageCache::Sections>(rule->scrape_sections(content.value(), url));
+            if(sections->empty())
+            {
+                throw std::runtime_error("Failed to parse lyrics, the page format may have changed");
+            }
+            g_page_cache.put(url, sections);
+        }
+
+        for(const ScrapedSection& section : *sections)
+        {
+            if(tag_values_match(section.title, context.title))
+            {
+                lyric_text = section.text;
+                break;
+            }
+        }
+
+        if(lyric_text.empty())
+        {
+            LOG_INFO("Page %s does not contain lyrics for %s", url.c_str(), context.title.c_str());
+            return {};
+        }
+    }
+    else
+    {
+        std::optional<std::string> content = download_page(rule_name(), *rule, url, abort);
+        if(!content.has_value())
+        {
+            return {};
+        }
+
+        lyric_text = rule->scrape(content.value(), url, context.title);
+        if(lyric_text.empty())
+        {
+            throw std::runtime_error("Failed to parse lyrics, the page format may have changed");
+        }
+    }
+
+    LOG_INFO("Successfully retrieved lyrics from %s", url.c_str());
+
+    LyricDataRaw result = {};
+    result.source_id = id();
+    result.persistent_storage_path = url;
+    result.artist = context.artist;
+    if(rule->url_uses_album())
+    {
+        result.album = context.album;
+    }
+    result.title = context.title;
+    result.text = trim_surrounding_whitespace(lyric_text);
+    return {std::move(result)};
+}
+
+bool ScraperRuleSource::lookup(const SearchContext& /*context*/, LyricDataRaw& /*data*/, abort_callback& /*abort*/)
+{
+    LOG_ERROR("We should never need to do a lookup of the %s source", from_tstring(friendly_name()).c_str());
+    assert(false);
+    return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "stdafx.h"
+
+#include "lyric_source.h"
+#include "scraper_program.h"
+
+enum class ScraperUrlEncoding
+{
+    Alphanumeric, // Lower-case, with everything except ASCII letters & digits removed (e.g "AC/DC" -> "acdc")
+    Hyphenated,   // As above, but spaces become hyphens and '&' and '@' become "and" and "at"
+};
+
+// A declarative description of how to retrieve lyrics from a website.
+// Rules are read from the built-in defaults (which can be overridden per-source by a
+// openlyrics_scraper_rules.json file in the foobar2000 profile directory) and are compiled
+// once into a program that is executed by a streaming HTML scraper.
+class ScraperRule
+{
+public:
+    std::string name;
+    std::string url_template; // May contain the placeholders {artist}, {album} and {title}
+    ScraperUrlEncoding url_encoding;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::shared_ptr<const ScraperProgram> program;
+
+    // If set, every section of each page that is downloaded is kept, so that searches for other tracks
+    // whose lyrics are on the same page (e.g the rest of an album) do not need to download or parse it again.
+    bool cache_sections;
+
+    std::string format_url(const SearchContext& context) const;
+    bool url_uses_album() const;
+
+    // Returns the lyrics for the given track from the given page, or an empty string if none could be found
+    std::string scrape(std::string_view html, std::string_view url, std::string_view track_title) const;
+
+    // Returns every section on the page (for rules with "sections" content), with titles and text trimmed
+    std::vector<ScrapedSection> scrape_sections(std::string_view html, std::string_view url) const;
+};
+
+// Returns the compiled rule with the given name, or null if there is no valid rule with that name
+std::shared_ptr<const ScraperRule> get_scraper_rule(std::string_view name);
+
+// A lyric source that is entirely described by a scraper rule
+class ScraperRuleSource : public LyricSourceRemote
+{
+public:
+    std::vector<LyricDataRaw> search(const SearchContext& context, abort_callback& abort) override;
+    bool lookup(const SearchContext& context, LyricDataRaw& data, abort_callback& abort) override;
+
+protected:
+    virtual std::string_view rule_name() const = 0;
+};
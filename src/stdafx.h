@@ -1,8 +1,8 @@
-#pragma warning(push, 0)
-#include <foobar2000/helpers/foobar2000+atl.h>
-
-#include <algorithm>
-#include <numeric>
-#include <optional>
-#include <string_view>
+#pragma warning(push, 0)
+#include <foobar2000/helpers/foobar2000+atl.h>
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <string_view>
 #pragma warning(pop)
\ No newline at end of file
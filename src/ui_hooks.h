@@ -1,10 +1,12 @@
-#pragma once
-
-#include "lyric_io.h"
-#include "win32_util.h"
-
-void SpawnLyricEditor(const LyricData& lyrics, LyricUpdateHandle& update);
-void SpawnManualLyricSearch(LyricUpdateHandle& update);
-void SpawnBulkLyricSearch(std::vector<metadb_handle_ptr> tracks_to_search);
-
-void repaint_all_lyric_panels();
+#pragma once
+
+#include "lyric_io.h"
+#include "win32_util.h"
+
+void SpawnLyricEditor(const LyricData& lyrics, LyricUpdateHandle& update);
+void SpawnManualLyricSearch(LyricUpdateHandle& update);
+void SpawnBulkLyricSearch(std::vector<metadb_handle_ptr> tracks_to_search);
+void SpawnResumedBulkLyricSearch();
+
+void repaint_all_lyric_panels();
+void reload_all_lyric_panel_settings();
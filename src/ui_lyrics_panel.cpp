@@ -1,1322 +1,1871 @@
-#include "stdafx.h"
-
-#pragma warning(push, 0)
-#include <libPPUI/win32_op.h>
-#include <foobar2000/helpers/BumpableElem.h>
-#pragma warning(pop)
-
-#include "logging.h"
-#include "lyric_auto_edit.h"
-#include "lyric_data.h"
-#include "lyric_io.h"
-#include "math_util.h"
-#include "metadb_index_search_avoidance.h"
-#include "parsers.h"
-#include "preferences.h"
-#include "sources/lyric_source.h"
-#include "ui_hooks.h"
-#include "uie_shim_panel.h"
-#include "win32_util.h"
-
-namespace {
-    static const GUID GUID_LYRICS_PANEL = { 0x6e24d0be, 0xad68, 0x4bc9,{ 0xa0, 0x62, 0x2e, 0xc7, 0xb3, 0x53, 0xd5, 0xbd } };
-    static const UINT_PTR PANEL_UPDATE_TIMER = 2304692;
-
-    class LyricPanel;
-    static std::vector<LyricPanel*> g_active_panels;
-
-    class LyricPanel : public ui_element_instance, public CWindowImpl<LyricPanel>, private play_callback_impl_base
-    {
-    public:
-        // ATL window class declaration. Replace class name with your own when reusing code.
-        DECLARE_WND_CLASS_EX(TEXT("{32CB89E1-3EA5-4AE7-A6E6-2DEA68A04D53}"), CS_VREDRAW | CS_HREDRAW | CS_DBLCLKS, (-1))
-
-        LyricPanel(ui_element_config::ptr,ui_element_instance_callback_ptr p_callback);
-        HWND get_wnd() override;
-        void initialize_window(HWND parent);
-        void set_configuration(ui_element_config::ptr config) override;
-        ui_element_config::ptr get_configuration() override;
-
-        static GUID g_get_guid();
-        static GUID g_get_subclass();
-        static void g_get_name(pfc::string_base & out);
-        static ui_element_config::ptr g_get_default_configuration();
-        static const char * g_get_description();
-
-        void notify(const GUID& p_what, t_size p_param1, const void* p_param2, t_size p_param2size) override;
-
-        void on_playback_new_track(metadb_handle_ptr track) override;
-        void on_playback_stop(play_control::t_stop_reason reason) override;
-        void on_playback_pause(bool state) override;
-        void on_playback_seek(double time) override;
-
-    private:
-        BEGIN_MSG_MAP_EX(LyricPanel)
-            MSG_WM_CREATE(OnWindowCreate)
-            MSG_WM_DESTROY(OnWindowDestroy)
-            MSG_WM_SIZE(OnWindowResize)
-            MSG_WM_TIMER(OnTimer)
-            MSG_WM_ERASEBKGND(OnEraseBkgnd)
-            MSG_WM_PAINT(OnPaint)
-            MSG_WM_CONTEXTMENU(OnContextMenu)
-            MSG_WM_LBUTTONDBLCLK(OnDoubleClick)
-            MSG_WM_MOUSEWHEEL(OnMouseWheel)
-            MSG_WM_MOUSEMOVE(OnMouseMove)
-            MSG_WM_LBUTTONDOWN(OnLMBDown)
-            MSG_WM_LBUTTONUP(OnLMBUp)
-        END_MSG_MAP()
-
-        LRESULT OnWindowCreate(LPCREATESTRUCT);
-        void OnWindowDestroy();
-        void OnWindowResize(UINT request_type, CSize new_size);
-        LRESULT OnTimer(WPARAM);
-        void OnPaint(CDCHandle);
-        BOOL OnEraseBkgnd(CDCHandle);
-        void OnContextMenu(CWindow window, CPoint point);
-        void OnDoubleClick(UINT virtualKeys, CPoint cursorPos);
-        LRESULT OnMouseWheel(UINT virtualKeys, short rotation, CPoint point);
-        void OnMouseMove(UINT virtualKeys, CPoint point);
-        void OnLMBDown(UINT virtualKeys, CPoint point);
-        void OnLMBUp(UINT virtualKeys, CPoint point);
-
-        t_ui_font get_font();
-        t_ui_color get_fg_colour();
-        t_ui_color get_bg_colour();
-        t_ui_color get_highlight_colour();
-
-        void StartTimer();
-        void StopTimer();
-
-        void DrawNoLyrics(HDC dc, CRect client_area);
-        void DrawUntimedLyricsVertical(HDC dc, CRect client_area);
-        void DrawUntimedLyricsHorizontal(HDC dc, CRect client_area);
-        void DrawTimestampedLyricsVertical(HDC dc, CRect client_area);
-        void DrawTimestampedLyricsHorizontal(HDC dc, CRect client_area);
-
-        void InitiateLyricSearch(metadb_handle_ptr track);
-
-        ui_element_config::ptr m_config;
-
-        bool m_timerRunning;
-
-        metadb_handle_ptr m_now_playing;
-        std::vector<std::unique_ptr<LyricUpdateHandle>> m_update_handles;
-        LyricData m_lyrics;
-        bool m_auto_search_avoided;
-        uint64_t m_auto_search_avoided_timestamp;
-
-        HDC m_back_buffer;
-        HBITMAP m_back_buffer_bitmap;
-
-        std::optional<CPoint> m_manual_scroll_start;
-        int m_manual_scroll_distance;
-
-    protected:
-        // this must be declared as protected for ui_element_impl_withpopup<> to work.
-        const ui_element_instance_callback_ptr m_callback;
-    };
-
-    HWND LyricPanel::get_wnd() { return *this; }
-    void LyricPanel::initialize_window(HWND parent) { WIN32_OP(Create(parent) != NULL) }
-    void LyricPanel::set_configuration(ui_element_config::ptr config) { m_config = config; }
-    ui_element_config::ptr LyricPanel::get_configuration() { return m_config; }
-
-    GUID LyricPanel::g_get_guid() { return GUID_LYRICS_PANEL; }
-    GUID LyricPanel::g_get_subclass() { return ui_element_subclass_utility; }
-    ui_element_config::ptr LyricPanel::g_get_default_configuration() { return ui_element_config::g_create_empty(g_get_guid()); }
-    void LyricPanel::g_get_name(pfc::string_base & out) { out = "OpenLyrics Panel"; }
-    const char * LyricPanel::g_get_description() { return "Displays lyrics for the currently-playing track."; }
-
-    LyricPanel::LyricPanel(ui_element_config::ptr config, ui_element_instance_callback_ptr p_callback) :
-        m_config(config),
-        m_timerRunning(false),
-        m_now_playing(nullptr),
-        m_update_handles(),
-        m_lyrics(),
-        m_callback(p_callback),
-        m_auto_search_avoided(false),
-        m_auto_search_avoided_timestamp(0)
-    {
-    }
-
-    void LyricPanel::notify(const GUID& what, t_size /*param1*/, const void* /*param2*/, t_size /*param2size*/)
-    {
-        if ((what == ui_element_notify_colors_changed) || (what == ui_element_notify_font_changed))
-        {
-            // we use global colors and fonts - trigger a repaint whenever these change.
-            Invalidate();
-        }
-    }
-
-    void LyricPanel::on_playback_new_track(metadb_handle_ptr track)
-    {
-        m_now_playing = track;
-        m_manual_scroll_distance = 0;
-
-        // NOTE: We also track a generation counter that increments every time you change the search config
-        //       so that if you don't find lyrics with some active sources and then add more, it'll search
-        //       again at least once, possibly finding something if there are new active sources.
-        lyric_search_avoidance avoidance = load_search_avoidance(track);
-        const bool expected_to_fail = (avoidance.failed_searches > 3);
-        const bool trial_period_expired = ((avoidance.first_fail_time + system_time_periods::week) < filetimestamp_from_system_timer());
-        const bool same_generation = (avoidance.search_config_generation == preferences::searching::source_config_generation());
-        if(!same_generation || !expected_to_fail || !trial_period_expired)
-        {
-            InitiateLyricSearch(track);
-        }
-        else
-        {
-            LOG_INFO("Skipped search because it's expected to fail anyway and was not specifically requested");
-            m_lyrics = {};
-            m_auto_search_avoided = true;
-            m_auto_search_avoided_timestamp = filetimestamp_from_system_timer();
-        }
-
-        // NOTE: If playback is paused on startup then this gets called with the paused track,
-        //       but playback is paused so we don't actually want to run the timer
-        service_ptr_t<playback_control> playback = playback_control::get();
-        if(!playback->is_paused())
-        {
-            StartTimer();
-        }
-    }
-
-    void LyricPanel::on_playback_stop(play_control::t_stop_reason /*reason*/)
-    {
-        m_now_playing = nullptr;
-        m_lyrics = {};
-        m_auto_search_avoided = false;
-        StopTimer();
-        Invalidate(); // Draw one more time to clear the panel
-    }
-
-    void LyricPanel::on_playback_pause(bool state)
-    {
-        if (state)
-        {
-            StopTimer();
-        }
-        else
-        {
-            StartTimer();
-        }
-    }
-
-    void LyricPanel::on_playback_seek(double /*time*/)
-    {
-        Invalidate(); // Draw again to update the scroll for the new seek time
-    }
-
-    LRESULT LyricPanel::OnWindowCreate(LPCREATESTRUCT /*params*/)
-    {
-        service_ptr_t<playback_control> playback = playback_control::get();
-        metadb_handle_ptr track;
-        if(playback->get_now_playing(track))
-        {
-            on_playback_new_track(track);
-        }
-
-        g_active_panels.push_back(this);
-        return 0;
-    }
-
-    void LyricPanel::OnWindowDestroy()
-    {
-        if(m_back_buffer_bitmap != nullptr) DeleteObject(m_back_buffer_bitmap);
-        if(m_back_buffer != nullptr) DeleteDC(m_back_buffer);
-
-        // Cancel and clean up any pending updates
-        m_update_handles.clear();
-
-        auto panel_iter = std::find(g_active_panels.begin(), g_active_panels.end(), this);
-        assert(panel_iter != g_active_panels.end());
-        if(panel_iter != g_active_panels.end())
-        {
-            g_active_panels.erase(panel_iter);
-        }
-    }
-
-    void LyricPanel::OnWindowResize(UINT /*request_type*/, CSize new_size)
-    {
-        if(m_back_buffer != nullptr) DeleteDC(m_back_buffer);
-        if(m_back_buffer_bitmap != nullptr) DeleteObject(m_back_buffer_bitmap);
-
-        CRect client_rect;
-        WIN32_OP_D(GetClientRect(&client_rect))
-
-        HDC front_buffer = GetDC();
-        m_back_buffer = CreateCompatibleDC(front_buffer);
-        m_back_buffer_bitmap = CreateCompatibleBitmap(front_buffer, new_size.cx, new_size.cy);
-        SelectObject(m_back_buffer, m_back_buffer_bitmap);
-        ReleaseDC(front_buffer);
-
-        SetBkMode(m_back_buffer, TRANSPARENT);
-        UINT align_result = SetTextAlign(m_back_buffer, TA_BASELINE | TA_CENTER);
-        if(align_result == GDI_ERROR)
-        {
-            LOG_WARN("Failed to set text alignment: %d", GetLastError());
-        }
-    }
-
-    LRESULT LyricPanel::OnTimer(WPARAM /*wParam*/)
-    {
-        Invalidate();
-        return 0;
-    }
-
-    BOOL LyricPanel::OnEraseBkgnd(CDCHandle /*dc*/)
-    {
-        // NOTE: It isn't strictly required to implement this behaviour, but it's an optimisation.
-        //       By default (if we return FALSE here or don't overload this at all), the window
-        //       will be erased (filled with the background colour) when invalidated (to prepare
-        //       for drawing). However we draw the correct background during our paint anyway
-        //       so there is no need for the system (or us) to do it again here.
-        return TRUE;
-    }
-
-    int _WrapLyricsLineToRect(HDC dc, CRect clip_rect, std::tstring_view line, const CPoint* origin)
-    {
-        TEXTMETRIC font_metrics = {};
-        WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
-        int line_height = font_metrics.tmHeight + preferences::display::linegap();
-
-        if(line.length() == 0)
-        {
-            return line_height;
-        }
-
-        int visible_width = clip_rect.Width();
-
-        // This serves as an upper bound on the number of chars we draw on a single line.
-        // Used to prevent GDI from having to compute the size of very long strings.
-        size_t generous_max_chars = 256;
-        if(font_metrics.tmAveCharWidth > 0)
-        {
-            assert(visible_width >= 0);
-            size_t avg_chars_that_fit = ((size_t)visible_width/(size_t)font_metrics.tmAveCharWidth) + 1;
-            generous_max_chars = 3*avg_chars_that_fit;
-        }
-
-        std::tstring_view text_outstanding = line;
-        int total_height = 0;
-        while(text_outstanding.length() > 0)
-        {
-            size_t leading_spaces = text_outstanding.find_first_not_of(_T(' '));
-            text_outstanding.remove_prefix(min(leading_spaces, text_outstanding.size()));
-
-            size_t last_not_space = text_outstanding.find_last_not_of(_T(' '));
-            if(last_not_space != std::tstring_view::npos)
-            {
-                size_t trailing_spaces = text_outstanding.length() - 1 - last_not_space;
-                text_outstanding.remove_suffix(trailing_spaces);
-            }
-
-            size_t next_line_start_index = text_outstanding.length();
-            size_t chars_to_draw = min(text_outstanding.length(), generous_max_chars);
-            while(true)
-            {
-                SIZE line_size;
-                BOOL extent_success = GetTextExtentPoint32(dc,
-                                                           text_outstanding.data(),
-                                                           chars_to_draw,
-                                                           &line_size);
-                if(!extent_success)
-                {
-                    LOG_WARN("Failed to compute lyric line extents");
-                    return 0;
-                }
-
-                if((chars_to_draw == 0) || (line_size.cx <= visible_width))
-                {
-                    break;
-                }
-                else
-                {
-                    assert(chars_to_draw > 0);
-                    size_t previous_space_index = text_outstanding.rfind(' ', chars_to_draw-1);
-                    if(previous_space_index == std::tstring::npos)
-                    {
-                        // There is a single word that doesn't fit on the line
-                        // This should be rare so just draw it rather than trying to split words.
-                        break;
-                    }
-                    else
-                    {
-                        next_line_start_index = previous_space_index;
-                        chars_to_draw = previous_space_index;
-                    }
-                }
-            }
-
-            bool draw_requested = (origin != nullptr);
-            if(draw_requested)
-            {
-                int draw_y = origin->y + total_height;
-                bool clipped = (draw_y + font_metrics.tmDescent < clip_rect.top) || (draw_y - font_metrics.tmAscent > clip_rect.bottom);
-                if(!clipped)
-                {
-                    BOOL draw_success = TextOut(dc, origin->x, draw_y, text_outstanding.data(), chars_to_draw);
-                    if(!draw_success)
-                    {
-                        LOG_WARN("Failed to draw lyrics text: %d", GetLastError());
-                        return 0;
-                    }
-                }
-            }
-
-            total_height += line_height;
-            text_outstanding = text_outstanding.substr(next_line_start_index);
-        }
-
-        return total_height;
-    }
-
-    int ComputeWrappedLyricLineHeight(HDC dc, CRect clip_rect, const std::tstring& line)
-    {
-        return _WrapLyricsLineToRect(dc, clip_rect, line, nullptr);
-    }
-
-    int DrawWrappedLyricLine(HDC dc, CRect clip_rect, const std::tstring_view line, CPoint origin)
-    {
-        return _WrapLyricsLineToRect(dc, clip_rect, line, &origin);
-    }
-
-    void LyricPanel::DrawNoLyrics(HDC dc, CRect client_rect)
-    {
-        if(m_now_playing == nullptr)
-        {
-            return;
-        }
-
-        // TODO: If we make this text configurable in future and we want to also show some text
-        //       telling you that it didn't search because nothing was found, look into:
-        //       metadb.h (in foo_SDK) -> metadb_display_field_provider
-        //       which exists to let you hook into the title format process and add new fields.
-
-        std::string artist = track_metadata(m_now_playing, "artist");
-        std::string album = track_metadata(m_now_playing, "album");
-        std::string title = track_metadata(m_now_playing, "title");
-
-        int total_height = 0;
-        std::tstring artist_line;
-        std::tstring album_line;
-        std::tstring title_line;
-        if(!artist.empty())
-        {
-            artist_line = _T("Artist: ") + to_tstring(artist);
-            total_height += ComputeWrappedLyricLineHeight(dc, client_rect, artist_line);
-        }
-        if(!album.empty())
-        {
-            album_line = _T("Album: ") + to_tstring(album);
-            total_height += ComputeWrappedLyricLineHeight(dc, client_rect, album_line);
-        }
-        if(!title.empty())
-        {
-            title_line = _T("Title: ") + to_tstring(title);
-            total_height += ComputeWrappedLyricLineHeight(dc, client_rect, title_line);
-        }
-
-        // NOTE: Since our calculation is for the *top* of the rendered text, we need to
-        //       shift down by the font's ascent so that we get to the baseline (which
-        //       is what is used as the rendering origin).
-        TEXTMETRIC font_metrics = {};
-        WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
-
-        CPoint centre = client_rect.CenterPoint();
-        int top_y = centre.y - total_height/2 + font_metrics.tmAscent;
-        CPoint origin = {centre.x, top_y};
-        if(!artist_line.empty())
-        {
-            origin.y += DrawWrappedLyricLine(dc, client_rect, artist_line, origin);
-        }
-        if(!album_line.empty())
-        {
-            origin.y += DrawWrappedLyricLine(dc, client_rect, album_line, origin);
-        }
-        if(!title_line.empty())
-        {
-            origin.y += DrawWrappedLyricLine(dc, client_rect, title_line, origin);
-        }
-
-        if(!m_update_handles.empty())
-        {
-            bool is_search = false;
-            std::string progress_msg;
-            for(std::unique_ptr<LyricUpdateHandle>& update : m_update_handles)
-            {
-                if((update != nullptr) &&
-                    (update->get_type() == LyricUpdateHandle::Type::AutoSearch) &&
-                    (update->get_track() == m_now_playing))
-                {
-                    progress_msg = update->get_progress();
-                    is_search = true;
-                    break;
-                }
-            }
-
-            if(is_search)
-            {
-                std::tstring progress_text = to_tstring(progress_msg);
-                origin.y += DrawWrappedLyricLine(dc, client_rect, progress_text, origin);
-            }
-        }
-
-        if(m_auto_search_avoided)
-        {
-            const double search_avoided_msg_seconds = 15.0;
-            uint64_t search_avoided_msg_ticks = static_cast<uint64_t>(search_avoided_msg_seconds * 10'000'000); // A "tick" here means "100-nanoseconds"
-            uint64_t ticks_since_search_avoided = filetimestamp_from_system_timer() - m_auto_search_avoided_timestamp;
-            if(ticks_since_search_avoided < search_avoided_msg_ticks)
-            {
-                origin.y += DrawWrappedLyricLine(dc, client_rect, _T(""), origin);
-                origin.y += DrawWrappedLyricLine(dc, client_rect, _T("Auto-search skipped because it failed too many times."), origin);
-                origin.y += DrawWrappedLyricLine(dc, client_rect, _T("Manually request a lyrics search to try again."), origin);
-            }
-        }
-    }
-
-    void LyricPanel::DrawUntimedLyricsVertical(HDC dc, CRect client_area)
-    {
-        service_ptr_t<playback_control> playback = playback_control::get();
-        double current_position = playback->playback_get_position();
-        double total_length = playback->playback_get_length_ex();
-        double track_fraction = current_position / total_length;
-
-        int total_height = std::accumulate(m_lyrics.lines.begin(), m_lyrics.lines.end(), 0,
-                                           [dc, client_area](int x, const LyricDataLine& line)
-                                           {
-                                               return x + ComputeWrappedLyricLineHeight(dc, client_area, line.text);
-                                           });
-
-        CPoint centre = client_area.CenterPoint();
-        int top_y = 0;
-        if(preferences::display::scroll_type() == LineScrollType::Manual)
-        {
-            // Shift the 'top' Y down by a single line so we can see the first line of text,
-            // because the 'top y' is actually used as the *baseline*
-            int one_line_height = ComputeWrappedLyricLineHeight(dc, client_area, _T(""));
-
-            int default_top_y = one_line_height;
-            if(total_height < client_area.Height())
-            {
-                int centre_y = client_area.Height()/2;
-                default_top_y = centre_y + one_line_height - total_height/2;
-            }
-
-            // We want:
-            // 1) bottom_y >= one_line_height
-            //    top_y + total_height >= one_line_height
-            //    top_y >= one_line_height - total_height
-            //    default_top_y - one_line_height + m_manual_scroll_distance >= one_line_height - total_height
-            //    m_manual_scroll_distance >= one_line_height - total_height - default_top_y + one_line_height
-            // 2) top_y <= panel_height
-            //    default_top_y + m_manual_scroll_distance <= panel_height
-            //    m_manual_scroll_distance <= panel_height - default_top_y
-            // So:
-            //    (one_line_height - total_height - default_top_y + one_line_height) <= m_manual_scroll_distance <= (panel_height - default_top_y)
-            int min_scroll = one_line_height - total_height - default_top_y + one_line_height;
-            int max_scroll = client_area.Height() - default_top_y;
-            if(m_manual_scroll_distance < min_scroll) m_manual_scroll_distance = min_scroll;
-            if(m_manual_scroll_distance > max_scroll) m_manual_scroll_distance = max_scroll;
-
-            top_y = default_top_y + m_manual_scroll_distance;
-        }
-        else
-        {
-            // NOTE: Since our calculation is for the *top* of the rendered text, we need to
-            //       shift down by the font's ascent so that we get to the baseline (which
-            //       is what is used as the rendering origin).
-            TEXTMETRIC font_metrics = {};
-            WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
-
-            top_y = centre.y - (int)(track_fraction * total_height) + font_metrics.tmAscent;
-        }
-
-        CPoint origin = {centre.x, top_y};
-        for(const LyricDataLine& line : m_lyrics.lines)
-        {
-            int wrapped_line_height = DrawWrappedLyricLine(dc, client_area, line.text, origin);
-            if(wrapped_line_height <= 0)
-            {
-                LOG_WARN("Failed to draw unsynced text: %d", GetLastError());
-                StopTimer();
-                break;
-            }
-            origin.y += wrapped_line_height;
-        }
-    }
-
-    void LyricPanel::DrawUntimedLyricsHorizontal(HDC dc, CRect client_area)
-    {
-        if(m_lyrics.lines.empty()) return;
-        assert(m_lyrics.lines.size() > 0);
-
-        size_t linegap = static_cast<size_t>(max(0, preferences::display::linegap()));
-        std::tstring glue(linegap, _T(' '));
-
-        assert(preferences::display::scroll_direction() == LineScrollDirection::Horizontal);
-        service_ptr_t<playback_control> playback = playback_control::get();
-        double current_position = playback->playback_get_position();
-        double total_length = playback->playback_get_length_ex();
-        double track_fraction = current_position / total_length;
-
-        std::tstring joined = m_lyrics.lines[0].text;
-        joined = std::accumulate(++m_lyrics.lines.begin(), m_lyrics.lines.end(), joined,
-                                 [&glue](const std::tstring& accum, const LyricDataLine& line)
-                                 {
-                                    return accum + glue + line.text;
-                                 });
-
-        SIZE line_size;
-        BOOL extent_success = GetTextExtentPoint32(dc,
-                                                   joined.c_str(),
-                                                   joined.length(),
-                                                   &line_size);
-        if(!extent_success)
-        {
-            LOG_ERROR("Failed to compute unsynced text width");
-            StopTimer();
-            return;
-        }
-
-        // NOTE: The drawing call uses the glyph baseline as the origin.
-        //       We want our text to be perfectly vertically centered, so we need to offset it
-        //       but the difference between the baseline and the vertical centre of the font.
-        TEXTMETRIC font_metrics = {};
-        WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
-        int baseline_centre_correction = (font_metrics.tmAscent + font_metrics.tmDescent)/2;
-
-        CPoint centre = client_area.CenterPoint();
-        CPoint origin = centre;
-        if(preferences::display::scroll_type() == LineScrollType::Manual)
-        {
-            int half_width = client_area.Width()/2;
-            if(m_manual_scroll_distance > half_width)
-            {
-                m_manual_scroll_distance = half_width;
-            }
-            if(m_manual_scroll_distance < -line_size.cx + half_width)
-            {
-                m_manual_scroll_distance = -line_size.cx + half_width;
-            }
-            origin.x += (line_size.cx - client_area.Width())/2 + m_manual_scroll_distance;
-        }
-        else
-        {
-            origin.x += (int)((0.5 - track_fraction) * (double)line_size.cx);
-        }
-        origin.y += baseline_centre_correction;
-
-        BOOL draw_success = DrawTextOut(dc, origin.x, origin.y, joined);
-        if(!draw_success)
-        {
-            LOG_ERROR("Failed to draw unsynced text");
-            StopTimer();
-        }
-    }
-
-
-    void LyricPanel::DrawTimestampedLyricsVertical(HDC dc, CRect client_area)
-    {
-        // NOTE: The drawing call uses the glyph baseline as the origin.
-        //       We want our text to be perfectly vertically centered, so we need to offset it
-        //       but the difference between the baseline and the vertical centre of the font.
-        TEXTMETRIC font_metrics = {};
-        WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
-        int baseline_centre_correction = (font_metrics.tmAscent + font_metrics.tmDescent)/2;
-
-        t_ui_color fg_colour = get_fg_colour();
-        t_ui_color hl_colour = get_highlight_colour();
-
-        service_ptr_t<playback_control> playback = playback_control::get();
-        double current_time = playback->playback_get_position();
-
-        int active_line_height = 0;
-        int text_height_above_active_line = 0;
-        int active_line_index = -1;
-        int lyric_line_count = static_cast<int>(m_lyrics.lines.size());
-        while((active_line_index+1 < lyric_line_count) && (current_time > m_lyrics.LineTimestamp(active_line_index+1)))
-        {
-            active_line_index++;
-            text_height_above_active_line += active_line_height;
-            active_line_height = ComputeWrappedLyricLineHeight(dc, client_area, m_lyrics.lines[active_line_index].text);
-        }
-
-        double next_line_time = m_lyrics.LineTimestamp(active_line_index+1);
-        double scroll_time = preferences::display::scroll_time_seconds();
-        double next_line_scroll_factor = lerp_inverse_clamped(next_line_time - scroll_time, next_line_time, current_time);
-
-        CPoint centre = client_area.CenterPoint();
-        int next_line_scroll = (int)((double)active_line_height * next_line_scroll_factor);
-        int top_y = (int)((double)centre.y - text_height_above_active_line - next_line_scroll + baseline_centre_correction);
-        CPoint origin = {centre.x, top_y};
-        for(int line_index=0; line_index < lyric_line_count; line_index++)
-        {
-            const LyricDataLine& line = m_lyrics.lines[line_index];
-            if(line_index == active_line_index)
-            {
-                COLORREF colour = lerp(hl_colour, fg_colour, next_line_scroll_factor);
-                SetTextColor(dc, colour);
-            }
-            else if(line_index == active_line_index+1)
-            {
-                COLORREF colour = lerp(fg_colour, hl_colour, next_line_scroll_factor);
-                SetTextColor(dc, colour);
-            }
-            else
-            {
-                SetTextColor(dc, fg_colour);
-            }
-
-            int wrapped_line_height = DrawWrappedLyricLine(dc, client_area, line.text, origin);
-            if(wrapped_line_height == 0)
-            {
-                LOG_ERROR("Failed to draw synced text");
-                StopTimer();
-                break;
-            }
-
-            origin.y += wrapped_line_height;
-        }
-    }
-
-    void LyricPanel::DrawTimestampedLyricsHorizontal(HDC dc, CRect client_area)
-    {
-        // NOTE: The drawing call uses the glyph baseline as the origin.
-        //       We want our text to be perfectly vertically centered, so we need to offset it
-        //       but the difference between the baseline and the vertical centre of the font.
-        TEXTMETRIC font_metrics = {};
-        WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
-        int baseline_centre_correction = (font_metrics.tmAscent + font_metrics.tmDescent)/2;
-
-        service_ptr_t<playback_control> playback = playback_control::get();
-        double current_time = playback->playback_get_position();
-
-        size_t linegap = static_cast<size_t>(max(0, preferences::display::linegap()));
-        std::tstring glue(linegap, _T(' '));
-        t_ui_color fg_colour = get_fg_colour();
-        t_ui_color hl_colour = get_highlight_colour();
-
-        int active_line_index = -1;
-        int lyric_line_count = static_cast<int>(m_lyrics.lines.size());
-        while((active_line_index+1 < lyric_line_count) && (current_time > m_lyrics.LineTimestamp(active_line_index+1)))
-        {
-            active_line_index++;
-        }
-        size_t next_line_index = static_cast<size_t>(active_line_index + 1);
-
-        bool has_active_text = (active_line_index >= 0);
-        bool has_preactive_text = (active_line_index > 0);
-        bool has_postactive_text = (active_line_index < static_cast<int>(m_lyrics.lines.size() - 1));
-        std::tstring active_line_text;
-        std::tstring next_line_text;
-        std::tstring pre_active_line_text;
-        std::tstring post_active_line_text;
-        if(has_active_text)
-        {
-            active_line_text = m_lyrics.lines[active_line_index].text;
-        }
-        if(has_preactive_text)
-        {
-            auto start = m_lyrics.lines.begin();
-            auto end = m_lyrics.lines.begin();
-            std::advance(end, active_line_index);
-
-            pre_active_line_text = std::accumulate(++start, end, m_lyrics.lines[0].text,
-                                                   [&glue](const std::tstring& accum, const LyricDataLine& line)
-                                                   {
-                                                      return accum + glue + line.text;
-                                                   });
-
-            if(has_active_text)
-            {
-                pre_active_line_text += glue;
-            }
-        }
-
-        if(has_postactive_text)
-        {
-            next_line_text = glue + m_lyrics.lines[next_line_index].text;
-
-            auto end = m_lyrics.lines.end();
-            auto start = m_lyrics.lines.begin();
-            std::advance(start, next_line_index + 1);
-
-            if(start != end)
-            {
-                std::tstring initial_value = glue + start->text;
-                post_active_line_text = std::accumulate(++start, end, initial_value,
-                                                        [&glue](const std::tstring& accum, const LyricDataLine& line)
-                                                        {
-                                                           return accum + glue + line.text;
-                                                        });
-            }
-        }
-
-        std::optional<SIZE> active_line_extents = GetTextExtents(dc, active_line_text);
-        std::optional<SIZE> next_line_extents = GetTextExtents(dc, next_line_text);
-        std::optional<SIZE> pre_active_extents = GetTextExtents(dc, pre_active_line_text);
-        std::optional<SIZE> post_active_extents = GetTextExtents(dc, post_active_line_text);
-        std::optional<SIZE> glue_extents = GetTextExtents(dc, glue);
-        if(!active_line_extents.has_value() ||
-                !next_line_extents.has_value() ||
-                !pre_active_extents.has_value() ||
-                !post_active_extents.has_value() ||
-                !glue_extents.has_value())
-        {
-            LOG_ERROR("Failed to compute synced text width");
-            StopTimer();
-            return;
-        }
-        int active_line_width = active_line_extents.value().cx;
-        int next_line_width = next_line_extents.value().cx;
-        int pre_active_width = pre_active_extents.value().cx;
-        int post_active_width = post_active_extents.value().cx;
-        int glue_width = glue_extents.value().cx;
-
-        double next_line_time = m_lyrics.LineTimestamp(next_line_index);
-        double scroll_time = preferences::display::scroll_time_seconds();
-        double next_line_scroll_factor = lerp_inverse_clamped(next_line_time - scroll_time, next_line_time, current_time);
-
-        // NOTE: We want to scroll by half of the active line and half of the next line because
-        //       the rendering origin is at the centre of the text. However the "next line"
-        //       already contains the glue string for rendering, so when we half that, we need
-        //       to add in an extra half of the glue string width.
-        int total_scroll_to_next_line = active_line_width + glue_width;
-        int next_line_scroll = (int)((double)total_scroll_to_next_line * next_line_scroll_factor);
-
-        CPoint centre = client_area.CenterPoint();
-        int centre_y = centre.y + baseline_centre_correction;
-        double active_x_alignment_factor = 0.15;
-        int active_left_x = client_area.left + (int)((double)client_area.Width() * active_x_alignment_factor);
-        int left_x = active_left_x - pre_active_width - next_line_scroll;
-        BOOL draw_success = TRUE;
-
-        SetTextColor(dc, fg_colour);
-        draw_success &= DrawTextOut(dc, left_x + pre_active_width/2, centre_y, pre_active_line_text);
-        left_x += pre_active_width;
-
-        COLORREF active_line_colour = lerp(hl_colour, fg_colour, next_line_scroll_factor);
-        SetTextColor(dc, active_line_colour);
-        draw_success &= DrawTextOut(dc, left_x + active_line_width/2, centre_y, active_line_text);
-        left_x += active_line_width;
-
-        COLORREF next_line_colour = lerp(fg_colour, hl_colour, next_line_scroll_factor);
-        SetTextColor(dc, next_line_colour);
-        draw_success &= DrawTextOut(dc, left_x + next_line_width/2, centre_y, next_line_text);
-        left_x += next_line_width;
-
-        SetTextColor(dc, fg_colour);
-        draw_success &= DrawTextOut(dc, left_x + post_active_width/2, centre_y, post_active_line_text);
-
-        if(!draw_success)
-        {
-            LOG_ERROR("Failed to draw horizontally-scrolling synced text");
-            StopTimer();
-        }
-    }
-
-    void LyricPanel::OnPaint(CDCHandle)
-    {
-        for(auto iter=m_update_handles.begin(); iter!=m_update_handles.end(); /*omitted*/)
-        {
-            std::unique_ptr<LyricUpdateHandle>& update = *iter;
-            if(update->has_result())
-            {
-                std::optional<LyricData> maybe_lyrics = io::process_available_lyric_update(*update);
-
-                if((maybe_lyrics.has_value()) && (update->get_track() == m_now_playing))
-                {
-                    m_lyrics = std::move(maybe_lyrics.value());
-                    m_auto_search_avoided = false;
-                }
-            }
-
-            if(update->is_complete())
-            {
-                iter = m_update_handles.erase(iter);
-            }
-            else
-            {
-                ++iter;
-            }
-        }
-
-        // As suggested in this article: https://docs.microsoft.com/en-us/previous-versions/ms969905(v=msdn.10)
-        // We get flickering if we draw everything to the UI directly, so instead we render everything to a back buffer
-        // and then blit the whole thing to the screen at the end.
-        PAINTSTRUCT paintstruct;
-        HDC front_buffer = BeginPaint(&paintstruct);
-
-        CRect client_rect;
-        WIN32_OP_D(GetClientRect(&client_rect))
-
-        HBRUSH bg_brush = CreateSolidBrush(get_bg_colour());
-        FillRect(m_back_buffer, &client_rect, bg_brush);
-        DeleteObject(bg_brush);
-
-        SelectObject(m_back_buffer, get_font());
-        COLORREF color_result = SetTextColor(m_back_buffer, get_fg_colour());
-        if(color_result == CLR_INVALID)
-        {
-            LOG_WARN("Failed to set text colour: %d", GetLastError());
-        }
-
-        if(m_lyrics.IsEmpty())
-        {
-            DrawNoLyrics(m_back_buffer, client_rect);
-        }
-        else if(m_lyrics.IsTimestamped() &&
-                (preferences::display::scroll_type() == LineScrollType::Automatic))
-        {
-            LineScrollDirection dir = preferences::display::scroll_direction();
-            switch(dir)
-            {
-                case LineScrollDirection::Vertical: DrawTimestampedLyricsVertical(m_back_buffer, client_rect); break;
-                case LineScrollDirection::Horizontal: DrawTimestampedLyricsHorizontal(m_back_buffer, client_rect); break;
-                default:
-                    LOG_ERROR("Unsupported scroll direction: %d", (int)dir);
-                    uBugCheck();
-            }
-        }
-        else // We have lyrics, but no timestamps
-        {
-            LineScrollDirection dir = preferences::display::scroll_direction();
-            switch(dir)
-            {
-                case LineScrollDirection::Vertical: DrawUntimedLyricsVertical(m_back_buffer, client_rect); break;
-                case LineScrollDirection::Horizontal: DrawUntimedLyricsHorizontal(m_back_buffer, client_rect); break;
-                default:
-                    LOG_ERROR("Unsupported scroll direction: %d", (int)dir);
-                    uBugCheck();
-            }
-        }
-
-        BitBlt(front_buffer, client_rect.left, client_rect.top,
-                client_rect.Width(), client_rect.Height(),
-                m_back_buffer, 0, 0,
-                SRCCOPY);
-        EndPaint(&paintstruct);
-    }
-
-    void LyricPanel::OnContextMenu(CWindow window, CPoint point)
-    {
-        if(m_callback->is_edit_mode_enabled())
-        {
-            // NOTE: When edit-mode is enabled then we want the default behaviour for allowing users
-            //       to change this panel, so we mark the message as unhandled and let foobar's default
-            //       handling take care of it for us.
-            SetMsgHandled(FALSE);
-            return;
-        }
-
-        // handle the context menu key case - center the menu
-        if (point == CPoint(-1, -1))
-        {
-            CRect rc;
-            WIN32_OP(window.GetWindowRect(&rc))
-            point = rc.CenterPoint();
-        }
-
-        try
-        {
-            UINT disabled_without_nowplaying = (m_now_playing == nullptr) ? MF_GRAYED : 0;
-            UINT disabled_without_lyrics = m_lyrics.IsEmpty() ? MF_GRAYED : 0;
-            UINT disabled_with_lyrics = m_lyrics.IsEmpty() ? 0 : MF_GRAYED;
-            enum {
-                ID_SEARCH_LYRICS = 1,
-                ID_SEARCH_LYRICS_MANUAL,
-                ID_SAVE_LYRICS,
-                ID_PREFERENCES,
-                ID_EDIT_LYRICS,
-                ID_OPEN_FILE_DIR,
-                ID_AUTO_ADD_INSTRUMENTAL,
-                ID_AUTO_REMOVE_EXTRA_SPACES,
-                ID_AUTO_REMOVE_EXTRA_BLANK_LINES,
-                ID_AUTO_REMOVE_ALL_BLANK_LINES,
-                ID_AUTO_REPLACE_XML_CHARS,
-                ID_AUTO_RESET_CAPITALISATION,
-                ID_FIX_MALFORMED_TIMESTAMPS,
-                ID_CMD_COUNT,
-            };
-
-            CMenu menu_edit = nullptr;
-            WIN32_OP(menu_edit.CreatePopupMenu())
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_with_lyrics, ID_AUTO_ADD_INSTRUMENTAL, _T("Mark as 'instrumental'"));
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REPLACE_XML_CHARS, _T("Replace &&-named HTML characters"));
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REMOVE_EXTRA_SPACES, _T("Remove repeated spaces"));
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REMOVE_EXTRA_BLANK_LINES, _T("Remove repeated blank lines"));
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REMOVE_ALL_BLANK_LINES, _T("Remove all blank lines"));
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_RESET_CAPITALISATION, _T("Reset capitalisation"));
-            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_FIX_MALFORMED_TIMESTAMPS, _T("Fix malformed timestamps"));
-
-            CMenu menu = nullptr;
-            WIN32_OP(menu.CreatePopupMenu())
-            AppendMenu(menu, MF_STRING | disabled_without_nowplaying, ID_SEARCH_LYRICS, _T("Search for lyrics"));
-            AppendMenu(menu, MF_STRING | disabled_without_nowplaying, ID_SEARCH_LYRICS_MANUAL, _T("Search for lyrics (manually)"));
-            AppendMenu(menu, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_SAVE_LYRICS, _T("Save lyrics"));
-            AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
-            AppendMenu(menu, MF_STRING | disabled_without_nowplaying, ID_EDIT_LYRICS, _T("Edit lyrics"));
-            AppendMenu(menu, MF_STRING | MF_POPUP, (UINT_PTR)menu_edit.m_hMenu, _T("Auto-edit lyrics"));
-            AppendMenu(menu, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_OPEN_FILE_DIR, _T("Open file location"));
-            AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
-            AppendMenu(menu, MF_STRING, ID_PREFERENCES, _T("Preferences"));
-            // TODO: Delete lyrics (delete the currently-loaded file, maybe search again). Maybe this button actually belongs in the lyric editor window?
-
-            CMenuDescriptionHybrid menudesc(get_wnd());
-            menudesc.Set(ID_SEARCH_LYRICS, "Start a completely new search for lyrics");
-            menudesc.Set(ID_SEARCH_LYRICS_MANUAL, "Start a new search for lyrics with customisable search terms and multiple results");
-            menudesc.Set(ID_SAVE_LYRICS, "Save the current lyrics, even if they would not be auto-saved");
-            menudesc.Set(ID_PREFERENCES, "Open the OpenLyrics preferences page");
-            menudesc.Set(ID_EDIT_LYRICS, "Open the lyric editor with the current lyrics");
-            menudesc.Set(ID_OPEN_FILE_DIR, "Open explorer to the location of the lyrics file");
-            menudesc.Set(ID_AUTO_ADD_INSTRUMENTAL, "Add lyrics containing just the text '[Instrumental]'");
-            menudesc.Set(ID_AUTO_REPLACE_XML_CHARS, "Replace &-encoded named HTML characters (e.g &lt;) with the characters they represent (e.g <)");
-            menudesc.Set(ID_AUTO_REMOVE_EXTRA_SPACES, "Replace sequences of multiple whitespace characters with a single space");
-            menudesc.Set(ID_AUTO_REMOVE_EXTRA_BLANK_LINES, "Replace sequences of multiple empty lines with just a single empty line");
-            menudesc.Set(ID_AUTO_REMOVE_ALL_BLANK_LINES, "Remove all empty lines");
-            menudesc.Set(ID_AUTO_RESET_CAPITALISATION, "Reset capitalisation of each line so that only the first character is upper case");
-            menudesc.Set(ID_FIX_MALFORMED_TIMESTAMPS, "Fix timestamps that are slightly malformed so that they're recognised as timestamps and not shown in the text");
-
-            std::optional<LyricData> updated_lyrics;
-            int cmd = menu.TrackPopupMenu(TPM_RIGHTBUTTON | TPM_NONOTIFY | TPM_RETURNCMD, point.x, point.y, menudesc, nullptr);
-            switch(cmd)
-            {
-                case ID_SEARCH_LYRICS:
-                {
-                    if(m_now_playing != nullptr)
-                    {
-                        InitiateLyricSearch(m_now_playing);
-                    }
-                } break;
-
-                case ID_SEARCH_LYRICS_MANUAL:
-                {
-                    if(m_now_playing != nullptr)
-                    {
-                        LOG_INFO("Initiate manual lyric search");
-                        auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::ManualSearch, m_now_playing, fb2k::noAbort);
-                        SpawnManualLyricSearch(*update);
-                        m_update_handles.push_back(std::move(update));
-                    }
-                } break;
-
-                case ID_SAVE_LYRICS:
-                {
-                    if((m_now_playing == nullptr) || m_lyrics.IsEmpty())
-                    {
-                        LOG_INFO("Attempt to manually save empty lyrics, ignoring...");
-                    }
-                    else
-                    {
-                        try
-                        {
-                            bool allow_overwrite = true;
-                            m_lyrics.persistent_storage_path = io::save_lyrics(m_now_playing, m_lyrics, allow_overwrite, fb2k::noAbort);
-                        }
-                        catch(const std::exception& e)
-                        {
-                            LOG_ERROR("Failed to complete manually requested lyric save: %s", e.what());
-                        }
-                    }
-                } break;
-
-                case ID_PREFERENCES:
-                {
-                    ui_control::get()->show_preferences(GUID_PREFERENCES_PAGE_ROOT);
-                } break;
-
-                case ID_EDIT_LYRICS:
-                {
-                    if(m_now_playing == nullptr) break;
-
-                    auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::Edit, m_now_playing, fb2k::noAbort);
-                    SpawnLyricEditor(m_lyrics, *update);
-                    m_update_handles.push_back(std::move(update));
-                } break;
-
-                case ID_OPEN_FILE_DIR:
-                {
-                    if(m_lyrics.persistent_storage_path.empty())
-                    {
-                        popup_message::g_complain("The selected track does not have any lyrics stored locally");
-                    }
-                    else
-                    {
-                        std::tstring pathstr = to_tstring(m_lyrics.persistent_storage_path);
-
-                        // Truncate the string at the last directory separator to get a directory path
-                        for(size_t i=pathstr.length(); i>0; i--)
-                        {
-                            if(pathstr[i] == _T('\\'))
-                            {
-                                pathstr = pathstr.substr(0, i);
-                                break;
-                            }
-                        }
-
-                        int exec_result = (int)ShellExecute(get_wnd(), _T("explore"), pathstr.c_str(), nullptr, nullptr, SW_SHOWMAXIMIZED);
-                        if(exec_result <= 32)
-                        {
-                            LOG_WARN("Failed to open lyric file directory: %d", exec_result);
-                        }
-                    }
-                } break;
-
-                case ID_AUTO_ADD_INSTRUMENTAL:
-                {
-                    if(m_lyrics.IsEmpty())
-                    {
-                        updated_lyrics = auto_edit::CreateInstrumental(m_lyrics);
-                    }
-                    else
-                    {
-                        LOG_WARN("Current track already has lyrics. It will not be marked as instrumental to avoid overwriting existing lyrics");
-                    }
-
-                } break;
-
-                case ID_AUTO_REMOVE_EXTRA_SPACES:
-                {
-                    updated_lyrics = auto_edit::RemoveRepeatedSpaces(m_lyrics);
-                } break;
-
-                case ID_AUTO_REMOVE_EXTRA_BLANK_LINES:
-                {
-                    updated_lyrics = auto_edit::RemoveRepeatedBlankLines(m_lyrics);
-                } break;
-
-                case ID_AUTO_REMOVE_ALL_BLANK_LINES:
-                {
-                    updated_lyrics = auto_edit::RemoveAllBlankLines(m_lyrics);
-                } break;
-
-                case ID_AUTO_REPLACE_XML_CHARS:
-                {
-                    updated_lyrics = auto_edit::ReplaceHtmlEscapedChars(m_lyrics);
-                } break;
-
-                case ID_AUTO_RESET_CAPITALISATION:
-                {
-                    updated_lyrics = auto_edit::ResetCapitalisation(m_lyrics);
-                } break;
-
-                case ID_FIX_MALFORMED_TIMESTAMPS:
-                {
-                    updated_lyrics = auto_edit::FixMalformedTimestamps(m_lyrics);
-                } break;
-            }
-
-            if(updated_lyrics.has_value())
-            {
-                LyricUpdateHandle update(LyricUpdateHandle::Type::Edit, m_now_playing, fb2k::noAbort);
-                update.set_started();
-                update.set_result(std::move(updated_lyrics.value()), true);
-
-                std::optional<LyricData> maybe_lyrics = io::process_available_lyric_update(update);
-                assert(maybe_lyrics.has_value()); // Round-trip through the processing to avoid copies
-                m_lyrics = std::move(maybe_lyrics.value());
-                m_auto_search_avoided = false;
-            }
-        }
-        catch(std::exception const & e)
-        {
-            LOG_ERROR("Failed to create OpenLyrics context menu: %s", e.what());
-        }
-    }
-
-    void LyricPanel::OnDoubleClick(UINT /*virtualKeys*/, CPoint /*cursorPos*/)
-    {
-        if(m_now_playing == nullptr) return;
-
-        auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::Edit, m_now_playing, fb2k::noAbort);
-        SpawnLyricEditor(m_lyrics, *update);
-        m_update_handles.push_back(std::move(update));
-    }
-
-    LRESULT LyricPanel::OnMouseWheel(UINT /*virtualKeys*/, short rotation, CPoint /*point*/)
-    {
-        if(preferences::display::scroll_type() == LineScrollType::Automatic)
-        {
-            return 0;
-        }
-
-        // NOTE: WHEEL_DELTA is defined to be 120
-        // rotation > 0 (usually 120) means we scrolled up
-        // rotation < 0 (usually -120) means we scrolled down
-        double scroll_ticks = double(rotation)/double(WHEEL_DELTA);
-
-        switch(preferences::display::scroll_direction())
-        {
-            case LineScrollDirection::Horizontal:
-            {
-                // NOTE: It's not clear how far we should scroll here so we just use the height
-                //       of an empty line as a reasonable first approximation.
-                RECT fake_client_area = {};
-                int one_line_height = ComputeWrappedLyricLineHeight(m_back_buffer, fake_client_area, _T(""));
-                m_manual_scroll_distance += int(scroll_ticks * one_line_height);
-            } break;
-
-            case LineScrollDirection::Vertical:
-            {
-                RECT fake_client_area = {};
-                int one_line_height = ComputeWrappedLyricLineHeight(m_back_buffer, fake_client_area, _T(""));
-                m_manual_scroll_distance += int(scroll_ticks * one_line_height);
-            } break;
-
-            default:
-                LOG_ERROR("Unexpected scroll direction setting: %d", int(preferences::display::scroll_direction()));
-                assert(false);
-                break;
-        }
-
-        Invalidate();
-        return 0;
-    }
-
-    void LyricPanel::OnMouseMove(UINT /*virtualKeys*/, CPoint point)
-    {
-        if(m_manual_scroll_start.has_value())
-        {
-            int scroll_delta = 0;
-            switch(preferences::display::scroll_direction())
-            {
-                case LineScrollDirection::Horizontal:
-                    scroll_delta = point.x - m_manual_scroll_start.value().x;
-                    break;
-
-                case LineScrollDirection::Vertical:
-                    scroll_delta = point.y - m_manual_scroll_start.value().y;
-                    break;
-
-                default:
-                    LOG_ERROR("Unexpected scroll direction setting: %d", int(preferences::display::scroll_direction()));
-                    assert(false);
-                    break;
-            }
-
-            m_manual_scroll_distance += scroll_delta;
-            m_manual_scroll_start = point;
-            Invalidate();
-        }
-    }
-
-    void LyricPanel::OnLMBDown(UINT /*virtualKeys*/, CPoint point)
-    {
-        if(preferences::display::scroll_type() == LineScrollType::Manual)
-        {
-            m_manual_scroll_start = point;
-            SetCapture();
-        }
-    }
-
-    void LyricPanel::OnLMBUp(UINT /*virtualKeys*/, CPoint /*point*/)
-    {
-        if(m_manual_scroll_start.has_value())
-        {
-            m_manual_scroll_start.reset();
-            ReleaseCapture();
-        }
-    }
-
-    t_ui_font LyricPanel::get_font()
-    {
-        t_ui_font result = preferences::display::font();
-        if(result == nullptr)
-        {
-            result = m_callback->query_font_ex(ui_font_console);
-        }
-        return result;
-    }
-
-    t_ui_color LyricPanel::get_fg_colour()
-    {
-        std::optional<t_ui_color> colour = preferences::display::foreground_colour();
-        if(colour.has_value())
-        {
-            return colour.value();
-        }
-        else
-        {
-            return m_callback->query_std_color(ui_color_text);
-        }
-    }
-
-    t_ui_color LyricPanel::get_bg_colour()
-    {
-        std::optional<t_ui_color> colour = preferences::display::background_colour();
-        if(colour.has_value())
-        {
-            return colour.value();
-        }
-        else
-        {
-            return m_callback->query_std_color(ui_color_background);
-        }
-    }
-
-    t_ui_color LyricPanel::get_highlight_colour()
-    {
-        std::optional<t_ui_color> colour = preferences::display::highlight_colour();
-        if(colour.has_value())
-        {
-            return colour.value();
-        }
-        else
-        {
-            return m_callback->query_std_color(ui_color_highlight);
-        }
-    }
-
-    void LyricPanel::StartTimer()
-    {
-        if (m_timerRunning) return;
-        m_timerRunning = true;
-
-        UINT_PTR result = SetTimer(PANEL_UPDATE_TIMER, 16, nullptr);
-        if (result != PANEL_UPDATE_TIMER)
-        {
-            LOG_WARN("Unexpected timer result when starting playback timer");
-        }
-    }
-
-    void LyricPanel::StopTimer()
-    {
-        if (!m_timerRunning) return;
-        m_timerRunning = false;
-
-        WIN32_OP(KillTimer(PANEL_UPDATE_TIMER))
-    }
-
-    void LyricPanel::InitiateLyricSearch(metadb_handle_ptr track)
-    {
-        LOG_INFO("Initiate lyric search");
-        m_lyrics = {};
-        m_auto_search_avoided = false;
-
-        auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::AutoSearch, track, fb2k::noAbort);
-        io::search_for_lyrics(*update, false);
-        m_update_handles.push_back(std::move(update));
-    }
-
-    // ui_element_impl_withpopup autogenerates standalone version of our component and proper menu commands. Use ui_element_impl instead if you don't want that.
-    class LyricPanelImpl : public ui_element_impl_withpopup<LyricPanel> {};
-    FB2K_SERVICE_FACTORY(LyricPanelImpl)
-    UIE_SHIM_PANEL_FACTORY(LyricPanel)
-
-} // namespace
-
-void repaint_all_lyric_panels()
-{
-    fb2k::inMainThread2([]()
-    {
-        core_api::ensure_main_thread();
-        for(LyricPanel* panel : g_active_panels)
-        {
-            assert(panel != nullptr);
-            InvalidateRect(panel->get_wnd(), nullptr, TRUE);
-        }
-    });
-}
-
+#include "stdafx.h"
+
+#pragma warning(push, 0)
+#include <libPPUI/win32_op.h>
+#include <foobar2000/helpers/BumpableElem.h>
+#pragma warning(pop)
+
+#include "logging.h"
+#include "lyric_auto_edit.h"
+#include "lyric_data.h"
+#include "lyric_io.h"
+#include "lyric_layout.h"
+#include "math_util.h"
+#include "metadb_index_search_avoidance.h"
+#include "parsers.h"
+#include "preferences.h"
+#include "sources/lyric_source.h"
+#include "ui_hooks.h"
+#include "uie_shim_panel.h"
+#include "win32_util.h"
+
+namespace {
+    static const GUID GUID_LYRICS_PANEL = { 0x6e24d0be, 0xad68, 0x4bc9,{ 0xa0, 0x62, 0x2e, 0xc7, 0xb3, 0x53, 0xd5, 0xbd } };
+    static const UINT_PTR PANEL_UPDATE_TIMER = 2304692;
+    static const UINT PANEL_LYRICS_PROCESSED_MSG = WM_APP + 1;
+
+    class LyricPanel;
+    static std::vector<LyricPanel*> g_active_panels;
+
+    // NOTE: Multiple panels (e.g in different UI layouts or popups) usually show the same lyrics in the same font.
+    //       These caches let them share layouts so that the text is only measured once.
+    //       They are only used from the main thread.
+    static SharedLayoutCache<LyricLayout> g_layout_cache;
+    static SharedLayoutCache<HorizontalLyricLayout> g_horizontal_layout_cache;
+
+    // NOTE: Fonts are deleted and re-created when they change (e.g in the display preferences or by the UI host),
+    //       and the new font can be given the same handle as the old one. The handle alone therefore can't tell us
+    //       whether a layout was measured with the current font, so this is incremented whenever a panel reloads its
+    //       display settings and layouts are only reused if they were computed in the current generation.
+    static uint64_t g_font_generation = 1;
+
+    // The inputs that the lyric layout of a panel was computed from.
+    // The layout only needs to be recomputed when one of these changes,
+    // so that we don't need to measure any text when drawing a frame.
+    struct LayoutCacheKey
+    {
+        uint64_t lyrics_revision;
+        HFONT font;
+        uint64_t font_generation;
+        int linegap;
+        int width;
+    };
+
+    // The position and colours of vertically-scrolling lyrics in a single frame
+    struct VerticalFrame
+    {
+        int top_y; // The baseline of the first segment of the first line
+        int active_line_index;
+        COLORREF fg_colour;
+        COLORREF active_colour;
+        COLORREF next_colour; // The colour of the line after the active line
+        int karaoke_x; // The distance along the active line up to which its words are highlighted, or -1 if it has no per-word timestamps
+    };
+
+    // What the back buffer currently contains, if it was last drawn with vertically-scrolling lyrics.
+    // If nothing but the vertical position and line colours change in the next frame, we can reuse most of it.
+    struct RetainedFrame
+    {
+        LayoutCacheKey layout_key;
+        CRect client_area;
+        COLORREF bg_colour;
+        VerticalFrame frame;
+    };
+
+    // A snapshot of every setting that affects how the lyrics are drawn.
+    // This is only rebuilt when the settings change, so that drawing never needs to read the configuration.
+    struct DisplaySettings
+    {
+        HFONT font;
+        COLORREF fg_colour;
+        COLORREF bg_colour;
+        COLORREF hl_colour;
+        LineScrollDirection scroll_direction;
+        LineScrollType scroll_type;
+        double scroll_time_seconds;
+        int linegap;
+    };
+
+    struct PanelFrameStats
+    {
+        pfc::hires_timer period_timer;
+        uint32_t frame_count;
+        double total_paint_seconds;
+        double max_paint_seconds;
+        uint32_t layouts_computed;
+        uint32_t layouts_shared; // The number of times a layout was needed but another panel had already computed it
+        uint32_t timer_ticks;
+        uint64_t pixels_drawn;
+        uint64_t pixels_total;
+        uint32_t frames_while_processing; // Frames painted while a lyric update was being processed (and maybe saved)
+        double max_paint_seconds_while_processing;
+    };
+
+    class LyricPanel : public ui_element_instance, public CWindowImpl<LyricPanel>, private play_callback_impl_base
+    {
+    public:
+        // ATL window class declaration. Replace class name with your own when reusing code.
+        DECLARE_WND_CLASS_EX(TEXT("{32CB89E1-3EA5-4AE7-A6E6-2DEA68A04D53}"), CS_VREDRAW | CS_HREDRAW | CS_DBLCLKS, (-1))
+
+        LyricPanel(ui_element_config::ptr,ui_element_instance_callback_ptr p_callback);
+        HWND get_wnd() override;
+        void initialize_window(HWND parent);
+        void set_configuration(ui_element_config::ptr config) override;
+        ui_element_config::ptr get_configuration() override;
+
+        static GUID g_get_guid();
+        static GUID g_get_subclass();
+        static void g_get_name(pfc::string_base & out);
+        static ui_element_config::ptr g_get_default_configuration();
+        static const char * g_get_description();
+        static void g_on_display_settings_changed();
+
+        void notify(const GUID& p_what, t_size p_param1, const void* p_param2, t_size p_param2size) override;
+
+        void on_playback_new_track(metadb_handle_ptr track) override;
+        void on_playback_stop(play_control::t_stop_reason reason) override;
+        void on_playback_pause(bool state) override;
+        void on_playback_seek(double time) override;
+
+        void on_display_settings_changed();
+
+    private:
+        BEGIN_MSG_MAP_EX(LyricPanel)
+            MSG_WM_CREATE(OnWindowCreate)
+            MSG_WM_DESTROY(OnWindowDestroy)
+            MSG_WM_SIZE(OnWindowResize)
+            MSG_WM_TIMER(OnTimer)
+            MSG_WM_ERASEBKGND(OnEraseBkgnd)
+            MSG_WM_PAINT(OnPaint)
+            MSG_WM_CONTEXTMENU(OnContextMenu)
+            MSG_WM_LBUTTONDBLCLK(OnDoubleClick)
+            MSG_WM_MOUSEWHEEL(OnMouseWheel)
+            MSG_WM_MOUSEMOVE(OnMouseMove)
+            MSG_WM_LBUTTONDOWN(OnLMBDown)
+            MSG_WM_LBUTTONUP(OnLMBUp)
+            MESSAGE_HANDLER_EX(PANEL_LYRICS_PROCESSED_MSG, OnLyricsProcessed)
+        END_MSG_MAP()
+
+        LRESULT OnWindowCreate(LPCREATESTRUCT);
+        void OnWindowDestroy();
+        void OnWindowResize(UINT request_type, CSize new_size);
+        LRESULT OnTimer(WPARAM);
+        void OnPaint(CDCHandle);
+        BOOL OnEraseBkgnd(CDCHandle);
+        void OnContextMenu(CWindow window, CPoint point);
+        void OnDoubleClick(UINT virtualKeys, CPoint cursorPos);
+        LRESULT OnMouseWheel(UINT virtualKeys, short rotation, CPoint point);
+        void OnMouseMove(UINT virtualKeys, CPoint point);
+        void OnLMBDown(UINT virtualKeys, CPoint point);
+        void OnLMBUp(UINT virtualKeys, CPoint point);
+        LRESULT OnLyricsProcessed(UINT msg, WPARAM wParam, LPARAM lParam);
+
+        t_ui_font get_font();
+        t_ui_color get_fg_colour();
+        t_ui_color get_bg_colour();
+        t_ui_color get_highlight_colour();
+
+        void StartTimer();
+        void StopTimer();
+        void ScheduleNextFrame();
+        std::optional<double> ComputeSecondsUntilNextChange();
+        void ReloadDisplaySettings();
+
+        void ProcessAvailableLyricUpdates();
+        void RenderFrame(const DisplaySettings& settings, CRect client_area);
+        uint64_t BlitBackBuffer(HDC front_buffer, CRect rect);
+
+        void DrawNoLyrics(HDC dc, const DisplaySettings& settings, CRect client_area);
+        VerticalFrame ComputeUntimedVerticalFrame(HDC dc, const DisplaySettings& settings, CRect client_area);
+        VerticalFrame ComputeTimestampedVerticalFrame(HDC dc, const DisplaySettings& settings, CRect client_area);
+        void DrawLyricsVertical(HDC dc, const DisplaySettings& settings, CRect client_area, CRect dirty_area, const VerticalFrame& frame);
+        void DrawUntimedLyricsHorizontal(HDC dc, const DisplaySettings& settings, CRect client_area);
+        void DrawTimestampedLyricsHorizontal(HDC dc, const DisplaySettings& settings, CRect client_area);
+
+        void InitiateLyricSearch(metadb_handle_ptr track, bool ignore_search_avoidance);
+
+        const LyricLayout& GetLayout(HDC dc, const DisplaySettings& settings, CRect client_area);
+        const HorizontalLyricLayout& GetHorizontalLayout(HDC dc, const DisplaySettings& settings);
+        void SetLyrics(LyricData&& lyrics);
+        void RecordFrameTime(double paint_seconds, uint64_t pixels_drawn, uint64_t pixels_total);
+
+        ui_element_config::ptr m_config;
+        DisplaySettings m_settings;
+
+        bool m_timerRunning;
+
+        metadb_handle_ptr m_now_playing;
+        std::vector<std::unique_ptr<LyricUpdateHandle>> m_update_handles;
+        std::vector<std::pair<metadb_handle_ptr, LyricData>> m_processed_lyrics;
+        uint32_t m_updates_processing; // The number of lyric updates that have been handed off but not yet returned to us
+        LyricData m_lyrics;
+        uint64_t m_lyrics_revision;
+        uint64_t m_lyrics_hash;
+        LayoutCacheKey m_layout_key;
+        std::shared_ptr<const LyricLayout> m_layout;
+        LayoutCacheKey m_horizontal_layout_key;
+        std::shared_ptr<const HorizontalLyricLayout> m_horizontal_layout;
+        std::vector<PositionedRun> m_runs;
+        std::optional<RetainedFrame> m_retained_frame;
+        std::vector<CRect> m_dirty_rects;
+        PanelFrameStats m_frame_stats;
+        bool m_auto_search_avoided;
+        uint64_t m_auto_search_avoided_timestamp;
+
+        HDC m_back_buffer;
+        HBITMAP m_back_buffer_bitmap;
+
+        std::optional<CPoint> m_manual_scroll_start;
+        int m_manual_scroll_distance;
+
+    protected:
+        // this must be declared as protected for ui_element_impl_withpopup<> to work.
+        const ui_element_instance_callback_ptr m_callback;
+    };
+
+    HWND LyricPanel::get_wnd() { return *this; }
+    void LyricPanel::initialize_window(HWND parent) { WIN32_OP(Create(parent) != NULL) }
+    void LyricPanel::set_configuration(ui_element_config::ptr config) { m_config = config; }
+    ui_element_config::ptr LyricPanel::get_configuration() { return m_config; }
+
+    GUID LyricPanel::g_get_guid() { return GUID_LYRICS_PANEL; }
+    GUID LyricPanel::g_get_subclass() { return ui_element_subclass_utility; }
+    ui_element_config::ptr LyricPanel::g_get_default_configuration() { return ui_element_config::g_create_empty(g_get_guid()); }
+    void LyricPanel::g_get_name(pfc::string_base & out) { out = "OpenLyrics Panel"; }
+    const char * LyricPanel::g_get_description() { return "Displays lyrics for the currently-playing track."; }
+    void LyricPanel::g_on_display_settings_changed() { reload_all_lyric_panel_settings(); }
+
+    LyricPanel::LyricPanel(ui_element_config::ptr config, ui_element_instance_callback_ptr p_callback) :
+        m_config(config),
+        m_settings(),
+        m_timerRunning(false),
+        m_now_playing(nullptr),
+        m_update_handles(),
+        m_processed_lyrics(),
+        m_updates_processing(0),
+        m_lyrics(),
+        m_lyrics_revision(1),
+        m_lyrics_hash(hash_lyric_lines({})),
+        m_layout_key(),
+        m_layout(),
+        m_horizontal_layout_key(),
+        m_horizontal_layout(),
+        m_runs(),
+        m_retained_frame(),
+        m_dirty_rects(),
+        m_frame_stats(),
+        m_callback(p_callback),
+        m_auto_search_avoided(false),
+        m_auto_search_avoided_timestamp(0)
+    {
+        m_frame_stats.period_timer.start();
+    }
+
+    void LyricPanel::notify(const GUID& what, t_size /*param1*/, const void* /*param2*/, t_size /*param2size*/)
+    {
+        if ((what == ui_element_notify_colors_changed) || (what == ui_element_notify_font_changed))
+        {
+            // we use global colors and fonts - trigger a repaint whenever these change.
+            ReloadDisplaySettings();
+            Invalidate();
+        }
+    }
+
+    void LyricPanel::on_playback_new_track(metadb_handle_ptr track)
+    {
+        m_now_playing = track;
+        m_manual_scroll_distance = 0;
+
+        // NOTE: Remote sources that have recently failed to find lyrics for this track are skipped by
+        //       the search itself. We only need to check here so that we can tell the user if *every*
+        //       remote source was skipped (in which case only local sources will actually be searched).
+        lyric_search_avoidance avoidance = load_search_avoidance(track);
+        const t_filetimestamp now = filetimestamp_from_system_timer();
+        int remote_source_count = 0;
+        int avoided_source_count = 0;
+        for(GUID source_id : preferences::searching::active_sources())
+        {
+            LyricSourceBase* source = LyricSourceBase::get(source_id);
+            if((source == nullptr) || source->is_local())
+            {
+                continue;
+            }
+
+            remote_source_count++;
+            if(!search_avoidance_allows_search(avoidance, source_id, now))
+            {
+                avoided_source_count++;
+            }
+        }
+
+        InitiateLyricSearch(track, false);
+        if((remote_source_count > 0) && (avoided_source_count == remote_source_count))
+        {
+            LOG_INFO("Skipped searching remote sources because they're expected to fail anyway and were not specifically requested");
+            m_auto_search_avoided = true;
+            m_auto_search_avoided_timestamp = now;
+        }
+
+        // NOTE: If playback is paused on startup then this gets called with the paused track,
+        //       but playback is paused so we don't actually want to run the timer
+        service_ptr_t<playback_control> playback = playback_control::get();
+        if(!playback->is_paused())
+        {
+            StartTimer();
+        }
+    }
+
+    void LyricPanel::on_playback_stop(play_control::t_stop_reason /*reason*/)
+    {
+        m_now_playing = nullptr;
+        SetLyrics({});
+        m_auto_search_avoided = false;
+        StopTimer();
+        Invalidate(); // Draw one more time to clear the panel
+    }
+
+    void LyricPanel::on_playback_pause(bool state)
+    {
+        if (state)
+        {
+            StopTimer();
+        }
+        else
+        {
+            StartTimer();
+        }
+    }
+
+    void LyricPanel::on_playback_seek(double /*time*/)
+    {
+        Invalidate(); // Draw again to update the scroll for the new seek time
+    }
+
+    void LyricPanel::on_display_settings_changed()
+    {
+        ReloadDisplaySettings();
+        Invalidate();
+    }
+
+    LRESULT LyricPanel::OnWindowCreate(LPCREATESTRUCT /*params*/)
+    {
+        ReloadDisplaySettings();
+
+        service_ptr_t<playback_control> playback = playback_control::get();
+        metadb_handle_ptr track;
+        if(playback->get_now_playing(track))
+        {
+            on_playback_new_track(track);
+        }
+
+        g_active_panels.push_back(this);
+        return 0;
+    }
+
+    void LyricPanel::OnWindowDestroy()
+    {
+        if(m_back_buffer_bitmap != nullptr) DeleteObject(m_back_buffer_bitmap);
+        if(m_back_buffer != nullptr) DeleteDC(m_back_buffer);
+
+        // Cancel and clean up any pending updates
+        m_update_handles.clear();
+
+        auto panel_iter = std::find(g_active_panels.begin(), g_active_panels.end(), this);
+        assert(panel_iter != g_active_panels.end());
+        if(panel_iter != g_active_panels.end())
+        {
+            g_active_panels.erase(panel_iter);
+        }
+    }
+
+    void LyricPanel::OnWindowResize(UINT /*request_type*/, CSize new_size)
+    {
+        if(m_back_buffer != nullptr) DeleteDC(m_back_buffer);
+        if(m_back_buffer_bitmap != nullptr) DeleteObject(m_back_buffer_bitmap);
+        m_retained_frame.reset();
+
+        CRect client_rect;
+        WIN32_OP_D(GetClientRect(&client_rect))
+
+        HDC front_buffer = GetDC();
+        m_back_buffer = CreateCompatibleDC(front_buffer);
+        m_back_buffer_bitmap = CreateCompatibleBitmap(front_buffer, new_size.cx, new_size.cy);
+        SelectObject(m_back_buffer, m_back_buffer_bitmap);
+        ReleaseDC(front_buffer);
+
+        SetBkMode(m_back_buffer, TRANSPARENT);
+        UINT align_result = SetTextAlign(m_back_buffer, TA_BASELINE | TA_CENTER);
+        if(align_result == GDI_ERROR)
+        {
+            LOG_WARN("Failed to set text alignment: %d", GetLastError());
+        }
+    }
+
+    LRESULT LyricPanel::OnTimer(WPARAM /*wParam*/)
+    {
+        pfc::hires_timer frame_timer;
+        frame_timer.start();
+        m_frame_stats.timer_ticks++;
+
+        CRect client_rect;
+        WIN32_OP_D(GetClientRect(&client_rect))
+        RenderFrame(m_settings, client_rect);
+
+        // NOTE: We copy the parts of the back buffer that changed directly to the window rather than
+        //       invalidating it, because invalidating would make us blit the entire client area on paint.
+        uint64_t pixels_drawn = 0;
+        HDC front_buffer = GetDC();
+        for(const CRect& rect : m_dirty_rects)
+        {
+            pixels_drawn += BlitBackBuffer(front_buffer, rect);
+        }
+        ReleaseDC(front_buffer);
+
+        ScheduleNextFrame();
+        RecordFrameTime(frame_timer.query(), pixels_drawn, uint64_t(client_rect.Width()) * uint64_t(client_rect.Height()));
+        return 0;
+    }
+
+    BOOL LyricPanel::OnEraseBkgnd(CDCHandle /*dc*/)
+    {
+        // NOTE: It isn't strictly required to implement this behaviour, but it's an optimisation.
+        //       By default (if we return FALSE here or don't overload this at all), the window
+        //       will be erased (filled with the background colour) when invalidated (to prepare
+        //       for drawing). However we draw the correct background during our paint anyway
+        //       so there is no need for the system (or us) to do it again here.
+        return TRUE;
+    }
+
+    // Measures text in the font that is currently selected into a device context
+    class GdiTextMetrics : public TextMetricsProvider
+    {
+    public:
+        explicit GdiTextMetrics(HDC dc) :
+            m_dc(dc),
+            m_font_metrics({})
+        {
+            WIN32_OP_D(GetTextMetrics(dc, &m_font_metrics))
+        }
+
+        int ascent() const override { return m_font_metrics.tmAscent; }
+        int descent() const override { return m_font_metrics.tmDescent; }
+        int height() const override { return m_font_metrics.tmHeight; }
+        int average_char_width() const override { return m_font_metrics.tmAveCharWidth; }
+
+        std::optional<int> measure(std::tstring_view text) override
+        {
+            SIZE size;
+            BOOL extent_success = GetTextExtentPoint32(m_dc, text.data(), int(text.length()), &size);
+            if(!extent_success)
+            {
+                LOG_WARN("Failed to compute lyric line extents");
+                return {};
+            }
+            return size.cx;
+        }
+
+    private:
+        HDC m_dc;
+        TEXTMETRIC m_font_metrics;
+    };
+
+    // Draws a single run of text with its baseline centred on the given point, unless it lies entirely outside the clip rect.
+    // Returns false if the text could not be drawn.
+    bool DrawRun(HDC dc, CRect clip_rect, int font_ascent, int font_descent, int x, int y, std::tstring_view text)
+    {
+        bool clipped = (y + font_descent < clip_rect.top) || (y - font_ascent > clip_rect.bottom);
+        if(clipped)
+        {
+            return true;
+        }
+
+        BOOL draw_success = DrawTextOut(dc, x, y, text);
+        if(!draw_success)
+        {
+            LOG_WARN("Failed to draw lyrics text: %d", GetLastError());
+            return false;
+        }
+        return true;
+    }
+
+    // Draws a single run of text as with DrawRun, but with only the first `highlight_width` pixels in `highlight_colour`
+    // and the rest in `colour`. The text is drawn (at most) twice, each time clipped to one side of the split.
+    bool DrawKaraokeRun(HDC dc, CRect clip_rect, int font_ascent, int font_descent, int x, int y, int width, int highlight_width,
+                        COLORREF highlight_colour, COLORREF colour, std::tstring_view text)
+    {
+        if(highlight_width <= 0)
+        {
+            SetTextColor(dc, colour);
+            return DrawRun(dc, clip_rect, font_ascent, font_descent, x, y, text);
+        }
+        if(highlight_width >= width)
+        {
+            SetTextColor(dc, highlight_colour);
+            return DrawRun(dc, clip_rect, font_ascent, font_descent, x, y, text);
+        }
+
+        // NOTE: Text is drawn centred on x, so the left edge of the run is half its width to the left
+        const int split_x = x - width/2 + highlight_width;
+        bool success = true;
+
+        int saved_dc = SaveDC(dc);
+        IntersectClipRect(dc, clip_rect.left, clip_rect.top, split_x, clip_rect.bottom);
+        SetTextColor(dc, highlight_colour);
+        success &= DrawRun(dc, clip_rect, font_ascent, font_descent, x, y, text);
+        RestoreDC(dc, saved_dc);
+
+        saved_dc = SaveDC(dc);
+        IntersectClipRect(dc, split_x, clip_rect.top, clip_rect.right, clip_rect.bottom);
+        SetTextColor(dc, colour);
+        success &= DrawRun(dc, clip_rect, font_ascent, font_descent, x, y, text);
+        RestoreDC(dc, saved_dc);
+        return success;
+    }
+
+    int ComputeWrappedLyricLineHeight(HDC dc, CRect clip_rect, int linegap, std::tstring_view line)
+    {
+        GdiTextMetrics metrics(dc);
+        return layout_line(metrics, clip_rect.Width(), linegap, line).height;
+    }
+
+    int DrawWrappedLyricLine(HDC dc, CRect clip_rect, int linegap, std::tstring_view line, CPoint origin)
+    {
+        GdiTextMetrics metrics(dc);
+        LayoutLine wrapped = layout_line(metrics, clip_rect.Width(), linegap, line);
+
+        int draw_y = origin.y;
+        for(const LayoutLine::Segment& segment : wrapped.segments)
+        {
+            if(!DrawRun(dc, clip_rect, metrics.ascent(), metrics.descent(), origin.x, draw_y, line.substr(segment.start, segment.length)))
+            {
+                return 0;
+            }
+            draw_y += metrics.height() + linegap;
+        }
+        return wrapped.height;
+    }
+
+    const LyricLayout& LyricPanel::GetLayout(HDC dc, const DisplaySettings& settings, CRect client_area)
+    {
+        const HFONT font = settings.font;
+        const uint64_t font_generation = g_font_generation;
+        const int linegap = settings.linegap;
+        const int width = client_area.Width();
+        const bool layout_valid = (m_layout_key.lyrics_revision == m_lyrics_revision) &&
+                                  (m_layout_key.font == font) &&
+                                  (m_layout_key.font_generation == font_generation) &&
+                                  (m_layout_key.linegap == linegap) &&
+                                  (m_layout_key.width == width);
+        if(layout_valid)
+        {
+            return *m_layout;
+        }
+
+        const uint32_t previous_layouts_computed = m_frame_stats.layouts_computed;
+        m_layout = g_layout_cache.get(reinterpret_cast<uintptr_t>(font), font_generation, width, linegap, m_lyrics.lines, m_lyrics_hash,
+            [this, dc, width, linegap]()
+            {
+                GdiTextMetrics metrics(dc);
+                m_frame_stats.layouts_computed++;
+                return layout_lyrics(metrics, width, linegap, m_lyrics.lines);
+            });
+        m_layout_key = {m_lyrics_revision, font, font_generation, linegap, width};
+        if(m_frame_stats.layouts_computed == previous_layouts_computed)
+        {
+            m_frame_stats.layouts_shared++;
+        }
+        return *m_layout;
+    }
+
+    const HorizontalLyricLayout& LyricPanel::GetHorizontalLayout(HDC dc, const DisplaySettings& settings)
+    {
+        // NOTE: Lines are never wrapped when scrolling horizontally, so the panel width does not affect this layout
+        const HFONT font = settings.font;
+        const uint64_t font_generation = g_font_generation;
+        const int linegap = settings.linegap;
+        const bool layout_valid = (m_horizontal_layout_key.lyrics_revision == m_lyrics_revision) &&
+                                  (m_horizontal_layout_key.font == font) &&
+                                  (m_horizontal_layout_key.font_generation == font_generation) &&
+                                  (m_horizontal_layout_key.linegap == linegap);
+        if(layout_valid)
+        {
+            return *m_horizontal_layout;
+        }
+
+        const uint32_t previous_layouts_computed = m_frame_stats.layouts_computed;
+        m_horizontal_layout = g_horizontal_layout_cache.get(reinterpret_cast<uintptr_t>(font), font_generation, 0, linegap, m_lyrics.lines, m_lyrics_hash,
+            [this, dc, linegap]()
+            {
+                GdiTextMetrics metrics(dc);
+                m_frame_stats.layouts_computed++;
+                return layout_lyrics_horizontal(metrics, linegap, m_lyrics.lines);
+            });
+        m_horizontal_layout_key = {m_lyrics_revision, font, font_generation, linegap, 0};
+        if(m_frame_stats.layouts_computed == previous_layouts_computed)
+        {
+            m_frame_stats.layouts_shared++;
+        }
+        return *m_horizontal_layout;
+    }
+
+    void LyricPanel::SetLyrics(LyricData&& lyrics)
+    {
+        m_lyrics = std::move(lyrics);
+        m_lyrics_revision++;
+        m_lyrics_hash = hash_lyric_lines(m_lyrics.lines);
+    }
+
+    void LyricPanel::RecordFrameTime(double paint_seconds, uint64_t pixels_drawn, uint64_t pixels_total)
+    {
+        m_frame_stats.frame_count++;
+        m_frame_stats.total_paint_seconds += paint_seconds;
+        m_frame_stats.pixels_drawn += pixels_drawn;
+        m_frame_stats.pixels_total += pixels_total;
+        m_frame_stats.max_paint_seconds = max(m_frame_stats.max_paint_seconds, paint_seconds);
+        if(m_updates_processing > 0)
+        {
+            m_frame_stats.frames_while_processing++;
+            m_frame_stats.max_paint_seconds_while_processing = max(m_frame_stats.max_paint_seconds_while_processing, paint_seconds);
+        }
+
+        const double report_period_seconds = 5.0;
+        const double period_seconds = m_frame_stats.period_timer.query();
+        if(period_seconds >= report_period_seconds)
+        {
+            double drawn_fraction = 0.0;
+            if(m_frame_stats.pixels_total > 0)
+            {
+                drawn_fraction = double(m_frame_stats.pixels_drawn)/double(m_frame_stats.pixels_total);
+            }
+            LOG_INFO("Panel painted %u frames in %.1fs (%.1f fps, %.1f timer redraws per second), taking %.3fms on average and %.3fms at most and copying %.1f%% of the panel to the screen. %u frames were painted while lyrics were being processed, taking %.3fms at most. The layout was computed %u times and shared with another panel %u times",
+                     m_frame_stats.frame_count,
+                     period_seconds,
+                     double(m_frame_stats.frame_count)/period_seconds,
+                     double(m_frame_stats.timer_ticks)/period_seconds,
+                     1000.0*m_frame_stats.total_paint_seconds/double(m_frame_stats.frame_count),
+                     1000.0*m_frame_stats.max_paint_seconds,
+                     100.0*drawn_fraction,
+                     m_frame_stats.frames_while_processing,
+                     1000.0*m_frame_stats.max_paint_seconds_while_processing,
+                     m_frame_stats.layouts_computed,
+                     m_frame_stats.layouts_shared);
+            m_frame_stats = {};
+            m_frame_stats.period_timer.start();
+        }
+    }
+
+    void LyricPanel::DrawNoLyrics(HDC dc, const DisplaySettings& settings, CRect client_rect)
+    {
+        if(m_now_playing == nullptr)
+        {
+            return;
+        }
+
+        // TODO: If we make this text configurable in future and we want to also show some text
+        //       telling you that it didn't search because nothing was found, look into:
+        //       metadb.h (in foo_SDK) -> metadb_display_field_provider
+        //       which exists to let you hook into the title format process and add new fields.
+
+        std::string artist = track_metadata(m_now_playing, "artist");
+        std::string album = track_metadata(m_now_playing, "album");
+        std::string title = track_metadata(m_now_playing, "title");
+
+        int total_height = 0;
+        std::tstring artist_line;
+        std::tstring album_line;
+        std::tstring title_line;
+        if(!artist.empty())
+        {
+            artist_line = _T("Artist: ") + to_tstring(artist);
+            total_height += ComputeWrappedLyricLineHeight(dc, client_rect, settings.linegap, artist_line);
+        }
+        if(!album.empty())
+        {
+            album_line = _T("Album: ") + to_tstring(album);
+            total_height += ComputeWrappedLyricLineHeight(dc, client_rect, settings.linegap, album_line);
+        }
+        if(!title.empty())
+        {
+            title_line = _T("Title: ") + to_tstring(title);
+            total_height += ComputeWrappedLyricLineHeight(dc, client_rect, settings.linegap, title_line);
+        }
+
+        // NOTE: Since our calculation is for the *top* of the rendered text, we need to
+        //       shift down by the font's ascent so that we get to the baseline (which
+        //       is what is used as the rendering origin).
+        TEXTMETRIC font_metrics = {};
+        WIN32_OP_D(GetTextMetrics(dc, &font_metrics))
+
+        CPoint centre = client_rect.CenterPoint();
+        int top_y = centre.y - total_height/2 + font_metrics.tmAscent;
+        CPoint origin = {centre.x, top_y};
+        if(!artist_line.empty())
+        {
+            origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, artist_line, origin);
+        }
+        if(!album_line.empty())
+        {
+            origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, album_line, origin);
+        }
+        if(!title_line.empty())
+        {
+            origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, title_line, origin);
+        }
+
+        if(!m_update_handles.empty())
+        {
+            bool is_search = false;
+            std::string progress_msg;
+            for(std::unique_ptr<LyricUpdateHandle>& update : m_update_handles)
+            {
+                if((update != nullptr) &&
+                    (update->get_type() == LyricUpdateHandle::Type::AutoSearch) &&
+                    (update->get_track() == m_now_playing))
+                {
+                    progress_msg = update->get_progress();
+                    is_search = true;
+                    break;
+                }
+            }
+
+            if(is_search)
+            {
+                std::tstring progress_text = to_tstring(progress_msg);
+                origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, progress_text, origin);
+            }
+        }
+
+        if(m_auto_search_avoided)
+        {
+            const double search_avoided_msg_seconds = 15.0;
+            uint64_t search_avoided_msg_ticks = static_cast<uint64_t>(search_avoided_msg_seconds * 10'000'000); // A "tick" here means "100-nanoseconds"
+            uint64_t ticks_since_search_avoided = filetimestamp_from_system_timer() - m_auto_search_avoided_timestamp;
+            if(ticks_since_search_avoided < search_avoided_msg_ticks)
+            {
+                origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, _T(""), origin);
+                origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, _T("Online sources skipped because they failed too many times."), origin);
+                origin.y += DrawWrappedLyricLine(dc, client_rect, settings.linegap, _T("Manually request a lyrics search to try again."), origin);
+            }
+        }
+    }
+
+    VerticalFrame LyricPanel::ComputeUntimedVerticalFrame(HDC dc, const DisplaySettings& settings, CRect client_area)
+    {
+        service_ptr_t<playback_control> playback = playback_control::get();
+        double current_position = playback->playback_get_position();
+        double total_length = playback->playback_get_length_ex();
+        double track_fraction = current_position / total_length;
+
+        const LyricLayout& layout = GetLayout(dc, settings, client_area);
+        const int total_height = layout.total_height;
+
+        CPoint centre = client_area.CenterPoint();
+        int top_y = 0;
+        if(settings.scroll_type == LineScrollType::Manual)
+        {
+            // Shift the 'top' Y down by a single line so we can see the first line of text,
+            // because the 'top y' is actually used as the *baseline*
+            int one_line_height = layout.line_height;
+
+            int default_top_y = one_line_height;
+            if(total_height < client_area.Height())
+            {
+                int centre_y = client_area.Height()/2;
+                default_top_y = centre_y + one_line_height - total_height/2;
+            }
+
+            // We want:
+            // 1) bottom_y >= one_line_height
+            //    top_y + total_height >= one_line_height
+            //    top_y >= one_line_height - total_height
+            //    default_top_y - one_line_height + m_manual_scroll_distance >= one_line_height - total_height
+            //    m_manual_scroll_distance >= one_line_height - total_height - default_top_y + one_line_height
+            // 2) top_y <= panel_height
+            //    default_top_y + m_manual_scroll_distance <= panel_height
+            //    m_manual_scroll_distance <= panel_height - default_top_y
+            // So:
+            //    (one_line_height - total_height - default_top_y + one_line_height) <= m_manual_scroll_distance <= (panel_height - default_top_y)
+            int min_scroll = one_line_height - total_height - default_top_y + one_line_height;
+            int max_scroll = client_area.Height() - default_top_y;
+            if(m_manual_scroll_distance < min_scroll) m_manual_scroll_distance = min_scroll;
+            if(m_manual_scroll_distance > max_scroll) m_manual_scroll_distance = max_scroll;
+
+            top_y = default_top_y + m_manual_scroll_distance;
+        }
+        else
+        {
+            // NOTE: Since our calculation is for the *top* of the rendered text, we need to
+            //       shift down by the font's ascent so that we get to the baseline (which
+            //       is what is used as the rendering origin).
+            top_y = centre.y - (int)(track_fraction * total_height) + layout.font_ascent;
+        }
+
+        const t_ui_color fg_colour = settings.fg_colour;
+        return {top_y, -1, fg_colour, fg_colour, fg_colour, -1};
+    }
+
+    void LyricPanel::DrawUntimedLyricsHorizontal(HDC dc, const DisplaySettings& settings, CRect client_area)
+    {
+        if(m_lyrics.lines.empty()) return;
+        assert(m_lyrics.lines.size() > 0);
+
+        assert(settings.scroll_direction == LineScrollDirection::Horizontal);
+        service_ptr_t<playback_control> playback = playback_control::get();
+        double current_position = playback->playback_get_position();
+        double total_length = playback->playback_get_length_ex();
+        double track_fraction = current_position / total_length;
+
+        const HorizontalLyricLayout& layout = GetHorizontalLayout(dc, settings);
+        if(layout.measure_failed)
+        {
+            LOG_ERROR("Failed to compute unsynced text width");
+            StopTimer();
+            return;
+        }
+        const int total_width = layout.total_width;
+
+        // NOTE: The drawing call uses the glyph baseline as the origin.
+        //       We want our text to be perfectly vertically centered, so we need to offset it
+        //       but the difference between the baseline and the vertical centre of the font.
+        int baseline_centre_correction = (layout.font_ascent + layout.font_descent)/2;
+
+        CPoint centre = client_area.CenterPoint();
+        CPoint origin = centre;
+        if(settings.scroll_type == LineScrollType::Manual)
+        {
+            int half_width = client_area.Width()/2;
+            if(m_manual_scroll_distance > half_width)
+            {
+                m_manual_scroll_distance = half_width;
+            }
+            if(m_manual_scroll_distance < -total_width + half_width)
+            {
+                m_manual_scroll_distance = -total_width + half_width;
+            }
+            origin.x += (total_width - client_area.Width())/2 + m_manual_scroll_distance;
+        }
+        else
+        {
+            origin.x += (int)((0.5 - track_fraction) * (double)total_width);
+        }
+        origin.y += baseline_centre_correction;
+
+        // NOTE: The origin computed above is the centre of all the lines joined together
+        const int left_x = origin.x - total_width/2;
+        const auto [first_line, end_line] = visible_lines_horizontal(layout, left_x, client_area.left, client_area.right);
+        for(size_t line_index=first_line; line_index<end_line; line_index++)
+        {
+            const int line_centre_x = left_x + layout.line_lefts[line_index] + layout.line_widths[line_index]/2;
+            BOOL draw_success = DrawTextOut(dc, line_centre_x, origin.y, m_lyrics.lines[line_index].text);
+            if(!draw_success)
+            {
+                LOG_ERROR("Failed to draw unsynced text");
+                StopTimer();
+                break;
+            }
+        }
+    }
+
+
+    VerticalFrame LyricPanel::ComputeTimestampedVerticalFrame(HDC dc, const DisplaySettings& settings, CRect client_area)
+    {
+        // NOTE: The drawing call uses the glyph baseline as the origin.
+        //       We want our text to be perfectly vertically centered, so we need to offset it
+        //       but the difference between the baseline and the vertical centre of the font.
+        const LyricLayout& layout = GetLayout(dc, settings, client_area);
+        int baseline_centre_correction = (layout.font_ascent + layout.font_descent)/2;
+
+        t_ui_color fg_colour = settings.fg_colour;
+        t_ui_color hl_colour = settings.hl_colour;
+
+        service_ptr_t<playback_control> playback = playback_control::get();
+        double current_time = playback->playback_get_position();
+
+        // NOTE: Lines are sorted by timestamp, so the active line is the last one that started before the current time
+        const auto first_future_line = std::partition_point(m_lyrics.lines.begin(), m_lyrics.lines.end(),
+                                                            [this, current_time](const LyricDataLine& line)
+                                                            {
+                                                                return current_time > (line.timestamp - m_lyrics.timestamp_offset);
+                                                            });
+        int active_line_index = static_cast<int>(first_future_line - m_lyrics.lines.begin()) - 1;
+        int active_line_height = 0;
+        int text_height_above_active_line = 0;
+        if(active_line_index >= 0)
+        {
+            active_line_height = layout.lines[active_line_index].height;
+            text_height_above_active_line = layout.line_tops[active_line_index];
+        }
+
+        double next_line_time = m_lyrics.LineTimestamp(active_line_index+1);
+        double scroll_time = settings.scroll_time_seconds;
+        double next_line_scroll_factor = lerp_inverse_clamped(next_line_time - scroll_time, next_line_time, current_time);
+
+        CPoint centre = client_area.CenterPoint();
+        int next_line_scroll = (int)((double)active_line_height * next_line_scroll_factor);
+        int top_y = (int)((double)centre.y - text_height_above_active_line - next_line_scroll + baseline_centre_correction);
+        COLORREF active_colour = lerp(hl_colour, fg_colour, next_line_scroll_factor);
+        COLORREF next_colour = lerp(fg_colour, hl_colour, next_line_scroll_factor);
+
+        // NOTE: Lines with per-word timestamps are highlighted word-by-word once they become active,
+        //       so the next line should not fade into the highlight colour ahead of time.
+        if((first_future_line != m_lyrics.lines.end()) && !first_future_line->words.empty())
+        {
+            next_colour = fg_colour;
+        }
+
+        int karaoke_x = -1;
+        if((active_line_index >= 0) && !m_lyrics.lines[active_line_index].words.empty())
+        {
+            const LayoutLine& active_layout = layout.lines[active_line_index];
+            const double line_end_time = (first_future_line == m_lyrics.lines.end()) ? DBL_MAX : first_future_line->timestamp;
+            karaoke_x = karaoke_position(m_lyrics.lines[active_line_index],
+                                         active_layout.word_positions,
+                                         active_layout.text_width,
+                                         current_time + m_lyrics.timestamp_offset,
+                                         line_end_time);
+        }
+        return {top_y, active_line_index, fg_colour, active_colour, next_colour, karaoke_x};
+    }
+
+    COLORREF VerticalLineColour(const VerticalFrame& frame, int line_index)
+    {
+        if(line_index == frame.active_line_index)
+        {
+            return frame.active_colour;
+        }
+        else if(line_index == frame.active_line_index+1)
+        {
+            return frame.next_colour;
+        }
+        else
+        {
+            return frame.fg_colour;
+        }
+    }
+
+    // Returns true if the given line looks the same in both frames
+    bool VerticalLineMatches(const VerticalFrame& lhs, const VerticalFrame& rhs, int line_index)
+    {
+        if(VerticalLineColour(lhs, line_index) != VerticalLineColour(rhs, line_index))
+        {
+            return false;
+        }
+
+        const int lhs_karaoke_x = (line_index == lhs.active_line_index) ? lhs.karaoke_x : -1;
+        const int rhs_karaoke_x = (line_index == rhs.active_line_index) ? rhs.karaoke_x : -1;
+        return lhs_karaoke_x == rhs_karaoke_x;
+    }
+
+    void LyricPanel::DrawLyricsVertical(HDC dc, const DisplaySettings& settings, CRect client_area, CRect dirty_area, const VerticalFrame& frame)
+    {
+        const LyricLayout& layout = GetLayout(dc, settings, client_area);
+        const int centre_x = client_area.CenterPoint().x;
+        const auto [first_line, end_line] = visible_lines(layout, frame.top_y, dirty_area.top, dirty_area.bottom);
+        m_runs.clear();
+        position_runs(layout, first_line, end_line, centre_x, frame.top_y + layout.line_tops[first_line], m_runs);
+
+        // NOTE: The karaoke position is measured along the whole line, so we track how far along
+        //       the active line each of its segments starts.
+        int line_offset = 0;
+        size_t previous_line_index = SIZE_MAX;
+        for(const PositionedRun& run : m_runs)
+        {
+            if(run.line_index != previous_line_index)
+            {
+                line_offset = 0;
+                previous_line_index = run.line_index;
+            }
+
+            std::tstring_view text = std::tstring_view(m_lyrics.lines[run.line_index].text).substr(run.start, run.length);
+            bool draw_success = false;
+            if((static_cast<int>(run.line_index) == frame.active_line_index) && (frame.karaoke_x >= 0))
+            {
+                const int highlight_width = frame.karaoke_x - line_offset;
+                draw_success = DrawKaraokeRun(dc, dirty_area, layout.font_ascent, layout.font_descent, run.x, run.y, run.width,
+                                              highlight_width, frame.active_colour, frame.fg_colour, text);
+            }
+            else
+            {
+                SetTextColor(dc, VerticalLineColour(frame, static_cast<int>(run.line_index)));
+                draw_success = DrawRun(dc, dirty_area, layout.font_ascent, layout.font_descent, run.x, run.y, text);
+            }
+            line_offset += run.width;
+            if(!draw_success || layout.measure_failed)
+            {
+                LOG_ERROR("Failed to draw vertically-scrolling text");
+                StopTimer();
+                break;
+            }
+        }
+    }
+
+    void LyricPanel::DrawTimestampedLyricsHorizontal(HDC dc, const DisplaySettings& settings, CRect client_area)
+    {
+        const HorizontalLyricLayout& layout = GetHorizontalLayout(dc, settings);
+        if(layout.measure_failed)
+        {
+            LOG_ERROR("Failed to compute synced text width");
+            StopTimer();
+            return;
+        }
+
+        // NOTE: The drawing call uses the glyph baseline as the origin.
+        //       We want our text to be perfectly vertically centered, so we need to offset it
+        //       but the difference between the baseline and the vertical centre of the font.
+        int baseline_centre_correction = (layout.font_ascent + layout.font_descent)/2;
+
+        service_ptr_t<playback_control> playback = playback_control::get();
+        double current_time = playback->playback_get_position();
+
+        t_ui_color fg_colour = settings.fg_colour;
+        t_ui_color hl_colour = settings.hl_colour;
+
+        // NOTE: Lines are sorted by timestamp, so the active line is the last one that started before the current time
+        const auto first_future_line = std::partition_point(m_lyrics.lines.begin(), m_lyrics.lines.end(),
+                                                            [this, current_time](const LyricDataLine& line)
+                                                            {
+                                                                return current_time > (line.timestamp - m_lyrics.timestamp_offset);
+                                                            });
+        int active_line_index = static_cast<int>(first_future_line - m_lyrics.lines.begin()) - 1;
+        size_t next_line_index = static_cast<size_t>(active_line_index + 1);
+
+        // NOTE: Before the first line is active, we treat the (empty) active line as sitting one glue-width
+        //       to the left of the first line, so that the first line scrolls into place like any other.
+        bool has_active_text = (active_line_index >= 0);
+        int active_line_width = has_active_text ? layout.line_widths[active_line_index] : 0;
+        int active_line_left = has_active_text ? layout.line_lefts[active_line_index] : -layout.glue_width;
+
+        double next_line_time = m_lyrics.LineTimestamp(next_line_index);
+        double scroll_time = settings.scroll_time_seconds;
+        double next_line_scroll_factor = lerp_inverse_clamped(next_line_time - scroll_time, next_line_time, current_time);
+
+        int total_scroll_to_next_line = active_line_width + layout.glue_width;
+        int next_line_scroll = (int)((double)total_scroll_to_next_line * next_line_scroll_factor);
+
+        CPoint centre = client_area.CenterPoint();
+        int centre_y = centre.y + baseline_centre_correction;
+        double active_x_alignment_factor = 0.15;
+        int active_left_x = client_area.left + (int)((double)client_area.Width() * active_x_alignment_factor);
+        int left_x = active_left_x - active_line_left - next_line_scroll;
+
+        const auto [first_line, end_line] = visible_lines_horizontal(layout, left_x, client_area.left, client_area.right);
+        for(size_t line_index=first_line; line_index<end_line; line_index++)
+        {
+            const LyricDataLine& line = m_lyrics.lines[line_index];
+            const int line_width = layout.line_widths[line_index];
+            const int line_centre_x = left_x + layout.line_lefts[line_index] + line_width/2;
+            bool draw_success = false;
+            if((static_cast<int>(line_index) == active_line_index) && !line.words.empty())
+            {
+                const double line_end_time = (next_line_index < m_lyrics.lines.size()) ? m_lyrics.lines[next_line_index].timestamp : DBL_MAX;
+                const int highlight_width = karaoke_position(line, layout.word_positions[line_index], line_width,
+                                                             current_time + m_lyrics.timestamp_offset, line_end_time);
+                draw_success = DrawKaraokeRun(dc, client_area, layout.font_ascent, layout.font_descent, line_centre_x, centre_y, line_width,
+                                              highlight_width, lerp(hl_colour, fg_colour, next_line_scroll_factor), fg_colour, line.text);
+            }
+            else
+            {
+                if(static_cast<int>(line_index) == active_line_index)
+                {
+                    SetTextColor(dc, lerp(hl_colour, fg_colour, next_line_scroll_factor));
+                }
+                else if((line_index == next_line_index) && line.words.empty())
+                {
+                    SetTextColor(dc, lerp(fg_colour, hl_colour, next_line_scroll_factor));
+                }
+                else
+                {
+                    SetTextColor(dc, fg_colour);
+                }
+                draw_success = (DrawTextOut(dc, line_centre_x, centre_y, line.text) != FALSE);
+            }
+
+            if(!draw_success)
+            {
+                LOG_ERROR("Failed to draw horizontally-scrolling synced text");
+                StopTimer();
+                break;
+            }
+        }
+    }
+
+    void LyricPanel::ProcessAvailableLyricUpdates()
+    {
+        for(auto iter=m_update_handles.begin(); iter!=m_update_handles.end(); /*omitted*/)
+        {
+            std::unique_ptr<LyricUpdateHandle>& update = *iter;
+            if(update->has_result())
+            {
+                // NOTE: Processing the update may involve writing to disk or updating tags, which can be slow.
+                //       We don't want to block drawing on that, so it happens in the background and the
+                //       processed lyrics are handed back to us with a message once they're ready.
+                const HWND panel_wnd = m_hWnd;
+                const bool processing = io::process_available_lyric_update_async(*update, [this, panel_wnd, track = update->get_track()](LyricData&& lyrics)
+                {
+                    // The panel may have been closed while the update was being processed
+                    auto panel_iter = std::find(g_active_panels.begin(), g_active_panels.end(), this);
+                    if((panel_iter == g_active_panels.end()) || (m_hWnd != panel_wnd))
+                    {
+                        return;
+                    }
+
+                    m_updates_processing--;
+                    m_processed_lyrics.emplace_back(track, std::move(lyrics));
+                    PostMessage(PANEL_LYRICS_PROCESSED_MSG);
+                });
+                if(processing)
+                {
+                    // NOTE: The callback above always runs later on the main thread, never during the call
+                    m_updates_processing++;
+                }
+            }
+
+            if(update->is_complete())
+            {
+                iter = m_update_handles.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    LRESULT LyricPanel::OnLyricsProcessed(UINT /*msg*/, WPARAM /*wParam*/, LPARAM /*lParam*/)
+    {
+        for(auto& [track, lyrics] : m_processed_lyrics)
+        {
+            if(track == m_now_playing)
+            {
+                SetLyrics(std::move(lyrics));
+                m_auto_search_avoided = false;
+            }
+        }
+        m_processed_lyrics.clear();
+
+        Invalidate();
+        return 0;
+    }
+
+    void LyricPanel::RenderFrame(const DisplaySettings& settings, CRect client_rect)
+    {
+        ProcessAvailableLyricUpdates();
+
+        SelectObject(m_back_buffer, settings.font);
+        COLORREF color_result = SetTextColor(m_back_buffer, settings.fg_colour);
+        if(color_result == CLR_INVALID)
+        {
+            LOG_WARN("Failed to set text colour: %d", GetLastError());
+        }
+
+        m_dirty_rects.clear();
+        const COLORREF bg_colour = settings.bg_colour;
+        if(!m_lyrics.IsEmpty() && (settings.scroll_direction == LineScrollDirection::Vertical))
+        {
+            VerticalFrame frame = {};
+            if(m_lyrics.IsTimestamped() && (settings.scroll_type == LineScrollType::Automatic))
+            {
+                frame = ComputeTimestampedVerticalFrame(m_back_buffer, settings, client_rect);
+            }
+            else
+            {
+                frame = ComputeUntimedVerticalFrame(m_back_buffer, settings, client_rect);
+            }
+
+            // NOTE: Computing the frame updates the layout if required, so the layout key is current here.
+            //       If the only things that changed since the last frame are the scroll position and line colours
+            //       then we shift the existing contents of the back buffer by the scroll distance and only redraw
+            //       the newly-exposed area and the lines whose colour changed.
+            bool reuse_back_buffer = false;
+            if(m_retained_frame.has_value())
+            {
+                const RetainedFrame& retained = m_retained_frame.value();
+                reuse_back_buffer = (retained.layout_key.lyrics_revision == m_layout_key.lyrics_revision) &&
+                                    (retained.layout_key.font == m_layout_key.font) &&
+                                    (retained.layout_key.font_generation == m_layout_key.font_generation) &&
+                                    (retained.layout_key.linegap == m_layout_key.linegap) &&
+                                    (retained.layout_key.width == m_layout_key.width) &&
+                                    (retained.client_area == client_rect) &&
+                                    (retained.bg_colour == bg_colour) &&
+                                    (retained.frame.fg_colour == frame.fg_colour) &&
+                                    (abs(frame.top_y - retained.frame.top_y) < client_rect.Height());
+            }
+
+            if(reuse_back_buffer)
+            {
+                const VerticalFrame& previous = m_retained_frame.value().frame;
+                const int scroll_delta = frame.top_y - previous.top_y;
+                if(scroll_delta != 0)
+                {
+                    ScrollDC(m_back_buffer, 0, scroll_delta, &client_rect, &client_rect, nullptr, nullptr);
+
+                    CRect exposed_rect = client_rect;
+                    if(scroll_delta > 0)
+                    {
+                        exposed_rect.bottom = client_rect.top + scroll_delta;
+                    }
+                    else
+                    {
+                        exposed_rect.top = client_rect.bottom + scroll_delta;
+                    }
+                    m_dirty_rects.push_back(exposed_rect);
+                }
+
+                // NOTE: Only the active line and the one after it are ever drawn in a colour other than the foreground
+                //       (or highlighted word-by-word)
+                const int colour_candidates[] = {previous.active_line_index,
+                                                 previous.active_line_index + 1,
+                                                 frame.active_line_index,
+                                                 frame.active_line_index + 1};
+                for(int line_index : colour_candidates)
+                {
+                    if((line_index < 0) || (line_index >= static_cast<int>(m_layout->lines.size())))
+                    {
+                        continue;
+                    }
+                    if(VerticalLineMatches(previous, frame, line_index))
+                    {
+                        continue;
+                    }
+
+                    CRect line_rect = client_rect;
+                    line_rect.top = frame.top_y + m_layout->line_tops[line_index] - m_layout->font_ascent;
+                    line_rect.bottom = line_rect.top + m_layout->lines[line_index].height;
+                    if(line_rect.IntersectRect(line_rect, client_rect))
+                    {
+                        m_dirty_rects.push_back(line_rect);
+                    }
+                }
+            }
+            else
+            {
+                m_dirty_rects.push_back(client_rect);
+            }
+
+            HBRUSH bg_brush = CreateSolidBrush(bg_colour);
+            for(const CRect& dirty_rect : m_dirty_rects)
+            {
+                // NOTE: Clip to the dirty rect so that lines that only partially overlap it don't
+                //       draw over the (already-correct) parts of the back buffer around it.
+                IntersectClipRect(m_back_buffer, dirty_rect.left, dirty_rect.top, dirty_rect.right, dirty_rect.bottom);
+                FillRect(m_back_buffer, &dirty_rect, bg_brush);
+                DrawLyricsVertical(m_back_buffer, settings, client_rect, dirty_rect, frame);
+                SelectClipRgn(m_back_buffer, nullptr);
+            }
+            DeleteObject(bg_brush);
+
+            m_retained_frame = RetainedFrame{m_layout_key, client_rect, bg_colour, frame};
+        }
+        else
+        {
+            m_retained_frame.reset();
+            m_dirty_rects.push_back(client_rect);
+
+            HBRUSH bg_brush = CreateSolidBrush(bg_colour);
+            FillRect(m_back_buffer, &client_rect, bg_brush);
+            DeleteObject(bg_brush);
+
+            if(m_lyrics.IsEmpty())
+            {
+                DrawNoLyrics(m_back_buffer, settings, client_rect);
+            }
+            else if(m_lyrics.IsTimestamped() &&
+                    (settings.scroll_type == LineScrollType::Automatic))
+            {
+                DrawTimestampedLyricsHorizontal(m_back_buffer, settings, client_rect);
+            }
+            else // We have lyrics, but no timestamps
+            {
+                DrawUntimedLyricsHorizontal(m_back_buffer, settings, client_rect);
+            }
+        }
+    }
+
+    uint64_t LyricPanel::BlitBackBuffer(HDC front_buffer, CRect rect)
+    {
+        BitBlt(front_buffer, rect.left, rect.top,
+                rect.Width(), rect.Height(),
+                m_back_buffer, rect.left, rect.top,
+                SRCCOPY);
+        return uint64_t(rect.Width()) * uint64_t(rect.Height());
+    }
+
+    void LyricPanel::OnPaint(CDCHandle)
+    {
+        pfc::hires_timer paint_timer;
+        paint_timer.start();
+
+        // As suggested in this article: https://docs.microsoft.com/en-us/previous-versions/ms969905(v=msdn.10)
+        // We get flickering if we draw everything to the UI directly, so instead we render everything to a back buffer
+        // and then blit it to the screen at the end.
+        PAINTSTRUCT paintstruct;
+        HDC front_buffer = BeginPaint(&paintstruct);
+
+        CRect client_rect;
+        WIN32_OP_D(GetClientRect(&client_rect))
+        RenderFrame(m_settings, client_rect);
+
+        // NOTE: The entire back buffer is up-to-date after rendering, so we only need to copy the part
+        //       of it that the system asked us to paint.
+        uint64_t pixels_drawn = BlitBackBuffer(front_buffer, paintstruct.rcPaint);
+        EndPaint(&paintstruct);
+
+        ScheduleNextFrame();
+        RecordFrameTime(paint_timer.query(), pixels_drawn, uint64_t(client_rect.Width()) * uint64_t(client_rect.Height()));
+    }
+
+    void LyricPanel::OnContextMenu(CWindow window, CPoint point)
+    {
+        if(m_callback->is_edit_mode_enabled())
+        {
+            // NOTE: When edit-mode is enabled then we want the default behaviour for allowing users
+            //       to change this panel, so we mark the message as unhandled and let foobar's default
+            //       handling take care of it for us.
+            SetMsgHandled(FALSE);
+            return;
+        }
+
+        // handle the context menu key case - center the menu
+        if (point == CPoint(-1, -1))
+        {
+            CRect rc;
+            WIN32_OP(window.GetWindowRect(&rc))
+            point = rc.CenterPoint();
+        }
+
+        try
+        {
+            UINT disabled_without_nowplaying = (m_now_playing == nullptr) ? MF_GRAYED : 0;
+            UINT disabled_without_lyrics = m_lyrics.IsEmpty() ? MF_GRAYED : 0;
+            UINT disabled_with_lyrics = m_lyrics.IsEmpty() ? 0 : MF_GRAYED;
+            enum {
+                ID_SEARCH_LYRICS = 1,
+                ID_SEARCH_LYRICS_MANUAL,
+                ID_SAVE_LYRICS,
+                ID_PREFERENCES,
+                ID_EDIT_LYRICS,
+                ID_OPEN_FILE_DIR,
+                ID_AUTO_ADD_INSTRUMENTAL,
+                ID_AUTO_REMOVE_EXTRA_SPACES,
+                ID_AUTO_REMOVE_EXTRA_BLANK_LINES,
+                ID_AUTO_REMOVE_ALL_BLANK_LINES,
+                ID_AUTO_REPLACE_XML_CHARS,
+                ID_AUTO_RESET_CAPITALISATION,
+                ID_FIX_MALFORMED_TIMESTAMPS,
+                ID_CMD_COUNT,
+            };
+
+            CMenu menu_edit = nullptr;
+            WIN32_OP(menu_edit.CreatePopupMenu())
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_with_lyrics, ID_AUTO_ADD_INSTRUMENTAL, _T("Mark as 'instrumental'"));
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REPLACE_XML_CHARS, _T("Replace &&-named HTML characters"));
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REMOVE_EXTRA_SPACES, _T("Remove repeated spaces"));
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REMOVE_EXTRA_BLANK_LINES, _T("Remove repeated blank lines"));
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_REMOVE_ALL_BLANK_LINES, _T("Remove all blank lines"));
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_AUTO_RESET_CAPITALISATION, _T("Reset capitalisation"));
+            AppendMenu(menu_edit, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_FIX_MALFORMED_TIMESTAMPS, _T("Fix malformed timestamps"));
+
+            CMenu menu = nullptr;
+            WIN32_OP(menu.CreatePopupMenu())
+            AppendMenu(menu, MF_STRING | disabled_without_nowplaying, ID_SEARCH_LYRICS, _T("Search for lyrics"));
+            AppendMenu(menu, MF_STRING | disabled_without_nowplaying, ID_SEARCH_LYRICS_MANUAL, _T("Search for lyrics (manually)"));
+            AppendMenu(menu, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_SAVE_LYRICS, _T("Save lyrics"));
+            AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
+            AppendMenu(menu, MF_STRING | disabled_without_nowplaying, ID_EDIT_LYRICS, _T("Edit lyrics"));
+            AppendMenu(menu, MF_STRING | MF_POPUP, (UINT_PTR)menu_edit.m_hMenu, _T("Auto-edit lyrics"));
+            AppendMenu(menu, MF_STRING | disabled_without_nowplaying | disabled_without_lyrics, ID_OPEN_FILE_DIR, _T("Open file location"));
+            AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
+            AppendMenu(menu, MF_STRING, ID_PREFERENCES, _T("Preferences"));
+            // TODO: Delete lyrics (delete the currently-loaded file, maybe search again). Maybe this button actually belongs in the lyric editor window?
+
+            CMenuDescriptionHybrid menudesc(get_wnd());
+            menudesc.Set(ID_SEARCH_LYRICS, "Start a completely new search for lyrics");
+            menudesc.Set(ID_SEARCH_LYRICS_MANUAL, "Start a new search for lyrics with customisable search terms and multiple results");
+            menudesc.Set(ID_SAVE_LYRICS, "Save the current lyrics, even if they would not be auto-saved");
+            menudesc.Set(ID_PREFERENCES, "Open the OpenLyrics preferences page");
+            menudesc.Set(ID_EDIT_LYRICS, "Open the lyric editor with the current lyrics");
+            menudesc.Set(ID_OPEN_FILE_DIR, "Open explorer to the location of the lyrics file");
+            menudesc.Set(ID_AUTO_ADD_INSTRUMENTAL, "Add lyrics containing just the text '[Instrumental]'");
+            menudesc.Set(ID_AUTO_REPLACE_XML_CHARS, "Replace &-encoded named HTML characters (e.g &lt;) with the characters they represent (e.g <)");
+            menudesc.Set(ID_AUTO_REMOVE_EXTRA_SPACES, "Replace sequences of multiple whitespace characters with a single space");
+            menudesc.Set(ID_AUTO_REMOVE_EXTRA_BLANK_LINES, "Replace sequences of multiple empty lines with just a single empty line");
+            menudesc.Set(ID_AUTO_REMOVE_ALL_BLANK_LINES, "Remove all empty lines");
+            menudesc.Set(ID_AUTO_RESET_CAPITALISATION, "Reset capitalisation of each line so that only the first character is upper case");
+            menudesc.Set(ID_FIX_MALFORMED_TIMESTAMPS, "Fix timestamps that are slightly malformed so that they're recognised as timestamps and not shown in the text");
+
+            std::optional<LyricData> updated_lyrics;
+            int cmd = menu.TrackPopupMenu(TPM_RIGHTBUTTON | TPM_NONOTIFY | TPM_RETURNCMD, point.x, point.y, menudesc, nullptr);
+            switch(cmd)
+            {
+                case ID_SEARCH_LYRICS:
+                {
+                    if(m_now_playing != nullptr)
+                    {
+                        InitiateLyricSearch(m_now_playing, true);
+                    }
+                } break;
+
+                case ID_SEARCH_LYRICS_MANUAL:
+                {
+                    if(m_now_playing != nullptr)
+                    {
+                        LOG_INFO("Initiate manual lyric search");
+                        auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::ManualSearch, m_now_playing, fb2k::noAbort);
+                        SpawnManualLyricSearch(*update);
+                        m_update_handles.push_back(std::move(update));
+                    }
+                } break;
+
+                case ID_SAVE_LYRICS:
+                {
+                    if((m_now_playing == nullptr) || m_lyrics.IsEmpty())
+                    {
+                        LOG_INFO("Attempt to manually save empty lyrics, ignoring...");
+                    }
+                    else
+                    {
+                        try
+                        {
+                            bool allow_overwrite = true;
+                            m_lyrics.persistent_storage_path = io::save_lyrics(m_now_playing, m_lyrics, allow_overwrite, fb2k::noAbort);
+                        }
+                        catch(const std::exception& e)
+                        {
+                            LOG_ERROR("Failed to complete manually requested lyric save: %s", e.what());
+                        }
+                    }
+                } break;
+
+                case ID_PREFERENCES:
+                {
+                    ui_control::get()->show_preferences(GUID_PREFERENCES_PAGE_ROOT);
+                } break;
+
+                case ID_EDIT_LYRICS:
+                {
+                    if(m_now_playing == nullptr) break;
+
+                    auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::Edit, m_now_playing, fb2k::noAbort);
+                    SpawnLyricEditor(m_lyrics, *update);
+                    m_update_handles.push_back(std::move(update));
+                } break;
+
+                case ID_OPEN_FILE_DIR:
+                {
+                    if(m_lyrics.persistent_storage_path.empty())
+                    {
+                        popup_message::g_complain("The selected track does not have any lyrics stored locally");
+                    }
+                    else
+                    {
+                        std::tstring pathstr = to_tstring(m_lyrics.persistent_storage_path);
+
+                        // Truncate the string at the last directory separator to get a directory path
+                        for(size_t i=pathstr.length(); i>0; i--)
+                        {
+                            if(pathstr[i] == _T('\\'))
+                            {
+                                pathstr = pathstr.substr(0, i);
+                                break;
+                            }
+                        }
+
+                        int exec_result = (int)ShellExecute(get_wnd(), _T("explore"), pathstr.c_str(), nullptr, nullptr, SW_SHOWMAXIMIZED);
+                        if(exec_result <= 32)
+                        {
+                            LOG_WARN("Failed to open lyric file directory: %d", exec_result);
+                        }
+                    }
+                } break;
+
+                case ID_AUTO_ADD_INSTRUMENTAL:
+                {
+                    if(m_lyrics.IsEmpty())
+                    {
+                        updated_lyrics = auto_edit::CreateInstrumental(m_lyrics);
+                    }
+                    else
+                    {
+                        LOG_WARN("Current track already has lyrics. It will not be marked as instrumental to avoid overwriting existing lyrics");
+                    }
+
+                } break;
+
+                case ID_AUTO_REMOVE_EXTRA_SPACES:
+                {
+                    updated_lyrics = auto_edit::RemoveRepeatedSpaces(m_lyrics);
+                } break;
+
+                case ID_AUTO_REMOVE_EXTRA_BLANK_LINES:
+                {
+                    updated_lyrics = auto_edit::RemoveRepeatedBlankLines(m_lyrics);
+                } break;
+
+                case ID_AUTO_REMOVE_ALL_BLANK_LINES:
+                {
+                    updated_lyrics = auto_edit::RemoveAllBlankLines(m_lyrics);
+                } break;
+
+                case ID_AUTO_REPLACE_XML_CHARS:
+                {
+                    updated_lyrics = auto_edit::ReplaceHtmlEscapedChars(m_lyrics);
+                } break;
+
+                case ID_AUTO_RESET_CAPITALISATION:
+                {
+                    updated_lyrics = auto_edit::ResetCapitalisation(m_lyrics);
+                } break;
+
+                case ID_FIX_MALFORMED_TIMESTAMPS:
+                {
+                    updated_lyrics = auto_edit::FixMalformedTimestamps(m_lyrics);
+                } break;
+            }
+
+            if(updated_lyrics.has_value())
+            {
+                LyricUpdateHandle update(LyricUpdateHandle::Type::Edit, m_now_playing, fb2k::noAbort);
+                update.set_started();
+                update.set_result(std::move(updated_lyrics.value()), true);
+
+                std::optional<LyricData> maybe_lyrics = io::process_available_lyric_update(update);
+                assert(maybe_lyrics.has_value()); // Round-trip through the processing to avoid copies
+                SetLyrics(std::move(maybe_lyrics.value()));
+                m_auto_search_avoided = false;
+            }
+        }
+        catch(std::exception const & e)
+        {
+            LOG_ERROR("Failed to create OpenLyrics context menu: %s", e.what());
+        }
+    }
+
+    void LyricPanel::OnDoubleClick(UINT /*virtualKeys*/, CPoint /*cursorPos*/)
+    {
+        if(m_now_playing == nullptr) return;
+
+        auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::Edit, m_now_playing, fb2k::noAbort);
+        SpawnLyricEditor(m_lyrics, *update);
+        m_update_handles.push_back(std::move(update));
+    }
+
+    LRESULT LyricPanel::OnMouseWheel(UINT /*virtualKeys*/, short rotation, CPoint /*point*/)
+    {
+        if(m_settings.scroll_type == LineScrollType::Automatic)
+        {
+            return 0;
+        }
+
+        // NOTE: WHEEL_DELTA is defined to be 120
+        // rotation > 0 (usually 120) means we scrolled up
+        // rotation < 0 (usually -120) means we scrolled down
+        double scroll_ticks = double(rotation)/double(WHEEL_DELTA);
+
+        switch(m_settings.scroll_direction)
+        {
+            case LineScrollDirection::Horizontal:
+            {
+                // NOTE: It's not clear how far we should scroll here so we just use the height
+                //       of an empty line as a reasonable first approximation.
+                RECT fake_client_area = {};
+                int one_line_height = ComputeWrappedLyricLineHeight(m_back_buffer, fake_client_area, m_settings.linegap, _T(""));
+                m_manual_scroll_distance += int(scroll_ticks * one_line_height);
+            } break;
+
+            case LineScrollDirection::Vertical:
+            {
+                RECT fake_client_area = {};
+                int one_line_height = ComputeWrappedLyricLineHeight(m_back_buffer, fake_client_area, m_settings.linegap, _T(""));
+                m_manual_scroll_distance += int(scroll_ticks * one_line_height);
+            } break;
+
+            default:
+                LOG_ERROR("Unexpected scroll direction setting: %d", int(m_settings.scroll_direction));
+                assert(false);
+                break;
+        }
+
+        Invalidate();
+        return 0;
+    }
+
+    void LyricPanel::OnMouseMove(UINT /*virtualKeys*/, CPoint point)
+    {
+        if(m_manual_scroll_start.has_value())
+        {
+            int scroll_delta = 0;
+            switch(m_settings.scroll_direction)
+            {
+                case LineScrollDirection::Horizontal:
+                    scroll_delta = point.x - m_manual_scroll_start.value().x;
+                    break;
+
+                case LineScrollDirection::Vertical:
+                    scroll_delta = point.y - m_manual_scroll_start.value().y;
+                    break;
+
+                default:
+                    LOG_ERROR("Unexpected scroll direction setting: %d", int(m_settings.scroll_direction));
+                    assert(false);
+                    break;
+            }
+
+            m_manual_scroll_distance += scroll_delta;
+            m_manual_scroll_start = point;
+            Invalidate();
+        }
+    }
+
+    void LyricPanel::OnLMBDown(UINT /*virtualKeys*/, CPoint point)
+    {
+        if(m_settings.scroll_type == LineScrollType::Manual)
+        {
+            m_manual_scroll_start = point;
+            SetCapture();
+        }
+    }
+
+    void LyricPanel::OnLMBUp(UINT /*virtualKeys*/, CPoint /*point*/)
+    {
+        if(m_manual_scroll_start.has_value())
+        {
+            m_manual_scroll_start.reset();
+            ReleaseCapture();
+        }
+    }
+
+    void LyricPanel::ReloadDisplaySettings()
+    {
+        // NOTE: Other panels will also recompute their layouts in the new generation, but (if their font did not
+        //       actually change) they'll find the layout computed by this panel in the shared cache.
+        g_font_generation++;
+        m_settings.font = get_font();
+        m_settings.fg_colour = get_fg_colour();
+        m_settings.bg_colour = get_bg_colour();
+        m_settings.hl_colour = get_highlight_colour();
+        m_settings.scroll_direction = preferences::display::scroll_direction();
+        m_settings.scroll_type = preferences::display::scroll_type();
+        m_settings.scroll_time_seconds = preferences::display::scroll_time_seconds();
+        m_settings.linegap = preferences::display::linegap();
+    }
+
+    t_ui_font LyricPanel::get_font()
+    {
+        t_ui_font result = preferences::display::font();
+        if(result == nullptr)
+        {
+            result = m_callback->query_font_ex(ui_font_console);
+        }
+        return result;
+    }
+
+    t_ui_color LyricPanel::get_fg_colour()
+    {
+        std::optional<t_ui_color> colour = preferences::display::foreground_colour();
+        if(colour.has_value())
+        {
+            return colour.value();
+        }
+        else
+        {
+            return m_callback->query_std_color(ui_color_text);
+        }
+    }
+
+    t_ui_color LyricPanel::get_bg_colour()
+    {
+        std::optional<t_ui_color> colour = preferences::display::background_colour();
+        if(colour.has_value())
+        {
+            return colour.value();
+        }
+        else
+        {
+            return m_callback->query_std_color(ui_color_background);
+        }
+    }
+
+    t_ui_color LyricPanel::get_highlight_colour()
+    {
+        std::optional<t_ui_color> colour = preferences::display::highlight_colour();
+        if(colour.has_value())
+        {
+            return colour.value();
+        }
+        else
+        {
+            return m_callback->query_std_color(ui_color_highlight);
+        }
+    }
+
+    void LyricPanel::StartTimer()
+    {
+        if (m_timerRunning) return;
+        m_timerRunning = true;
+
+        UINT_PTR result = SetTimer(PANEL_UPDATE_TIMER, 16, nullptr);
+        if (result != PANEL_UPDATE_TIMER)
+        {
+            LOG_WARN("Unexpected timer result when starting playback timer");
+        }
+    }
+
+    void LyricPanel::StopTimer()
+    {
+        if (!m_timerRunning) return;
+        m_timerRunning = false;
+
+        WIN32_OP(KillTimer(PANEL_UPDATE_TIMER))
+    }
+
+    void LyricPanel::ScheduleNextFrame()
+    {
+        if (!m_timerRunning) return;
+
+        // NOTE: We always redraw at least once per second, so that anything that changes the panel
+        //       without us noticing (or that we don't predict) is still reflected reasonably quickly.
+        //       The lower bound is roughly one frame at 60fps, which is what we use while animating.
+        const UINT min_delay_ms = 16;
+        const UINT max_delay_ms = 1000;
+        UINT delay_ms = max_delay_ms;
+
+        std::optional<double> seconds_until_change = ComputeSecondsUntilNextChange();
+        if(seconds_until_change.has_value())
+        {
+            double delay_ms_fractional = ceil(1000.0 * seconds_until_change.value());
+            delay_ms = static_cast<UINT>(max(double(min_delay_ms), min(double(max_delay_ms), delay_ms_fractional)));
+        }
+
+        // NOTE: Calling SetTimer with the ID of an existing timer replaces that timer
+        UINT_PTR result = SetTimer(PANEL_UPDATE_TIMER, delay_ms, nullptr);
+        if (result != PANEL_UPDATE_TIMER)
+        {
+            LOG_WARN("Unexpected timer result when scheduling the next panel frame");
+        }
+    }
+
+    std::optional<double> LyricPanel::ComputeSecondsUntilNextChange()
+    {
+        if(!m_update_handles.empty())
+        {
+            // We need to poll for the results of the update and the progress text may change
+            return 0.1;
+        }
+
+        if(m_lyrics.IsEmpty())
+        {
+            if(m_auto_search_avoided)
+            {
+                const double search_avoided_msg_seconds = 15.0;
+                uint64_t ticks_since_search_avoided = filetimestamp_from_system_timer() - m_auto_search_avoided_timestamp;
+                double seconds_since_search_avoided = double(ticks_since_search_avoided) / 10'000'000.0; // A "tick" here means "100-nanoseconds"
+                if(seconds_since_search_avoided < search_avoided_msg_seconds)
+                {
+                    return search_avoided_msg_seconds - seconds_since_search_avoided;
+                }
+            }
+            return {};
+        }
+
+        if(m_settings.scroll_type == LineScrollType::Manual)
+        {
+            // Manually-scrolled lyrics only move in response to input, which redraws the panel itself
+            return {};
+        }
+
+        service_ptr_t<playback_control> playback = playback_control::get();
+        double current_time = playback->playback_get_position();
+        if(m_lyrics.IsTimestamped())
+        {
+            // NOTE: The panel only changes while scrolling to the next line, which happens during the
+            //       `scroll_time` seconds before that line's timestamp. Outside of that we can sleep
+            //       until the next scroll starts.
+            const auto first_future_line = std::partition_point(m_lyrics.lines.begin(), m_lyrics.lines.end(),
+                                                                [this, current_time](const LyricDataLine& line)
+                                                                {
+                                                                    return current_time > (line.timestamp - m_lyrics.timestamp_offset);
+                                                                });
+            // NOTE: The highlight on a line with per-word timestamps moves continuously until its last word ends
+            if(first_future_line != m_lyrics.lines.begin())
+            {
+                const LyricDataLine& active_line = *(first_future_line - 1);
+                const double line_end_time = (first_future_line == m_lyrics.lines.end()) ? DBL_MAX : first_future_line->timestamp;
+                if(!active_line.words.empty() && (current_time + m_lyrics.timestamp_offset < karaoke_end_time(active_line, line_end_time)))
+                {
+                    return 0.0;
+                }
+            }
+
+            if(first_future_line == m_lyrics.lines.end())
+            {
+                return {};
+            }
+
+            double next_line_time = first_future_line->timestamp - m_lyrics.timestamp_offset;
+            double scroll_start_time = next_line_time - m_settings.scroll_time_seconds;
+            return max(0.0, scroll_start_time - current_time);
+        }
+        else
+        {
+            // NOTE: Untimed lyrics scroll smoothly through the whole track, so we wait just long enough
+            //       for them to move by a single pixel. These layouts are kept up-to-date by painting.
+            double total_length = playback->playback_get_length_ex();
+            int total_size = 0;
+            switch(m_settings.scroll_direction)
+            {
+                case LineScrollDirection::Vertical: total_size = (m_layout != nullptr) ? m_layout->total_height : 0; break;
+                case LineScrollDirection::Horizontal: total_size = (m_horizontal_layout != nullptr) ? m_horizontal_layout->total_width : 0; break;
+                default: break;
+            }
+
+            if((total_size <= 0) || (total_length <= 0.0))
+            {
+                return {};
+            }
+            return total_length / double(total_size);
+        }
+    }
+
+    void LyricPanel::InitiateLyricSearch(metadb_handle_ptr track, bool ignore_search_avoidance)
+    {
+        LOG_INFO("Initiate lyric search");
+        SetLyrics({});
+        m_auto_search_avoided = false;
+
+        auto update = std::make_unique<LyricUpdateHandle>(LyricUpdateHandle::Type::AutoSearch, track, fb2k::noAbort);
+        io::search_for_lyrics(*update, false, ignore_search_avoidance);
+        m_update_handles.push_back(std::move(update));
+    }
+
+    // ui_element_impl_withpopup autogenerates standalone version of our component and proper menu commands. Use ui_element_impl instead if you don't want that.
+    class LyricPanelImpl : public ui_element_impl_withpopup<LyricPanel> {};
+    FB2K_SERVICE_FACTORY(LyricPanelImpl)
+    UIE_SHIM_PANEL_FACTORY(LyricPanel)
+
+} // namespace
+
+void reload_all_lyric_panel_settings()
+{
+    // NOTE: This is called synchronously (rather than deferred to the main thread like a repaint) because the old
+    //       font may already have been deleted and we don't want any panel to draw with it in the meantime.
+    core_api::ensure_main_thread();
+    for(LyricPanel* panel : g_active_panels)
+    {
+        assert(panel != nullptr);
+        panel->on_display_settings_changed();
+    }
+}
+
+void repaint_all_lyric_panels()
+{
+    fb2k::inMainThread2([]()
+    {
+        core_api::ensure_main_thread();
+        for(LyricPanel* panel : g_active_panels)
+        {
+            assert(panel != nullptr);
+            InvalidateRect(panel->get_wnd(), nullptr, TRUE);
+        }
+    });
+}
+
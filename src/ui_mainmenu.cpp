@@ -0,0 +1,79 @@
+#include "stdafx.h"
+
+#include "bulk_search.h"
+#include "ui_hooks.h"
+
+class OpenLyricsMainMenuCommands : public mainmenu_commands
+{
+public:
+    t_uint32 get_command_count() override { return cmd_total; }
+    GUID get_parent() override { return mainmenu_groups::library; }
+
+    GUID get_command(t_uint32 index) override
+    {
+        static const GUID GUID_CMD_RESUME_BULK_SEARCH = { 0x7aaff6ba, 0x9ca, 0x4df2, { 0xb7, 0x7a, 0xb, 0xce, 0xf9, 0x85, 0x18, 0x6d } };
+
+        switch(index)
+        {
+            case cmd_resume_bulk_search: return GUID_CMD_RESUME_BULK_SEARCH;
+            default: uBugCheck();
+        }
+    }
+
+    void get_name(t_uint32 index, pfc::string_base& out) override
+    {
+        switch(index)
+        {
+            case cmd_resume_bulk_search: out = "Resume interrupted lyric search"; break;
+            default: uBugCheck();
+        }
+    }
+
+    bool get_description(t_uint32 index, pfc::string_base& out) override
+    {
+        switch(index)
+        {
+            case cmd_resume_bulk_search:
+                out = "Continue the last bulk lyric search from where it stopped, searching only the tracks that it had not yet finished";
+                return true;
+            default:
+                uBugCheck();
+        }
+    }
+
+    bool get_display(t_uint32 index, pfc::string_base& text, t_uint32& flags) override
+    {
+        get_name(index, text);
+        flags = 0;
+        switch(index)
+        {
+            case cmd_resume_bulk_search:
+                if(!BulkSearchJournal::persistent_exists())
+                {
+                    flags = flag_disabled;
+                }
+                break;
+            default:
+                uBugCheck();
+        }
+        return true;
+    }
+
+    void execute(t_uint32 index, service_ptr_t<service_base> /*callback*/) override
+    {
+        switch(index)
+        {
+            case cmd_resume_bulk_search: SpawnResumedBulkLyricSearch(); break;
+            default: uBugCheck();
+        }
+    }
+
+private:
+    enum
+    {
+        cmd_resume_bulk_search = 0,
+        cmd_total
+    };
+};
+
+static mainmenu_commands_factory_t<OpenLyricsMainMenuCommands> g_mainmenu_commands_factory;
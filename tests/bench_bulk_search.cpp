@@ -0,0 +1,108 @@
+#include <cstdio>
+#include <thread>
+
+#include "bulk_search_schedule.h"
+
+#include "bench_framework.h"
+
+// Runs a bulk search job headlessly in the same way as BulkSearchEngine (which starts searches from the schedule and
+// collects those that have completed each time it is polled), but with each search replaced by a simulated one that
+// completes after a fixed latency. Measures the throughput of the job for various numbers of concurrent searches,
+// along with how well the schedule's throughput and remaining-time estimates match what actually happened.
+BENCHMARK(bulk_search_schedule_throughput)
+{
+    const size_t track_count = 60;
+    const std::chrono::milliseconds poll_interval(2);
+    const size_t concurrencies[] = {1, 2, 4, 8, 16};
+
+    // Every tenth track was already found by an earlier (interrupted) run of the job, so it is not searched again
+    std::vector<BulkSearchTrackState> initial_states(track_count, BulkSearchTrackState::Pending);
+    size_t tracks_to_search = 0;
+    for(size_t i=0; i<track_count; i++)
+    {
+        if(i % 10 == 5)
+        {
+            initial_states[i] = BulkSearchTrackState::Found;
+        }
+        else
+        {
+            tracks_to_search++;
+        }
+    }
+
+    // Searches take between 20ms and 60ms, and end in a mix of outcomes
+    const auto search_latency = [](size_t track_index) { return std::chrono::milliseconds(20 + (track_index*17) % 41); };
+    const auto search_result = [](size_t track_index)
+    {
+        if(track_index % 10 == 0) return BulkSearchTrackState::Error;
+        if(track_index % 3 == 0) return BulkSearchTrackState::NotFound;
+        return BulkSearchTrackState::Found;
+    };
+
+    std::printf("%zu tracks (%zu to search), simulated search latency of 20-60ms\n", track_count, tracks_to_search);
+    std::printf("%12s %10s %14s %14s %14s %14s\n", "concurrency", "time (s)", "tracks/min", "reported/min", "eta at 50% (s)", "actual (s)");
+    for(size_t concurrency : concurrencies)
+    {
+        struct SimulatedSearch
+        {
+            size_t track_index;
+            std::chrono::steady_clock::time_point completion_time;
+        };
+
+        BulkSearchSchedule schedule(initial_states, concurrency);
+        std::vector<SimulatedSearch> in_progress;
+        size_t searched = 0;
+        std::optional<double> halfway_eta;
+        double halfway_seconds = 0.0;
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto seconds_since_start = [&start]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+        while(!schedule.is_complete())
+        {
+            const auto now = std::chrono::steady_clock::now();
+            for(auto iter=in_progress.begin(); iter!=in_progress.end(); /*omitted*/)
+            {
+                if(iter->completion_time > now)
+                {
+                    iter++;
+                    continue;
+                }
+                schedule.finish(search_result(iter->track_index));
+                searched++;
+                iter = in_progress.erase(iter);
+            }
+
+            if(!halfway_eta.has_value() && (searched >= tracks_to_search/2))
+            {
+                halfway_seconds = seconds_since_start();
+                halfway_eta = schedule.estimated_seconds_remaining(halfway_seconds);
+            }
+
+            while(true)
+            {
+                const std::optional<size_t> index = schedule.start_next(seconds_since_start());
+                if(!index.has_value())
+                {
+                    break;
+                }
+                in_progress.push_back({index.value(), std::chrono::steady_clock::now() + search_latency(index.value())});
+            }
+            std::this_thread::sleep_for(poll_interval);
+        }
+        const double total_seconds = seconds_since_start();
+
+        if((searched != tracks_to_search) || (schedule.completed_count() != track_count) || !halfway_eta.has_value())
+        {
+            std::printf("The job with %zu concurrent searches searched %zu of %zu tracks\n", concurrency, searched, tracks_to_search);
+            return false;
+        }
+        std::printf("%12zu %10.2f %14.1f %14.1f %14.2f %14.2f\n",
+                    concurrency,
+                    total_seconds,
+                    double(tracks_to_search) / (total_seconds / 60.0),
+                    schedule.tracks_per_minute(total_seconds),
+                    halfway_eta.value(),
+                    total_seconds - halfway_seconds);
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// A minimal benchmark runner, like the test runner in test_framework.h. Benchmarks are registered with BENCHMARK()
+// and print their own results. They return false if they could not measure what they set out to (for example
+// because the code being measured produced the wrong results).
+struct BenchmarkCase
+{
+    const char* name;
+    bool (*run)();
+};
+
+std::vector<BenchmarkCase>& registered_benchmarks();
+
+struct BenchmarkRegistration
+{
+    BenchmarkRegistration(const char* name, bool (*run)())
+    {
+        registered_benchmarks().push_back({name, run});
+    }
+};
+
+#define BENCHMARK(name) \
+    static bool name(); \
+    static const BenchmarkRegistration name##_registration(#name, name); \
+    static bool name()
+
+// Returns the average time (in microseconds) taken by a single call to `func`, over the given number of calls
+template<typename TFunc>
+double average_microseconds(int iterations, TFunc func)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++)
+    {
+        func();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / double(iterations);
+}
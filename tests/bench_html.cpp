@@ -0,0 +1,331 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+#include "libxml/HTMLparser.h"
+#include "libxml/xpath.h"
+
+#include "sources/scraper_program.h"
+
+#include "bench_framework.h"
+
+// Compares the streaming scraper (running the same programs as the built-in scraper rules) with building a libxml2
+// DOM of the whole page and querying it with XPath (as the AZLyrics, Genius and DarkLyrics sources did before the
+// scraper rules), on generated pages that are laid out like those of each site.
+// Peak memory is the most that libxml2 had allocated at once during the parse. Neither side counts the memory used
+// for the lyric text itself, which is the same for both.
+static size_t g_libxml_current_bytes = 0;
+static size_t g_libxml_peak_bytes = 0;
+static std::unordered_map<void*, size_t>* g_libxml_allocations = nullptr; // Only set while measuring
+
+static void* tracked_malloc(size_t size)
+{
+    void* ptr = std::malloc(size);
+    if((ptr != nullptr) && (g_libxml_allocations != nullptr))
+    {
+        (*g_libxml_allocations)[ptr] = size;
+        g_libxml_current_bytes += size;
+        g_libxml_peak_bytes = (std::max)(g_libxml_peak_bytes, g_libxml_current_bytes);
+    }
+    return ptr;
+}
+
+static void tracked_free(void* ptr)
+{
+    // NOTE: Allocations made while we were not measuring are not in the map, and are freed without being counted
+    if((ptr != nullptr) && (g_libxml_allocations != nullptr))
+    {
+        const auto iter = g_libxml_allocations->find(ptr);
+        if(iter != g_libxml_allocations->end())
+        {
+            g_libxml_current_bytes -= iter->second;
+            g_libxml_allocations->erase(iter);
+        }
+    }
+    std::free(ptr);
+}
+
+static void* tracked_realloc(void* ptr, size_t size)
+{
+    size_t old_size = 0;
+    bool was_tracked = false;
+    if((ptr != nullptr) && (g_libxml_allocations != nullptr))
+    {
+        const auto iter = g_libxml_allocations->find(ptr);
+        if(iter != g_libxml_allocations->end())
+        {
+            old_size = iter->second;
+            was_tracked = true;
+            g_libxml_allocations->erase(iter);
+        }
+    }
+
+    void* new_ptr = std::realloc(ptr, size);
+    if(new_ptr == nullptr)
+    {
+        if(was_tracked)
+        {
+            (*g_libxml_allocations)[ptr] = old_size;
+        }
+        return nullptr;
+    }
+
+    if(g_libxml_allocations != nullptr)
+    {
+        (*g_libxml_allocations)[new_ptr] = size;
+        g_libxml_current_bytes = g_libxml_current_bytes - old_size + size;
+        g_libxml_peak_bytes = (std::max)(g_libxml_peak_bytes, g_libxml_current_bytes);
+    }
+    return new_ptr;
+}
+
+static char* tracked_strdup(const char* str)
+{
+    const size_t length = std::strlen(str);
+    char* copy = static_cast<char*>(tracked_malloc(length + 1));
+    if(copy != nullptr)
+    {
+        std::memcpy(copy, str, length + 1);
+    }
+    return copy;
+}
+
+// Returns the peak number of bytes that libxml2 had allocated at once while running `func`
+template<typename TFunc>
+static size_t libxml_peak_bytes(TFunc func)
+{
+    std::unordered_map<void*, size_t> allocations;
+    g_libxml_allocations = &allocations;
+    g_libxml_current_bytes = 0;
+    g_libxml_peak_bytes = 0;
+    func();
+    g_libxml_allocations = nullptr;
+    return g_libxml_peak_bytes;
+}
+
+static std::string make_filler_markup(size_t bytes)
+{
+    std::string markup;
+    for(int i=0; markup.length() < bytes; i++)
+    {
+        markup += "<div class=\"related\"><a href=\"/lyrics/other/song" + std::to_string(i) + ".html\">Another song " + std::to_string(i) +
+                  "</a><span class=\"info\">Some more information about this song</span></div>\n";
+    }
+    return markup;
+}
+
+static std::string make_filler_script(size_t bytes)
+{
+    std::string script = "<script>window.__PRELOADED_STATE__ = JSON.parse('{";
+    for(int i=0; script.length() < bytes; i++)
+    {
+        script += "\\\"key" + std::to_string(i) + "\\\":{\\\"value\\\":\\\"<b>not markup</b>\\\",\\\"count\\\":" + std::to_string(i) + "},";
+    }
+    script += "}');</script>\n";
+    return script;
+}
+
+static std::string make_lyric_lines(size_t line_count, const char* separator)
+{
+    std::string lines;
+    for(size_t i=0; i<line_count; i++)
+    {
+        lines += "This is line number " + std::to_string(i) + " of the song, with some words in it" + separator + "\n";
+    }
+    return lines;
+}
+
+struct ScrapeComparison
+{
+    const char* name;
+    std::string page;
+    ScraperProgram program;
+    SectionTitleMatcher section_matches;
+    std::function<std::string(htmlDocPtr)> dom_scrape;
+};
+
+static ContentRule make_content(std::vector<SelectorStep>& steps, const char* selector, TextPolicy text_policy, bool match_all = false)
+{
+    ContentRule rule = {};
+    rule.selector = compile_selector(selector, steps);
+    rule.text_policy = text_policy;
+    rule.match_all = match_all;
+    rule.section_header = -1;
+    rule.section_end = -1;
+    return rule;
+}
+
+// Returns the text of every node matched by the given XPath expression, one line per text node
+static std::string xpath_text(htmlDocPtr doc, const char* expression, bool direct_text_only)
+{
+    std::string output;
+    xmlXPathContextPtr context = xmlXPathNewContext(doc);
+    xmlXPathObjectPtr result = xmlXPathEvalExpression(reinterpret_cast<const xmlChar*>(expression), context);
+    if((result != nullptr) && (result->nodesetval != nullptr))
+    {
+        for(int i=0; i<result->nodesetval->nodeNr; i++)
+        {
+            std::function<void(xmlNodePtr)> append_text = [&](xmlNodePtr node)
+            {
+                for(xmlNodePtr child = node->children; child != nullptr; child = child->next)
+                {
+                    if(child->type == XML_TEXT_NODE)
+                    {
+                        output += reinterpret_cast<const char*>(child->content);
+                        output += "\r\n";
+                    }
+                    else if(!direct_text_only && (child->type == XML_ELEMENT_NODE))
+                    {
+                        append_text(child);
+                    }
+                }
+            };
+            append_text(result->nodesetval->nodeTab[i]);
+        }
+    }
+    xmlXPathFreeObject(result);
+    xmlXPathFreeContext(context);
+    return output;
+}
+
+static std::vector<ScrapeComparison> make_comparisons()
+{
+    std::vector<ScrapeComparison> comparisons;
+
+    // AZLyrics pages have the lyrics in an unclassed div after the heading, with lots of other content around them
+    {
+        ScrapeComparison azlyrics = {};
+        azlyrics.name = "AZLyrics";
+        azlyrics.page = "<html><head><title>Artist - Title Lyrics</title>" + make_filler_script(20*1024) + "</head><body>" +
+                        make_filler_markup(15*1024) +
+                        "<div class=\"lyricsh\"><h2><b>Artist Lyrics</b></h2></div><div class=\"ringtone\">Ringtone</div>"
+                        "<div><!-- Usage of azlyrics.com content by any third-party lyrics provider is prohibited -->\n" +
+                        make_lyric_lines(60, "<br>") + "</div>" + make_filler_markup(40*1024) + "</body></html>";
+        azlyrics.program.content.push_back(make_content(azlyrics.program.steps, "div.lyricsh ~ div:not([class])", TextPolicy::DirectText));
+        azlyrics.dom_scrape = [](htmlDocPtr doc) { return xpath_text(doc, "//div[@class='lyricsh']/following-sibling::div[not(@class)][1]", true); };
+        comparisons.push_back(std::move(azlyrics));
+    }
+
+    // Genius pages split the lyrics across several containers, followed by a very large script with the page state.
+    // NOTE: The scraper has to read the whole page, since any part of it could have another container.
+    {
+        ScrapeComparison genius = {};
+        genius.name = "Genius";
+        genius.page = "<html><head><title>Artist - Title Lyrics | Genius Lyrics</title>" + make_filler_script(30*1024) + "</head><body>" +
+                      make_filler_markup(30*1024);
+        for(int i=0; i<3; i++)
+        {
+            genius.page += "<div data-lyrics-container=\"true\" class=\"Lyrics__Container-sc-1ynbvzw-1 kUgSbL\">" + make_lyric_lines(20, "<br/>") + "</div>";
+            genius.page += "<div class=\"RightSidebar__Container-pajcl2-0\">" + make_filler_markup(2*1024) + "</div>";
+        }
+        genius.page += make_filler_markup(60*1024) + make_filler_script(400*1024) + "</body></html>";
+        genius.program.content.push_back(make_content(genius.program.steps, "div.lyrics", TextPolicy::AllText));
+        genius.program.content.push_back(make_content(genius.program.steps, "div[class*=Lyrics__Container]", TextPolicy::AllText, true));
+        genius.dom_scrape = [](htmlDocPtr doc) { return xpath_text(doc, "//div[contains(@class, 'Lyrics__Container')]", false); };
+        comparisons.push_back(std::move(genius));
+    }
+
+    // DarkLyrics pages have the lyrics for a whole album, one section per track. We look for the third track.
+    {
+        ScrapeComparison darklyrics = {};
+        darklyrics.name = "DarkLyrics";
+        darklyrics.page = "<html><head><title>Artist - Album lyrics</title></head><body>" + make_filler_markup(10*1024) + "<div class=\"lyrics\">";
+        for(int track=1; track<=12; track++)
+        {
+            darklyrics.page += "<h3><a name=\"" + std::to_string(track) + "\">" + std::to_string(track) + ". Track " + std::to_string(track) + "</a></h3><br />\n" +
+                               make_lyric_lines(40, "<br />");
+        }
+        darklyrics.page += "<div class=\"thanks\">Thanks to someone for sending these lyrics</div></div>" + make_filler_markup(10*1024) + "</body></html>";
+
+        ContentRule rule = make_content(darklyrics.program.steps, "div.lyrics", TextPolicy::Sections);
+        rule.section_header = compile_selector("div.lyrics > h3", darklyrics.program.steps);
+        rule.section_end = compile_selector("div.lyrics div", darklyrics.program.steps);
+        rule.section_title_after = ".";
+        darklyrics.program.content.push_back(rule);
+        darklyrics.section_matches = [](std::string_view title) { return title == "Track 3"; };
+        darklyrics.dom_scrape = [](htmlDocPtr doc)
+        {
+            // The lyrics are the text nodes between the heading for the track and the next heading (or the credits)
+            std::string lyrics;
+            xmlXPathContextPtr context = xmlXPathNewContext(doc);
+            xmlXPathObjectPtr result = xmlXPathEvalExpression(reinterpret_cast<const xmlChar*>("//div[@class='lyrics']/h3[a/@name='3']"), context);
+            if((result != nullptr) && (result->nodesetval != nullptr) && (result->nodesetval->nodeNr > 0))
+            {
+                for(xmlNodePtr node = result->nodesetval->nodeTab[0]->next; node != nullptr; node = node->next)
+                {
+                    if((node->type == XML_ELEMENT_NODE) && ((xmlStrcmp(node->name, BAD_CAST "h3") == 0) || (xmlStrcmp(node->name, BAD_CAST "div") == 0)))
+                    {
+                        break;
+                    }
+                    if(node->type == XML_TEXT_NODE)
+                    {
+                        lyrics += reinterpret_cast<const char*>(node->content);
+                        lyrics += "\r\n";
+                    }
+                }
+            }
+            xmlXPathFreeObject(result);
+            xmlXPathFreeContext(context);
+            return lyrics;
+        };
+        comparisons.push_back(std::move(darklyrics));
+    }
+
+    return comparisons;
+}
+
+static std::string dom_scrape_page(const ScrapeComparison& comparison)
+{
+    htmlDocPtr doc = htmlReadMemory(comparison.page.data(), int(comparison.page.length()), "https://example.com", nullptr,
+                                    HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+    if(doc == nullptr)
+    {
+        return {};
+    }
+    std::string lyrics = comparison.dom_scrape(doc);
+    xmlFreeDoc(doc);
+    return lyrics;
+}
+
+BENCHMARK(html_streaming_scraper_vs_dom)
+{
+    xmlMemSetup(tracked_free, tracked_malloc, tracked_realloc, tracked_strdup);
+    xmlInitParser();
+
+    const int iterations = 50;
+    std::printf("%-12s %10s %12s %12s %8s %14s %14s\n", "page", "bytes", "DOM (us)", "stream (us)", "speedup", "DOM peak (KB)", "stream peak (KB)");
+    for(const ScrapeComparison& comparison : make_comparisons())
+    {
+        std::optional<std::string> stream_lyrics;
+        const double stream_us = average_microseconds(iterations, [&]()
+        {
+            stream_lyrics = scrape_lyrics(comparison.program, comparison.page, "https://example.com", comparison.section_matches);
+        });
+
+        std::string dom_lyrics;
+        const double dom_us = average_microseconds(iterations, [&]()
+        {
+            dom_lyrics = dom_scrape_page(comparison);
+        });
+
+        // NOTE: Every page has at least 20 lines of lyrics
+        const auto has_lyrics = [](std::string_view lyrics)
+        {
+            return (lyrics.find("line number 0 ") != std::string_view::npos) && (lyrics.find("line number 19 ") != std::string_view::npos);
+        };
+        if(!stream_lyrics.has_value() || !has_lyrics(stream_lyrics.value()) || !has_lyrics(dom_lyrics))
+        {
+            std::printf("The lyrics were not found on the %s page\n", comparison.name);
+            return false;
+        }
+
+        const size_t stream_peak = libxml_peak_bytes([&]() { scrape_lyrics(comparison.program, comparison.page, "https://example.com", comparison.section_matches); });
+        const size_t dom_peak = libxml_peak_bytes([&]() { dom_scrape_page(comparison); });
+        std::printf("%-12s %10zu %12.1f %12.1f %7.1fx %14.1f %14.1f\n", comparison.name, comparison.page.length(), dom_us, stream_us, dom_us / stream_us,
+                    double(dom_peak) / 1024.0, double(stream_peak) / 1024.0);
+    }
+
+    xmlCleanupParser();
+    return true;
+}
@@ -0,0 +1,45 @@
+#include <cstdio>
+
+#include "parsers/json.h"
+
+#include "bench_framework.h"
+#include "json_test_data.h"
+
+// Compares the time taken to read the tracks from Musixmatch search responses of various sizes with
+// parsers::json::extract_records and with a cJSON DOM (as the sources did before the streaming extractor).
+BENCHMARK(json_extract_records_vs_cjson)
+{
+    const size_t track_counts[] = {5, 20, 100};
+    std::printf("%8s %10s %14s %14s %8s\n", "tracks", "bytes", "cJSON (us)", "extract (us)", "speedup");
+    for(size_t track_count : track_counts)
+    {
+        const std::string response = make_musixmatch_search_response(track_count);
+        const int iterations = int(20000 / track_count);
+
+        size_t cjson_tracks = 0;
+        const double cjson_us = average_microseconds(iterations, [&]()
+        {
+            cjson_tracks = read_musixmatch_tracks_with_cjson(response).size();
+        });
+
+        size_t extracted_tracks = 0;
+        const double extract_us = average_microseconds(iterations, [&]()
+        {
+            extracted_tracks = 0;
+            parsers::json::extract_records(response, "message.body.track_list[]", MUSIXMATCH_FIELDS,
+                [&extracted_tracks](const parsers::json::RecordFields& fields)
+                {
+                    extracted_tracks += fields[0].has_value() ? 1 : 0;
+                    return true;
+                });
+        });
+
+        if((cjson_tracks != track_count) || (extracted_tracks != track_count))
+        {
+            std::printf("Expected %zu tracks but cJSON read %zu and the extractor read %zu\n", track_count, cjson_tracks, extracted_tracks);
+            return false;
+        }
+        std::printf("%8zu %10zu %14.1f %14.1f %7.1fx\n", track_count, response.length(), cjson_us, extract_us, cjson_us / extract_us);
+    }
+    return true;
+}
@@ -0,0 +1,180 @@
+#include <cstdio>
+
+#include "lyric_layout.h"
+
+#include "bench_framework.h"
+
+static const int CHAR_ADVANCE = 8;
+static const int ASCENT = 13;
+static const int DESCENT = 4;
+static const int LINEGAP = 4;
+
+// Counts the text that the layout engine measures, since with a real font (e.g through GDI) measuring the text
+// costs far more than anything else that the layout does.
+class CountingTextMetrics : public FixedAdvanceTextMetrics
+{
+public:
+    CountingTextMetrics() : FixedAdvanceTextMetrics(CHAR_ADVANCE, ASCENT, DESCENT) {}
+
+    std::optional<int> measure(std::wstring_view text) override
+    {
+        measure_calls++;
+        return FixedAdvanceTextMetrics::measure(text);
+    }
+
+    size_t measure_calls = 0;
+};
+
+// Generates lyrics with words of varied lengths and lines of varied word counts. Every fourth line has
+// per-word timestamps, as with "enhanced" LRC lyrics.
+static std::vector<LyricDataLine> make_lyric_lines(size_t line_count)
+{
+    uint32_t state = 12345;
+    const auto next_random = [&state](uint32_t bound)
+    {
+        state = state*1103515245 + 12345;
+        return (state >> 16) % bound;
+    };
+
+    std::vector<LyricDataLine> lines;
+    lines.reserve(line_count);
+    for(size_t i=0; i<line_count; i++)
+    {
+        LyricDataLine line = {};
+        line.timestamp = double(i) * 2.5;
+        const bool enhanced = (i % 4 == 0);
+
+        const uint32_t word_count = 2 + next_random(12);
+        for(uint32_t word=0; word<word_count; word++)
+        {
+            if(word > 0)
+            {
+                line.text += L' ';
+            }
+            if(enhanced)
+            {
+                line.words.push_back({line.text.length(), line.timestamp + word*0.2});
+            }
+            line.text.append(1 + next_random(9), wchar_t(L'a' + next_random(26)));
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+// Lays out lyrics of various lengths at a narrow width (where most lines wrap) and at a wide one
+// (where few do), for both the vertical and horizontal layouts.
+BENCHMARK(layout_lyrics_thousands_of_lines)
+{
+    const size_t line_counts[] = {1000, 5000, 20000};
+    const int widths[] = {240, 960};
+    std::printf("%8s %8s %12s %12s %14s %14s\n", "lines", "width", "segments", "measures", "layout (ms)", "lines/ms");
+    for(size_t line_count : line_counts)
+    {
+        const std::vector<LyricDataLine> lines = make_lyric_lines(line_count);
+        const int iterations = int(100000 / line_count);
+        for(int width : widths)
+        {
+            CountingTextMetrics metrics;
+            LyricLayout layout = {};
+            const double layout_us = average_microseconds(iterations, [&]() { layout = layout_lyrics(metrics, width, LINEGAP, lines); });
+            if(layout.measure_failed || (layout.lines.size() != line_count))
+            {
+                std::printf("The layout of %zu lines did not succeed\n", line_count);
+                return false;
+            }
+
+            size_t segments = 0;
+            for(const LayoutLine& line : layout.lines)
+            {
+                segments += line.segments.size();
+            }
+            std::printf("%8zu %8d %12zu %12zu %14.3f %14.1f\n", line_count, width, segments, metrics.measure_calls / size_t(iterations), layout_us / 1000.0, double(line_count) / (layout_us / 1000.0));
+        }
+
+        CountingTextMetrics metrics;
+        HorizontalLyricLayout horizontal = {};
+        const double horizontal_us = average_microseconds(iterations, [&]() { horizontal = layout_lyrics_horizontal(metrics, 4, lines); });
+        if(horizontal.measure_failed || (horizontal.line_widths.size() != line_count))
+        {
+            std::printf("The horizontal layout of %zu lines did not succeed\n", line_count);
+            return false;
+        }
+        std::printf("%8zu %8s %12zu %12zu %14.3f %14.1f\n", line_count, "horiz", line_count, metrics.measure_calls / size_t(iterations), horizontal_us / 1000.0, double(line_count) / (horizontal_us / 1000.0));
+    }
+    return true;
+}
+
+// Measures the per-frame cost of drawing a panel that is scrolling through a long layout: finding the visible lines
+// and positioning their segments. This does not depend on the length of the lyrics, only on the size of the panel.
+BENCHMARK(layout_scroll_frames)
+{
+    const int panel_width = 400;
+    const int panel_height = 600;
+    const size_t line_counts[] = {1000, 20000};
+    std::printf("%8s %12s %14s %14s\n", "lines", "frames", "runs/frame", "frame (us)");
+    for(size_t line_count : line_counts)
+    {
+        CountingTextMetrics metrics;
+        const LyricLayout layout = layout_lyrics(metrics, panel_width, LINEGAP, make_lyric_lines(line_count));
+
+        // Scroll from the first line to the last, one frame at a time
+        const int frame_count = 10000;
+        const int scroll_per_frame = (std::max)(layout.total_height / frame_count, 1);
+        std::vector<PositionedRun> runs;
+        size_t total_runs = 0;
+        int frame = 0;
+        const double frame_us = average_microseconds(frame_count, [&]()
+        {
+            const int first_baseline_y = panel_height/2 - frame*scroll_per_frame;
+            const std::pair<size_t, size_t> visible = visible_lines(layout, first_baseline_y, 0, panel_height);
+            runs.clear();
+            position_runs(layout, visible.first, visible.second, panel_width/2, first_baseline_y + layout.line_tops[visible.first], runs);
+            total_runs += runs.size();
+            frame++;
+        });
+
+        if(total_runs == 0)
+        {
+            std::printf("No lines were visible while scrolling through %zu lines\n", line_count);
+            return false;
+        }
+        std::printf("%8zu %12d %14.1f %14.3f\n", line_count, frame_count, double(total_runs) / frame_count, frame_us);
+    }
+    return true;
+}
+
+// Compares laying out the lyrics again with fetching the existing layout from a SharedLayoutCache (as a second panel
+// showing the same lyrics does), which hashes and compares the text of every line instead of measuring it.
+// The fixed-advance metrics are far cheaper than measuring with a real font, so this understates the difference.
+BENCHMARK(shared_layout_cache_hit_vs_layout)
+{
+    const size_t line_counts[] = {1000, 5000, 20000};
+    std::printf("%8s %12s %14s %14s %8s\n", "lines", "measures", "layout (us)", "cache (us)", "speedup");
+    for(size_t line_count : line_counts)
+    {
+        const std::vector<LyricDataLine> lines = make_lyric_lines(line_count);
+        const int iterations = int(100000 / line_count);
+        CountingTextMetrics metrics;
+        const auto compute = [&]() { return layout_lyrics(metrics, 400, LINEGAP, lines); };
+
+        const double layout_us = average_microseconds(iterations, [&]() { compute(); });
+        const size_t layout_measures = metrics.measure_calls / size_t(iterations);
+
+        SharedLayoutCache<LyricLayout> cache;
+        const std::shared_ptr<const LyricLayout> held = cache.get(1, 1, 400, LINEGAP, lines, hash_lyric_lines(lines), compute);
+        metrics.measure_calls = 0;
+        bool all_hit = true;
+        const double cache_us = average_microseconds(iterations, [&]()
+        {
+            all_hit &= (cache.get(1, 1, 400, LINEGAP, lines, hash_lyric_lines(lines), compute) == held);
+        });
+        if(!all_hit || (metrics.measure_calls != 0))
+        {
+            std::printf("The cached layout of %zu lines was not reused\n", line_count);
+            return false;
+        }
+        std::printf("%8zu %12zu %14.1f %14.1f %7.1fx\n", line_count, layout_measures, layout_us, cache_us, layout_us / cache_us);
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+#include <cstdio>
+#include <cstring>
+
+#include "bench_framework.h"
+
+std::vector<BenchmarkCase>& registered_benchmarks()
+{
+    static std::vector<BenchmarkCase> benchmarks;
+    return benchmarks;
+}
+
+// Runs every benchmark, or only those named on the command line:
+//     openlyrics_benchmarks [benchmark name]...
+int main(int argc, char** argv)
+{
+    int failed_benchmarks = 0;
+    for(const BenchmarkCase& benchmark : registered_benchmarks())
+    {
+        bool selected = (argc <= 1);
+        for(int i=1; i<argc; i++)
+        {
+            selected |= (std::strcmp(argv[i], benchmark.name) == 0);
+        }
+        if(!selected)
+        {
+            continue;
+        }
+
+        std::printf("== %s\n", benchmark.name);
+        if(!benchmark.run())
+        {
+            std::printf("[FAIL] %s\n", benchmark.name);
+            failed_benchmarks++;
+        }
+        std::printf("\n");
+    }
+    return (failed_benchmarks == 0) ? 0 : 1;
+}
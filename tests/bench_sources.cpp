@@ -0,0 +1,262 @@
+#include <cstdio>
+#include <functional>
+
+#include "cJSON.h"
+#include "parsers/json.h"
+#include "sources/http_fixture.h"
+
+#include "bench_framework.h"
+#include "http_standin_server.h"
+#include "json_test_data.h"
+
+// Replays a search and a lyric lookup for each of the JSON-based lyric sources through the local stand-in server,
+// and measures the time from sending the search request to having the lyric text for the first result.
+// The requests, record paths and fields match those sent and read by the sources in src/sources/, but the
+// responses are generated (with a realistic number of results and a realistic size) so that the results are
+// deterministic and do not depend on having recorded fixtures from the real services.
+struct SourceReplay
+{
+    const char* name;
+    std::string search_method;
+    std::string search_url;
+    std::string search_body;
+    std::string search_response;
+    std::string search_record_path;
+    std::vector<std::string_view> search_fields;
+    std::string lookup_url;
+    std::string lookup_response;
+    std::function<bool(cJSON*)> lookup_has_lyrics;
+};
+
+static std::string make_lrc_lyrics(size_t line_count)
+{
+    std::string lyrics;
+    for(size_t i=0; i<line_count; i++)
+    {
+        char timestamp[16];
+        std::snprintf(timestamp, sizeof(timestamp), "[%02d:%02d.%02d]", int(i*3/60), int(i*3%60), int(i*7%100));
+        lyrics += timestamp;
+        lyrics += "This is line number " + std::to_string(i) + " of the song, with some words in it\\n";
+    }
+    return lyrics;
+}
+
+static std::string make_netease_search_response(size_t song_count)
+{
+    std::string response = R"({"result":{"songs":[)";
+    for(size_t i=0; i<song_count; i++)
+    {
+        if(i > 0) response += ',';
+        response += R"({"id":)" + std::to_string(1000000 + i) + R"(,"name":"Song Title )" + std::to_string(i) +
+            R"(","artists":[{"id":12345,"name":"Artist Name","picUrl":null,"alias":[],"albumSize":0,"picId":0,"img1v1Url":"https://p1.music.126.net/default.jpg","img1v1":0,"trans":null}],)"
+            R"("album":{"id":67890,"name":"Album Name","artist":{"id":0,"name":"","picUrl":null,"alias":[],"albumSize":0,"picId":0},"publishTime":1262275200000,"size":12,"copyrightId":0,"status":1,"picId":109951163000000000,"mark":0},)"
+            R"("duration":215000,"copyrightId":0,"status":0,"alias":[],"rtype":0,"ftype":0,"mvid":0,"fee":8,"rUrl":null,"mark":8192})";
+    }
+    response += R"(],"songCount":)" + std::to_string(song_count) + R"(},"code":200})";
+    return response;
+}
+
+static std::string make_qqmusic_search_response(size_t song_count)
+{
+    std::string response = R"({"code":0,"data":{"keyword":"artist album title","priority":0,"song":{"curnum":)" + std::to_string(song_count) + R"(,"curpage":1,"list":[)";
+    for(size_t i=0; i<song_count; i++)
+    {
+        if(i > 0) response += ',';
+        response += R"({"action":{"alert":0,"icons":0,"msg":0,"switch":65537},"album":{"id":54321,"mid":"002abcDEF0","name":"Album Name","pmid":"002abcDEF0_1","subtitle":"","title":"Album Name"},)"
+            R"("file":{"media_mid":"000xyz","size_128mp3":3440000,"size_320mp3":8600000,"size_flac":25000000},"id":)" + std::to_string(2000000 + i) +
+            R"(,"interval":215,"mid":"003Song)" + std::to_string(i) + R"(","name":"Song Title )" + std::to_string(i) +
+            R"(","singer":[{"id":6789,"mid":"001Singer","name":"Artist Name","title":"Artist Name","type":0}],"subtitle":"","time_public":"2010-01-01","title":"Song Title"})";
+    }
+    response += R"(],"totalnum":)" + std::to_string(song_count) + R"(}},"message":"","notice":"","subcode":0})";
+    return response;
+}
+
+static std::vector<SourceReplay> make_source_replays()
+{
+    const std::string lyrics = make_lrc_lyrics(60);
+    std::vector<SourceReplay> replays;
+
+    replays.push_back({
+        "NetEase",
+        "POST", "https://music.163.com/api/search/get", "s=Artist+Title&type=1&offset=0&sub=false&limit=5",
+        make_netease_search_response(5),
+        "result.songs[]", {"artists[0].name", "album.name", "name", "id"},
+        "https://music.163.com/api/song/lyric?tv=-1&kv=-1&lv=-1&os=pc&id=1000000",
+        R"({"sgc":false,"sfy":false,"qfy":false,"lrc":{"version":3,"lyric":")" + lyrics + R"("},"code":200})",
+        [](cJSON* json)
+        {
+            cJSON* lrc = cJSON_GetObjectItem(json, "lrc");
+            return (lrc != nullptr) && cJSON_IsString(cJSON_GetObjectItem(lrc, "lyric"));
+        }});
+
+    // NOTE: QQMusic returns its lyrics base64-encoded, but decoding them is not included here
+    replays.push_back({
+        "QQMusic",
+        "GET", "http://c.y.qq.com/soso/fcgi-bin/client_search_cp?p=1&n=10&new_json=1&cr=1&format=json&inCharset=utf-8&outCharset=utf-8&w=Artist+Album+Title", "",
+        make_qqmusic_search_response(10),
+        "data.song.list[]", {"singer[0].name", "album.name", "name", "mid"},
+        "http://c.y.qq.com/lyric/fcgi-bin/fcg_query_lyric_new.fcg?g_tk=5381&format=json&inCharset=utf-8&outCharset=utf-8&songmid=003Song0",
+        R"({"retcode":0,"code":0,"subcode":0,"lyric":")" + lyrics + R"(","trans":""})",
+        [](cJSON* json)
+        {
+            return cJSON_IsString(cJSON_GetObjectItem(json, "lyric"));
+        }});
+
+    replays.push_back({
+        "Musixmatch",
+        "GET", "https://apic-desktop.musixmatch.com/ws/1.1/track.search?format=json&q_artist=Artist&q_track=Title&usertoken=token", "",
+        make_musixmatch_search_response(10),
+        "message.body.track_list[]", MUSIXMATCH_FIELDS,
+        "https://apic-desktop.musixmatch.com/ws/1.1/track.subtitle.get?format=json&usertoken=token&commontrack_id=1000",
+        R"({"message":{"header":{"status_code":200,"execute_time":0.01},"body":{"subtitle":{"subtitle_id":1,"subtitle_body":")" + lyrics + R"(","subtitle_language":"en"}}}})",
+        [](cJSON* json)
+        {
+            cJSON* body = cJSON_GetObjectItem(cJSON_GetObjectItem(json, "message"), "body");
+            return cJSON_IsString(cJSON_GetObjectItem(cJSON_GetObjectItem(body, "subtitle"), "subtitle_body"));
+        }});
+
+    return replays;
+}
+
+BENCHMARK(source_replay_latency)
+{
+    const std::vector<SourceReplay> replays = make_source_replays();
+    std::map<std::string, std::string> fixtures;
+    for(const SourceReplay& replay : replays)
+    {
+        fixtures[http_fixture_key(replay.search_method, replay.search_url, replay.search_body)] = replay.search_response;
+        fixtures[http_fixture_key(replay.search_method, replay.lookup_url, "")] = replay.lookup_response;
+    }
+    HttpStandinServer server(std::move(fixtures));
+
+    const int iterations = 200;
+    std::printf("%-12s %10s %16s %12s %12s\n", "source", "bytes", "round trip (us)", "parse (us)", "total (us)");
+    for(const SourceReplay& replay : replays)
+    {
+        double round_trip_us = 0.0;
+        double parse_us = 0.0;
+        size_t response_bytes = 0;
+        bool success = true;
+        const double total_us = average_microseconds(iterations, [&]()
+        {
+            const auto search_start = std::chrono::steady_clock::now();
+            const HttpStandinResponse search = send_http_standin_request(server.port(), replay.search_method, replay.search_url, replay.search_body);
+            const auto search_parse_start = std::chrono::steady_clock::now();
+            size_t results = 0;
+            parsers::json::extract_records(search.body, replay.search_record_path, replay.search_fields,
+                [&results](const parsers::json::RecordFields& fields)
+                {
+                    results += fields.back().has_value() ? 1 : 0;
+                    return true;
+                });
+
+            const auto lookup_start = std::chrono::steady_clock::now();
+            const HttpStandinResponse lookup = send_http_standin_request(server.port(), replay.search_method, replay.lookup_url, "");
+            const auto lookup_parse_start = std::chrono::steady_clock::now();
+            cJSON* json = cJSON_ParseWithLength(lookup.body.c_str(), lookup.body.length());
+            const bool has_lyrics = (json != nullptr) && replay.lookup_has_lyrics(json);
+            cJSON_Delete(json);
+            const auto end = std::chrono::steady_clock::now();
+
+            success &= (search.status_code == 200) && (lookup.status_code == 200) && (results > 0) && has_lyrics;
+            response_bytes = search.body.length() + lookup.body.length();
+            round_trip_us += std::chrono::duration<double, std::micro>((search_parse_start - search_start) + (lookup_parse_start - lookup_start)).count();
+            parse_us += std::chrono::duration<double, std::micro>((lookup_start - search_parse_start) + (end - lookup_parse_start)).count();
+        });
+
+        if(!success)
+        {
+            std::printf("%s responses were not replayed or did not contain the expected results\n", replay.name);
+            return false;
+        }
+        std::printf("%-12s %10zu %16.1f %12.1f %12.1f\n", replay.name, response_bytes, round_trip_us / iterations, parse_us / iterations, total_us);
+    }
+    std::printf("%zu requests were served by the stand-in server\n", server.request_count());
+    return true;
+}
+
+// Replays a Musixmatch search and lyric lookup for each of the ways that the source can get its lyrics, through the
+// stand-in server with a simulated network latency, and measures the number of round trips and the time taken.
+// Requesting a new token for every search costs a whole extra round trip before the search can even start, which
+// the cached token avoids. The macro search also folds the search and the lookup into a single request.
+BENCHMARK(musixmatch_token_round_trips)
+{
+    const std::string api_url = "https://apic-desktop.musixmatch.com/ws/1.1/";
+    const std::string token_url = api_url + "token.get?format=json&app_id=web-desktop-app-v1.0";
+    const auto search_url = [&api_url](const std::string& token) { return api_url + "track.search?format=json&q_artist=Artist&q_track=Title&usertoken=" + token; };
+    const auto lookup_url = [&api_url](const std::string& token) { return api_url + "track.subtitle.get?format=json&usertoken=" + token + "&commontrack_id=1000"; };
+    const auto macro_url = [&api_url](const std::string& token) { return api_url + "macro.subtitles.get?format=json&q_artist=Artist&q_track=Title&usertoken=" + token; };
+
+    const std::string lyrics = make_lrc_lyrics(60);
+    const std::string subtitle = R"({"message":{"header":{"status_code":200},"body":{"subtitle":{"subtitle_id":1,"subtitle_body":")" + lyrics + R"(","subtitle_language":"en"}}}})";
+    std::map<std::string, std::string> fixtures;
+    fixtures[http_fixture_key("GET", token_url, "")] = R"({"message":{"header":{"status_code":200},"body":{"user_token":"token"}}})";
+    fixtures[http_fixture_key("GET", search_url("token"), "")] = make_musixmatch_search_response(10);
+    fixtures[http_fixture_key("GET", lookup_url("token"), "")] = subtitle;
+    fixtures[http_fixture_key("GET", macro_url("token"), "")] = R"({"message":{"header":{"status_code":200},"body":{"macro_calls":{"track.subtitles.get":)" + subtitle + "}}}}";
+    HttpStandinServer server(std::move(fixtures));
+
+    const int latency_ms = 20;
+    server.set_response_delay(std::chrono::milliseconds(latency_ms));
+
+    // Each request returns whether it was answered successfully
+    const auto get = [&server](const std::string& url, std::string* body = nullptr)
+    {
+        HttpStandinResponse response = send_http_standin_request(server.port(), "GET", url, "");
+        if(body != nullptr)
+        {
+            *body = std::move(response.body);
+        }
+        return response.status_code == 200;
+    };
+    const auto request_token = [&get, &token_url](std::string& token)
+    {
+        std::string body;
+        if(!get(token_url, &body))
+        {
+            return false;
+        }
+        cJSON* json = cJSON_ParseWithLength(body.c_str(), body.length());
+        cJSON* user_token = cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(json, "message"), "body"), "user_token");
+        const bool success = cJSON_IsString(user_token);
+        token = success ? user_token->valuestring : "";
+        cJSON_Delete(json);
+        return success;
+    };
+
+    struct Strategy
+    {
+        const char* name;
+        std::function<bool(const std::string& cached_token)> run;
+    };
+    const Strategy strategies[] = {
+        {"token per search", [&](const std::string&) { std::string token; return request_token(token) && get(search_url(token)) && get(lookup_url(token)); }},
+        {"cached token", [&](const std::string& token) { return get(search_url(token)) && get(lookup_url(token)); }},
+        {"cached token, macro", [&](const std::string& token) { return get(macro_url(token)); }},
+    };
+
+    std::string cached_token;
+    if(!request_token(cached_token))
+    {
+        std::printf("The token request was not replayed\n");
+        return false;
+    }
+
+    const int iterations = 10;
+    std::printf("Simulated network latency: %dms per request\n", latency_ms);
+    std::printf("%-20s %12s %14s\n", "strategy", "round trips", "latency (ms)");
+    for(const Strategy& strategy : strategies)
+    {
+        const size_t requests_before = server.request_count();
+        bool success = true;
+        const double average_us = average_microseconds(iterations, [&]() { success &= strategy.run(cached_token); });
+        if(!success)
+        {
+            std::printf("%s requests were not replayed\n", strategy.name);
+            return false;
+        }
+        const double round_trips = double(server.request_count() - requests_before) / double(iterations);
+        std::printf("%-20s %12.1f %14.1f\n", strategy.name, round_trips, average_us / 1000.0);
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#include "http_standin_server.h"
+
+// Serves a directory of fixtures recorded by the component, for end-to-end testing of the lyric sources.
+// Set the component's "local stand-in server" advanced setting to the address that this prints, then search as normal.
+//     openlyrics_http_standin <fixture directory> [port]
+int main(int argc, char** argv)
+{
+    if((argc < 2) || (argc > 3))
+    {
+        std::printf("Usage: %s <fixture directory> [port]\n", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        const uint16_t port = (argc >= 3) ? uint16_t(std::atoi(argv[2])) : uint16_t(0);
+        HttpStandinServer server(load_http_fixture_directory(argv[1]), port);
+        server.set_log_requests(true);
+        std::printf("Serving the fixtures in %s on 127.0.0.1:%u. Press Enter to stop...\n", argv[1], unsigned(server.port()));
+        std::getchar();
+    }
+    catch(const std::exception& e)
+    {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
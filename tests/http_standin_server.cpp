@@ -0,0 +1,343 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using socket_t = SOCKET;
+static int close_socket(socket_t s) { return closesocket(s); }
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using socket_t = int;
+static const socket_t INVALID_SOCKET = -1;
+static int close_socket(socket_t s) { return close(s); }
+#endif
+
+#include "sources/http_fixture.h"
+
+#include "http_standin_server.h"
+
+#ifdef _WIN32
+struct WinsockInit
+{
+    WinsockInit()
+    {
+        WSADATA data = {};
+        WSAStartup(MAKEWORD(2, 2), &data);
+    }
+    ~WinsockInit()
+    {
+        WSACleanup();
+    }
+};
+static WinsockInit g_winsock_init;
+#endif
+
+static bool send_all(socket_t s, std::string_view data)
+{
+    while(!data.empty())
+    {
+        const int sent = send(s, data.data(), int(data.length()), 0);
+        if(sent <= 0)
+        {
+            return false;
+        }
+        data.remove_prefix(size_t(sent));
+    }
+    return true;
+}
+
+static bool equals_ignore_case(std::string_view a, std::string_view b)
+{
+    if(a.length() != b.length())
+    {
+        return false;
+    }
+    for(size_t i=0; i<a.length(); i++)
+    {
+        const auto lower = [](char c) { return ((c >= 'A') && (c <= 'Z')) ? char(c - 'A' + 'a') : c; };
+        if(lower(a[i]) != lower(b[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// An HTTP request or response, with its start line and the headers that we care about
+struct HttpMessage
+{
+    std::string start_line;
+    std::optional<std::string> original_url;
+    std::optional<size_t> content_length;
+    std::string body;
+};
+
+// Reads a message from the socket. If the message has no Content-Length header then the body is everything
+// up until the other end closes the connection.
+static std::optional<HttpMessage> receive_message(socket_t s)
+{
+    std::string data;
+    size_t header_end = std::string::npos;
+    char buffer[16*1024];
+    while(header_end == std::string::npos)
+    {
+        const int received = recv(s, buffer, int(sizeof(buffer)), 0);
+        if(received <= 0)
+        {
+            return {};
+        }
+        data.append(buffer, size_t(received));
+        header_end = data.find("\r\n\r\n");
+    }
+
+    HttpMessage message;
+    std::string_view headers = std::string_view(data).substr(0, header_end);
+    size_t line_end = headers.find("\r\n");
+    message.start_line = std::string(headers.substr(0, line_end));
+    while(line_end != std::string_view::npos)
+    {
+        headers.remove_prefix(line_end + 2);
+        line_end = headers.find("\r\n");
+        const std::string_view line = headers.substr(0, line_end);
+        const size_t colon = line.find(':');
+        if(colon == std::string_view::npos)
+        {
+            continue;
+        }
+
+        const std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while(!value.empty() && (value.front() == ' '))
+        {
+            value.remove_prefix(1);
+        }
+        if(equals_ignore_case(name, "Content-Length"))
+        {
+            message.content_length = size_t(std::strtoull(std::string(value).c_str(), nullptr, 10));
+        }
+        else if(equals_ignore_case(name, HTTP_STANDIN_ORIGINAL_URL_HEADER))
+        {
+            message.original_url = std::string(value);
+        }
+    }
+
+    message.body = data.substr(header_end + 4);
+    while(!message.content_length.has_value() || (message.body.length() < message.content_length.value()))
+    {
+        const int received = recv(s, buffer, int(sizeof(buffer)), 0);
+        if(received <= 0)
+        {
+            break;
+        }
+        message.body.append(buffer, size_t(received));
+    }
+    if(message.content_length.has_value())
+    {
+        if(message.body.length() < message.content_length.value())
+        {
+            return {};
+        }
+        message.body.resize(message.content_length.value());
+    }
+    return message;
+}
+
+HttpStandinServer::HttpStandinServer(std::map<std::string, std::string> responses, uint16_t port) :
+    m_responses(std::move(responses)),
+    m_listen_socket(intptr_t(INVALID_SOCKET)),
+    m_port(0),
+    m_stopping(false),
+    m_log_requests(false),
+    m_request_count(0),
+    m_response_delay_ms(0)
+{
+    const socket_t listen_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(listen_socket == INVALID_SOCKET)
+    {
+        throw std::runtime_error("Failed to create the stand-in server socket");
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t address_length = sizeof(address);
+    if((bind(listen_socket, reinterpret_cast<const sockaddr*>(&address), address_length) != 0) ||
+        (listen(listen_socket, 16) != 0) ||
+        (getsockname(listen_socket, reinterpret_cast<sockaddr*>(&address), &address_length) != 0))
+    {
+        close_socket(listen_socket);
+        throw std::runtime_error("Failed to listen for stand-in server connections on port " + std::to_string(port));
+    }
+
+    m_listen_socket = intptr_t(listen_socket);
+    m_port = ntohs(address.sin_port);
+    m_thread = std::thread([this]() { serve(); });
+}
+
+HttpStandinServer::~HttpStandinServer()
+{
+    m_stopping = true;
+    m_thread.join();
+    close_socket(socket_t(m_listen_socket));
+}
+
+uint16_t HttpStandinServer::port() const
+{
+    return m_port;
+}
+
+size_t HttpStandinServer::request_count() const
+{
+    return m_request_count;
+}
+
+void HttpStandinServer::set_log_requests(bool log_requests)
+{
+    m_log_requests = log_requests;
+}
+
+void HttpStandinServer::set_response_delay(std::chrono::milliseconds delay)
+{
+    m_response_delay_ms = int64_t(delay.count());
+}
+
+void HttpStandinServer::serve()
+{
+    // NOTE: Connections are handled one at a time on this thread. We wait for new connections with a timeout
+    //       so that we notice when the server is being destroyed.
+    const socket_t listen_socket = socket_t(m_listen_socket);
+    while(!m_stopping)
+    {
+        fd_set read_sockets;
+        FD_ZERO(&read_sockets);
+        FD_SET(listen_socket, &read_sockets);
+        timeval timeout = {0, 50*1000};
+        if(select(int(listen_socket + 1), &read_sockets, nullptr, nullptr, &timeout) <= 0)
+        {
+            continue;
+        }
+
+        const socket_t connection = accept(listen_socket, nullptr, nullptr);
+        if(connection != INVALID_SOCKET)
+        {
+            handle_connection(intptr_t(connection));
+            close_socket(connection);
+        }
+    }
+}
+
+void HttpStandinServer::handle_connection(intptr_t connection)
+{
+    const std::optional<HttpMessage> request = receive_message(socket_t(connection));
+    if(!request.has_value())
+    {
+        return;
+    }
+    m_request_count++;
+
+    // The start line is "<method> <target> HTTP/1.1"
+    const size_t method_end = request->start_line.find(' ');
+    const size_t target_end = request->start_line.find(' ', method_end + 1);
+    const std::string method = request->start_line.substr(0, method_end);
+    const std::string target = (method_end == std::string::npos) ? std::string() : request->start_line.substr(method_end + 1, target_end - method_end - 1);
+    const std::string key = http_fixture_key(method, request->original_url.value_or(target), request->body);
+
+    const auto response_iter = m_responses.find(key);
+    const bool found = (response_iter != m_responses.end());
+    if(m_log_requests)
+    {
+        std::printf("%s %s\n", found ? "200" : "404", key.c_str());
+    }
+
+    const std::string_view body = found ? std::string_view(response_iter->second) : std::string_view("No fixture was recorded for this request");
+    std::string response = found ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 404 Not Found\r\n";
+    response += "Content-Type: application/octet-stream\r\n";
+    response += "Content-Length: " + std::to_string(body.length()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    if(m_response_delay_ms > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_response_delay_ms.load()));
+    }
+    send_all(socket_t(connection), response);
+}
+
+std::map<std::string, std::string> load_http_fixture_directory(const std::string& directory)
+{
+    std::map<std::string, std::string> responses;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+    {
+        if(!entry.is_regular_file())
+        {
+            continue;
+        }
+
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        const std::string contents_str = contents.str();
+
+        const std::optional<std::string> key = parse_http_fixture_key(contents_str);
+        if(!key.has_value())
+        {
+            continue;
+        }
+        std::optional<std::string> response = parse_http_fixture(contents_str, key.value());
+        if(response.has_value())
+        {
+            responses[key.value()] = std::move(response.value());
+        }
+    }
+    return responses;
+}
+
+HttpStandinResponse send_http_standin_request(uint16_t port, const std::string& method, const std::string& url, const std::string& body)
+{
+    const std::string server = "127.0.0.1:" + std::to_string(port);
+    const std::string standin_url = http_standin_url(server, url);
+    const std::string target = standin_url.substr(std::strlen("http://") + server.length());
+
+    std::string request = method + " " + target + " HTTP/1.1\r\n";
+    request += "Host: " + server + "\r\n";
+    request += std::string(HTTP_STANDIN_ORIGINAL_URL_HEADER) + ": " + url + "\r\n";
+    request += "Content-Length: " + std::to_string(body.length()) + "\r\n";
+    request += "Connection: close\r\n\r\n";
+    request += body;
+
+    const socket_t s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(s == INVALID_SOCKET)
+    {
+        return {0, {}};
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    std::optional<HttpMessage> response;
+    if((connect(s, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0) && send_all(s, request))
+    {
+        response = receive_message(s);
+    }
+    close_socket(s);
+
+    // The start line is "HTTP/1.1 <status code> <reason>"
+    if(!response.has_value() || (response->start_line.find(' ') == std::string::npos))
+    {
+        return {0, {}};
+    }
+    const int status_code = std::atoi(response->start_line.c_str() + response->start_line.find(' ') + 1);
+    return {status_code, std::move(response->body)};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+
+// A tiny HTTP server that listens on the loopback interface and answers each request with the response recorded for
+// it in a set of fixtures, so that the component (with its "local stand-in server" advanced setting pointed at it),
+// the tests and the benchmarks can exercise the lyric sources end-to-end over real sockets without any remote host.
+// Requests are identified by their fixture key (see src/sources/http_fixture.h), using the original URL from the
+// HTTP_STANDIN_ORIGINAL_URL_HEADER header if there is one. Requests with no fixture get a 404 response.
+class HttpStandinServer
+{
+public:
+    // `responses` maps each fixture key to the body of its response. Use port 0 to listen on any free port.
+    // Throws if the server cannot listen on the given port.
+    explicit HttpStandinServer(std::map<std::string, std::string> responses, uint16_t port = 0);
+    ~HttpStandinServer();
+
+    HttpStandinServer(const HttpStandinServer&) = delete;
+    HttpStandinServer& operator=(const HttpStandinServer&) = delete;
+
+    uint16_t port() const;
+    size_t request_count() const;
+    void set_log_requests(bool log_requests); // Print each request (and whether it had a fixture) to stdout
+    void set_response_delay(std::chrono::milliseconds delay); // Wait before each response, to simulate network latency
+
+private:
+    void serve();
+    void handle_connection(intptr_t connection);
+
+    std::map<std::string, std::string> m_responses;
+    intptr_t m_listen_socket;
+    uint16_t m_port;
+    std::atomic<bool> m_stopping;
+    std::atomic<bool> m_log_requests;
+    std::atomic<size_t> m_request_count;
+    std::atomic<int64_t> m_response_delay_ms;
+    std::thread m_thread;
+};
+
+// Returns the responses recorded in a directory of fixture files (as written by the component's fixture transport),
+// keyed by the fixture key on the first line of each file. Files that are not fixtures are ignored.
+std::map<std::string, std::string> load_http_fixture_directory(const std::string& directory);
+
+struct HttpStandinResponse
+{
+    int status_code; // Zero if the request could not be sent or the response was malformed
+    std::string body;
+};
+
+// Sends a request for `url` to the stand-in server on the given port, as the component does when it is configured
+// to use a stand-in server, and waits for the response.
+HttpStandinResponse send_http_standin_request(uint16_t port, const std::string& method, const std::string& url, const std::string& body);
@@ -0,0 +1,86 @@
+#include <string>
+
+#include "cJSON.h"
+
+#include "json_test_data.h"
+
+const std::vector<std::string_view> MUSIXMATCH_FIELDS = {
+    "track.artist_name",
+    "track.album_name",
+    "track.track_name",
+    "track.has_lyrics",
+    "track.has_subtitles",
+    "track.commontrack_id"
+};
+
+std::string make_musixmatch_search_response(size_t track_count)
+{
+    std::string result = R"({"message":{"header":{"status_code":200,"execute_time":0.0123,"available":)";
+    result += std::to_string(track_count);
+    result += R"(},"body":{"track_list":[)";
+    for(size_t i=0; i<track_count; i++)
+    {
+        const std::string index = std::to_string(i);
+        if(i > 0)
+        {
+            result += ',';
+        }
+
+        // NOTE: Based on the shape of a real response, with the fields that we don't use padded out with
+        //       the kind of nested objects, arrays, escapes and URLs that they contain.
+        result += R"({"track":{"track_id":)" + std::to_string(100000 + i);
+        result += R"(,"track_name":"Track \"number\" )" + index + R"(","track_name_translation_list":[{"track_name_translation":{"language":"JA","translation":"トラック )" + index + R"("}}])";
+        result += R"(,"track_rating":)" + std::to_string(i % 100);
+        result += R"(,"commontrack_id":)" + std::to_string(5000000 + i);
+        result += R"(,"instrumental":0,"explicit":0,"has_lyrics":1,"has_subtitles":)" + std::to_string(i % 2);
+        result += R"(,"has_richsync":0,"num_favourite":)" + std::to_string(i * 7);
+        result += R"(,"album_id":)" + std::to_string(200000 + i) + R"(,"album_name":"Album )" + index;
+        result += R"(","artist_id":)" + std::to_string(300000 + i) + R"(,"artist_name":"Artist )" + index;
+        result += R"(","track_share_url":"https:\/\/www.musixmatch.com\/lyrics\/Artist-)" + index + R"(\/Track-)" + index + R"(?utm_source=application&utm_campaign=api&utm_medium=musixmatch-community%3A1409608317702")";
+        result += R"(,"track_edit_url":"https:\/\/www.musixmatch.com\/lyrics\/Artist-)" + index + R"(\/Track-)" + index + R"(\/edit?utm_source=application&utm_campaign=api&utm_medium=musixmatch-community%3A1409608317702")";
+        result += R"(,"restricted":0,"updated_time":"2023-04-12T09:15:42Z","primary_genres":{"music_genre_list":[)";
+        for(int genre=0; genre<3; genre++)
+        {
+            result += (genre > 0) ? "," : "";
+            result += R"({"music_genre":{"music_genre_id":)" + std::to_string(genre + 14);
+            result += R"(,"music_genre_parent_id":34,"music_genre_name":"Pop","music_genre_name_extended":"Pop \/ Rock \/ Indie","music_genre_vanity":"Pop-Rock-Indie"}})";
+        }
+        result += R"(]},"secondary_genres":{"music_genre_list":[]},"track_spotify_id":"4uLU6hMCjMI75M1A2tKUQC","track_soundcloud_id":0,"track_xboxmusic_id":"")";
+        result += R"(,"track_mbid":"f8b1f1a5-37f4-4b7d-9c52-0b1b3b0c)" + index + R"(","track_isrc":"USRC1)" + index + R"(","track_length":215)";
+        result += R"(,"album_coverart_100x100":"http:\/\/s.mxmcdn.net\/images-storage\/albums\/nocover.png","album_coverart_350x350":"","album_coverart_500x500":"","album_coverart_800x800":"")";
+        result += R"(,"lyrics_id":)" + std::to_string(400000 + i) + R"(,"subtitle_id":)" + std::to_string(600000 + i);
+        result += R"(,"commontrack_vanity_id":"Artist-)" + index + R"(\/Track-)" + index + R"(","artist_mbid":"","first_release_date":"2009-01-01T00:00:00Z","track_nums":[1,2,3,4,5,6,7,8,9,10])";
+        result += R"(,"description":"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.")";
+        result += "}}";
+    }
+    result += "]}}}";
+    return result;
+}
+
+std::vector<MusixmatchTrack> read_musixmatch_tracks_with_cjson(const std::string& response)
+{
+    std::vector<MusixmatchTrack> result;
+    cJSON* json = cJSON_ParseWithLength(response.c_str(), response.length());
+    cJSON* track_list = cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(json, "message"), "body"), "track_list");
+
+    cJSON* item = nullptr;
+    cJSON_ArrayForEach(item, track_list)
+    {
+        cJSON* track = cJSON_GetObjectItem(item, "track");
+        cJSON* artist = cJSON_GetObjectItem(track, "artist_name");
+        cJSON* album = cJSON_GetObjectItem(track, "album_name");
+        cJSON* title = cJSON_GetObjectItem(track, "track_name");
+        cJSON* has_lyrics = cJSON_GetObjectItem(track, "has_lyrics");
+        cJSON* has_subtitles = cJSON_GetObjectItem(track, "has_subtitles");
+        cJSON* id = cJSON_GetObjectItem(track, "commontrack_id");
+        if(!cJSON_IsString(artist) || !cJSON_IsString(album) || !cJSON_IsString(title) ||
+           !cJSON_IsNumber(has_lyrics) || !cJSON_IsNumber(has_subtitles) || !cJSON_IsNumber(id))
+        {
+            break;
+        }
+        result.push_back({artist->valuestring, album->valuestring, title->valuestring, int64_t(id->valuedouble)});
+    }
+
+    cJSON_Delete(json);
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The fields that the Musixmatch source extracts from each track in a search response
+extern const std::vector<std::string_view> MUSIXMATCH_FIELDS;
+
+struct MusixmatchTrack
+{
+    std::string artist;
+    std::string album;
+    std::string title;
+    int64_t commontrack_id;
+};
+
+// Returns a Musixmatch track search response with the given number of tracks. As with the real responses,
+// each track has many more fields than the ones we extract (making the response around 3KB per track).
+std::string make_musixmatch_search_response(size_t track_count);
+
+// Reads the tracks from a search response by parsing it into a cJSON DOM, as the Musixmatch source used to
+std::vector<MusixmatchTrack> read_musixmatch_tracks_with_cjson(const std::string& response);
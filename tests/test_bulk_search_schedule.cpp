@@ -0,0 +1,138 @@
+#include <deque>
+#include <utility>
+
+#include "bulk_search_schedule.h"
+#include "test_framework.h"
+
+using State = BulkSearchTrackState;
+
+// Runs a job in which every search takes the same amount of time, starting new searches as soon as earlier ones
+// finish (as the bulk search dialog does on its timer). Returns the time at which the last search finished.
+static double simulate_job(BulkSearchSchedule& schedule, double search_seconds, std::vector<size_t>* out_search_order = nullptr)
+{
+    std::deque<std::pair<size_t, double>> in_progress; // Track index & finish time, in the order they finish
+    double now = 0.0;
+    while(!schedule.is_complete())
+    {
+        std::optional<size_t> next;
+        while((next = schedule.start_next(now)).has_value())
+        {
+            in_progress.emplace_back(next.value(), now + search_seconds);
+            if(out_search_order != nullptr)
+            {
+                out_search_order->push_back(next.value());
+            }
+        }
+
+        if(in_progress.empty())
+        {
+            break;
+        }
+        now = in_progress.front().second;
+        in_progress.pop_front();
+        schedule.finish(State::NotFound);
+    }
+    return now;
+}
+
+TEST(bulk_search_outcome_states)
+{
+    CHECK(bulk_search_outcome_state({true, false, false, false}) == State::Found);
+    CHECK(bulk_search_outcome_state({true, false, false, true}) == State::Found);  // Another source had lyrics
+    CHECK(bulk_search_outcome_state({true, false, true, false}) == State::Found);  // Saved before the abort
+    CHECK(bulk_search_outcome_state({false, false, false, false}) == State::NotFound);
+    CHECK(bulk_search_outcome_state({false, false, false, true}) == State::Error);
+    CHECK(bulk_search_outcome_state({true, true, false, false}) == State::Error);  // Found but not saved
+    CHECK(bulk_search_outcome_state({false, false, true, false}) == State::Pending);
+    CHECK(bulk_search_outcome_state({true, true, true, false}) == State::Pending); // The save was aborted
+}
+
+TEST(bulk_search_schedule_limits_searches_in_progress)
+{
+    BulkSearchSchedule schedule(std::vector<State>(10, State::Pending), 4);
+    for(size_t i=0; i<4; i++)
+    {
+        CHECK(schedule.start_next(0.0) == std::optional<size_t>(i));
+    }
+    CHECK(!schedule.start_next(0.0).has_value());
+    CHECK_EQ(schedule.in_progress_count(), size_t(4));
+
+    schedule.finish(State::Found);
+    CHECK(schedule.start_next(1.0) == std::optional<size_t>(4));
+    CHECK(!schedule.start_next(1.0).has_value());
+    CHECK_EQ(schedule.completed_count(), size_t(1));
+}
+
+TEST(bulk_search_schedule_zero_concurrency_still_searches)
+{
+    BulkSearchSchedule schedule(std::vector<State>(2, State::Pending), 0);
+    CHECK(schedule.start_next(0.0) == std::optional<size_t>(0));
+    CHECK(!schedule.start_next(0.0).has_value());
+}
+
+TEST(bulk_search_schedule_resumes_unfinished_tracks)
+{
+    const std::vector<State> states = {State::Found, State::Pending, State::NotFound, State::Error, State::Found, State::Pending};
+    BulkSearchSchedule schedule(states, 4);
+    CHECK_EQ(schedule.completed_count(), size_t(3));
+
+    std::vector<size_t> search_order;
+    simulate_job(schedule, 1.0, &search_order);
+    CHECK(search_order == std::vector<size_t>({1, 3, 5})); // Tracks that failed with an error are searched again
+    CHECK_EQ(schedule.completed_count(), size_t(6));
+    CHECK(schedule.is_complete());
+}
+
+TEST(bulk_search_schedule_interrupted_searches_are_not_completed)
+{
+    BulkSearchSchedule schedule(std::vector<State>(3, State::Pending), 3);
+    while(schedule.start_next(0.0).has_value()) {}
+
+    schedule.finish(State::Found);
+    schedule.finish(State::Pending);
+    CHECK(!schedule.is_complete());
+    schedule.finish(State::Pending);
+    CHECK(schedule.is_complete()); // Nothing is left to start in this session
+    CHECK_EQ(schedule.completed_count(), size_t(1));
+}
+
+TEST(bulk_search_schedule_with_nothing_to_search_is_complete)
+{
+    BulkSearchSchedule schedule({State::Found, State::NotFound}, 4);
+    CHECK(schedule.is_complete());
+    CHECK(!schedule.start_next(0.0).has_value());
+    CHECK_EQ(schedule.completed_count(), size_t(2));
+    CHECK_EQ(schedule.tracks_per_minute(10.0), 0.0);
+    CHECK(!schedule.estimated_seconds_remaining(10.0).has_value());
+}
+
+TEST(bulk_search_schedule_concurrent_searches_increase_throughput)
+{
+    // NOTE: With every search taking 2 seconds, 20 tracks take 40 seconds one at a time and 10 seconds four at a time
+    BulkSearchSchedule sequential(std::vector<State>(20, State::Pending), 1);
+    CHECK_EQ(simulate_job(sequential, 2.0), 40.0);
+    CHECK_EQ(sequential.tracks_per_minute(40.0), 30.0);
+
+    BulkSearchSchedule concurrent(std::vector<State>(20, State::Pending), 4);
+    CHECK_EQ(simulate_job(concurrent, 2.0), 10.0);
+    CHECK_EQ(concurrent.tracks_per_minute(10.0), 120.0);
+}
+
+TEST(bulk_search_schedule_estimates_remaining_time)
+{
+    // Two of the tracks were completed in an earlier session, so they count towards the progress but not the rate
+    std::vector<State> states(12, State::Pending);
+    states[0] = State::Found;
+    states[1] = State::NotFound;
+    BulkSearchSchedule schedule(states, 2);
+
+    CHECK(!schedule.estimated_seconds_remaining(0.0).has_value());
+    CHECK(schedule.start_next(5.0).has_value()); // The rate is measured from when the first search starts
+    CHECK(schedule.start_next(5.0).has_value());
+    CHECK(!schedule.estimated_seconds_remaining(6.0).has_value()); // Nothing has completed yet
+
+    schedule.finish(State::Found);
+    schedule.finish(State::NotFound);
+    CHECK_EQ(schedule.tracks_per_minute(11.0), 20.0);
+    CHECK(schedule.estimated_seconds_remaining(11.0) == std::optional<double>(24.0)); // 8 tracks at 3 seconds each
+}
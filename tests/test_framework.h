@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// A minimal test runner, so that the tests have no dependencies beyond the standard library.
+// Tests are registered with TEST() and report failures with CHECK() or CHECK_EQ(), which continue running the test.
+struct TestCase
+{
+    const char* name;
+    void (*run)();
+};
+
+std::vector<TestCase>& registered_tests();
+void record_check_failure(const char* file, int line, const char* expression);
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, void (*run)())
+    {
+        registered_tests().push_back({name, run});
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static const TestRegistration name##_registration(#name, name); \
+    static void name()
+
+#define CHECK(expression) \
+    do { if(!(expression)) { record_check_failure(__FILE__, __LINE__, #expression); } } while(false)
+
+#define CHECK_EQ(lhs, rhs) \
+    do { if(!((lhs) == (rhs))) { record_check_failure(__FILE__, __LINE__, #lhs " == " #rhs); } } while(false)
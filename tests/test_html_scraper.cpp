@@ -0,0 +1,164 @@
+#include <string>
+#include <vector>
+
+#include "sources/html_scraper.h"
+#include "test_framework.h"
+
+// Records every callback as a line of text (e.g "<div class=lyrics>@2", "text:hello@2" or "</div>")
+// so that the tests can compare the whole sequence of events with what they expect.
+class RecordingScraper : public HtmlScraper
+{
+public:
+    std::vector<std::string> events;
+    std::string stop_at_text;
+
+protected:
+    void on_element_start(const HtmlElement& element) override
+    {
+        std::string event = "<" + std::string(element.name());
+        const std::optional<std::string_view> css_class = element.attribute("class");
+        if(css_class.has_value())
+        {
+            event += " class=" + std::string(*css_class);
+        }
+        events.push_back(event + ">@" + std::to_string(depth()));
+    }
+
+    void on_element_end(std::string_view name) override
+    {
+        events.push_back("</" + std::string(name) + ">");
+    }
+
+    void on_text(std::string_view text) override
+    {
+        events.push_back("text:" + std::string(text) + "@" + std::to_string(depth()));
+        if(!stop_at_text.empty() && (text == stop_at_text))
+        {
+            stop_parsing();
+        }
+    }
+};
+
+// Returns the events for the given body content, without those for the <html> and <body> elements around it
+// (which libxml2 adds if they are not in the page).
+static std::vector<std::string> scrape_body(const std::string& body, const std::string& stop_at_text = {})
+{
+    RecordingScraper scraper;
+    scraper.stop_at_text = stop_at_text;
+    CHECK(scraper.parse("<html><body>" + body + "</body></html>", "https://example.com/test"));
+
+    std::vector<std::string>& events = scraper.events;
+    const bool has_body_start = (events.size() >= 2) && (events[0] == "<html>@1") && (events[1] == "<body>@2");
+    CHECK(has_body_start);
+    if(has_body_start)
+    {
+        events.erase(events.begin(), events.begin() + 2);
+    }
+    if((events.size() >= 2) && (events[events.size() - 2] == "</body>") && (events.back() == "</html>"))
+    {
+        events.erase(events.end() - 2, events.end());
+    }
+    return events;
+}
+
+TEST(html_scraper_reports_elements_text_and_depth)
+{
+    RecordingScraper scraper;
+    CHECK(scraper.parse(R"(<div class="lyrics">first line<br>second line</div>)", "https://example.com/test"));
+    // NOTE: libxml2 adds the <html> and <body> elements that are missing from the page
+    const std::vector<std::string> expected = {
+        "<html>@1",
+        "<body>@2",
+        "<div class=lyrics>@3",
+        "text:first line@3",
+        "<br>@4",
+        "</br>",
+        "text:second line@3",
+        "</div>",
+        "</body>",
+        "</html>",
+    };
+    CHECK(scraper.events == expected);
+}
+
+TEST(html_element_attributes)
+{
+    // NOTE: The attribute text is only valid during the callback, so it is copied out
+    struct AttributeScraper : public HtmlScraper
+    {
+        std::optional<std::string> id;
+        std::optional<std::string> disabled;
+        bool has_missing = true;
+
+    protected:
+        void on_element_start(const HtmlElement& element) override
+        {
+            if(element.name() == "input")
+            {
+                id = element.attribute("id");
+                disabled = element.attribute("disabled");
+                has_missing = element.has_attribute("missing");
+            }
+        }
+        void on_element_end(std::string_view) override {}
+        void on_text(std::string_view) override {}
+    };
+
+    AttributeScraper scraper;
+    CHECK(scraper.parse(R"(<p><input id="name" disabled></p>)", "https://example.com/test"));
+    CHECK(scraper.id == std::optional<std::string>("name"));
+    CHECK(scraper.disabled == std::optional<std::string>("")); // Attributes without a value have an empty one
+    CHECK(!scraper.has_missing);
+}
+
+TEST(html_scraper_joins_text_split_across_chunks)
+{
+    // NOTE: The page is fed to the parser in 16KB chunks, so this text node is split across two of them
+    //       (as well as being split by the entity reference) but should still be reported only once.
+    const std::string long_text(20*1024, 'a');
+    const std::vector<std::string> events = scrape_body("<p>" + long_text + "&amp;b</p>");
+    CHECK_EQ(events.size(), size_t(3));
+    if(events.size() == 3)
+    {
+        CHECK(events[1] == "text:" + long_text + "&b@3");
+    }
+}
+
+TEST(html_scraper_comments_split_text)
+{
+    const std::vector<std::string> events = scrape_body("<p>before<!-- hidden -->after</p>");
+    const std::vector<std::string> expected = {"<p>@3", "text:before@3", "text:after@3", "</p>"};
+    CHECK(events == expected);
+}
+
+TEST(html_scraper_ignores_script_and_style_contents)
+{
+    const std::vector<std::string> events = scrape_body(
+        "<div>lyric<script>var lyric = \"<b>not a lyric</b>\";</script>"
+        "<style>.lyric { color: red; }</style>text</div>");
+    const std::vector<std::string> expected = {
+        "<div>@3",
+        "text:lyric@3",
+        "<script>@4",
+        "</script>",
+        "<style>@4",
+        "</style>",
+        "text:text@3",
+        "</div>",
+    };
+    CHECK(events == expected);
+}
+
+TEST(html_scraper_stop_parsing_skips_the_rest_of_the_page)
+{
+    std::string html = "<div><p>wanted</p>";
+    for(int i=0; i<10000; i++)
+    {
+        html += "<p>unwanted</p>";
+    }
+    html += "</div>";
+
+    const std::vector<std::string> events = scrape_body(html, "wanted");
+    const std::vector<std::string> expected = {"<div>@3", "<p>@4", "text:wanted@4"};
+    CHECK(events == expected);
+}
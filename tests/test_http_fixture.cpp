@@ -0,0 +1,88 @@
+#include <map>
+
+#include "sources/http_fixture.h"
+#include "test_framework.h"
+
+struct RecordedRequest
+{
+    std::string method;
+    std::string url;
+    std::string body;
+    std::string response;
+};
+
+// Records each response as the fixture transport does (in a file named after the request's key) and then
+// replays every request from those recordings.
+TEST(http_fixture_replays_recorded_responses)
+{
+    const std::vector<RecordedRequest> requests = {
+        {"GET", "https://c.y.qq.com/search?w=artist%20title", "", "{\"data\":{\"song\":{\"list\":[]}}}"},
+        {"POST", "https://music.163.com/api/search/get?s=artist", "type=1&limit=10", "first response"},
+        {"POST", "https://music.163.com/api/search/get?s=artist", "type=1&limit=20", "second response"},
+        {"GET", "https://example.com/empty", "", ""},
+        {"GET", "https://example.com/multiline", "", "line one\r\nline two\r\n"},
+    };
+
+    std::map<std::string, std::string> fixture_files;
+    for(const RecordedRequest& request : requests)
+    {
+        const std::string key = http_fixture_key(request.method, request.url, request.body);
+        CHECK(fixture_files.count(key) == 0);
+        fixture_files[key] = format_http_fixture(key, request.response);
+    }
+
+    for(const RecordedRequest& request : requests)
+    {
+        const std::string key = http_fixture_key(request.method, request.url, request.body);
+        const auto file_iter = fixture_files.find(key);
+        CHECK(file_iter != fixture_files.end());
+        if(file_iter != fixture_files.end())
+        {
+            const std::optional<std::string> replayed = parse_http_fixture(file_iter->second, key);
+            CHECK(replayed.has_value());
+            CHECK_EQ(replayed.value_or("<missing>"), request.response);
+        }
+    }
+}
+
+TEST(http_fixture_key_without_body_is_method_and_url)
+{
+    // NOTE: Fixtures recorded before request bodies were supported must still replay
+    CHECK_EQ(http_fixture_key("GET", "https://example.com/a?b=c", ""), "GET https://example.com/a?b=c");
+}
+
+TEST(http_fixture_key_distinguishes_bodies)
+{
+    const std::string no_body = http_fixture_key("POST", "https://example.com", "");
+    const std::string body_a = http_fixture_key("POST", "https://example.com", "a=1");
+    const std::string body_b = http_fixture_key("POST", "https://example.com", "a=2");
+    CHECK(no_body != body_a);
+    CHECK(body_a != body_b);
+    CHECK_EQ(body_a, http_fixture_key("POST", "https://example.com", "a=1"));
+    CHECK(body_a.find('\n') == std::string::npos);
+    CHECK(http_fixture_key("POST", "https://example.com", "line\r\nbreak").find('\n') == std::string::npos);
+}
+
+TEST(http_fixture_rejects_other_requests)
+{
+    const std::string key = http_fixture_key("GET", "https://example.com/a", "");
+    const std::string contents = format_http_fixture(key, "response");
+    CHECK(!parse_http_fixture(contents, http_fixture_key("GET", "https://example.com/b", "")).has_value());
+    CHECK(!parse_http_fixture(contents, http_fixture_key("POST", "https://example.com/a", "")).has_value());
+    CHECK(!parse_http_fixture(contents, http_fixture_key("GET", "https://example.com/a", "body")).has_value());
+}
+
+TEST(http_fixture_rejects_malformed_files)
+{
+    const std::string key = http_fixture_key("GET", "https://example.com/a", "");
+    CHECK(!parse_http_fixture("", key).has_value());
+    CHECK(!parse_http_fixture(key, key).has_value()); // No line break after the key
+    CHECK(!parse_http_fixture("response only", key).has_value());
+}
+
+TEST(http_fixture_key_is_read_from_the_file)
+{
+    const std::string key = http_fixture_key("POST", "https://example.com/a", "body");
+    CHECK(parse_http_fixture_key(format_http_fixture(key, "response\r\nmore")) == std::optional<std::string>(key));
+    CHECK(!parse_http_fixture_key("no line break").has_value());
+}
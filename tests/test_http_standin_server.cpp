@@ -0,0 +1,49 @@
+#include "sources/http_fixture.h"
+
+#include "http_standin_server.h"
+#include "test_framework.h"
+
+TEST(http_standin_url_keeps_path_and_query)
+{
+    CHECK_EQ(http_standin_url("127.0.0.1:8080", "https://music.163.com/api/search/get?s=a+b"), "http://127.0.0.1:8080/api/search/get?s=a+b");
+    CHECK_EQ(http_standin_url("127.0.0.1:8080", "http://example.com"), "http://127.0.0.1:8080/");
+    CHECK_EQ(http_standin_url("127.0.0.1:8080", "http://example.com?a=b#c"), "http://127.0.0.1:8080/?a=b");
+    CHECK_EQ(http_standin_url("localhost:1", "example.com/a/b"), "http://localhost:1/a/b");
+}
+
+TEST(http_standin_server_replays_fixtures)
+{
+    const std::string search_url = "https://music.163.com/api/search/get";
+    std::map<std::string, std::string> fixtures;
+    fixtures[http_fixture_key("GET", "https://example.com/lyrics?id=1", "")] = "first lyrics";
+    fixtures[http_fixture_key("POST", search_url, "s=a")] = "search for a";
+    fixtures[http_fixture_key("POST", search_url, "s=b")] = "search for b";
+    fixtures[http_fixture_key("GET", "https://example.com/empty", "")] = "";
+    HttpStandinServer server(std::move(fixtures));
+
+    const HttpStandinResponse lyrics = send_http_standin_request(server.port(), "GET", "https://example.com/lyrics?id=1", "");
+    CHECK_EQ(lyrics.status_code, 200);
+    CHECK_EQ(lyrics.body, "first lyrics");
+
+    // Requests for the same URL with different bodies are answered separately
+    CHECK_EQ(send_http_standin_request(server.port(), "POST", search_url, "s=b").body, "search for b");
+    CHECK_EQ(send_http_standin_request(server.port(), "POST", search_url, "s=a").body, "search for a");
+
+    const HttpStandinResponse empty = send_http_standin_request(server.port(), "GET", "https://example.com/empty", "");
+    CHECK_EQ(empty.status_code, 200);
+    CHECK(empty.body.empty());
+
+    CHECK_EQ(server.request_count(), size_t(4));
+}
+
+TEST(http_standin_server_rejects_unknown_requests)
+{
+    std::map<std::string, std::string> fixtures;
+    fixtures[http_fixture_key("GET", "https://example.com/a", "")] = "a";
+    HttpStandinServer server(std::move(fixtures));
+
+    CHECK_EQ(send_http_standin_request(server.port(), "GET", "https://example.com/b", "").status_code, 404);
+    CHECK_EQ(send_http_standin_request(server.port(), "POST", "https://example.com/a", "").status_code, 404);
+    CHECK_EQ(send_http_standin_request(server.port(), "GET", "https://example.com/a", "body").status_code, 404);
+    CHECK_EQ(send_http_standin_request(server.port(), "GET", "https://example.com/a", "").status_code, 200);
+}
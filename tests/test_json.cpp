@@ -0,0 +1,201 @@
+#include "parsers/json.h"
+#include "test_framework.h"
+
+#include "json_test_data.h"
+
+using namespace parsers::json;
+
+static std::vector<RecordFields> extract_all(std::string_view input,
+                                             std::string_view record_path,
+                                             const std::vector<std::string_view>& field_paths,
+                                             bool* out_success = nullptr)
+{
+    std::vector<RecordFields> records;
+    const bool success = extract_records(input, record_path, field_paths,
+        [&records](const RecordFields& fields)
+        {
+            records.push_back(fields);
+            return true;
+        });
+    if(out_success != nullptr)
+    {
+        *out_success = success;
+    }
+    return records;
+}
+
+static bool field_is(const std::optional<Scalar>& field, ScalarType type, std::string_view text)
+{
+    return field.has_value() && (field->type == type) && (field->text == text);
+}
+
+TEST(json_extracts_fields_from_each_record)
+{
+    const char* input = R"({
+        "code": 200,
+        "result": {"songs": [
+            {"name": "First", "id": 11, "artists": [{"name": "Artist A"}, {"name": "Artist B"}], "album": {"name": "Album"}},
+            {"name": "Second", "id": 22, "artists": [{"name": "Artist C"}], "album": {"name": "Other"}}
+        ]}
+    })";
+
+    bool success = false;
+    const std::vector<RecordFields> records = extract_all(input, "result.songs[]", {"artists[0].name", "album.name", "name", "id"}, &success);
+    CHECK(success);
+    CHECK_EQ(records.size(), size_t(2));
+    if(records.size() != 2)
+    {
+        return;
+    }
+
+    CHECK(field_is(records[0][0], ScalarType::String, "Artist A")); // Only the first artist matches [0]
+    CHECK(field_is(records[0][1], ScalarType::String, "Album"));
+    CHECK(field_is(records[0][2], ScalarType::String, "First"));
+    CHECK(field_is(records[0][3], ScalarType::Number, "11"));
+    CHECK(field_is(records[1][0], ScalarType::String, "Artist C"));
+    CHECK(field_is(records[1][2], ScalarType::String, "Second"));
+    CHECK(records[1][3].has_value() && (records[1][3]->as_int64() == std::optional<int64_t>(22)));
+}
+
+TEST(json_missing_and_mistyped_fields)
+{
+    const char* input = R"({"list": [{"name": "only a name"}, {"name": null, "extra": {"name": "nested"}}, 5, {"name": true}]})";
+
+    const std::vector<RecordFields> records = extract_all(input, "list[]", {"name", "id"});
+    CHECK_EQ(records.size(), size_t(4));
+    if(records.size() != 4)
+    {
+        return;
+    }
+
+    CHECK(field_is(records[0][0], ScalarType::String, "only a name"));
+    CHECK(!records[0][1].has_value());
+    CHECK(field_is(records[1][0], ScalarType::Null, "null")); // The nested "name" is at a different path
+    CHECK(!records[2][0].has_value());                         // Records that are not objects have no fields
+    CHECK(field_is(records[3][0], ScalarType::Bool, "true"));
+}
+
+TEST(json_unescapes_matched_strings)
+{
+    const char* input = R"({"items": [{"title": "quote \" backslash \\ slash \/ newline \n tab \t e-acute \u00e9 euro \u20AC clef \ud834\udd1e"}]})";
+
+    const std::vector<RecordFields> records = extract_all(input, "items[]", {"title"});
+    CHECK_EQ(records.size(), size_t(1));
+    if(records.size() == 1)
+    {
+        CHECK(field_is(records[0][0], ScalarType::String,
+                       "quote \" backslash \\ slash / newline \n tab \t e-acute \xC3\xA9 euro \xE2\x82\xAC clef \xF0\x9D\x84\x9E"));
+    }
+}
+
+TEST(json_replaces_unpaired_surrogates)
+{
+    const char* input = R"({"items": [
+        {"title": "lone high \ud834 end"},
+        {"title": "lone low \udd1e end"},
+        {"title": "high then escape \ud834\u00e9"},
+        {"title": "two highs \ud834\ud834\udd1e"},
+        {"title": "high at end \ud834"}
+    ]})";
+
+    const std::vector<RecordFields> records = extract_all(input, "items[]", {"title"});
+    CHECK_EQ(records.size(), size_t(5));
+    if(records.size() == 5)
+    {
+        CHECK(field_is(records[0][0], ScalarType::String, "lone high \xEF\xBF\xBD end"));
+        CHECK(field_is(records[1][0], ScalarType::String, "lone low \xEF\xBF\xBD end"));
+        CHECK(field_is(records[2][0], ScalarType::String, "high then escape \xEF\xBF\xBD\xC3\xA9"));
+        CHECK(field_is(records[3][0], ScalarType::String, "two highs \xEF\xBF\xBD\xF0\x9D\x84\x9E"));
+        CHECK(field_is(records[4][0], ScalarType::String, "high at end \xEF\xBF\xBD"));
+    }
+}
+
+TEST(json_skips_strings_that_are_not_fields)
+{
+    // NOTE: Strings that are not fields are skipped without being unescaped, so their invalid escapes are not noticed
+    const char* input = R"({"items": [{"title": "wanted", "lyrics": "invalid \q escape", "tags": ["\u12"]}]})";
+
+    bool success = false;
+    const std::vector<RecordFields> records = extract_all(input, "items[]", {"title", "tags[1]"}, &success);
+    CHECK(success);
+    CHECK_EQ(records.size(), size_t(1));
+    if(records.size() == 1)
+    {
+        CHECK(field_is(records[0][0], ScalarType::String, "wanted"));
+        CHECK(!records[0][1].has_value());
+    }
+
+    bool field_success = true;
+    extract_all(input, "items[]", {"lyrics"}, &field_success);
+    CHECK(!field_success);
+}
+
+TEST(json_number_ids_with_fractions_or_exponents)
+{
+    const char* input = R"({"ids": [{"id": 12345}, {"id": 1.2345e5}, {"id": -7}, {"id": "12"}]})";
+
+    const std::vector<RecordFields> records = extract_all(input, "ids[]", {"id"});
+    CHECK_EQ(records.size(), size_t(4));
+    if(records.size() == 4)
+    {
+        CHECK(records[0][0]->as_int64() == std::optional<int64_t>(12345));
+        CHECK(records[1][0]->as_int64() == std::optional<int64_t>(123450));
+        CHECK(records[2][0]->as_int64() == std::optional<int64_t>(-7));
+        CHECK(!records[3][0]->as_int64().has_value()); // Strings are not numbers
+    }
+}
+
+TEST(json_stops_when_the_callback_returns_false)
+{
+    // NOTE: The document is truncated after the second record, so parsing would fail if it did not stop
+    const char* input = R"({"list": [{"n": 1}, {"n": 2}, {"n": 3)";
+
+    size_t record_count = 0;
+    const bool success = extract_records(input, "list[]", {"n"},
+        [&record_count](const RecordFields&)
+        {
+            record_count++;
+            return record_count < 2;
+        });
+    CHECK(success);
+    CHECK_EQ(record_count, size_t(2));
+}
+
+TEST(json_reports_malformed_documents)
+{
+    const char* malformed[] = {
+        "",
+        "{",
+        R"({"list": [{"n": 1},]})",
+        R"({"list": [{"n": 1} {"n": 2}]})",
+        R"({"list": "unterminated)",
+        R"({"list": [tru]})",
+        R"({"list" [1]})",
+    };
+    for(const char* input : malformed)
+    {
+        std::string error;
+        const bool success = extract_records(input, "list[]", {"n"}, [](const RecordFields&) { return true; }, &error);
+        CHECK(!success);
+        CHECK(!error.empty());
+    }
+}
+
+TEST(json_matches_cjson_on_a_search_response)
+{
+    const std::string input = make_musixmatch_search_response(20);
+    const std::vector<MusixmatchTrack> expected = read_musixmatch_tracks_with_cjson(input);
+    CHECK_EQ(expected.size(), size_t(20));
+
+    bool success = false;
+    const std::vector<RecordFields> records = extract_all(input, "message.body.track_list[]", MUSIXMATCH_FIELDS, &success);
+    CHECK(success);
+    CHECK_EQ(records.size(), expected.size());
+    for(size_t i=0; (i < records.size()) && (i < expected.size()); i++)
+    {
+        CHECK(field_is(records[i][0], ScalarType::String, expected[i].artist));
+        CHECK(field_is(records[i][1], ScalarType::String, expected[i].album));
+        CHECK(field_is(records[i][2], ScalarType::String, expected[i].title));
+        CHECK(records[i][5].has_value() && (records[i][5]->as_int64() == std::optional<int64_t>(expected[i].commontrack_id)));
+    }
+}
@@ -0,0 +1,168 @@
+#include "lyric_layout.h"
+#include "test_framework.h"
+
+// Every character is 10 units wide and lines are 10 units tall (plus the line gap), so the expected
+// layouts below can be worked out by hand from the text.
+static const int CHAR_ADVANCE = 10;
+static const int ASCENT = 8;
+static const int DESCENT = 2;
+static const int LINEGAP = 3;
+static const int WIDTH = 100;
+
+static std::vector<LyricDataLine> golden_lines()
+{
+    return {
+        {L"hello world", 0.0, {}},               // 110 wide, so it wraps at the space
+        {L"", 0.0, {}},                          // Empty lines still take up a line of height
+        {L"short", 0.0, {{0, 1.0}, {3, 2.0}}},   // Per-word timestamps
+        {L"abcdefghijklmn", 0.0, {}},            // A single word wider than the layout is not split
+    };
+}
+
+static bool segment_is(const LayoutLine::Segment& segment, size_t start, size_t length, int width)
+{
+    return (segment.start == start) && (segment.length == length) && (segment.width == width);
+}
+
+TEST(fixed_advance_metrics_measure_each_character_equally)
+{
+    FixedAdvanceTextMetrics metrics(CHAR_ADVANCE, ASCENT, DESCENT);
+    CHECK_EQ(metrics.ascent(), ASCENT);
+    CHECK_EQ(metrics.descent(), DESCENT);
+    CHECK_EQ(metrics.height(), ASCENT + DESCENT);
+    CHECK_EQ(metrics.average_char_width(), CHAR_ADVANCE);
+    CHECK(metrics.measure(L"") == std::optional<int>(0));
+    CHECK(metrics.measure(L"four") == std::optional<int>(40));
+}
+
+TEST(layout_lyrics_matches_golden_layout)
+{
+    FixedAdvanceTextMetrics metrics(CHAR_ADVANCE, ASCENT, DESCENT);
+    const LyricLayout layout = layout_lyrics(metrics, WIDTH, LINEGAP, golden_lines());
+
+    CHECK_EQ(layout.width, WIDTH);
+    CHECK_EQ(layout.font_ascent, ASCENT);
+    CHECK_EQ(layout.font_descent, DESCENT);
+    CHECK_EQ(layout.line_height, 13);
+    CHECK(!layout.measure_failed);
+    CHECK_EQ(layout.lines.size(), size_t(4));
+    if(layout.lines.size() != 4)
+    {
+        return;
+    }
+
+    // "hello world" wraps into "hello" and "world", dropping the space between them
+    const LayoutLine& wrapped = layout.lines[0];
+    CHECK_EQ(wrapped.segments.size(), size_t(2));
+    if(wrapped.segments.size() == 2)
+    {
+        CHECK(segment_is(wrapped.segments[0], 0, 5, 50));
+        CHECK(segment_is(wrapped.segments[1], 6, 5, 50));
+    }
+    CHECK_EQ(wrapped.height, 26);
+    CHECK_EQ(wrapped.text_width, 100);
+    CHECK(wrapped.word_positions.empty());
+
+    const LayoutLine& empty = layout.lines[1];
+    CHECK(empty.segments.empty());
+    CHECK_EQ(empty.height, 13);
+
+    const LayoutLine& timed = layout.lines[2];
+    CHECK_EQ(timed.segments.size(), size_t(1));
+    if(timed.segments.size() == 1)
+    {
+        CHECK(segment_is(timed.segments[0], 0, 5, 50));
+    }
+    CHECK(timed.word_positions == std::vector<int>({0, 30}));
+
+    const LayoutLine& long_word = layout.lines[3];
+    CHECK_EQ(long_word.segments.size(), size_t(1));
+    if(long_word.segments.size() == 1)
+    {
+        CHECK(segment_is(long_word.segments[0], 0, 14, 140));
+    }
+
+    CHECK(layout.line_tops == std::vector<int>({0, 26, 39, 52, 65}));
+    CHECK_EQ(layout.total_height, 65);
+}
+
+TEST(layout_lyrics_horizontal_matches_golden_layout)
+{
+    FixedAdvanceTextMetrics metrics(CHAR_ADVANCE, ASCENT, DESCENT);
+    const HorizontalLyricLayout layout = layout_lyrics_horizontal(metrics, 2, golden_lines());
+
+    CHECK_EQ(layout.glue_width, 20);
+    CHECK(!layout.measure_failed);
+    CHECK(layout.line_widths == std::vector<int>({110, 0, 50, 140}));
+    CHECK(layout.line_lefts == std::vector<int>({0, 130, 150, 220, 380}));
+    CHECK_EQ(layout.total_width, 360);
+    CHECK_EQ(layout.word_positions.size(), size_t(4));
+    if(layout.word_positions.size() == 4)
+    {
+        CHECK(layout.word_positions[2] == std::vector<int>({0, 30}));
+    }
+}
+
+TEST(position_runs_and_visible_lines_match_golden_layout)
+{
+    FixedAdvanceTextMetrics metrics(CHAR_ADVANCE, ASCENT, DESCENT);
+    const LyricLayout layout = layout_lyrics(metrics, WIDTH, LINEGAP, golden_lines());
+
+    std::vector<PositionedRun> runs;
+    position_runs(layout, 0, layout.lines.size(), 50, ASCENT, runs);
+    CHECK_EQ(runs.size(), size_t(4));
+    if(runs.size() == 4)
+    {
+        const int expected_y[] = {8, 21, 47, 60}; // The empty line has no run but still moves the next one down
+        const size_t expected_line[] = {0, 0, 2, 3};
+        for(size_t i=0; i<runs.size(); i++)
+        {
+            CHECK_EQ(runs[i].y, expected_y[i]);
+            CHECK_EQ(runs[i].line_index, expected_line[i]);
+            CHECK_EQ(runs[i].x, 50);
+        }
+    }
+
+    CHECK(visible_lines(layout, ASCENT, 0, 20) == std::make_pair(size_t(0), size_t(1)));
+    CHECK(visible_lines(layout, ASCENT, 0, 1000) == std::make_pair(size_t(0), size_t(4)));
+}
+
+TEST(karaoke_position_interpolates_across_each_word)
+{
+    FixedAdvanceTextMetrics metrics(CHAR_ADVANCE, ASCENT, DESCENT);
+    const std::vector<LyricDataLine> lines = golden_lines();
+    const LyricLayout layout = layout_lyrics(metrics, WIDTH, LINEGAP, lines);
+    const LyricDataLine& line = lines[2];
+    const std::vector<int>& positions = layout.lines[2].word_positions;
+    const int line_width = layout.lines[2].text_width;
+
+    CHECK_EQ(karaoke_position(line, positions, line_width, 0.5, 3.0), 0);
+    CHECK_EQ(karaoke_position(line, positions, line_width, 1.5, 3.0), 15);
+    CHECK_EQ(karaoke_position(line, positions, line_width, 2.5, 3.0), 40);
+    CHECK_EQ(karaoke_position(line, positions, line_width, 10.0, 3.0), 50);
+    CHECK_EQ(karaoke_end_time(line, 3.0), 3.0);
+}
+
+TEST(shared_layout_cache_reuses_layouts_only_for_the_same_font_generation)
+{
+    FixedAdvanceTextMetrics metrics(CHAR_ADVANCE, ASCENT, DESCENT);
+    const std::vector<LyricDataLine> lines = golden_lines();
+    const uint64_t lines_hash = hash_lyric_lines(lines);
+    int compute_count = 0;
+    const auto compute = [&]()
+    {
+        compute_count++;
+        return layout_lyrics(metrics, WIDTH, LINEGAP, lines);
+    };
+
+    SharedLayoutCache<LyricLayout> cache;
+    const std::shared_ptr<const LyricLayout> first = cache.get(1, 1, WIDTH, LINEGAP, lines, lines_hash, compute);
+    const std::shared_ptr<const LyricLayout> shared = cache.get(1, 1, WIDTH, LINEGAP, lines, lines_hash, compute);
+    CHECK(shared == first);
+    CHECK_EQ(compute_count, 1);
+
+    // NOTE: The same font ID in a new generation may be a different font that was given the handle of a deleted one
+    const std::shared_ptr<const LyricLayout> regenerated = cache.get(1, 2, WIDTH, LINEGAP, lines, lines_hash, compute);
+    CHECK(regenerated != first);
+    CHECK_EQ(compute_count, 2);
+}
@@ -0,0 +1,34 @@
+#include "test_framework.h"
+
+static int g_failed_checks = 0;
+
+std::vector<TestCase>& registered_tests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void record_check_failure(const char* file, int line, const char* expression)
+{
+    printf("    %s:%d: check failed: %s\n", file, line, expression);
+    g_failed_checks++;
+}
+
+int main()
+{
+    int failed_tests = 0;
+    for(const TestCase& test : registered_tests())
+    {
+        const int previous_failed_checks = g_failed_checks;
+        test.run();
+        const bool passed = (g_failed_checks == previous_failed_checks);
+        printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.name);
+        if(!passed)
+        {
+            failed_tests++;
+        }
+    }
+
+    printf("%d of %d tests passed\n", int(registered_tests().size()) - failed_tests, int(registered_tests().size()));
+    return (failed_tests == 0) ? 0 : 1;
+}
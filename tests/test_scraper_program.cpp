@@ -0,0 +1,128 @@
+#include <stdexcept>
+
+#include "sources/scraper_program.h"
+#include "test_framework.h"
+
+static ContentRule make_content(std::vector<SelectorStep>& steps, const char* selector, TextPolicy text_policy, bool match_all = false)
+{
+    ContentRule rule = {};
+    rule.selector = compile_selector(selector, steps);
+    rule.text_policy = text_policy;
+    rule.match_all = match_all;
+    rule.section_header = -1;
+    rule.section_end = -1;
+    return rule;
+}
+
+// The same content as the built-in "darklyrics" rule
+static ScraperProgram make_sections_program()
+{
+    ScraperProgram program;
+    ContentRule rule = make_content(program.steps, "div.lyrics", TextPolicy::Sections);
+    rule.section_header = compile_selector("div.lyrics > h3", program.steps);
+    rule.section_end = compile_selector("div.lyrics div", program.steps);
+    rule.section_title_after = ".";
+    program.content.push_back(rule);
+    return program;
+}
+
+static const char* g_sections_page = R"(<html><body><div class="lyrics">
+    <h3><a name="1">1. First Song</a></h3><br>
+    first line<br>
+    second line<br>
+    <h3><a name="2">2. Second Song</a></h3><br>
+    other line<br>
+    <div class="thanks">Thanks to someone</div>
+</div></body></html>)";
+
+TEST(scraper_selectors_compile_into_one_list_of_steps)
+{
+    std::vector<SelectorStep> steps;
+    CHECK_EQ(compile_selector("div.lyricsh ~ div:not([class])", steps), 1);
+    CHECK_EQ(compile_selector("div[class*=Lyrics__Container] > p", steps), 3);
+    CHECK_EQ(steps.size(), size_t(4));
+    CHECK(steps[1].combinator == Combinator::Sibling);
+    CHECK(steps[1].attributes.size() == 1);
+    CHECK(steps[1].attributes[0].op == AttributeOp::NotExists);
+    CHECK(steps[2].combinator == Combinator::None);
+    CHECK(steps[2].attributes[0].op == AttributeOp::Contains);
+    CHECK(steps[3].combinator == Combinator::Child);
+
+    const char* invalid[] = {"", "div[class", "div:not([class=x])", "div > > p", "div!"};
+    for(const char* selector : invalid)
+    {
+        bool threw = false;
+        try
+        {
+            compile_selector(selector, steps);
+        }
+        catch(const std::runtime_error&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+}
+
+TEST(scraper_direct_text_of_the_first_match)
+{
+    // The same content as the built-in "azlyrics" rule
+    ScraperProgram program;
+    program.content.push_back(make_content(program.steps, "div.lyricsh ~ div:not([class])", TextPolicy::DirectText));
+
+    const char* page = R"(<html><body>
+        <div class="lyricsh"><h2>Artist Lyrics</h2></div>
+        <div class="ringtone">Ringtone</div>
+        <div><!-- comment -->first line<br>
+        second line<br><i>[Chorus]</i><br>
+        </div>
+        <div>Not the lyrics</div>
+    </body></html>)";
+    // NOTE: Whitespace-only text nodes produce blank lines, which the source trims from the start and end
+    CHECK(scrape_lyrics(program, page, "https://example.com", nullptr) == std::optional<std::string>("first line\r\nsecond line\r\n\r\n"));
+}
+
+TEST(scraper_all_text_of_every_match)
+{
+    // The same content as the built-in "genius" rule, which prefers the older page layout
+    ScraperProgram program;
+    program.content.push_back(make_content(program.steps, "div.lyrics", TextPolicy::AllText));
+    program.content.push_back(make_content(program.steps, "div[class*=Lyrics__Container]", TextPolicy::AllText, true));
+
+    const char* page = R"(<html><body>
+        <div class="Lyrics__Container-sc-1">first <b>line</b><br>second line</div>
+        <div class="Ad">Advert</div>
+        <div class="Lyrics__Container-sc-1">third line</div>
+    </body></html>)";
+    CHECK(scrape_lyrics(program, page, "https://example.com", nullptr) == std::optional<std::string>("first\r\nline\r\nsecond line\r\nthird line\r\n"));
+
+    const char* old_page = R"(<html><body><div class="lyrics"><p>old layout</p></div><div class="Lyrics__Container">new layout</div></body></html>)";
+    CHECK(scrape_lyrics(program, old_page, "https://example.com", nullptr) == std::optional<std::string>("old layout\r\n"));
+}
+
+TEST(scraper_sections_are_matched_by_title)
+{
+    const ScraperProgram program = make_sections_program();
+    const auto matches_second = [](std::string_view title) { return title == "Second Song"; };
+    CHECK(scrape_lyrics(program, g_sections_page, "https://example.com", matches_second) == std::optional<std::string>("other line\r\n\r\n"));
+
+    const auto matches_nothing = [](std::string_view) { return false; };
+    CHECK(scrape_lyrics(program, g_sections_page, "https://example.com", matches_nothing) == std::optional<std::string>(""));
+}
+
+TEST(scraper_collects_every_section)
+{
+    const std::optional<std::vector<ScrapedSection>> sections = scrape_sections(make_sections_program(), g_sections_page, "https://example.com");
+    CHECK(sections.has_value());
+    if(sections.has_value())
+    {
+        CHECK_EQ(sections->size(), size_t(2));
+        if(sections->size() == 2)
+        {
+            CHECK_EQ((*sections)[0].title, "First Song");
+            CHECK_EQ((*sections)[0].text, "first line\r\nsecond line");
+            CHECK_EQ((*sections)[1].title, "Second Song");
+            CHECK_EQ((*sections)[1].text, "other line");
+        }
+    }
+}